@@ -44,6 +44,7 @@ public class BuoyancyPlugin : ModuleRules
 				"RHI",
 				"RenderCore",
 				"OceanPlugin",
+				"TraceLog",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -6,7 +6,11 @@
 #include "StaticMeshResources.h"
 #include "DrawDebugHelpers.h"
 #include "EngineUtils.h"
+#include "BuoyancyTrace.h"
+#include "BuoyantMesh/CompactTriangleMesh.h"
 
+// Only reached when the waves change abruptly, the grid usually converges on its first query.
+static const int32 MaxWaterHeightIterations = 4;
 
 // Constructor
 UAdvancedBuoyantComponent::UAdvancedBuoyantComponent()
@@ -50,46 +54,105 @@ void UAdvancedBuoyantComponent::InitializeComponent()
 }
 
 
+void UAdvancedBuoyantComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (RegisterWithBuoyancySubsystem(this))
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UAdvancedBuoyantComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterFromBuoyancySubsystem();
+
+	Super::EndPlay(EndPlayReason);
+}
+
 // Called every frame
 void UAdvancedBuoyantComponent::TickComponent( float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction )
 {
 	Super::TickComponent( DeltaTime, TickType, ThisTickFunction );
 
-	// Advanced Buoyant using a static mesh triangles
+	BUOYANCY_TRACE_SCOPE("UAdvancedBuoyantComponent", this);
+
+	if (GatherBuoyancy(DeltaTime)) {
+		EvaluateBuoyancy();
+		ApplyBuoyancy();
+	}
+}
 
-	if (!TheOcean) {
+bool UAdvancedBuoyantComponent::GatherBuoyancy(float DeltaTime)
+{
+	WaterSurface = FWaterSurfaceProviders::Resolve(WaterSurfaceProvider, this, TheOcean);
+	if (!WaterSurface) {
 		GetOcean();
-		return;
+		return false;
 	}
+	WaterTime = World->GetTimeSeconds();
+	return true;
+}
 
+void UAdvancedBuoyantComponent::EvaluateBuoyancy()
+{
+	// Advanced Buoyant using a static mesh triangles
+	// The forces are added to the mesh as they are found, so this runs on the game thread, see CanEvaluateBuoyancyInParallel.
 	AdvancedBuoyant();
-
 }
 
+void UAdvancedBuoyantComponent::ApplyBuoyancy()
+{
+	// Already applied by the evaluation
+}
 
-TArray<FForceTriangle> UAdvancedBuoyantComponent::SplitTriangle(FBuoyantVertex H, FBuoyantVertex M, FBuoyantVertex L, FVector OutArrow)
+void UAdvancedBuoyantComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
 {
-	TArray<FForceTriangle> ReturnTriangles;
-	FBuoyantVertex CutVertex; 
-	CutVertex.Position = ((L.Position - H.Position) * (H.Position.Z - M.Position.Z) / (H.Position.Z - L.Position.Z) + H.Position); CutVertex.Depth = GetOceanDepthFromGrid(CutVertex.Position);
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetBuoyancyAllocatedSize());
+}
 
-	ReturnTriangles.Emplace(L, CutVertex, M, OutArrow, true);
-	ReturnTriangles.Last().Center.Position = (L.Position + CutVertex.Position + M.Position) / 3.f;
-	ReturnTriangles.Last().Center.Depth = GetOceanDepthFromGrid(ReturnTriangles.Last().Center.Position);
-	ReturnTriangles.Last().CanSetForce = true;
+SIZE_T UAdvancedBuoyantComponent::GetBuoyancyAllocatedSize() const
+{
+	return HullVertices.GetAllocatedSize() + HullIndices.GetAllocatedSize() + CompactHull.GetAllocatedSize() +
+	       HullWorldVertices.GetAllocatedSize() + SubmergedTris.GetAllocatedSize() + TriSizes.GetAllocatedSize() +
+	       TriSubmergedArea.GetAllocatedSize() + AdvancedGridHeight.GetAllocatedSize() + GridInverseStates.GetAllocatedSize();
+}
 
-	SubmergedTris.Add(ReturnTriangles.Last());
-	SubmergedVolume += SubmergedTris.Last().TriArea;
 
-	ReturnTriangles.Emplace(H, CutVertex, M, OutArrow, false);
-	ReturnTriangles.Last().Center.Position = (H.Position + CutVertex.Position + M.Position) / 3.f;
-	ReturnTriangles.Last().Center.Depth = GetOceanDepthFromGrid(ReturnTriangles.Last().Center.Position);
-	ReturnTriangles.Last().CanSetForce = true;
+TArray<FForceTriangle> UAdvancedBuoyantComponent::SplitTriangle(FBuoyantVertex H, FBuoyantVertex M, FBuoyantVertex L, FVector OutArrow)
+{
+	AddSplitTriangles(H, M, L, OutArrow);
+	return TArray<FForceTriangle>(&SubmergedTris[SubmergedTris.Num() - 2], 2);
+}
 
-	SubmergedTris.Add(ReturnTriangles.Last());
-	SubmergedVolume += SubmergedTris.Last().TriArea;
+void UAdvancedBuoyantComponent::AddSplitTriangles(const FBuoyantVertex& H, const FBuoyantVertex& M, const FBuoyantVertex& L, const FVector& OutArrow)
+{
+	FBuoyantVertex CutVertex; 
+	// The cut lies on the HL edge, so its depth is interpolated from the edge ends instead of sampling the water again
+	const float CutAlpha = (H.Position.Z - M.Position.Z) / (H.Position.Z - L.Position.Z);
+	CutVertex.Position = (L.Position - H.Position) * CutAlpha + H.Position;
+	CutVertex.Depth = FMath::Lerp(H.Depth, L.Depth, CutAlpha);
+
+	FForceTriangle& LowTriangle = SubmergedTris[SubmergedTris.Emplace(L, CutVertex, M, OutArrow, true)];
+	LowTriangle.Center.Position = (L.Position + CutVertex.Position + M.Position) / 3.f;
+	LowTriangle.Center.Depth = (L.Depth + CutVertex.Depth + M.Depth) / 3.f;
+	LowTriangle.CanSetForce = true;
+	SubmergedVolume += LowTriangle.TriArea;
+
+	FForceTriangle& HighTriangle = SubmergedTris[SubmergedTris.Emplace(H, CutVertex, M, OutArrow, false)];
+	HighTriangle.Center.Position = (H.Position + CutVertex.Position + M.Position) / 3.f;
+	HighTriangle.Center.Depth = (H.Depth + CutVertex.Depth + M.Depth) / 3.f;
+	HighTriangle.CanSetForce = true;
+	SubmergedVolume += HighTriangle.TriArea;
+}
 
-	return ReturnTriangles;
+void UAdvancedBuoyantComponent::DrawLastSplitTriangles(FColor DebugColor)
+{
+	for (int32 i = FMath::Max(0, SubmergedTris.Num() - 2); i < SubmergedTris.Num(); i++) {
+		DrawDebugStuff(SubmergedTris[i], DebugColor);
+	}
 }
 
 void UAdvancedBuoyantComponent::ApplyForce(FForceTriangle TriForce)
@@ -106,6 +169,7 @@ void UAdvancedBuoyantComponent::ApplyForce(FForceTriangle TriForce)
 	FVector StaticBuoyantForce = TriForce.Force * ForceC * FVector(1.f, 1.f, 1.f - BuoyantReductionCoefficient) * FVector(1.f, 1.f, PitchBuoyantReductionOffset) * DensityCorrectionModifier;
 
 	if (!FMath::IsNearlyZero(StaticBuoyantForce.Size())) {
+		BUOYANCY_TRACE_FORCE(StaticBuoyantForce);
 		BuoyantMesh->AddForceAtLocation(StaticBuoyantForce, TriForce.ForceCenter);
 	}
 	if (bDebugOn) {
@@ -170,6 +234,7 @@ void UAdvancedBuoyantComponent::ApplyForce(FForceTriangle TriForce)
 	
 	// Non static Buoyant forces are applied to the centroid of the triangle as they do not vary with depth (assuming a constant density)
 	if (!FMath::IsNearlyZero(FinalForce.Size())) {
+		BUOYANCY_TRACE_FORCE(FinalForce);
 		BuoyantMesh->AddForceAtLocation(FinalForce, TriForce.Center.Position);
 	}
 
@@ -197,16 +262,19 @@ void UAdvancedBuoyantComponent::PopulateTrianglesFromStaticMesh()
 	int32 NumLODs = BuoyantMesh->GetStaticMesh()->RenderData->LODResources.Num();
 	FStaticMeshLODResources& LODResource = BuoyantMesh->GetStaticMesh()->RenderData->LODResources[NumLODs - 1];
 
+	// Copies of the render buffers, freed on every return.
 	int numIndices = LODResource.IndexBuffer.IndexBufferRHI->GetSize() / sizeof(uint16);
-	uint16* Indices = new uint16[numIndices];
+	TArray<uint16> Indices;
+	Indices.SetNumUninitialized(numIndices);
 	int numVertices = LODResource.VertexBuffers.PositionVertexBuffer.VertexBufferRHI->GetSize() / (sizeof(float) * 3);
-	float* Vertices = new float[numVertices * 3];
+	TArray<float> Vertices;
+	Vertices.SetNumUninitialized(numVertices * 3);
 
 
 	FRawStaticIndexBuffer* IndexBuffer = &LODResource.IndexBuffer;
-	uint16* Indices0 = Indices;
+	uint16* Indices0 = Indices.GetData();
 	FPositionVertexBuffer*  PositionVertexBuffer = &LODResource.VertexBuffers.PositionVertexBuffer;
-	float* Vertices0 = Vertices;
+	float* Vertices0 = Vertices.GetData();
 	ENQUEUE_RENDER_COMMAND(GetMyBuffers)
 		(
 		[IndexBuffer, Indices0, PositionVertexBuffer, Vertices0](FRHICommandListImmediate& RHICmdList)
@@ -241,13 +309,23 @@ void UAdvancedBuoyantComponent::PopulateTrianglesFromStaticMesh()
 	IndexBufferArray = LODResource.IndexBuffer.GetArrayView();
 	uint32 Stride = LODResource.VertexBuffers.PositionVertexBuffer.GetStride();
 
-	uint8* VertexBufferContent = (uint8*)Vertices;
+	uint8* VertexBufferContent = (uint8*)Vertices.GetData();
+
 
+	// Render meshes duplicate vertices along UV and normal seams, weld them back together so every hull vertex
+	// is only transformed and sampled once per tick.
+	HullVertices.Reset();
+	HullIndices.Reset(NumTris * 3);
+	TMap<FVector, int32> WeldedVertexIndices;
+	auto WeldVertex = [this, &WeldedVertexIndices](const FVector& Position) -> int32
+	{
+		if (const int32* ExistingIndex = WeldedVertexIndices.Find(Position)) { return *ExistingIndex; }
+		const int32 NewIndex = HullVertices.Add(Position);
+		WeldedVertexIndices.Add(Position, NewIndex);
+		return NewIndex;
+	};
 
-	FVector A; FVector B; FVector C;
 	for (int32 TriIndex = 0; TriIndex < NumTris; TriIndex++) {
-		TArray<FVector> Tri;
-		
 		int32 ia = Indices[TriIndex * 3 + 0];
 		int32 ib = Indices[TriIndex * 3 + 1];
 		int32 ic = Indices[TriIndex * 3 + 2];
@@ -256,11 +334,9 @@ void UAdvancedBuoyantComponent::PopulateTrianglesFromStaticMesh()
 		FVector vb = ((FPositionVertex*)(VertexBufferContent + ib*Stride))->Position;
 		FVector vc = ((FPositionVertex*)(VertexBufferContent + ic*Stride))->Position;
 
-		Tri.Add(va);
-		Tri.Add(vb);
-		Tri.Add(vc);
-
-		Triangles.Add(Tri);
+		HullIndices.Add(WeldVertex(va));
+		HullIndices.Add(WeldVertex(vb));
+		HullIndices.Add(WeldVertex(vc));
 
 		FVector SideAB = vb - va;
 		FVector SideAC = vc - va;
@@ -270,7 +346,55 @@ void UAdvancedBuoyantComponent::PopulateTrianglesFromStaticMesh()
 		TriSizes.Add(TriSize);
 		TriSubmergedArea.Add(0.f);
 	}
-	
+
+	HullVertices.Shrink();
+	HullWorldVertices.SetNumZeroed(HullVertices.Num());
+
+	if (FCompactTriangleMesh::ShouldReport()) {
+		const FCompactTriangleMeshComparison Comparison = FCompactTriangleMesh::Compare(HullVertices, HullIndices);
+		UE_LOG(LogTemp, Log, TEXT("%s: hull of %d vertices and %d triangles takes %d bytes as floats and %d bytes compact, with a position error of at most %f. %.1f and %.1f million corners per second."),
+			*GetPathName(), Comparison.VertexCount, Comparison.TriangleCount, (int32)Comparison.FloatBytes, (int32)Comparison.CompactBytes,
+			Comparison.MaxPositionError, Comparison.FloatCornersPerSecond / 1000000.0, Comparison.CompactCornersPerSecond / 1000000.0);
+	}
+
+	// Only one layout is kept
+	if (bUseCompactHull) {
+		CompactHull = FCompactTriangleMesh(HullVertices, HullIndices);
+		HullVertices.Empty();
+		HullIndices.Empty();
+	}
+	else {
+		CompactHull = FCompactTriangleMesh();
+	}
+}
+
+int32 UAdvancedBuoyantComponent::GetHullTriangleCount() const
+{
+	return bUseCompactHull ? CompactHull.GetTriangleCount() : HullIndices.Num() / 3;
+}
+
+int32 UAdvancedBuoyantComponent::GetHullIndex(int32 Index) const
+{
+	return bUseCompactHull ? CompactHull.GetIndex(Index) : HullIndices[Index];
+}
+
+FVector UAdvancedBuoyantComponent::GetHullOutwardNormal(int32 TriIndex, const FVector& v0, const FVector& v1, const FVector& v2) const
+{
+	// The hull triangles wind the other way around the normal
+	if (bUseCompactHull) {
+		return -FCompactTriangleMesh::TransformNormal(MeshTransform, CompactHull.GetTriangleNormal(TriIndex));
+	}
+	return -FVector::CrossProduct(v1 - v0, v2 - v0).GetSafeNormal();
+}
+
+void UAdvancedBuoyantComponent::UpdateHullWorldVertices()
+{
+	for (int32 VertexIndex = 0; VertexIndex < HullWorldVertices.Num(); VertexIndex++) {
+		const FVector LocalPosition = bUseCompactHull ? CompactHull.GetVertex(VertexIndex) : HullVertices[VertexIndex];
+		FBuoyantVertex& WorldVertex = HullWorldVertices[VertexIndex];
+		WorldVertex.Position = MeshTransform.TransformPosition(LocalPosition);
+		WorldVertex.Depth = GetOceanDepthFromLocalPosition(LocalPosition, WorldVertex.Position.Z);
+	}
 }
 
 
@@ -284,24 +408,24 @@ void UAdvancedBuoyantComponent::GetOcean()
 
 float UAdvancedBuoyantComponent::GetOceanDepthFromGrid(FVector Position, bool bJustGetHeightAtLocation)
 {
-	// Localized position is local X and Y but global Z
-	
-	FVector LocalPosition;
-
-	LocalPosition = MeshTransform.InverseTransformPosition(Position);
-
-	float InterDepth = 0.f;
 	if (bJustGetHeightAtLocation) {
-		InterDepth = TheOcean->GetWaveHeightValue(Position, World, false, false).Z;
-	}
-	else {
-		// Non interpolation method
-		int32 column = FMath::Clamp<int32>(FMath::RoundToInt((LocalPosition.Y - MinBound.Y) / (MaxBound.Y - MinBound.Y) * (4 - 1)), 0, 3);
-		int32 row = FMath::Clamp<int32>(FMath::RoundToInt((LocalPosition.X - MinBound.X) / (MaxBound.X - MinBound.X) * (5 - 1)), 0, 4);
-		InterDepth = AdvancedGridHeight[4 * row + column].Z;
+		BUOYANCY_TRACE_WATER_QUERIES(1);
+		float InterDepth = WaterSurface->GetWaterHeight(Position, WaterTime);
+		return (Position.Z - InterDepth) / 1.f; // in cm
 	}
 
-	return (Position.Z - InterDepth) / 1.f; // in cm
+	// Localized position is local X and Y but global Z
+	return GetOceanDepthFromLocalPosition(MeshTransform.InverseTransformPosition(Position), Position.Z);
+}
+
+float UAdvancedBuoyantComponent::GetOceanDepthFromLocalPosition(const FVector& LocalPosition, float WorldZ) const
+{
+	// Non interpolation method
+	int32 column = FMath::Clamp<int32>(FMath::RoundToInt((LocalPosition.Y - MinBound.Y) / (MaxBound.Y - MinBound.Y) * (4 - 1)), 0, 3);
+	int32 row = FMath::Clamp<int32>(FMath::RoundToInt((LocalPosition.X - MinBound.X) / (MaxBound.X - MinBound.X) * (5 - 1)), 0, 4);
+	float InterDepth = AdvancedGridHeight[4 * row + column].Z;
+
+	return (WorldZ - InterDepth) / 1.f; // in cm
 }
 
 float UAdvancedBuoyantComponent::TriangleArea(FVector A, FVector B, FVector C)
@@ -314,6 +438,7 @@ float UAdvancedBuoyantComponent::TriangleArea(FVector A, FVector B, FVector C)
 
 void UAdvancedBuoyantComponent::ApplySlamForce(FVector SlamForce, FVector TriCenter)
 {
+	BUOYANCY_TRACE_FORCE(SlamForce);
 	BuoyantMesh->AddForceAtLocation(SlamForce, TriCenter);
 }
 
@@ -323,18 +448,38 @@ void UAdvancedBuoyantComponent::AdvancedBuoyant()
 	if (!BuoyantMesh) { GEngine->AddOnScreenDebugMessage(-1, 2.f, FColor::Red, FString::Printf(TEXT("Mesh Missed"))); return; }
 	if (!BuoyantMesh->GetStaticMesh()) { GEngine->AddOnScreenDebugMessage(-1, 2.f, FColor::Red, FString::Printf(TEXT("Mesh Mesh Missed"))); return; }
 
+	MeshTransform = BuoyantMesh->GetComponentTransform();
+
 	// Create the grid for ocean height sampling based on the size of the boat mesh
 	AdvancedGridHeight.Empty();
 	int32 rows = 5; int32 columns = 4;
 	AdvancedGridHeight.SetNum(rows*columns);
 	float columnSize = (MaxBound.Y - MinBound.Y) / (float)(columns - 1);
-	FVector GridPoint;
+	TArray<FVector, TInlineAllocator<20>> GridPoints;
+	GridPoints.SetNum(rows * columns);
+	for (int32 i = 0; i < rows * columns; i++) {
+		GridPoints[i] = MeshTransform.TransformPosition(FVector((float)(i / columns) * (MaxBound.X - MinBound.X) / (float)(rows - 1) + MinBound.X,
+			(float)(i % columns) * (MaxBound.Y - MinBound.Y) / (float)(columns - 1) + MinBound.Y, 0.f));
+	}
+	// Sample the whole grid in one batch so providers can share work between the points
+	TArray<float, TInlineAllocator<20>> GridHeights;
+	GridHeights.SetNumUninitialized(rows * columns);
+	if (bAccurateWaterHeight) {
+		TArray<FVector, TInlineAllocator<20>> GridDisplacements;
+		GridDisplacements.SetNumUninitialized(rows * columns);
+		GridInverseStates.SetNum(rows * columns);
+		FWaterSurfaceInverse::SolveBatch(*WaterSurface, GridPoints, WaterTime, WaterHeightTolerance, MaxWaterHeightIterations, GridInverseStates, GridDisplacements);
+		for (int32 i = 0; i < rows * columns; i++) {
+			GridHeights[i] = GridDisplacements[i].Z;
+		}
+	}
+	else {
+		WaterSurface->GetWaterHeights(GridPoints, WaterTime, GridHeights);
+	}
 	for (int32 i = 0; i < rows * columns; i++) {
-		GridPoint = FVector((float)(i / columns) * (MaxBound.X - MinBound.X) / (float)(rows - 1) + MinBound.X,
-			(float)(i % columns) * (MaxBound.Y - MinBound.Y) / (float)(columns - 1) + MinBound.Y, 0.f);
-		GridPoint = BuoyantMesh->GetComponentTransform().TransformPosition(GridPoint);
-		AdvancedGridHeight[i] = FVector(GridPoint.X, GridPoint.Y, TheOcean->GetWaveHeightValue(GridPoint, World, false, true).Z);
+		AdvancedGridHeight[i] = FVector(GridPoints[i].X, GridPoints[i].Y, GridHeights[i]);
 	}
+	BUOYANCY_TRACE_WATER_QUERIES(rows * columns);
 
 
 	if (bDebugOn) {
@@ -343,55 +488,39 @@ void UAdvancedBuoyantComponent::AdvancedBuoyant()
 		}
 	}
 
+	// Transform and sample every welded vertex once, triangles only read from this list
+	UpdateHullWorldVertices();
+
 	FBuoyantVertex TempVertex;
 
+	const float MeshMass = BuoyantMesh->GetMass();
+	const float slamforcemult = MeshMass / 2.f * ImpactCoefficient;
+	FBodyInstance* const MeshBodyInstance = BuoyantMesh->GetBodyInstance();
+
 	// TODO ***OPTIMIZATION***
 	// Send this to another thread (get data, do work, pass back forces to apply to boat)
 	// the three vertices of a triangle
-	SubmergedTris.Empty();
+	SubmergedTris.Reset();
 	SubmergedVolume = 0.f;
-	for (int32 TriIndex = 0; TriIndex < Triangles.Num(); TriIndex++)
+	const int32 NumTriangles = GetHullTriangleCount();
+	BUOYANCY_TRACE_TRIANGLES(NumTriangles);
+	for (int32 TriIndex = 0; TriIndex < NumTriangles; TriIndex++)
 	{
-		FVector v0; FVector v1; FVector v2;
-		FBuoyantVertex H; FBuoyantVertex M; FBuoyantVertex L;
-
-
-		// TODO ***HIGH PRIORITY OPTIMIZATION*** 
-		// Figure out how this list of vertices relates to each single vertex so we can find the depth and location for each vertex one time instead of three times per vertex.
-		// Basically get all the location information for each vertex and then pull from the known list to analyze the triangles
-		MeshTransform = BuoyantMesh->GetComponentTransform();
-		v0 = MeshTransform.TransformPosition(Triangles[TriIndex][0]);
-		v1 = MeshTransform.TransformPosition(Triangles[TriIndex][1]);
-		v2 = MeshTransform.TransformPosition(Triangles[TriIndex][2]);
-
 		// Approximate the amount of each triangle that is underwater
 
 		// Order by height
+		FBuoyantVertex H = HullWorldVertices[GetHullIndex(TriIndex * 3 + 0)];
+		FBuoyantVertex M = HullWorldVertices[GetHullIndex(TriIndex * 3 + 1)];
+		FBuoyantVertex L = HullWorldVertices[GetHullIndex(TriIndex * 3 + 2)];
 
-		H.Position = v0;
-		M.Position = v1;
-		L.Position = v2;
-		float a; float b; float c;
-
-		a = GetOceanDepthFromGrid(v0);
-		b = GetOceanDepthFromGrid(v1);
-		c = GetOceanDepthFromGrid(v2);
-
-		H.Depth = a;
-		M.Depth = b;
-		L.Depth = c;
-
+		const FVector v0 = H.Position;
+		const FVector v1 = M.Position;
+		const FVector v2 = L.Position;
 
 		if (M.Depth > H.Depth) { TempVertex = H; H = M; M = TempVertex; }
 		if (L.Depth > H.Depth) { TempVertex = H; H = L; L = TempVertex; }
 		if (L.Depth > M.Depth) { TempVertex = M; M = L; L = TempVertex; }
 
-		float slamforcemult = 5000.f;
-
-		if (BuoyantMesh) {
-			slamforcemult = BuoyantMesh->GetMass() / 2.f * ImpactCoefficient;
-		}
-
 		// If no vertices are underwater
 		if (L.Depth > 0) { continue; }
 		// If one vertex is under water
@@ -400,13 +529,13 @@ void UAdvancedBuoyantComponent::AdvancedBuoyant()
 			FVector InterSectPointOne = -L.Depth / (M.Depth - L.Depth) * (M.Position - L.Position) + L.Position;
 			FVector InterSectPointTwo = -L.Depth / (H.Depth - L.Depth) * (H.Position - L.Position) + L.Position;
 
-			FVector OutArrow = -FVector::CrossProduct(v1 - v0, v2 - v0); // Outward facing normal
-			OutArrow.Normalize();
+			FVector OutArrow = GetHullOutwardNormal(TriIndex, v0, v1, v2); // Outward facing normal
 
 			// New vertices
 			FBuoyantVertex NewH; FBuoyantVertex NewM; FBuoyantVertex NewL;
-			NewH.Position = InterSectPointOne; NewH.Depth = GetOceanDepthFromGrid(InterSectPointOne);
-			NewM.Position = InterSectPointTwo; NewM.Depth = GetOceanDepthFromGrid(InterSectPointTwo);
+			// Intersection points are on the waterline by construction
+			NewH.Position = InterSectPointOne; NewH.Depth = 0.f;
+			NewM.Position = InterSectPointTwo; NewM.Depth = 0.f;
 			NewL = L;
 
 			if (NewM.Position.Z > NewH.Position.Z) { TempVertex = NewH; NewH = NewM; NewM = TempVertex; }
@@ -414,13 +543,11 @@ void UAdvancedBuoyantComponent::AdvancedBuoyant()
 			if (NewL.Position.Z > NewM.Position.Z) { TempVertex = NewM; NewM = NewL; NewL = TempVertex; }
 
 			// Get new triangles
-			TArray<FForceTriangle> SplitTris = SplitTriangle(NewH, NewM, NewL, OutArrow);
-			for (FForceTriangle TriForce : SplitTris) {
-				if (bDebugOn) {
-					// Waterline
-					DrawDebugLine(World, InterSectPointOne, InterSectPointTwo, FColor::Blue, false, -1.f, 0, 10.f);
-					DrawDebugStuff(TriForce, FColor::Orange);
-				}
+			AddSplitTriangles(NewH, NewM, NewL, OutArrow);
+			if (bDebugOn) {
+				// Waterline
+				DrawDebugLine(World, InterSectPointOne, InterSectPointTwo, FColor::Blue, false, -1.f, 0, 10.f);
+				DrawLastSplitTriangles(FColor::Orange);
 			}
 
 
@@ -428,11 +555,11 @@ void UAdvancedBuoyantComponent::AdvancedBuoyant()
 			float NewSubmergedArea = TriangleArea(NewH.Position, NewM.Position, NewL.Position);
 			float dS = FMath::Max(0.f, NewSubmergedArea - TriSubmergedArea[TriIndex]);
 			FVector TriCenter = (H.Position + M.Position + L.Position) / 3.f;
-			FVector v = BuoyantMesh->GetBodyInstance()->GetUnrealWorldVelocityAtPoint(TriCenter);
+			FVector v = MeshBodyInstance->GetUnrealWorldVelocityAtPoint(TriCenter);
 			float acceleration = v.Size() / World->DeltaTimeSeconds; // cm / s^2
 			float cT = FMath::Clamp(OutArrow | v.GetSafeNormal(), 0.f, 1.f); // face velocity value
 			float SlamRampValue = 2.f;
-			FVector StopForce = -OutArrow * BuoyantMesh->GetMass() * slamforcemult * dS / FalseVolume;  // Make sure the force won't push the boat in the opposite direction
+			FVector StopForce = -OutArrow * MeshMass * slamforcemult * dS / FalseVolume;  // Make sure the force won't push the boat in the opposite direction
 			FVector SlamForce = FMath::Pow(FMath::Clamp(acceleration / MaxSlamAcceleration, 0.f, 1.f), SlamRampValue) * cT * StopForce;
 			TriSubmergedArea[TriIndex] = NewSubmergedArea;
 			if (!FMath::IsNearlyZero(SlamForce.Size())) {
@@ -453,22 +580,22 @@ void UAdvancedBuoyantComponent::AdvancedBuoyant()
 			FVector InterSectPointOne = -L.Depth / (H.Depth - L.Depth) * (H.Position - L.Position) + L.Position;
 			FVector InterSectPointTwo = -M.Depth / (H.Depth - M.Depth) * (H.Position - M.Position) + M.Position;
 
-			FVector OutArrow = -FVector::CrossProduct(v1 - v0, v2 - v0); // Outward facing normal
-			OutArrow.Normalize();
+			FVector OutArrow = GetHullOutwardNormal(TriIndex, v0, v1, v2); // Outward facing normal
 
 			// Detrapezoidation
 
 			// New vertices 1
 			FBuoyantVertex NewH1; FBuoyantVertex NewM1; FBuoyantVertex NewL1;
-			NewH1.Position = InterSectPointOne; NewH1.Depth = GetOceanDepthFromGrid(InterSectPointOne);
-			NewM1.Position = InterSectPointTwo; NewM1.Depth = GetOceanDepthFromGrid(InterSectPointTwo);
+			// Intersection points are on the waterline by construction
+			NewH1.Position = InterSectPointOne; NewH1.Depth = 0.f;
+			NewM1.Position = InterSectPointTwo; NewM1.Depth = 0.f;
 			NewL1 = M;
 			if (NewM1.Position.Z > NewH1.Position.Z) { TempVertex = NewH1; NewH1 = NewM1; NewM1 = TempVertex; }
 			if (NewL1.Position.Z > NewH1.Position.Z) { TempVertex = NewH1; NewH1 = NewL1; NewL1 = TempVertex; }
 			if (NewL1.Position.Z > NewM1.Position.Z) { TempVertex = NewM1; NewM1 = NewL1; NewL1 = TempVertex; }
 			// New vertices 2
 			FBuoyantVertex NewH2; FBuoyantVertex NewM2; FBuoyantVertex NewL2;
-			NewH2.Position = InterSectPointOne; NewH2.Depth = GetOceanDepthFromGrid(InterSectPointOne);
+			NewH2.Position = InterSectPointOne; NewH2.Depth = 0.f;
 			NewM2 = M;
 			NewL2 = L;
 			if (NewM2.Position.Z > NewH2.Position.Z) { TempVertex = NewH2; NewH2 = NewM2; NewM2 = TempVertex; }
@@ -476,21 +603,16 @@ void UAdvancedBuoyantComponent::AdvancedBuoyant()
 			if (NewL2.Position.Z > NewM2.Position.Z) { TempVertex = NewM2; NewM2 = NewL2; NewL2 = TempVertex; }
 
 			// Get new triangles
-			TArray<FForceTriangle> SplitTris = SplitTriangle(NewH1, NewM1, NewL1, OutArrow);
-			for (FForceTriangle TriForce : SplitTris) {
-				if (bDebugOn) {
-					// Waterline
-					DrawDebugLine(World, InterSectPointOne, InterSectPointTwo, FColor::Blue, false, -1.f, 0, 10.f);
-					DrawDebugStuff(TriForce, FColor::Purple);
-				}
+			AddSplitTriangles(NewH1, NewM1, NewL1, OutArrow);
+			if (bDebugOn) {
+				// Waterline
+				DrawDebugLine(World, InterSectPointOne, InterSectPointTwo, FColor::Blue, false, -1.f, 0, 10.f);
+				DrawLastSplitTriangles(FColor::Purple);
 			}
 			// Get new triangles
-			SplitTris.Empty();
-			SplitTris = SplitTriangle(NewH2, NewM2, NewL2, OutArrow);
-			for (FForceTriangle TriForce : SplitTris) {
-				if (bDebugOn) {
-					DrawDebugStuff(TriForce, FColor::Turquoise);
-				}
+			AddSplitTriangles(NewH2, NewM2, NewL2, OutArrow);
+			if (bDebugOn) {
+				DrawLastSplitTriangles(FColor::Turquoise);
 			}
 
 			// Slamming force
@@ -498,11 +620,11 @@ void UAdvancedBuoyantComponent::AdvancedBuoyant()
 			NewSubmergedArea += TriangleArea(NewH2.Position, NewM2.Position, NewL2.Position);
 			float dS = FMath::Max(0.f, NewSubmergedArea - TriSubmergedArea[TriIndex]);
 			FVector TriCenter = (H.Position + M.Position + L.Position) / 3.f;
-			FVector v = BuoyantMesh->GetBodyInstance()->GetUnrealWorldVelocityAtPoint(TriCenter);
+			FVector v = MeshBodyInstance->GetUnrealWorldVelocityAtPoint(TriCenter);
 			float acceleration = v.Size() / World->DeltaTimeSeconds; // cm / s^2
 			float cT = FMath::Clamp(OutArrow | v.GetSafeNormal(), 0.f, 1.f); // face velocity value
 			float SlamRampValue = 2.f;
-			FVector StopForce = -OutArrow * BuoyantMesh->GetMass() * slamforcemult * dS / FalseVolume;  // Make sure the force won't push the boat in the opposite direction
+			FVector StopForce = -OutArrow * MeshMass * slamforcemult * dS / FalseVolume;  // Make sure the force won't push the boat in the opposite direction
 			FVector SlamForce = FMath::Pow(FMath::Clamp(acceleration / MaxSlamAcceleration, 0.f, 1.f), SlamRampValue) * cT * StopForce;
 			TriSubmergedArea[TriIndex] = NewSubmergedArea;
 			if (!FMath::IsNearlyZero(SlamForce.Size())) {
@@ -519,31 +641,27 @@ void UAdvancedBuoyantComponent::AdvancedBuoyant()
 		// If three vertices are underwater
 		if (H.Depth < 0) {
 
-			FVector OutArrow = -FVector::CrossProduct(v1 - v0, v2 - v0); // Outward facing normal
-			OutArrow.Normalize();
+			FVector OutArrow = GetHullOutwardNormal(TriIndex, v0, v1, v2); // Outward facing normal
 
 			if (M.Position.Z > H.Position.Z) { TempVertex = H; H = M; M = TempVertex; }
 			if (L.Position.Z > H.Position.Z) { TempVertex = H; H = L; L = TempVertex; }
 			if (L.Position.Z > M.Position.Z) { TempVertex = M; M = L; L = TempVertex; }
 
 			// Get new triangles
-			TArray<FForceTriangle> SplitTris = SplitTriangle(H, M, L, OutArrow);
-			for (FForceTriangle TriForce : SplitTris) {
-
-				if (bDebugOn) {
-					DrawDebugStuff(TriForce, FColor::Green);
-				}
+			AddSplitTriangles(H, M, L, OutArrow);
+			if (bDebugOn) {
+				DrawLastSplitTriangles(FColor::Green);
 			}
 
 			// Slamming force
 			float NewSubmergedArea = TriangleArea(H.Position, M.Position, L.Position);
 			float dS = FMath::Max(0.f, NewSubmergedArea - TriSubmergedArea[TriIndex]);
 			FVector TriCenter = (H.Position + M.Position + L.Position) / 3.f;
-			FVector v = BuoyantMesh->GetBodyInstance()->GetUnrealWorldVelocityAtPoint(TriCenter);
+			FVector v = MeshBodyInstance->GetUnrealWorldVelocityAtPoint(TriCenter);
 			float acceleration = v.Size() / World->DeltaTimeSeconds; // cm / s^2
 			float cT = FMath::Clamp(OutArrow | v.GetSafeNormal(), 0.f, 1.f); // face velocity value
 			float SlamRampValue = 2.f;
-			FVector StopForce = -OutArrow * BuoyantMesh->GetMass() * slamforcemult * dS / FalseVolume;  // Make sure the force won't push the boat in the opposite direction
+			FVector StopForce = -OutArrow * MeshMass * slamforcemult * dS / FalseVolume;  // Make sure the force won't push the boat in the opposite direction
 			FVector SlamForce = FMath::Pow(FMath::Clamp(acceleration / MaxSlamAcceleration, 0.f, 1.f), SlamRampValue) * cT * StopForce;
 			TriSubmergedArea[TriIndex] = NewSubmergedArea;
 			if (!FMath::IsNearlyZero(SlamForce.Size())) {
@@ -559,6 +677,8 @@ void UAdvancedBuoyantComponent::AdvancedBuoyant()
 		}
 	}
 
+	BUOYANCY_TRACE_SUBTRIANGLES(SubmergedTris.Num());
+
 	float totalupforce = 0.f;
 	for (FForceTriangle TriForce : SubmergedTris) {
 		ApplyForce(TriForce);
@@ -0,0 +1,19 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+// Allocated size of an array of arrays, the inner arrays included.
+template <typename ElementType>
+SIZE_T GetNestedAllocatedSize(const TArray<TArray<ElementType>>& Arrays)
+{
+	auto Size = Arrays.GetAllocatedSize();
+	for (const auto& Array : Arrays)
+	{
+		Size += Array.GetAllocatedSize();
+	}
+	return Size;
+}
@@ -0,0 +1,221 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "Engine/World.h"
+#include "UObject/UObjectHash.h"
+#include "UObject/UObjectIterator.h"
+#include "AdvancedBuoyantComponent/AdvancedBuoyantComponent.h"
+#include "BuoyantComponent.h"
+#include "BuoyantDestructibleComponent.h"
+#include "BuoyantForceComponent.h"
+#include "BuoyantMesh/BuoyantMeshComponent.h"
+#include "BuoyantMesh/HydrostaticTable.h"
+#include "BuoyantMesh/WaterHeightmapComponent.h"
+#include "Replay/BuoyancyRecorderComponent.h"
+#include "WaterQuery/WaterQueryComponent.h"
+#include "WaterSurface/BakedWaterSurfaceProvider.h"
+#include "WaterSurface/WaterSurfaceAtlasBakerComponent.h"
+
+
+// Plugin memory of a group of components. Shared objects are keyed by name, so each one is counted once per group
+// however many components of the group use it.
+struct FBuoyancyMemoryGroup
+{
+	FString Name;
+	int32 ComponentCount = 0;
+	SIZE_T UniqueBytes = 0;
+	TMap<FString, SIZE_T> SharedObjects;
+
+	void Add(SIZE_T InUniqueBytes, const TMap<FString, SIZE_T>& InSharedObjects)
+	{
+		++ComponentCount;
+		UniqueBytes += InUniqueBytes;
+		SharedObjects.Append(InSharedObjects);
+	}
+
+	SIZE_T GetSharedBytes() const
+	{
+		SIZE_T SharedBytes = 0;
+		for (const auto& SharedObject : SharedObjects)
+		{
+			SharedBytes += SharedObject.Value;
+		}
+		return SharedBytes;
+	}
+};
+
+template <typename ComponentType>
+static bool TryGetBuoyancyAllocatedSize(const UActorComponent* Component, SIZE_T& OutSize)
+{
+	const auto TypedComponent = Cast<ComponentType>(Component);
+	if (!TypedComponent) return false;
+
+	OutSize = TypedComponent->GetBuoyancyAllocatedSize();
+	return true;
+}
+
+// Per-instance memory of a component of the plugin. Returns false for the other components.
+static bool GetBuoyancyAllocatedSize(const UActorComponent* Component, SIZE_T& OutSize)
+{
+	return TryGetBuoyancyAllocatedSize<UBuoyantMeshComponent>(Component, OutSize) ||
+	       TryGetBuoyancyAllocatedSize<UAdvancedBuoyantComponent>(Component, OutSize) ||
+	       TryGetBuoyancyAllocatedSize<UBuoyantComponent>(Component, OutSize) ||
+	       TryGetBuoyancyAllocatedSize<UBuoyantForceComponent>(Component, OutSize) ||
+	       TryGetBuoyancyAllocatedSize<UBuoyantDestructibleComponent>(Component, OutSize) ||
+	       TryGetBuoyancyAllocatedSize<UWaterHeightmapComponent>(Component, OutSize) ||
+	       TryGetBuoyancyAllocatedSize<UWaterQueryComponent>(Component, OutSize) ||
+	       TryGetBuoyancyAllocatedSize<UBuoyancyRecorderComponent>(Component, OutSize) ||
+	       TryGetBuoyancyAllocatedSize<UWaterSurfaceAtlasBakerComponent>(Component, OutSize);
+}
+
+static const UObject* GetMeshAsset(const USceneComponent* MeshComponent)
+{
+	if (const auto StaticMeshComponent = Cast<UStaticMeshComponent>(MeshComponent))
+	{
+		return StaticMeshComponent->GetStaticMesh();
+	}
+	if (const auto SkinnedMeshComponent = Cast<USkinnedMeshComponent>(MeshComponent))
+	{
+		return SkinnedMeshComponent->SkeletalMesh;
+	}
+	return nullptr;
+}
+
+// Mesh the component floats, if any.
+static const UObject* GetBuoyantMesh(const UActorComponent* Component)
+{
+	if (const auto AdvancedBuoyantComponent = Cast<UAdvancedBuoyantComponent>(Component))
+	{
+		return GetMeshAsset(AdvancedBuoyantComponent->BuoyantMesh);
+	}
+	if (const auto BuoyantComponent = Cast<UBuoyantComponent>(Component))
+	{
+		return GetMeshAsset(BuoyantComponent->UpdatedComponent);
+	}
+	if (const auto BuoyantForceComponent = Cast<UBuoyantForceComponent>(Component))
+	{
+		return GetMeshAsset(BuoyantForceComponent->GetAttachParent());
+	}
+	// The buoyant mesh and destructible components are their own mesh.
+	return GetMeshAsset(Cast<USceneComponent>(Component));
+}
+
+// Adds the objects a component uses that aren't part of its own allocations: the hydrostatic table asset, and the
+// atlas of a baked water surface. Providers are instanced in their component, so a loaded copy of an atlas is unique
+// to it, while the pages of a mapped atlas are shared by every provider mapping the file.
+static void AddReferencedMemory(const UActorComponent* Component,
+                                SIZE_T& InOutUniqueBytes,
+                                TMap<FString, SIZE_T>& OutSharedObjects)
+{
+	if (const auto BuoyantMeshComponent = Cast<UBuoyantMeshComponent>(Component))
+	{
+		if (const auto HydrostaticTable = BuoyantMeshComponent->HydrostaticTable)
+		{
+			OutSharedObjects.Add(HydrostaticTable->GetPathName(),
+			                     HydrostaticTable->GetResourceSizeBytes(EResourceSizeMode::Exclusive));
+		}
+	}
+
+	ForEachObjectWithOuter(Component,
+	                       [&](UObject* Object) {
+		                       const auto BakedWaterSurface = Cast<UBakedWaterSurfaceProvider>(Object);
+		                       if (!BakedWaterSurface) return;
+
+		                       const auto& Atlas = BakedWaterSurface->GetAtlas();
+		                       if (Atlas.IsMapped())
+		                       {
+			                       OutSharedObjects.Add(UBakedWaterSurfaceProvider::GetAtlasPath(BakedWaterSurface->FileName),
+			                                            Atlas.GetSizeInBytes());
+		                       }
+		                       else
+		                       {
+			                       InOutUniqueBytes += Atlas.GetAllocatedSize();
+		                       }
+	                       },
+	                       false);
+}
+
+static double ToKilobytes(SIZE_T Bytes)
+{
+	return Bytes / 1024.0;
+}
+
+static void LogGroups(const TCHAR* Title, TMap<FString, FBuoyancyMemoryGroup>& Groups, FOutputDevice& Ar)
+{
+	TArray<FBuoyancyMemoryGroup> SortedGroups;
+	for (auto& Group : Groups)
+	{
+		Group.Value.Name = Group.Key;
+		SortedGroups.Add(Group.Value);
+	}
+	SortedGroups.Sort([](const FBuoyancyMemoryGroup& A, const FBuoyancyMemoryGroup& B) {
+		return A.UniqueBytes + A.GetSharedBytes() > B.UniqueBytes + B.GetSharedBytes();
+	});
+
+	Ar.Logf(TEXT("%s:"), Title);
+	Ar.Logf(TEXT("  %10s %12s %12s  %s"), TEXT("Components"), TEXT("Unique KB"), TEXT("Shared KB"), TEXT("Name"));
+	for (const auto& Group : SortedGroups)
+	{
+		Ar.Logf(TEXT("  %10d %12.1f %12.1f  %s"),
+		        Group.ComponentCount,
+		        ToKilobytes(Group.UniqueBytes),
+		        ToKilobytes(Group.GetSharedBytes()),
+		        *Group.Name);
+	}
+}
+
+static void ReportBuoyancyMemory(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+{
+	if (!World) return;
+
+	TMap<FString, FBuoyancyMemoryGroup> ComponentTypes;
+	TMap<FString, FBuoyancyMemoryGroup> Meshes;
+	FBuoyancyMemoryGroup Total;
+
+	for (TObjectIterator<UActorComponent> It; It; ++It)
+	{
+		const auto Component = *It;
+		if (Component->GetWorld() != World || Component->IsPendingKill()) continue;
+
+		SIZE_T UniqueBytes = 0;
+		if (!GetBuoyancyAllocatedSize(Component, UniqueBytes)) continue;
+
+		TMap<FString, SIZE_T> SharedObjects;
+		AddReferencedMemory(Component, UniqueBytes, SharedObjects);
+
+		const auto Mesh = GetBuoyantMesh(Component);
+		ComponentTypes.FindOrAdd(Component->GetClass()->GetName()).Add(UniqueBytes, SharedObjects);
+		Meshes.FindOrAdd(Mesh ? Mesh->GetPathName() : TEXT("None")).Add(UniqueBytes, SharedObjects);
+		Total.Add(UniqueBytes, SharedObjects);
+	}
+
+	Ar.Logf(TEXT("Buoyancy memory of %s: %d components, %.1f KB unique, %.1f KB shared."),
+	        *World->GetName(),
+	        Total.ComponentCount,
+	        ToKilobytes(Total.UniqueBytes),
+	        ToKilobytes(Total.GetSharedBytes()));
+	if (Total.ComponentCount == 0) return;
+
+	LogGroups(TEXT("By component type"), ComponentTypes, Ar);
+	LogGroups(TEXT("By mesh"), Meshes, Ar);
+
+	if (Total.SharedObjects.Num() > 0)
+	{
+		Ar.Logf(TEXT("Shared objects, counted once:"));
+		for (const auto& SharedObject : Total.SharedObjects)
+		{
+			Ar.Logf(TEXT("  %12.1f KB  %s"), ToKilobytes(SharedObject.Value), *SharedObject.Key);
+		}
+	}
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice BuoyancyMemReportCommand(
+    TEXT("buoyancy.MemReport"),
+    TEXT("Summarizes the memory of the buoyancy components of the world by component type and by mesh. Unique memory is ")
+        TEXT("allocated by each component, shared memory (hydrostatic tables, mapped water surface atlases) is counted ")
+        TEXT("once per group."),
+    FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&ReportBuoyancyMemory));
@@ -0,0 +1,233 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "BuoyancySubsystem.h"
+#include "Components/ActorComponent.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "PhysicsEngine/BodyInstance.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/PlatformTime.h"
+#include "BuoyancyStats.h"
+#include "BuoyancyTrace.h"
+
+
+DECLARE_CYCLE_STAT(TEXT("Buoyancy Subsystem Gather"), STAT_BuoyancySubsystemGather, STATGROUP_Buoyancy);
+DECLARE_CYCLE_STAT(TEXT("Buoyancy Subsystem Evaluate"), STAT_BuoyancySubsystemEvaluate, STATGROUP_Buoyancy);
+DECLARE_CYCLE_STAT(TEXT("Buoyancy Subsystem Apply"), STAT_BuoyancySubsystemApply, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Buoyancy Subsystem Bodies"), STAT_BuoyancySubsystemBodies, STATGROUP_Buoyancy);
+
+static TAutoConsoleVariable<int32> CVarUseSubsystem(
+    TEXT("buoyancy.UseSubsystem"),
+    0,
+    TEXT("Update the buoyant components from one parallel task per world instead of their own ticks.\n")
+        TEXT("Off by default. The forces are then applied in registration order before physics rather than in the ")
+        TEXT("tick order of the components. Read when the components begin play."));
+
+static TAutoConsoleVariable<int32> CVarMaxEvaluationTasks(
+    TEXT("buoyancy.MaxEvaluationTasks"),
+    0,
+    TEXT("Largest number of tasks the bodies of a world are evaluated in, so at most this many threads evaluate them at ")
+        TEXT("once. One of them runs on the game thread, with the bodies that can't be evaluated in parallel. 0 gives ")
+        TEXT("every body its own task, 1 evaluates every body on the game thread."));
+
+FBuoyantBodyState FBuoyantBodyState::FromBodyInstance(const FBodyInstance* BodyInstance)
+{
+	FBuoyantBodyState State;
+	if (BodyInstance && BodyInstance->IsValidBodyInstance())
+	{
+		State.CenterOfMass = BodyInstance->GetCOMPosition();
+		State.LinearVelocity = BodyInstance->GetUnrealWorldVelocity();
+		State.AngularVelocity = BodyInstance->GetUnrealWorldAngularVelocityInRadians();
+		State.Mass = BodyInstance->GetBodyMass();
+		State.Rotation = BodyInstance->GetUnrealWorldTransform().GetRotation();
+		State.Inertia = BodyInstance->GetBodyInertiaTensor();
+	}
+	return State;
+}
+
+bool FBuoyantBody::RegisterWithBuoyancySubsystem(UActorComponent* Component)
+{
+	check(Component);
+	if (Subsystem || CVarUseSubsystem.GetValueOnGameThread() == 0) return Subsystem != nullptr;
+
+	const auto World = Component->GetWorld();
+	Subsystem = World ? World->GetSubsystem<UBuoyancySubsystem>() : nullptr;
+	if (Subsystem)
+	{
+		Subsystem->Register(this, Component);
+	}
+	return Subsystem != nullptr;
+}
+
+bool FBuoyantBody::CanEvaluateBuoyancyWithNestedTasks()
+{
+	return CVarMaxEvaluationTasks.GetValueOnAnyThread() <= 0;
+}
+
+void FBuoyantBody::UnregisterFromBuoyancySubsystem()
+{
+	if (Subsystem)
+	{
+		Subsystem->Unregister(this);
+		Subsystem = nullptr;
+	}
+}
+
+void FBuoyantBody::AddBuoyancyPrerequisite(UObject* TargetObject, FTickFunction& TargetTickFunction)
+{
+	if (Subsystem)
+	{
+		Subsystem->AddPrerequisite(TargetObject, TargetTickFunction);
+	}
+}
+
+void FBuoyancySubsystemTickFunction::ExecuteTick(float DeltaTime,
+                                                 ELevelTick TickType,
+                                                 ENamedThreads::Type CurrentThread,
+                                                 const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && TickType != LEVELTICK_ViewportsOnly)
+	{
+		Target->Update(DeltaTime);
+	}
+}
+
+FString FBuoyancySubsystemTickFunction::DiagnosticMessage()
+{
+	return (Target ? Target->GetFullName() : TEXT("<NULL>")) + TEXT("[UpdateBuoyancy]");
+}
+
+void UBuoyancySubsystem::Deinitialize()
+{
+	if (TickFunction.IsTickFunctionRegistered())
+	{
+		TickFunction.UnRegisterTickFunction();
+	}
+	Bodies.Reset();
+
+	Super::Deinitialize();
+}
+
+void UBuoyancySubsystem::Register(FBuoyantBody* Body, UActorComponent* Component)
+{
+	check(IsInGameThread());
+	Bodies.Add(FRegisteredBody{Body, Component});
+
+	if (!TickFunction.IsTickFunctionRegistered())
+	{
+		// Forces have to be in before the physics step.
+		TickFunction.TickGroup = TG_PrePhysics;
+		TickFunction.EndTickGroup = TG_PrePhysics;
+		TickFunction.bCanEverTick = true;
+		TickFunction.bStartWithTickEnabled = true;
+		TickFunction.Target = this;
+		TickFunction.RegisterTickFunction(GetWorld()->PersistentLevel);
+	}
+}
+
+void UBuoyancySubsystem::Unregister(FBuoyantBody* Body)
+{
+	check(IsInGameThread());
+	Bodies.RemoveAll([Body](const FRegisteredBody& Registered) { return Registered.Body == Body; });
+}
+
+void UBuoyancySubsystem::AddPrerequisite(UObject* TargetObject, FTickFunction& TargetTickFunction)
+{
+	TickFunction.AddPrerequisite(TargetObject, TargetTickFunction);
+}
+
+int32 UBuoyancySubsystem::GetBodyCount() const
+{
+	return Bodies.Num();
+}
+
+int32 UBuoyancySubsystem::GetLastGameThreadBodyCount() const
+{
+	return GameThreadBodies.Num();
+}
+
+void UBuoyancySubsystem::Update(float DeltaTime)
+{
+	const auto StartSeconds = FPlatformTime::Seconds();
+	INC_DWORD_STAT_BY(STAT_BuoyancySubsystemBodies, Bodies.Num());
+
+	GatheredBodies.Reset();
+	ParallelBodies.Reset();
+	GameThreadBodies.Reset();
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BuoyancySubsystemGather);
+		BUOYANCY_TRACE_PHASE_SCOPE("UBuoyancySubsystem::Gather");
+		for (int32 i = 0; i < Bodies.Num(); ++i)
+		{
+			const auto Component = Bodies[i].Component.Get();
+			if (!Component || !Component->IsActive()) continue;
+
+			BUOYANCY_TRACE_BODY_EVENT(Bodies[i].TraceEventType, Component);
+			if (!Bodies[i].Body->GatherBuoyancy(DeltaTime)) continue;
+
+			GatheredBodies.Add(i);
+			(Bodies[i].Body->CanEvaluateBuoyancyInParallel() ? ParallelBodies : GameThreadBodies).Add(i);
+		}
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BuoyancySubsystemEvaluate);
+		const auto EvaluateBody = [this](int32 BodyIndex) {
+			auto& Registered = Bodies[BodyIndex];
+			BUOYANCY_TRACE_BODY_SCOPE(Registered.TraceEventType, Registered.Component.Get());
+			Registered.Body->EvaluateBuoyancy();
+		};
+		const auto EvaluateBodies = [&](TArrayView<const int32> BodyIndices) {
+			BUOYANCY_TRACE_PHASE_SCOPE("UBuoyancySubsystem::Evaluate");
+			for (const auto BodyIndex : BodyIndices)
+			{
+				EvaluateBody(BodyIndex);
+			}
+		};
+
+		// Each task evaluates a contiguous range of the parallel bodies. The workers run all but the last, which the
+		// game thread runs after the bodies that can't be evaluated in parallel. A single task runs on the game thread.
+		const auto MaxTaskCount = CVarMaxEvaluationTasks.GetValueOnGameThread();
+		const auto TaskCount = MaxTaskCount > 0 ? FMath::Min(MaxTaskCount, ParallelBodies.Num()) : ParallelBodies.Num();
+		const auto GetTaskBodies = [this, TaskCount](int32 Task) {
+			const auto FirstBody = ParallelBodies.Num() * Task / TaskCount;
+			const auto EndBody = ParallelBodies.Num() * (Task + 1) / TaskCount;
+			return MakeArrayView(ParallelBodies).Slice(FirstBody, EndBody - FirstBody);
+		};
+		FGraphEventArray Tasks;
+		for (int32 Task = 0; Task < TaskCount - 1; ++Task)
+		{
+			Tasks.Add(FFunctionGraphTask::CreateAndDispatchWhenReady(
+			    [&EvaluateBodies, TaskBodies = GetTaskBodies(Task)]() { EvaluateBodies(TaskBodies); },
+			    TStatId(),
+			    nullptr,
+			    ENamedThreads::AnyThread));
+		}
+		EvaluateBodies(GameThreadBodies);
+		if (TaskCount > 0)
+		{
+			EvaluateBodies(GetTaskBodies(TaskCount - 1));
+		}
+		FTaskGraphInterface::Get().WaitUntilTasksComplete(Tasks, ENamedThreads::GameThread);
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BuoyancySubsystemApply);
+		BUOYANCY_TRACE_PHASE_SCOPE("UBuoyancySubsystem::Apply");
+		for (const auto BodyIndex : GatheredBodies)
+		{
+			auto& Registered = Bodies[BodyIndex];
+			BUOYANCY_TRACE_BODY_EVENT(Registered.TraceEventType, Registered.Component.Get());
+			Registered.Body->ApplyBuoyancy();
+		}
+	}
+
+	LastUpdateSeconds = FPlatformTime::Seconds() - StartSeconds;
+}
+
+double UBuoyancySubsystem::GetLastUpdateSeconds() const
+{
+	return LastUpdateSeconds;
+}
@@ -0,0 +1,96 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "BuoyancyTrace.h"
+
+#if BUOYANCY_TRACE_ENABLED
+
+#include "Components/ActorComponent.h"
+#include "GameFramework/Actor.h"
+
+
+UE_TRACE_CHANNEL_DEFINE(BuoyancyChannel)
+
+UE_TRACE_EVENT_BEGIN(Buoyancy, BodyUpdate)
+	UE_TRACE_EVENT_FIELD(uint64, StartCycle)
+	UE_TRACE_EVENT_FIELD(uint64, EndCycle)
+	UE_TRACE_EVENT_FIELD(uint32, TriangleCount)
+	UE_TRACE_EVENT_FIELD(uint32, SubtriangleCount)
+	UE_TRACE_EVENT_FIELD(uint32, WaterQueryCount)
+	UE_TRACE_EVENT_FIELD(float, ForceMagnitude)
+	UE_TRACE_EVENT_FIELD(Trace::WideString, ActorName)
+	UE_TRACE_EVENT_FIELD(Trace::WideString, ComponentType)
+UE_TRACE_EVENT_END()
+
+FBuoyancyTraceScope*& FBuoyancyTraceScope::GetCurrentScope()
+{
+	static thread_local FBuoyancyTraceScope* CurrentScope = nullptr;
+	return CurrentScope;
+}
+
+FBuoyancyTraceScope::FBuoyancyTraceScope(const UActorComponent* Component)
+    : Component{Component}, OuterScope{GetCurrentScope()}, StartCycle{FPlatformTime::Cycles64()}
+{
+	GetCurrentScope() = this;
+}
+
+FBuoyancyTraceScope::~FBuoyancyTraceScope()
+{
+	GetCurrentScope() = OuterScope;
+
+	const auto Owner = Component ? Component->GetOwner() : nullptr;
+	const auto ActorName = Owner ? Owner->GetName() : FString{};
+	const auto ComponentType = Component ? Component->GetClass()->GetName() : FString{};
+
+	UE_TRACE_LOG(Buoyancy, BodyUpdate, BuoyancyChannel)
+	    << BodyUpdate.StartCycle(StartCycle) << BodyUpdate.EndCycle(FPlatformTime::Cycles64())
+	    << BodyUpdate.TriangleCount(TriangleCount) << BodyUpdate.SubtriangleCount(SubtriangleCount)
+	    << BodyUpdate.WaterQueryCount(WaterQueryCount) << BodyUpdate.ForceMagnitude(TotalForce.Size())
+	    << BodyUpdate.ActorName(*ActorName, ActorName.Len())
+	    << BodyUpdate.ComponentType(*ComponentType, ComponentType.Len());
+}
+
+void FBuoyancyTraceScope::AddTriangles(int32 Count)
+{
+	if (const auto Scope = GetCurrentScope()) Scope->TriangleCount += Count;
+}
+
+void FBuoyancyTraceScope::AddSubtriangles(int32 Count)
+{
+	if (const auto Scope = GetCurrentScope()) Scope->SubtriangleCount += Count;
+}
+
+void FBuoyancyTraceScope::AddWaterQueries(int32 Count)
+{
+	if (const auto Scope = GetCurrentScope()) Scope->WaterQueryCount += Count;
+}
+
+void FBuoyancyTraceScope::AddForce(const FVector& Force)
+{
+	if (const auto Scope = GetCurrentScope()) Scope->TotalForce += Force;
+}
+
+FBuoyancyTraceEventScope::FBuoyancyTraceEventScope(uint32& EventType, const UActorComponent* Component)
+    : bEnabled{UE_TRACE_CHANNELEXPR_IS_ENABLED(CpuChannel | BuoyancyChannel)}
+{
+	if (!bEnabled) return;
+
+	if (EventType == 0)
+	{
+		const auto Owner = Component ? Component->GetOwner() : nullptr;
+		const auto ComponentName = Component ? Component->GetName() : FString{TEXT("<NULL>")};
+		const auto Name = Owner ? Owner->GetName() + TEXT(".") + ComponentName : ComponentName;
+		EventType = FCpuProfilerTrace::OutputEventType(*Name);
+	}
+	FCpuProfilerTrace::OutputBeginEvent(EventType);
+}
+
+FBuoyancyTraceEventScope::~FBuoyancyTraceEventScope()
+{
+	if (bEnabled)
+	{
+		FCpuProfilerTrace::OutputEndEvent();
+	}
+}
+
+#endif // BUOYANCY_TRACE_ENABLED
@@ -0,0 +1,136 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+
+class UActorComponent;
+
+/*
+
+Unreal Insights trace channel of the buoyancy components. Enable it with -trace=cpu,buoyancy (and -tracehost=<address>
+on a headless server, or "Trace.Enable buoyancy" at runtime).
+
+Each component update shows up as a timing event named after the component class on the CPU track of its thread, and
+emits a Buoyancy.BodyUpdate event with the actor name, component type, triangle and submerged subtriangle counts, water
+queries issued and the magnitude of the resulting force.
+
+Updates run by UBuoyancySubsystem are traced per body instead: the Gather, Evaluate and Apply phases each show up as a
+UBuoyancySubsystem::<Phase> event, around one event per body named after its actor and component. The Evaluate events
+are on the worker that evaluated the body and carry the Buoyancy.BodyUpdate payload.
+
+While the channel is disabled a scope costs a single branch and the counters aren't touched.
+
+*/
+
+#if UE_TRACE_ENABLED && !UE_BUILD_SHIPPING
+#define BUOYANCY_TRACE_ENABLED 1
+#else
+#define BUOYANCY_TRACE_ENABLED 0
+#endif
+
+#if BUOYANCY_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_EXTERN(BuoyancyChannel);
+
+// Collects the payload of one component update and emits it when destroyed.
+// The counters are added to the innermost scope of the calling thread, so they can be called from any function the
+// update goes through.
+class FBuoyancyTraceScope
+{
+   public:
+	explicit FBuoyancyTraceScope(const UActorComponent* Component);
+	~FBuoyancyTraceScope();
+
+	static void AddTriangles(int32 Count);
+	static void AddSubtriangles(int32 Count);
+	static void AddWaterQueries(int32 Count);
+	static void AddForce(const FVector& Force);
+
+   private:
+	const UActorComponent* const Component;
+	FBuoyancyTraceScope* const OuterScope;
+	const uint64 StartCycle;
+
+	uint32 TriangleCount = 0;
+	uint32 SubtriangleCount = 0;
+	uint32 WaterQueryCount = 0;
+	FVector TotalForce = FVector::ZeroVector;
+
+	static FBuoyancyTraceScope*& GetCurrentScope();
+
+	FBuoyancyTraceScope(const FBuoyancyTraceScope&) = delete;
+	FBuoyancyTraceScope& operator=(const FBuoyancyTraceScope&) = delete;
+};
+
+// Times the enclosing scope as an event named "<Actor>.<Component>". The event type is registered the first time and
+// kept in EventType, which starts at 0 and must only be used by one thread at a time.
+class FBuoyancyTraceEventScope
+{
+   public:
+	FBuoyancyTraceEventScope(uint32& EventType, const UActorComponent* Component);
+	~FBuoyancyTraceEventScope();
+
+   private:
+	const bool bEnabled;
+
+	FBuoyancyTraceEventScope(const FBuoyancyTraceEventScope&) = delete;
+	FBuoyancyTraceEventScope& operator=(const FBuoyancyTraceEventScope&) = delete;
+};
+
+// Traces the rest of the enclosing scope as an update of Component. Name needs to be a string literal.
+#define BUOYANCY_TRACE_SCOPE(Name, Component)                              \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR(Name, BuoyancyChannel); \
+	TOptional<FBuoyancyTraceScope> BuoyancyTraceScope;                   \
+	if (UE_TRACE_CHANNELEXPR_IS_ENABLED(BuoyancyChannel))                \
+	{                                                                    \
+		BuoyancyTraceScope.Emplace(Component);                           \
+	}
+
+// Traces the rest of the enclosing scope as a phase of a subsystem update. Name needs to be a string literal.
+#define BUOYANCY_TRACE_PHASE_SCOPE(Name) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR(Name, BuoyancyChannel);
+
+// Traces the rest of the enclosing scope as the part of a phase spent on the body of Component, see
+// FBuoyancyTraceEventScope for EventType.
+#define BUOYANCY_TRACE_BODY_EVENT(EventType, Component) \
+	FBuoyancyTraceEventScope BuoyancyTraceEventScope{EventType, Component};
+
+// Same as BUOYANCY_TRACE_BODY_EVENT, also emitting the payload of BUOYANCY_TRACE_SCOPE.
+#define BUOYANCY_TRACE_BODY_SCOPE(EventType, Component)       \
+	BUOYANCY_TRACE_BODY_EVENT(EventType, Component)           \
+	TOptional<FBuoyancyTraceScope> BuoyancyTraceScope;        \
+	if (UE_TRACE_CHANNELEXPR_IS_ENABLED(BuoyancyChannel))     \
+	{                                                         \
+		BuoyancyTraceScope.Emplace(Component);                \
+	}
+
+#define BUOYANCY_TRACE_COUNTER(Function, Value)               \
+	do                                                        \
+	{                                                         \
+		if (UE_TRACE_CHANNELEXPR_IS_ENABLED(BuoyancyChannel)) \
+		{                                                     \
+			FBuoyancyTraceScope::Function(Value);             \
+		}                                                     \
+	} while (0)
+
+#define BUOYANCY_TRACE_TRIANGLES(Count) BUOYANCY_TRACE_COUNTER(AddTriangles, Count)
+#define BUOYANCY_TRACE_SUBTRIANGLES(Count) BUOYANCY_TRACE_COUNTER(AddSubtriangles, Count)
+#define BUOYANCY_TRACE_WATER_QUERIES(Count) BUOYANCY_TRACE_COUNTER(AddWaterQueries, Count)
+#define BUOYANCY_TRACE_FORCE(Force) BUOYANCY_TRACE_COUNTER(AddForce, Force)
+
+#else
+
+#define BUOYANCY_TRACE_SCOPE(Name, Component)
+#define BUOYANCY_TRACE_PHASE_SCOPE(Name)
+#define BUOYANCY_TRACE_BODY_EVENT(EventType, Component)
+#define BUOYANCY_TRACE_BODY_SCOPE(EventType, Component)
+#define BUOYANCY_TRACE_TRIANGLES(Count)
+#define BUOYANCY_TRACE_SUBTRIANGLES(Count)
+#define BUOYANCY_TRACE_WATER_QUERIES(Count)
+#define BUOYANCY_TRACE_FORCE(Force)
+
+#endif // BUOYANCY_TRACE_ENABLED
@@ -0,0 +1,40 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "BuoyantChunkBudget.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+
+static TAutoConsoleVariable<int32> CVarMaxActiveChunks(
+    TEXT("buoyancy.MaxActiveChunks"),
+    0,
+    TEXT("Most buoyant destructible chunks evaluated in full per world and frame, shared between the components.\n")
+        TEXT("0 for no global budget."));
+
+TMap<TWeakObjectPtr<const UWorld>, FBuoyantChunkBudget::FWorldBudget> FBuoyantChunkBudget::WorldBudgets;
+
+int32 FBuoyantChunkBudget::Request(const UWorld* World, int32 Demand)
+{
+	check(IsInGameThread());
+
+	const auto MaxActiveChunks = CVarMaxActiveChunks.GetValueOnGameThread();
+	if (MaxActiveChunks <= 0 || !World) return Demand;
+
+	for (auto It = WorldBudgets.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid()) It.RemoveCurrent();
+	}
+
+	auto& Budget = WorldBudgets.FindOrAdd(World);
+	if (Budget.Frame != GFrameCounter)
+	{
+		Budget.PreviousDemand = Budget.Demand;
+		Budget.Demand = 0;
+		Budget.Frame = GFrameCounter;
+	}
+	Budget.Demand += Demand;
+
+	if (Budget.PreviousDemand <= MaxActiveChunks) return FMath::Min(Demand, MaxActiveChunks);
+	return static_cast<int32>(static_cast<int64>(MaxActiveChunks) * Demand / Budget.PreviousDemand);
+}
@@ -7,6 +7,7 @@
 #include "Components/PrimitiveComponent.h"
 #include "PhysicsEngine/PhysicsConstraintComponent.h"
 #include "PhysicsEngine/ConstraintInstance.h"
+#include "BuoyancyTrace.h"
 
 
 UBuoyantComponent::UBuoyantComponent(const class FObjectInitializer& ObjectInitializer)
@@ -51,39 +52,79 @@ void UBuoyantComponent::BeginPlay()
 	Super::BeginPlay();
 
 	ApplyUprightConstraint();
+
+	if (RegisterWithBuoyancySubsystem(this))
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UBuoyantComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterFromBuoyancySubsystem();
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void UBuoyantComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	BUOYANCY_TRACE_SCOPE("UBuoyantComponent", this);
+
+	if (GatherBuoyancy(DeltaTime))
+	{
+		EvaluateBuoyancy();
+		ApplyBuoyancy();
+	}
+}
+
+bool UBuoyantComponent::GatherBuoyancy(float DeltaTime)
 {
 	// Make sure everything is valid
-	if (!OceanManager || !UpdatedComponent || !UpdatedPrimitive) return;
+	if (!UpdatedComponent || !UpdatedPrimitive) return false;
+
+	GatheredWaterSurface = FWaterSurfaceProviders::Resolve(WaterSurfaceProvider, this, OceanManager);
+	if (!GatheredWaterSurface) return false;
+	GatheredWaterTime = GetWorld()->GetTimeSeconds();
 
 	// No physics
 	if (!UpdatedComponent->IsSimulatingPhysics())
 	{
-		const FVector WaveHeight = OceanManager->GetWaveHeightValue(UpdatedComponent->GetComponentLocation());
-		UpdatedPrimitive->SetWorldLocation(FVector(UpdatedComponent->GetComponentLocation().X, UpdatedComponent->GetComponentLocation().Y, WaveHeight.Z), true);
-		return;
+		BUOYANCY_TRACE_WATER_QUERIES(1);
+		const float WaveHeight = GatheredWaterSurface->GetWaterHeight(UpdatedComponent->GetComponentLocation(), GatheredWaterTime);
+		UpdatedPrimitive->SetWorldLocation(FVector(UpdatedComponent->GetComponentLocation().X, UpdatedComponent->GetComponentLocation().Y, WaveHeight), true);
+		return false;
 	}
 
 	// Buoyant
+	if (TestPoints.Num() < 1) return false;
+
+	GatheredTransform = UpdatedComponent->GetComponentTransform();
+	GatheredBody = FBuoyantBodyState::FromBodyInstance(UpdatedPrimitive->GetBodyInstance());
+	GatheredGravityZ = GetGravityZ();
+	return true;
+}
+
+void UBuoyantComponent::EvaluateBuoyancy()
+{
 	const float TotalPoints = TestPoints.Num();
-	if (TotalPoints < 1) return;
+	PointPositions.SetNumUninitialized(TestPoints.Num());
+	PointForces.SetNumUninitialized(TestPoints.Num());
+	PointUnderwaterFlags.SetNumUninitialized(TestPoints.Num());
+	PointsUnderWaterCount = 0;
 
-	int PointsUnderWater = 0;
 	for (int PointIndex = 0; PointIndex < TotalPoints; PointIndex++)
 	{
-		if (!TestPoints.IsValidIndex(PointIndex)) return; // Array size changed during runtime
-
 		bool bIsUnderwater = false;
 		FVector TestPoint = TestPoints[PointIndex];
-		FVector WorldTestPoint = UpdatedComponent->GetComponentTransform().TransformPosition(TestPoint);
-		const float WaveHeight = OceanManager->GetWaveHeightValue(WorldTestPoint).Z;
+		FVector WorldTestPoint = GatheredTransform.TransformPosition(TestPoint);
+		BUOYANCY_TRACE_WATER_QUERIES(1);
+		const float WaveHeight = GatheredWaterSurface->GetWaterHeight(WorldTestPoint, GatheredWaterTime);
+		FVector Force = FVector::ZeroVector;
 
 		// If test point radius is touching water add Buoyant force
 		if (WaveHeight > (WorldTestPoint.Z + SignedRadius))
 		{
-			PointsUnderWater++;
+			PointsUnderWaterCount++;
 			bIsUnderwater = true;
 
 			float DepthMultiplier = (WaveHeight - (WorldTestPoint.Z + SignedRadius)) / (TestPointRadius * 2);
@@ -97,32 +138,53 @@ void UBuoyantComponent::TickComponent(float DeltaTime, enum ELevelTick TickType,
 			* Buoyant force formula: (Volume(Mass / Density) * Fluid Density * -Gravity) / Total Points * Depth Multiplier
 			* --------
 			*/
-			const float BuoyantForceZ = UpdatedPrimitive->GetMass() / PointDensity * FluidDensity * -GetGravityZ() / TotalPoints * DepthMultiplier;
+			const float BuoyantForceZ = GatheredBody.Mass / PointDensity * FluidDensity * -GatheredGravityZ / TotalPoints * DepthMultiplier;
 
-			// Experimental velocity damping using GetUnrealWorldVelocityAtPoint!
-			FVector DampingForce = -GetVelocityAtPoint(UpdatedPrimitive, WorldTestPoint) * VelocityDamper * UpdatedPrimitive->GetMass() * DepthMultiplier;
+			// Experimental velocity damping using the velocity at the test point
+			const FVector PointVelocity = GatheredBody.GetVelocityAtPoint(WorldTestPoint);
+			FVector DampingForce = -PointVelocity * VelocityDamper * GatheredBody.Mass * DepthMultiplier;
 
 			// Wave push force
 			if (EnableWaveForces)
 			{
-				const float WaveVelocity = FMath::Clamp(GetVelocityAtPoint(UpdatedPrimitive, WorldTestPoint).Z, -20.f, 150.f) * (1 - DepthMultiplier);
-				DampingForce += FVector(OceanManager->GlobalWaveDirection.X, OceanManager->GlobalWaveDirection.Y, 0) * UpdatedPrimitive->GetMass() * WaveVelocity * WaveForceMultiplier / TotalPoints;
+				const float WaveVelocity = FMath::Clamp(PointVelocity.Z, -20.f, 150.f) * (1 - DepthMultiplier);
+				const FVector2D WaveDirection = GatheredWaterSurface->GetWaveDirection();
+				DampingForce += FVector(WaveDirection.X, WaveDirection.Y, 0) * GatheredBody.Mass * WaveVelocity * WaveForceMultiplier / TotalPoints;
 			}
 
-			// Add force for this test point
-			UpdatedPrimitive->AddForceAtLocation(FVector(DampingForce.X, DampingForce.Y, DampingForce.Z + BuoyantForceZ), WorldTestPoint);
+			Force = FVector(DampingForce.X, DampingForce.Y, DampingForce.Z + BuoyantForceZ);
+			BUOYANCY_TRACE_FORCE(Force);
+		}
+
+		PointPositions[PointIndex] = WorldTestPoint;
+		PointForces[PointIndex] = Force;
+		PointUnderwaterFlags[PointIndex] = bIsUnderwater;
+	}
+}
+
+void UBuoyantComponent::ApplyBuoyancy()
+{
+	if (!UpdatedPrimitive) return;
+
+	const float TotalPoints = PointForces.Num();
+	for (int PointIndex = 0; PointIndex < PointForces.Num(); PointIndex++)
+	{
+		// Add force for this test point
+		if (PointUnderwaterFlags[PointIndex])
+		{
+			UpdatedPrimitive->AddForceAtLocation(PointForces[PointIndex], PointPositions[PointIndex]);
 		}
 
 		if (DrawDebugPoints)
 		{
 			FColor DebugColor = FLinearColor(0.8, 0.7, 0.2, 0.8).ToRGBE();
-			if (bIsUnderwater) { DebugColor = FLinearColor(0, 0.2, 0.7, 0.8).ToRGBE(); } //Blue color underwater, yellow out of watter
-			DrawDebugSphere(GetWorld(), WorldTestPoint, TestPointRadius, 8, DebugColor);
+			if (PointUnderwaterFlags[PointIndex]) { DebugColor = FLinearColor(0, 0.2, 0.7, 0.8).ToRGBE(); } //Blue color underwater, yellow out of watter
+			DrawDebugSphere(GetWorld(), PointPositions[PointIndex], TestPointRadius, 8, DebugColor);
 		}
 	}
 
 	// Clamp the velocity to MaxUnderwaterVelocity if there is any point underwater
-	if (ClampMaxVelocity && PointsUnderWater > 0
+	if (ClampMaxVelocity && PointsUnderWaterCount > 0
 		&& UpdatedPrimitive->GetPhysicsLinearVelocity().Size() > MaxUnderwaterVelocity)
 	{
 		const FVector LastVelocity = UpdatedPrimitive->GetPhysicsLinearVelocity().GetSafeNormal() * MaxUnderwaterVelocity;
@@ -130,8 +192,26 @@ void UBuoyantComponent::TickComponent(float DeltaTime, enum ELevelTick TickType,
 	}
 
 	// Update damping based on number of underwater test points
-	UpdatedPrimitive->SetLinearDamping(BaseLinearDamping + FluidLinearDamping / TotalPoints * PointsUnderWater);
-	UpdatedPrimitive->SetAngularDamping(BaseAngularDamping + FluidAngularDamping / TotalPoints * PointsUnderWater);
+	UpdatedPrimitive->SetLinearDamping(BaseLinearDamping + FluidLinearDamping / TotalPoints * PointsUnderWaterCount);
+	UpdatedPrimitive->SetAngularDamping(BaseAngularDamping + FluidAngularDamping / TotalPoints * PointsUnderWaterCount);
+}
+
+bool UBuoyantComponent::CanEvaluateBuoyancyInParallel() const
+{
+	// The evaluation queries the water surface.
+	return FWaterSurfaceProviders::CanQueryFromAnyThread(GatheredWaterSurface);
+}
+
+void UBuoyantComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetBuoyancyAllocatedSize());
+}
+
+SIZE_T UBuoyantComponent::GetBuoyancyAllocatedSize() const
+{
+	return TestPoints.GetAllocatedSize() + PointDensityOverride.GetAllocatedSize() + PointPositions.GetAllocatedSize() +
+		PointForces.GetAllocatedSize() + PointUnderwaterFlags.GetAllocatedSize();
 }
 
 FVector UBuoyantComponent::GetVelocityAtPoint(UPrimitiveComponent* Target, FVector Point, FName BoneName)
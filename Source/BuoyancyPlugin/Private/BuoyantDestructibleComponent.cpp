@@ -7,6 +7,22 @@
 #include "EngineUtils.h"
 #include "PhysXIncludes.h" 
 #include "PhysXPublic.h"
+#include "GameFramework/PlayerController.h"
+#include "Async/ParallelFor.h"
+#include "BuoyantChunkBudget.h"
+#include "BuoyancyStats.h"
+#include "BuoyancyTrace.h"
+
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Buoyant Destructible Chunks"), STAT_BuoyantDestructibleChunks, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Buoyant Destructible Chunk Writes"), STAT_BuoyantDestructibleChunkWrites, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Buoyant Destructible Active Chunks"), STAT_BuoyantDestructibleActiveChunks, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Buoyant Destructible Simplified Chunks"), STAT_BuoyantDestructibleSimplifiedChunks, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Buoyant Destructible Frozen Chunks"), STAT_BuoyantDestructibleFrozenChunks, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Buoyant Destructible Culled Chunks"), STAT_BuoyantDestructibleCulledChunks, STATGROUP_Buoyancy);
+
+//Below this many visible chunks, the chunk forces are evaluated on the game thread.
+static const int32 MinChunksForParallelEvaluation = 32;
 
 
 UBuoyantDestructibleComponent::UBuoyantDestructibleComponent(const class FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
@@ -14,6 +30,11 @@ UBuoyantDestructibleComponent::UBuoyantDestructibleComponent(const class FObject
 	PrimaryComponentTick.bCanEverTick = true;
 	bWantsInitializeComponent = true;
 	bAutoActivate = true;
+	WaterSurfaceProvider = nullptr;
+	WaterSurface = nullptr;
+#if WITH_PHYSX
+	PScene = nullptr;
+#endif // WITH_PHYSX
 
 	//Defaults
 	ChunkDensity = 600.0f;
@@ -29,6 +50,11 @@ UBuoyantDestructibleComponent::UBuoyantDestructibleComponent(const class FObject
 	ChunkStabilizationThreshold = 10.0f;
 
 	WaveForceMultiplier = 2.0f;
+
+	SmallChunkUpdateInterval = 4;
+	SettleLinearSpeed = 5.0f;
+	SettleAngularSpeed = 0.1f;
+	SettleTime = 2.0f;
 }
 
 void UBuoyantDestructibleComponent::InitializeComponent()
@@ -47,93 +73,355 @@ void UBuoyantDestructibleComponent::InitializeComponent()
 	
 	_baseLinearDamping = GetLinearDamping();
 	_baseAngularDamping = GetAngularDamping();
+
+	OnComponentFracture.AddUniqueDynamic(this, &UBuoyantDestructibleComponent::HandleFracture);
+}
+
+void UBuoyantDestructibleComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (RegisterWithBuoyancySubsystem(this))
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UBuoyantDestructibleComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterFromBuoyancySubsystem();
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void UBuoyantDestructibleComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	if (!OceanManager)
-		return;
+	BUOYANCY_TRACE_SCOPE("UBuoyantDestructibleComponent", this);
+
+	if (GatherBuoyancy(DeltaTime))
+	{
+		EvaluateBuoyancy();
+		ApplyBuoyancy();
+	}
+}
+
+bool UBuoyantDestructibleComponent::GatherBuoyancy(float DeltaTime)
+{
+	WaterSurface = FWaterSurfaceProviders::Resolve(WaterSurfaceProvider, this, OceanManager);
+	if (!WaterSurface)
+		return false;
+	WaterTime = GetWorld()->GetTimeSeconds();
+	GatheredDeltaTime = DeltaTime;
 
-	float Gravity = GetPhysicsVolume()->GetGravityZ();
+	GatheredGravity = GetPhysicsVolume()->GetGravityZ();
 	TestPointRadius = FMath::Abs(TestPointRadius);
 
 	//Signed based on gravity, just in case we need an upside down world
-	_SignedRadius = FMath::Sign(Gravity) * TestPointRadius;
+	_SignedRadius = FMath::Sign(GatheredGravity) * TestPointRadius;
 
 #if WITH_PHYSX
-	uint32 ChunkCount = ApexDestructibleActor->getNumVisibleChunks();
+	uint32 ChunkCount = ApexDestructibleActor ? ApexDestructibleActor->getNumVisibleChunks() : 0;
+	if (ChunkCount == 0)
+		return false;
 	const uint16* ChunkIndices = ApexDestructibleActor->getVisibleChunks();
-	for (uint32 c = 0; c < ChunkCount; c++)
-	{
-		PxRigidDynamic* Chunk = ApexDestructibleActor->getChunkPhysXActor(ChunkIndices[c]);
-		check(Chunk);
 
-		if (Chunk)
+	PxRigidDynamic* FirstChunk = ApexDestructibleActor->getChunkPhysXActor(ChunkIndices[0]);
+	PScene = FirstChunk ? FirstChunk->getScene() : nullptr;
+	if (!PScene)
+		return false;
+
+	//A settings change has to reach every chunk, forget what was written.
+	const float LinearDamping = _baseLinearDamping + FluidLinearDamping;
+	const float AngularDamping = _baseAngularDamping + FluidAngularDamping;
+	if (AppliedSleepThreshold != ChunkSleepThreshold || AppliedStabilizationThreshold != ChunkStabilizationThreshold
+		|| AppliedLinearDamping != LinearDamping || AppliedAngularDamping != AngularDamping)
+	{
+		for (FChunkState& State : ChunkStates)
 		{
-			PxTransform Trans = Chunk->getGlobalPose();
-			PxTransform MassTrans = Chunk->getCMassLocalPose();
-			PxVec3 PxLoc = Trans.p + Trans.rotate(MassTrans.p);
+			State.bPropertiesWritten = false;
+		}
+		AppliedSleepThreshold = ChunkSleepThreshold;
+		AppliedStabilizationThreshold = ChunkStabilizationThreshold;
+		AppliedLinearDamping = LinearDamping;
+		AppliedAngularDamping = AngularDamping;
+	}
 
-			FVector Location = P2UVector(PxLoc);
+	//Viewers, for the distance culling and the budget priority.
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+	for (auto Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		APlayerController* PlayerController = Iterator->Get();
+		if (!PlayerController) continue;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		ViewLocations.Add(ViewLocation);
+	}
 
-			float waveHeight = OceanManager->GetWaveHeightValue(Location).Z;
-			bool isUnderwater = false;
+	//Read the pose of every visible chunk in one pass.
+	ChunkEvaluations.Reset();
+	{
+		SCOPED_SCENE_READ_LOCK(PScene);
+		for (uint32 c = 0; c < ChunkCount; c++)
+		{
+			PxRigidDynamic* Chunk = ApexDestructibleActor->getChunkPhysXActor(ChunkIndices[c]);
+			check(Chunk);
 
-			//If test point radius is touching water add Buoyant force
-			if (waveHeight > (Location.Z + _SignedRadius))
+			if (Chunk)
 			{
-				isUnderwater = true;
+				PxTransform Trans = Chunk->getGlobalPose();
+				PxTransform MassTrans = Chunk->getCMassLocalPose();
+				PxVec3 PxLoc = Trans.p + Trans.rotate(MassTrans.p);
+
+				FChunkEvaluation& Evaluation = ChunkEvaluations[ChunkEvaluations.AddUninitialized()];
+				Evaluation.Actor = Chunk;
+				Evaluation.ChunkIndex = ChunkIndices[c];
+				Evaluation.Location = P2UVector(PxLoc);
+				Evaluation.Velocity = P2UVector(Chunk->getLinearVelocity());
+				Evaluation.AngularSpeed = Chunk->getAngularVelocity().magnitude();
+				Evaluation.Mass = Chunk->getMass();
+				Evaluation.bSmall = SmallChunkSize > 0.f && P2UVector(Chunk->getWorldBounds().getExtents()).GetMax() * 2.f < SmallChunkSize;
+				Evaluation.DistanceSquared = TNumericLimits<float>::Max();
+				for (const FVector& ViewLocation : ViewLocations)
+				{
+					Evaluation.DistanceSquared = FMath::Min(Evaluation.DistanceSquared, FVector::DistSquared(ViewLocation, Evaluation.Location));
+				}
+				Evaluation.bUnderwater = false;
+
+				if (!ChunkStates.IsValidIndex(Evaluation.ChunkIndex))
+				{
+					ChunkStates.SetNum(Evaluation.ChunkIndex + 1);
+				}
+			}
+		}
+	}
+
+	const int32 EvaluationCount = ChunkEvaluations.Num();
+	INC_DWORD_STAT_BY(STAT_BuoyantDestructibleChunks, EvaluationCount);
+
+	UpdateChunkTiers(ViewLocations.Num() > 0);
+
+	//Sample the water under all the chunks that need it in one batch, the others keep their last sample.
+	SampledChunks.Reset();
+	ChunkLocations.Reset();
+	for (int32 i = 0; i < EvaluationCount; i++)
+	{
+		FChunkEvaluation& Evaluation = ChunkEvaluations[i];
+		FChunkState& State = ChunkStates[Evaluation.ChunkIndex];
+
+		Evaluation.bSampleWater = Evaluation.Tier == EChunkTier::Active || Evaluation.Tier == EChunkTier::Frozen
+			|| (Evaluation.Tier == EChunkTier::Simplified && (State.Tier != EChunkTier::Simplified || State.TicksSinceWaterSample + 1 >= SmallChunkUpdateInterval));
+		Evaluation.WaterHeight = State.LastWaterHeight;
+		State.TicksSinceWaterSample = Evaluation.bSampleWater ? 0 : State.TicksSinceWaterSample + 1;
+
+		if (Evaluation.bSampleWater)
+		{
+			SampledChunks.Add(i);
+			ChunkLocations.Add(Evaluation.Location);
+		}
+	}
+	return true;
+#else
+	return false;
+#endif // WITH_PHYSX
+}
+
+void UBuoyantDestructibleComponent::EvaluateBuoyancy()
+{
+#if WITH_PHYSX
+	const FVector2D WaveDirection = WaterSurface->GetWaveDirection();
+	const int32 EvaluationCount = ChunkEvaluations.Num();
+
+	BUOYANCY_TRACE_WATER_QUERIES(SampledChunks.Num());
+	ChunkWaterHeights.SetNumUninitialized(SampledChunks.Num(), false);
+	WaterSurface->GetWaterHeights(ChunkLocations, WaterTime, ChunkWaterHeights);
+	for (int32 i = 0; i < SampledChunks.Num(); i++)
+	{
+		FChunkEvaluation& Evaluation = ChunkEvaluations[SampledChunks[i]];
+		Evaluation.WaterHeight = ChunkWaterHeights[i];
+		ChunkStates[Evaluation.ChunkIndex].LastWaterHeight = ChunkWaterHeights[i];
+	}
+
+	//The forces only depend on what was read above, so the chunks are evaluated in parallel, unless the threads are capped.
+	ParallelFor(EvaluationCount, [&](int32 i)
+	{
+		FChunkEvaluation& Evaluation = ChunkEvaluations[i];
+		if (Evaluation.Tier != EChunkTier::Active && Evaluation.Tier != EChunkTier::Simplified)
+			return;
+
+		const FVector& Location = Evaluation.Location;
+		const float waveHeight = Evaluation.WaterHeight;
 
-				float DepthMultiplier = (waveHeight - (Location.Z + _SignedRadius)) / (TestPointRadius * 2);
-				DepthMultiplier = FMath::Clamp(DepthMultiplier, 0.f, 1.f);
+		//If test point radius is touching water add Buoyant force
+		Evaluation.bUnderwater = waveHeight > (Location.Z + _SignedRadius);
+		if (!Evaluation.bUnderwater)
+			return;
 
-				/**
-				* --------
-				* Buoyant force formula: (Volume(Mass / Density) * Fluid Density * -Gravity) * Depth Multiplier
-				* --------
-				*/
-				float BuoyantForceZ = Chunk->getMass() / ChunkDensity * FluidDensity * -Gravity * DepthMultiplier;
+		float DepthMultiplier = (waveHeight - (Location.Z + _SignedRadius)) / (TestPointRadius * 2);
+		DepthMultiplier = FMath::Clamp(DepthMultiplier, 0.f, 1.f);
+
+		/**
+		* --------
+		* Buoyant force formula: (Volume(Mass / Density) * Fluid Density * -Gravity) * Depth Multiplier
+		* --------
+		*/
+		float BuoyantForceZ = Evaluation.Mass / ChunkDensity * FluidDensity * -GatheredGravity * DepthMultiplier;
+
+		//Velocity damping
+		FVector DampingForce = -Evaluation.Velocity * VelocityDamper * Evaluation.Mass * DepthMultiplier;
+
+		//Wave push force, not worth it on small chunks
+		if (EnableWaveForces && Evaluation.Tier == EChunkTier::Active)
+		{
+			float waveVelocity = FMath::Clamp(Evaluation.Velocity.Z, -20.f, 150.f) * (1 - DepthMultiplier);
+			DampingForce += FVector(WaveDirection.X, WaveDirection.Y, 0) * Evaluation.Mass * waveVelocity * WaveForceMultiplier;
+		}
+		Evaluation.Force = FVector(DampingForce.X, DampingForce.Y, DampingForce.Z + BuoyantForceZ);
 
-				//Velocity damping
-				FVector DampingForce = -P2UVector(Chunk->getLinearVelocity()) * VelocityDamper * Chunk->getMass() * DepthMultiplier;
+		//Clamp the chunk's velocity to MaxUnderwaterVelocity if chunk is underwater
+		Evaluation.bClampVelocity = ClampMaxVelocity && Evaluation.Velocity.Size() > MaxUnderwaterVelocity;
+		Evaluation.ClampedVelocity = Evaluation.Velocity.GetSafeNormal() * MaxUnderwaterVelocity;
+	}, EvaluationCount < MinChunksForParallelEvaluation || !CanEvaluateBuoyancyWithNestedTasks());
 
-				//Wave push force
-				if (EnableWaveForces)
+	//Traced from the calling thread, the trace scope doesn't follow the parallel evaluation.
+	for (const FChunkEvaluation& Evaluation : ChunkEvaluations)
+	{
+		if (Evaluation.bUnderwater)
+		{
+			BUOYANCY_TRACE_FORCE(Evaluation.Force);
+		}
+	}
+#endif // WITH_PHYSX
+}
+
+void UBuoyantDestructibleComponent::ApplyBuoyancy()
+{
+#if WITH_PHYSX
+	//Write everything back under a single lock. Chunk properties are only written when they change.
+	ActiveChunkCount = 0;
+	SimplifiedChunkCount = 0;
+	FrozenChunkCount = 0;
+	CulledChunkCount = 0;
+	{
+		SCOPED_SCENE_WRITE_LOCK(PScene);
+		for (const FChunkEvaluation& Evaluation : ChunkEvaluations)
+		{
+			PxRigidDynamic* Chunk = Evaluation.Actor;
+			FChunkState& State = ChunkStates[Evaluation.ChunkIndex];
+			const EChunkTier PreviousTier = State.Tier;
+			State.Tier = Evaluation.Tier;
+
+			if (State.Actor != Chunk || !State.bPropertiesWritten)
+			{
+				//Advanced
+				Chunk->setSleepThreshold(ChunkSleepThreshold);
+				Chunk->setStabilizationThreshold(ChunkStabilizationThreshold);
+				State.Actor = Chunk;
+				State.bPropertiesWritten = true;
+				//Write the damping again too
+				State.bUnderwater = !Evaluation.bUnderwater;
+			}
+
+			if (Evaluation.Tier == EChunkTier::Active || Evaluation.Tier == EChunkTier::Simplified)
+			{
+				if (Evaluation.bUnderwater)
+				{
+					//Add force for this chunk
+					Chunk->addForce(U2PVector(Evaluation.Force), PxForceMode::eFORCE, true);
+
+					if (Evaluation.bClampVelocity)
+					{
+						Chunk->setLinearVelocity(U2PVector(Evaluation.ClampedVelocity));
+					}
+				}
+
+				//Update damping based on isUnderwater
+				if (State.bUnderwater != Evaluation.bUnderwater)
 				{
-					float waveVelocity = FMath::Clamp(P2UVector(Chunk->getLinearVelocity()).Z, -20.f, 150.f) * (1 - DepthMultiplier);
-					DampingForce += FVector(OceanManager->GlobalWaveDirection.X, OceanManager->GlobalWaveDirection.Y, 0) * Chunk->getMass() * waveVelocity * WaveForceMultiplier;
+					INC_DWORD_STAT(STAT_BuoyantDestructibleChunkWrites);
+					Chunk->setLinearDamping(_baseLinearDamping + FluidLinearDamping * Evaluation.bUnderwater);
+					Chunk->setAngularDamping(_baseAngularDamping + FluidAngularDamping * Evaluation.bUnderwater);
+					State.bUnderwater = Evaluation.bUnderwater;
 				}
 
-				//Add force for this chunk
-				Chunk->addForce(PxVec3(DampingForce.X, DampingForce.Y, DampingForce.Z + BuoyantForceZ), PxForceMode::eFORCE, true);
+				//Freeze the chunk once it has floated still for long enough
+				const bool bSettled = Evaluation.bUnderwater && Evaluation.Velocity.Size() < SettleLinearSpeed && Evaluation.AngularSpeed < SettleAngularSpeed;
+				State.SettledTime = bSettled ? State.SettledTime + GatheredDeltaTime : 0.f;
+				if (FreezeSettledChunks && State.SettledTime >= SettleTime)
+				{
+					State.Tier = EChunkTier::Frozen;
+					State.FrozenHeightAboveWater = Evaluation.Location.Z - Evaluation.WaterHeight;
+				}
 			}
 
-			if (DrawDebugPoints)
+			const bool bKinematic = State.Tier == EChunkTier::Frozen;
+			if (State.bKinematic != bKinematic)
 			{
-				FColor DebugColor = FLinearColor(0.8, 0.7, 0.2, 0.8).ToRGBE();
-				if (isUnderwater) { DebugColor = FLinearColor(0, 0.2, 0.7, 0.8).ToRGBE(); } //Blue color underwater, yellow out of watter
-				DrawDebugSphere(GetWorld(), Location, TestPointRadius, 8, DebugColor);
+				INC_DWORD_STAT(STAT_BuoyantDestructibleChunkWrites);
+				Chunk->setRigidBodyFlag(PxRigidBodyFlag::eKINEMATIC, bKinematic);
+				if (!bKinematic && State.Tier != EChunkTier::Culled)
+				{
+					Chunk->wakeUp();
+				}
+				State.bKinematic = bKinematic;
+				State.SettledTime = 0.f;
 			}
 
-			//Advanced
-			Chunk->setSleepThreshold(ChunkSleepThreshold);
-			Chunk->setStabilizationThreshold(ChunkStabilizationThreshold);
+			//Culled chunks stay dynamic without buoyancy, so they don't hang where they were culled. They are put to sleep once at rest, as the sleep threshold is usually too low for physics to do it.
+			if (State.Tier == EChunkTier::Culled)
+			{
+				//A frozen chunk had settled already.
+				const bool bAtRest = PreviousTier == EChunkTier::Frozen
+					|| (Evaluation.Velocity.Size() < SettleLinearSpeed && Evaluation.AngularSpeed < SettleAngularSpeed);
+				if (bAtRest && !Chunk->isSleeping())
+				{
+					INC_DWORD_STAT(STAT_BuoyantDestructibleChunkWrites);
+					Chunk->putToSleep();
+				}
+			}
+			else if (PreviousTier == EChunkTier::Culled && Chunk->isSleeping())
+			{
+				INC_DWORD_STAT(STAT_BuoyantDestructibleChunkWrites);
+				Chunk->wakeUp();
+			}
 
-			//Update damping based on isUnderwater
-			Chunk->setLinearDamping(_baseLinearDamping + FluidLinearDamping * isUnderwater);
-			Chunk->setAngularDamping(_baseAngularDamping + FluidAngularDamping * isUnderwater);
+			//Frozen chunks follow the water surface
+			if (Evaluation.Tier == EChunkTier::Frozen)
+			{
+				PxTransform Target = Chunk->getGlobalPose();
+				Target.p.z += Evaluation.WaterHeight + State.FrozenHeightAboveWater - Evaluation.Location.Z;
+				Chunk->setKinematicTarget(Target);
+			}
 
-			//Clamp the chunk's velocity to MaxUnderwaterVelocity if chunk is underwater
-			if (ClampMaxVelocity && isUnderwater
-				&& Chunk->getLinearVelocity().magnitude() > MaxUnderwaterVelocity)
+			switch (State.Tier)
 			{
-				FVector	Velocity = P2UVector(Chunk->getLinearVelocity()).GetSafeNormal() * MaxUnderwaterVelocity;
-				Chunk->setLinearVelocity(PxVec3(Velocity.X, Velocity.Y, Velocity.Z));
+			case EChunkTier::Active: ActiveChunkCount++; break;
+			case EChunkTier::Simplified: SimplifiedChunkCount++; break;
+			case EChunkTier::Frozen: FrozenChunkCount++; break;
+			case EChunkTier::Culled: CulledChunkCount++; break;
 			}
 		}
 	}
+
+	INC_DWORD_STAT_BY(STAT_BuoyantDestructibleActiveChunks, ActiveChunkCount);
+	INC_DWORD_STAT_BY(STAT_BuoyantDestructibleSimplifiedChunks, SimplifiedChunkCount);
+	INC_DWORD_STAT_BY(STAT_BuoyantDestructibleFrozenChunks, FrozenChunkCount);
+	INC_DWORD_STAT_BY(STAT_BuoyantDestructibleCulledChunks, CulledChunkCount);
+
+	if (DrawDebugPoints)
+	{
+		for (const FChunkEvaluation& Evaluation : ChunkEvaluations)
+		{
+			FColor DebugColor = FLinearColor(0.8, 0.7, 0.2, 0.8).ToRGBE();
+			if (Evaluation.bUnderwater) { DebugColor = FLinearColor(0, 0.2, 0.7, 0.8).ToRGBE(); } //Blue color underwater, yellow out of watter
+			if (Evaluation.Tier == EChunkTier::Frozen) { DebugColor = FColor::Cyan; }
+			if (Evaluation.Tier == EChunkTier::Culled) { DebugColor = FColor::Black; }
+			DrawDebugSphere(GetWorld(), Evaluation.Location, TestPointRadius, 8, DebugColor);
+		}
+	}
 #endif // WITH_PHYSX 
 
 // 	for (const FName& BoneName : GetAllSocketNames())
@@ -204,3 +492,104 @@ void UBuoyantDestructibleComponent::TickComponent(float DeltaTime, enum ELevelTi
 // 		}
 // 	}
 }
+
+bool UBuoyantDestructibleComponent::CanEvaluateBuoyancyInParallel() const
+{
+	//The evaluation queries the water surface.
+	return FWaterSurfaceProviders::CanQueryFromAnyThread(WaterSurface);
+}
+
+void UBuoyantDestructibleComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetBuoyancyAllocatedSize());
+}
+
+SIZE_T UBuoyantDestructibleComponent::GetBuoyancyAllocatedSize() const
+{
+#if WITH_PHYSX
+	return ChunkStates.GetAllocatedSize() + ChunkEvaluations.GetAllocatedSize() + BudgetedChunks.GetAllocatedSize() +
+		SampledChunks.GetAllocatedSize() + ChunkLocations.GetAllocatedSize() + ChunkWaterHeights.GetAllocatedSize();
+#else
+	return 0;
+#endif // WITH_PHYSX
+}
+
+void UBuoyantDestructibleComponent::WakeChunks()
+{
+#if WITH_PHYSX
+	for (FChunkState& State : ChunkStates)
+	{
+		if (State.Tier == EChunkTier::Frozen)
+		{
+			State.Tier = EChunkTier::Active;
+			State.SettledTime = 0.f;
+		}
+	}
+#endif // WITH_PHYSX
+}
+
+void UBuoyantDestructibleComponent::HandleFracture(const FVector& HitPoint, const FVector& HitDirection)
+{
+	WakeChunks();
+}
+
+#if WITH_PHYSX
+void UBuoyantDestructibleComponent::UpdateChunkTiers(bool bHasViewers)
+{
+	const float CullDistanceSquared = FMath::Square(CullDistance);
+
+	BudgetedChunks.Reset();
+	for (int32 i = 0; i < ChunkEvaluations.Num(); i++)
+	{
+		FChunkEvaluation& Evaluation = ChunkEvaluations[i];
+		FChunkState& State = ChunkStates[Evaluation.ChunkIndex];
+
+		//A new actor for the chunk starts over
+		if (State.Actor != Evaluation.Actor)
+		{
+			State = FChunkState();
+		}
+
+		if (bHasViewers && CullDistance > 0.f && Evaluation.DistanceSquared > CullDistanceSquared)
+		{
+			Evaluation.Tier = EChunkTier::Culled;
+		}
+		else if (State.Tier == EChunkTier::Frozen)
+		{
+			Evaluation.Tier = EChunkTier::Frozen;
+		}
+		else
+		{
+			Evaluation.Tier = Evaluation.bSmall ? EChunkTier::Simplified : EChunkTier::Active;
+			BudgetedChunks.Add(i);
+		}
+	}
+
+	//Frozen and culled chunks are cheap, only the others count against the budgets.
+	int32 Grant = FBuoyantChunkBudget::Request(GetWorld(), BudgetedChunks.Num());
+	if (MaxActiveChunks > 0)
+	{
+		Grant = FMath::Min(Grant, MaxActiveChunks);
+	}
+	if (BudgetedChunks.Num() <= Grant)
+		return;
+
+	//Keep the chunks nearest to the viewers, and those that weren't culled already so the culled set doesn't flicker.
+	BudgetedChunks.StableSort([this](int32 A, int32 B)
+	{
+		const FChunkEvaluation& EvaluationA = ChunkEvaluations[A];
+		const FChunkEvaluation& EvaluationB = ChunkEvaluations[B];
+		if (EvaluationA.DistanceSquared != EvaluationB.DistanceSquared)
+			return EvaluationA.DistanceSquared < EvaluationB.DistanceSquared;
+
+		const bool bWasCulledA = ChunkStates[EvaluationA.ChunkIndex].Tier == EChunkTier::Culled;
+		const bool bWasCulledB = ChunkStates[EvaluationB.ChunkIndex].Tier == EChunkTier::Culled;
+		return !bWasCulledA && bWasCulledB;
+	});
+	for (int32 i = Grant; i < BudgetedChunks.Num(); i++)
+	{
+		ChunkEvaluations[BudgetedChunks[i]].Tier = EChunkTier::Culled;
+	}
+}
+#endif // WITH_PHYSX
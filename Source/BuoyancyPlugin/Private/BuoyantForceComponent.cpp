@@ -6,10 +6,15 @@
 #include "PhysicsEngine/PhysicsConstraintComponent.h"
 #include "Components/PrimitiveComponent.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "Async/ParallelFor.h"
 #include "DrawDebugHelpers.h"
 #include "EngineUtils.h"
 #include "GameFramework/PhysicsVolume.h"
 #include "PhysicsEngine/ConstraintInstance.h"
+#include "BuoyancyTrace.h"
+
+//Below this many active bones, the bone forces are evaluated on the game thread.
+static const int32 MinBonesForParallelEvaluation = 16;
  	
 UBuoyantForceComponent::UBuoyantForceComponent(const class FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer) 
@@ -18,6 +23,9 @@ UBuoyantForceComponent::UBuoyantForceComponent(const class FObjectInitializer& O
 	PrimaryComponentTick.TickGroup = TickGroup;
 	bWantsInitializeComponent = true;
 	bAutoActivate = true;
+	WaterSurfaceProvider = nullptr;
+	WaterSurface = nullptr;
+	bBoneTableDirty = true;
 	
 	//Defaults
 	MeshDensity = 600.0f;
@@ -33,6 +41,13 @@ UBuoyantForceComponent::UBuoyantForceComponent(const class FObjectInitializer& O
 	StayUprightDamping = 5.0f;
 
 	WaveForceMultiplier = 2.0f;
+
+	WaterHeightTolerance = 1.0f;
+	MaxWaterHeightIterations = 4;
+
+	SemiImplicitBuoyancy = false;
+	SemiImplicitForce = FVector::ZeroVector;
+	SemiImplicitTorque = FVector::ZeroVector;
 }
 
 void UBuoyantForceComponent::InitializeComponent()
@@ -65,149 +80,126 @@ void UBuoyantForceComponent::InitializeComponent()
 	}
 }
 
+void UBuoyantForceComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (RegisterWithBuoyancySubsystem(this))
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UBuoyantForceComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterFromBuoyancySubsystem();
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void UBuoyantForceComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
+	BUOYANCY_TRACE_SCOPE("UBuoyantForceComponent", this);
+
+	if (GatherBuoyancy(DeltaTime))
+	{
+		EvaluateBuoyancy();
+		ApplyBuoyancy();
+	}
+}
+
+bool UBuoyantForceComponent::GatherBuoyancy(float DeltaTime)
+{
 	// If disabled or we are not attached to a parent component, return.
-	if (!IsActive() || !GetAttachParent()) return;
+	if (!IsActive() || !GetAttachParent()) return false;
 
-	if (!OceanManager) return;
+	WaterSurface = FWaterSurfaceProviders::Resolve(WaterSurfaceProvider, this, OceanManager);
+	if (!WaterSurface) return false;
+	WaterTime = World->GetTimeSeconds();
 
 	UPrimitiveComponent* BasePrimComp = Cast<UPrimitiveComponent>(GetAttachParent());
-	if (!BasePrimComp) return;
+	if (!BasePrimComp) return false;
 
 	if (!BasePrimComp->IsSimulatingPhysics())
 	{
-		if (!SnapToSurfaceIfNoPhysics) return;
+		if (!SnapToSurfaceIfNoPhysics) return false;
 
 		UE_LOG(LogTemp, Warning, TEXT("Running in no physics mode.."));
 
-		float waveHeight = OceanManager->GetWaveHeightValue(BasePrimComp->GetComponentLocation(), World, true, TwoGerstnerIterations).Z;
+		BUOYANCY_TRACE_WATER_QUERIES(1);
+		float waveHeight = GetWaterAt(BasePrimComp->GetComponentLocation(), false, SnapInverseState).Z;
 		BasePrimComp->SetWorldLocation(FVector(BasePrimComp->GetComponentLocation().X, BasePrimComp->GetComponentLocation().Y, waveHeight));
-		return;
+		return false;
 	}
 
 	//Get gravity
-	float Gravity = BasePrimComp->GetPhysicsVolume()->GetGravityZ();
+	GatheredGravity = BasePrimComp->GetPhysicsVolume()->GetGravityZ();
+	GatheredPrimComp = BasePrimComp;
+	GatheredDeltaTime = DeltaTime;
 
 	//--------------- If Skeletal ---------------
 	USkeletalMeshComponent* SkeletalComp = Cast<USkeletalMeshComponent>(GetAttachParent());
-	if (SkeletalComp && ApplyForceToBones)
+	bGatheredBones = SkeletalComp && ApplyForceToBones;
+	if (bGatheredBones)
 	{
-		TArray<FName> BoneNames;
-		SkeletalComp->GetBoneNames(BoneNames);
-
-		for (int32 Itr = 0; Itr < BoneNames.Num(); Itr++)
-		{
-			FBodyInstance* BI = SkeletalComp->GetBodyInstance(BoneNames[Itr], false);
-			if (BI && BI->IsValidBodyInstance()
-				&& BI->bEnableGravity) //Buoyant doesn't exist without gravity
-			{
-				bool isUnderwater = false;
-				//FVector worldBoneLoc = SkeletalComp->GetBoneLocation(BoneNames[Itr]);
-				FVector worldBoneLoc = BI->GetCOMPosition(); //Use center of mass of the bone's physics body instead of bone's location
-				FVector waveHeight = OceanManager->GetWaveHeightValue(worldBoneLoc, World, true, TwoGerstnerIterations);
-
-				float BoneDensity = MeshDensity;
-				float BoneTestRadius = FMath::Abs(TestPointRadius);
-				float SignedBoneRadius = FMath::Sign(Gravity) * TestPointRadius; //Direction of radius (test radius is actually a Z offset, should probably rename it!). Just in case we need an upside down world.
-
-				//Get density & radius from the override array, if available.
-				for (int pointIndex = 0; pointIndex < BoneOverride.Num(); pointIndex++)
-				{
-					FStructBoneOverride Override = BoneOverride[pointIndex];
-
-					if (Override.BoneName.IsEqual(BoneNames[Itr]))
-					{
-						BoneDensity = Override.Density;
-						BoneTestRadius = FMath::Abs(Override.TestRadius);
-						SignedBoneRadius = FMath::Sign(Gravity) * BoneTestRadius;
-					}
-				}
-
-				//If test point radius is below water surface, add Buoyant force.
-				if (waveHeight.Z > (worldBoneLoc.Z + SignedBoneRadius))
-				{
-					isUnderwater = true;
-
-					float DepthMultiplier = (waveHeight.Z - (worldBoneLoc.Z + SignedBoneRadius)) / (BoneTestRadius * 2);
-					DepthMultiplier = FMath::Clamp(DepthMultiplier, 0.f, 1.f);
-
-					float Mass = SkeletalComp->CalculateMass(BoneNames[Itr]); //Mass of this specific bone's physics body
-
-					 /**
-					* --------
-					* Buoyant force formula: (Volume(Mass / Density) * Fluid Density * -Gravity) / Total Points * Depth Multiplier
-					* --------
-					*/
-					float BuoyantForceZ = Mass / BoneDensity * FluidDensity * -Gravity * DepthMultiplier;
-
-					//Velocity damping.
-					FVector DampingForce = -BI->GetUnrealWorldVelocity() * VelocityDamper * Mass * DepthMultiplier;
+		return GatherBoneStates(SkeletalComp);
+	}
+	//--------------------------------------------------------
 
-					//Experimental xy wave force
-					if (EnableWaveForces)
-					{
-						float waveVelocity = FMath::Clamp(BI->GetUnrealWorldVelocity().Z, -20.f, 150.f) * (1 - DepthMultiplier);
-						DampingForce += FVector(OceanManager->GlobalWaveDirection.X, OceanManager->GlobalWaveDirection.Y, 0) * Mass * waveVelocity * WaveForceMultiplier;
-					}
+	if (TestPoints.Num() < 1) return false;
 
-					//Add force to this bone
-					BI->AddForce(FVector(DampingForce.X, DampingForce.Y, DampingForce.Z + BuoyantForceZ));
-					//BasePrimComp->AddForceAtLocation(FVector(DampingForce.X, DampingForce.Y, DampingForce.Z + BuoyantForceZ), worldBoneLoc, BoneNames[Itr]);
-				}
+	TestPointInverseStates.SetNum(TestPoints.Num());
+	GatheredTransform = BasePrimComp->GetComponentTransform();
+	GatheredBody = FBuoyantBodyState::FromBodyInstance(BasePrimComp->GetBodyInstance());
+	bGatheredGravityEnabled = BasePrimComp->IsGravityEnabled();
+	return true;
+}
 
-				//Apply fluid damping & clamp velocity
-				if (isUnderwater)
-				{
-					BI->SetLinearVelocity(-BI->GetUnrealWorldVelocity() * (FluidLinearDamping / 10), true);
-					BI->SetAngularVelocityInRadians(-BI->GetUnrealWorldAngularVelocityInRadians() * FMath::DegreesToRadians(FluidAngularDamping / 10), true);
-
-					//Clamp the velocity to MaxUnderwaterVelocity
-					if (ClampMaxVelocity && BI->GetUnrealWorldVelocity().Size() > MaxUnderwaterVelocity)
-					{
-						FVector	Velocity = BI->GetUnrealWorldVelocity().GetSafeNormal() * MaxUnderwaterVelocity;
-						BI->SetLinearVelocity(Velocity, false);
-					}
-				}
+void UBuoyantForceComponent::EvaluateBuoyancy()
+{
+	const FVector2D WaveDirection = WaterSurface->GetWaveDirection();
 
-				if (DrawDebugPoints)
-				{
-					FColor DebugColor = FLinearColor(0.8, 0.7, 0.2, 0.8).ToRGBE();
-					if (isUnderwater) { DebugColor = FLinearColor(0, 0.2, 0.7, 0.8).ToRGBE(); } //Blue color underwater, yellow out of watter
-					DrawDebugSphere(World, worldBoneLoc, BoneTestRadius, 8, DebugColor);
-				}
-			}
-		}
+	if (bGatheredBones)
+	{
+		EvaluateBoneForces(WaveDirection);
 		return;
 	}
-	//--------------------------------------------------------
 
 	float TotalPoints = TestPoints.Num();
-	if (TotalPoints < 1) return;
+	PointPositions.SetNumUninitialized(TestPoints.Num());
+	PointForces.SetNumUninitialized(TestPoints.Num());
+	PointUnderwaterFlags.SetNumUninitialized(TestPoints.Num());
+
+	//Direction of radius (test radius is actually a Z offset, should probably rename it!). Just in case we need an upside down world.
+	float SignedRadius = FMath::Sign(GatheredGravity) * TestPointRadius;
+
+	//The stiffness is measured with Z up.
+	const bool bSemiImplicit = SemiImplicitBuoyancy && GatheredGravity < 0.f;
+	Stiffness.Reset(GatheredBody);
+	SemiImplicitForce = FVector::ZeroVector;
+	SemiImplicitTorque = FVector::ZeroVector;
 
 	PointsUnderWater = 0;
 	for (int pointIndex = 0; pointIndex < TotalPoints; pointIndex++)
 	{
-		if (!TestPoints.IsValidIndex(pointIndex)) return; //Array size changed during runtime
-
 		bool isUnderwater = false;
 		FVector testPoint = TestPoints[pointIndex];
-		FVector worldTestPoint = BasePrimComp->GetComponentTransform().TransformPosition(testPoint);
-		FVector waveHeight = OceanManager->GetWaveHeightValue(worldTestPoint, World, !EnableWaveForces, TwoGerstnerIterations);
-
-		//Direction of radius (test radius is actually a Z offset, should probably rename it!). Just in case we need an upside down world.
-		float SignedRadius = FMath::Sign(BasePrimComp->GetPhysicsVolume()->GetGravityZ()) * TestPointRadius;
+		FVector worldTestPoint = GatheredTransform.TransformPosition(testPoint);
+		BUOYANCY_TRACE_WATER_QUERIES(1);
+		FVector waveHeight = GetWaterAt(worldTestPoint, EnableWaveForces, TestPointInverseStates[pointIndex]);
+		FVector Force = FVector::ZeroVector;
 
 		//If test point radius is below water surface, add Buoyant force.
 		if (waveHeight.Z > (worldTestPoint.Z + SignedRadius)
-			&& BasePrimComp->IsGravityEnabled()) //Buoyant doesn't exist without gravity
+			&& bGatheredGravityEnabled) //Buoyant doesn't exist without gravity
 		{
 			PointsUnderWater++;
 			isUnderwater = true;
 
 			float DepthMultiplier = (waveHeight.Z - (worldTestPoint.Z + SignedRadius)) / (TestPointRadius * 2);
+			const bool bPartiallySubmerged = DepthMultiplier < 1.f;
 			DepthMultiplier = FMath::Clamp(DepthMultiplier, 0.f, 1.f);
 
 			//If we have a point density override, use the overridden value instead of MeshDensity
@@ -218,31 +210,93 @@ void UBuoyantForceComponent::TickComponent(float DeltaTime, enum ELevelTick Tick
 			* Buoyant force formula: (Volume(Mass / Density) * Fluid Density * -Gravity) / Total Points * Depth Multiplier
 			* --------
 			*/
-			float BuoyantForceZ = BasePrimComp->GetMass() / PointDensity * FluidDensity * -Gravity / TotalPoints * DepthMultiplier;
+			float BuoyantForceZ = GatheredBody.Mass / PointDensity * FluidDensity * -GatheredGravity / TotalPoints * DepthMultiplier;
 
-			//Experimental velocity damping using GetUnrealWorldVelocityAtPoint!
-			FVector DampingForce = -GetUnrealVelocityAtPoint(BasePrimComp, worldTestPoint) * VelocityDamper * BasePrimComp->GetMass() * DepthMultiplier;
+			//Experimental velocity damping using the velocity at the test point
+			FVector DampingForce = -GatheredBody.GetVelocityAtPoint(worldTestPoint) * VelocityDamper * GatheredBody.Mass * DepthMultiplier;
 
 			//Experimental xy wave force
 			if (EnableWaveForces)
 			{
-				DampingForce += BasePrimComp->GetMass() * FVector2D(waveHeight.X, waveHeight.Y).Size() * FVector(OceanManager->GlobalWaveDirection.X, OceanManager->GlobalWaveDirection.Y, 0) * WaveForceMultiplier / TotalPoints;
-				//float waveVelocity = FMath::Clamp(GetUnrealVelocityAtPoint(BasePrimComp, worldTestPoint).Z, -20.f, 150.f) * (1 - DepthMultiplier);
-				//DampingForce += OceanManager->GlobalWaveDirection * BasePrimComp->GetMass() * waveVelocity * WaveForceMultiplier / TotalPoints;
+				DampingForce += GatheredBody.Mass * FVector2D(waveHeight.X, waveHeight.Y).Size() * FVector(WaveDirection.X, WaveDirection.Y, 0) * WaveForceMultiplier / TotalPoints;
+				//float waveVelocity = FMath::Clamp(GatheredBody.GetVelocityAtPoint(worldTestPoint).Z, -20.f, 150.f) * (1 - DepthMultiplier);
+				//DampingForce += OceanManager->GlobalWaveDirection * GatheredBody.Mass * waveVelocity * WaveForceMultiplier / TotalPoints;
 			}
 
-			//Add force for this test point
-			BasePrimComp->AddForceAtLocation(FVector(DampingForce.X, DampingForce.Y, DampingForce.Z + BuoyantForceZ), worldTestPoint);
+			Force = FVector(DampingForce.X, DampingForce.Y, DampingForce.Z + BuoyantForceZ);
+			BUOYANCY_TRACE_FORCE(Force);
+
+			//The buoyant force grows linearly over the diameter of the point, then stays constant.
+			if (bSemiImplicit)
+			{
+				if (bPartiallySubmerged)
+				{
+					Stiffness.AddVerticalSpring(worldTestPoint, BuoyantForceZ / DepthMultiplier / (TestPointRadius * 2));
+				}
+				Stiffness.AddVerticalForce(worldTestPoint, BuoyantForceZ);
+				Stiffness.AddLinearDamper(worldTestPoint, VelocityDamper * GatheredBody.Mass * DepthMultiplier);
+			}
+		}
+
+		PointPositions[pointIndex] = worldTestPoint;
+		PointForces[pointIndex] = Force;
+		PointUnderwaterFlags[pointIndex] = isUnderwater;
+	}
+
+	if (bSemiImplicit && PointsUnderWater > 0)
+	{
+		FVector NetForce = FVector::ZeroVector;
+		FVector NetTorque = FVector::ZeroVector;
+		for (int pointIndex = 0; pointIndex < PointForces.Num(); pointIndex++)
+		{
+			NetForce += PointForces[pointIndex];
+			NetTorque += FVector::CrossProduct(PointPositions[pointIndex] - GatheredBody.CenterOfMass, PointForces[pointIndex]);
+		}
+		if (bGatheredGravityEnabled)
+		{
+			NetForce.Z += GatheredBody.Mass * GatheredGravity;
+		}
+		Stiffness.GetSemiImplicitCorrection(NetForce, NetTorque, GatheredDeltaTime, SemiImplicitForce, SemiImplicitTorque);
+	}
+}
+
+void UBuoyantForceComponent::ApplyBuoyancy()
+{
+	UPrimitiveComponent* BasePrimComp = GatheredPrimComp.Get();
+	if (!BasePrimComp) return;
+
+	if (bGatheredBones)
+	{
+		ApplyBoneForces();
+		return;
+	}
+
+	float TotalPoints = PointForces.Num();
+	for (int pointIndex = 0; pointIndex < PointForces.Num(); pointIndex++)
+	{
+		//Add force for this test point
+		if (PointUnderwaterFlags[pointIndex])
+		{
+			BasePrimComp->AddForceAtLocation(PointForces[pointIndex], PointPositions[pointIndex]);
 		}
 
 		if (DrawDebugPoints)
 		{
 			FColor DebugColor = FLinearColor(0.8, 0.7, 0.2, 0.8).ToRGBE();
-			if (isUnderwater) { DebugColor = FLinearColor(0, 0.2, 0.7, 0.8).ToRGBE(); } //Blue color underwater, yellow out of watter
-			DrawDebugSphere(World, worldTestPoint, TestPointRadius, 8, DebugColor);
+			if (PointUnderwaterFlags[pointIndex]) { DebugColor = FLinearColor(0, 0.2, 0.7, 0.8).ToRGBE(); } //Blue color underwater, yellow out of watter
+			DrawDebugSphere(World, PointPositions[pointIndex], TestPointRadius, 8, DebugColor);
 		}
 	}
 
+	if (!SemiImplicitForce.IsZero())
+	{
+		BasePrimComp->AddForce(SemiImplicitForce);
+	}
+	if (!SemiImplicitTorque.IsZero())
+	{
+		BasePrimComp->AddTorqueInRadians(SemiImplicitTorque);
+	}
+
 	//Clamp the velocity to MaxUnderwaterVelocity if there is any point underwater
 	if (ClampMaxVelocity && PointsUnderWater > 0
 		&& BasePrimComp->GetPhysicsLinearVelocity().Size() > MaxUnderwaterVelocity)
@@ -256,6 +310,265 @@ void UBuoyantForceComponent::TickComponent(float DeltaTime, enum ELevelTick Tick
 	BasePrimComp->SetAngularDamping(_baseAngularDamping + FluidAngularDamping / TotalPoints * PointsUnderWater);
 }
 
+bool UBuoyantForceComponent::CanEvaluateBuoyancyInParallel() const
+{
+	//The evaluation queries the water surface.
+	return FWaterSurfaceProviders::CanQueryFromAnyThread(WaterSurface);
+}
+
+void UBuoyantForceComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetBuoyancyAllocatedSize());
+}
+
+SIZE_T UBuoyantForceComponent::GetBuoyancyAllocatedSize() const
+{
+	//Test points
+	SIZE_T Size = TestPoints.GetAllocatedSize() + PointDensityOverride.GetAllocatedSize() + PointPositions.GetAllocatedSize() +
+		PointForces.GetAllocatedSize() + PointUnderwaterFlags.GetAllocatedSize() + TestPointInverseStates.GetAllocatedSize();
+
+	//Bones
+	Size += BoneOverride.GetAllocatedSize() + BoneTable.GetAllocatedSize() + BoneInverseStates.GetAllocatedSize() +
+		BoneEvaluations.GetAllocatedSize() + BonePositions.GetAllocatedSize() + BoneWaterDisplacements.GetAllocatedSize() +
+		BoneWaterHeights.GetAllocatedSize() + ActiveBoneInverseStates.GetAllocatedSize();
+	return Size;
+}
+
+void UBuoyantForceComponent::RebuildBoneTable()
+{
+	bBoneTableDirty = true;
+}
+
+bool UBuoyantForceComponent::IsBoneTableValid(USkeletalMeshComponent* SkeletalComp) const
+{
+	if (bBoneTableDirty || BoneTableMesh.Get() != SkeletalComp || BoneTableBodyCount != SkeletalComp->Bodies.Num()
+		|| BoneTableOverrideCount != BoneOverride.Num() || BoneTableMeshDensity != MeshDensity || BoneTableTestPointRadius != TestPointRadius)
+	{
+		return false;
+	}
+
+	//Bodies are recreated with the physics state, e.g. when the physics asset changes.
+	for (const FBuoyantBone& Bone : BoneTable)
+	{
+		if (SkeletalComp->Bodies[Bone.BodyIndex] != Bone.BodyInstance) return false;
+	}
+	return true;
+}
+
+void UBuoyantForceComponent::BuildBoneTable(USkeletalMeshComponent* SkeletalComp)
+{
+	BoneTable.Reset();
+	BoneTableMesh = SkeletalComp;
+	BoneTableBodyCount = SkeletalComp->Bodies.Num();
+	BoneTableOverrideCount = BoneOverride.Num();
+	BoneTableMeshDensity = MeshDensity;
+	BoneTableTestPointRadius = TestPointRadius;
+	bBoneTableDirty = false;
+
+	for (int32 BodyIndex = 0; BodyIndex < SkeletalComp->Bodies.Num(); BodyIndex++)
+	{
+		FBodyInstance* BI = SkeletalComp->Bodies[BodyIndex];
+		if (!BI) continue;
+
+		const FName BoneName = SkeletalComp->GetBoneName(BI->InstanceBoneIndex);
+		if (BoneName == NAME_None) continue;
+
+		FBuoyantBone Bone;
+		Bone.BodyInstance = BI;
+		Bone.BodyIndex = BodyIndex;
+		Bone.Density = MeshDensity;
+		Bone.TestRadius = FMath::Abs(TestPointRadius);
+
+		//Get density & radius from the override array, if available. The last matching override wins.
+		for (const FStructBoneOverride& Override : BoneOverride)
+		{
+			if (Override.BoneName.IsEqual(BoneName))
+			{
+				Bone.Density = Override.Density;
+				Bone.TestRadius = FMath::Abs(Override.TestRadius);
+			}
+		}
+
+		Bone.Mass = SkeletalComp->CalculateMass(BoneName); //Mass of this specific bone's physics body
+		BoneTable.Add(Bone);
+	}
+
+	BoneInverseStates.Reset();
+	BoneInverseStates.SetNum(BoneTable.Num());
+}
+
+bool UBuoyantForceComponent::GatherBoneStates(USkeletalMeshComponent* SkeletalComp)
+{
+	if (!IsBoneTableValid(SkeletalComp))
+	{
+		BuildBoneTable(SkeletalComp);
+	}
+
+	//Read the state of every bone from physics in one pass.
+	BoneEvaluations.Reset();
+	BonePositions.Reset();
+	for (int32 BoneIndex = 0; BoneIndex < BoneTable.Num(); BoneIndex++)
+	{
+		FBodyInstance* BI = BoneTable[BoneIndex].BodyInstance;
+		if (!BI->IsValidBodyInstance() || !BI->bEnableGravity) continue; //Buoyant doesn't exist without gravity
+
+		FBoneEvaluation& Evaluation = BoneEvaluations[BoneEvaluations.AddUninitialized()];
+		Evaluation.BoneIndex = BoneIndex;
+		Evaluation.Velocity = BI->GetUnrealWorldVelocity();
+		Evaluation.AngularVelocity = BI->GetUnrealWorldAngularVelocityInRadians();
+		BonePositions.Add(BI->GetCOMPosition()); //Use center of mass of the bone's physics body instead of bone's location
+	}
+
+	return BoneEvaluations.Num() > 0;
+}
+
+void UBuoyantForceComponent::EvaluateBoneForces(const FVector2D& WaveDirection)
+{
+	const float Gravity = GatheredGravity;
+	const int32 ActiveBoneCount = BoneEvaluations.Num();
+
+	//Sample the water under all the bones in one batch.
+	BUOYANCY_TRACE_WATER_QUERIES(ActiveBoneCount);
+	BoneWaterHeights.SetNumUninitialized(ActiveBoneCount, false);
+	if (AccurateWaterHeight)
+	{
+		ActiveBoneInverseStates.SetNumUninitialized(ActiveBoneCount, false);
+		BoneWaterDisplacements.SetNumUninitialized(ActiveBoneCount, false);
+		for (int32 i = 0; i < ActiveBoneCount; i++)
+		{
+			ActiveBoneInverseStates[i] = BoneInverseStates[BoneEvaluations[i].BoneIndex];
+		}
+		FWaterSurfaceInverse::SolveBatch(*WaterSurface, BonePositions, WaterTime, WaterHeightTolerance, MaxWaterHeightIterations, ActiveBoneInverseStates, BoneWaterDisplacements);
+		for (int32 i = 0; i < ActiveBoneCount; i++)
+		{
+			BoneInverseStates[BoneEvaluations[i].BoneIndex] = ActiveBoneInverseStates[i];
+			BoneWaterHeights[i] = BoneWaterDisplacements[i].Z;
+		}
+	}
+	else
+	{
+		WaterSurface->GetWaterHeights(BonePositions, WaterTime, BoneWaterHeights);
+	}
+
+	//The forces only depend on what was read above, so the bones are evaluated in parallel, unless the threads are capped.
+	ParallelFor(ActiveBoneCount, [&](int32 i)
+	{
+		FBoneEvaluation& Evaluation = BoneEvaluations[i];
+		const FBuoyantBone& Bone = BoneTable[Evaluation.BoneIndex];
+		const FVector& worldBoneLoc = BonePositions[i];
+		const float waveHeight = BoneWaterHeights[i];
+		const float SignedBoneRadius = FMath::Sign(Gravity) * Bone.TestRadius; //Direction of radius (test radius is actually a Z offset, should probably rename it!). Just in case we need an upside down world.
+
+		//If test point radius is below water surface, add Buoyant force.
+		Evaluation.bUnderwater = waveHeight > (worldBoneLoc.Z + SignedBoneRadius);
+		if (!Evaluation.bUnderwater) return;
+
+		float DepthMultiplier = (waveHeight - (worldBoneLoc.Z + SignedBoneRadius)) / (Bone.TestRadius * 2);
+		const bool bPartiallySubmerged = DepthMultiplier < 1.f;
+		DepthMultiplier = FMath::Clamp(DepthMultiplier, 0.f, 1.f);
+
+		/**
+		* --------
+		* Buoyant force formula: (Volume(Mass / Density) * Fluid Density * -Gravity) / Total Points * Depth Multiplier
+		* --------
+		*/
+		float BuoyantForceZ = Bone.Mass / Bone.Density * FluidDensity * -Gravity * DepthMultiplier;
+
+		//Velocity damping.
+		FVector DampingForce = -Evaluation.Velocity * VelocityDamper * Bone.Mass * DepthMultiplier;
+
+		//Experimental xy wave force
+		if (EnableWaveForces)
+		{
+			float waveVelocity = FMath::Clamp(Evaluation.Velocity.Z, -20.f, 150.f) * (1 - DepthMultiplier);
+			DampingForce += FVector(WaveDirection.X, WaveDirection.Y, 0) * Bone.Mass * waveVelocity * WaveForceMultiplier;
+		}
+		Evaluation.Force = FVector(DampingForce.X, DampingForce.Y, DampingForce.Z + BuoyantForceZ);
+
+		//Heave only, the bone force is applied at its center of mass.
+		if (SemiImplicitBuoyancy && Gravity < 0.f)
+		{
+			FBuoyantBodyState BoneState;
+			BoneState.CenterOfMass = worldBoneLoc;
+			BoneState.LinearVelocity = Evaluation.Velocity;
+			BoneState.AngularVelocity = Evaluation.AngularVelocity;
+			BoneState.Mass = Bone.Mass;
+
+			FBuoyantStiffness BoneStiffness;
+			BoneStiffness.Reset(BoneState);
+			if (bPartiallySubmerged)
+			{
+				BoneStiffness.AddVerticalSpring(worldBoneLoc, BuoyantForceZ / DepthMultiplier / (Bone.TestRadius * 2));
+			}
+			BoneStiffness.AddLinearDamper(worldBoneLoc, VelocityDamper * Bone.Mass * DepthMultiplier);
+
+			FVector CorrectionForce;
+			FVector CorrectionTorque;
+			BoneStiffness.GetSemiImplicitCorrection(Evaluation.Force + FVector(0, 0, Bone.Mass * Gravity), FVector::ZeroVector, GatheredDeltaTime, CorrectionForce, CorrectionTorque);
+			Evaluation.Force += CorrectionForce;
+		}
+
+		//Fluid damping & velocity clamp
+		Evaluation.LinearVelocityChange = -Evaluation.Velocity * (FluidLinearDamping / 10);
+		Evaluation.AngularVelocityChange = -Evaluation.AngularVelocity * FMath::DegreesToRadians(FluidAngularDamping / 10);
+		const FVector DampedVelocity = Evaluation.Velocity + Evaluation.LinearVelocityChange;
+		Evaluation.bClampVelocity = ClampMaxVelocity && DampedVelocity.Size() > MaxUnderwaterVelocity;
+		Evaluation.ClampedVelocity = DampedVelocity.GetSafeNormal() * MaxUnderwaterVelocity;
+	}, ActiveBoneCount < MinBonesForParallelEvaluation || !CanEvaluateBuoyancyWithNestedTasks());
+
+	//Traced from the calling thread, the trace scope doesn't follow the parallel evaluation.
+	for (const FBoneEvaluation& Evaluation : BoneEvaluations)
+	{
+		if (Evaluation.bUnderwater)
+		{
+			BUOYANCY_TRACE_FORCE(Evaluation.Force);
+		}
+	}
+}
+
+void UBuoyantForceComponent::ApplyBoneForces()
+{
+	//Apply the results back on the game thread.
+	for (int32 i = 0; i < BoneEvaluations.Num(); i++)
+	{
+		const FBoneEvaluation& Evaluation = BoneEvaluations[i];
+		const FBuoyantBone& Bone = BoneTable[Evaluation.BoneIndex];
+		FBodyInstance* BI = Bone.BodyInstance;
+
+		if (Evaluation.bUnderwater)
+		{
+			//Add force to this bone
+			BI->AddForce(Evaluation.Force);
+
+			BI->SetLinearVelocity(Evaluation.LinearVelocityChange, true);
+			BI->SetAngularVelocityInRadians(Evaluation.AngularVelocityChange, true);
+
+			//Clamp the velocity to MaxUnderwaterVelocity
+			if (Evaluation.bClampVelocity)
+			{
+				BI->SetLinearVelocity(Evaluation.ClampedVelocity, false);
+			}
+		}
+
+		if (DrawDebugPoints)
+		{
+			FColor DebugColor = FLinearColor(0.8, 0.7, 0.2, 0.8).ToRGBE();
+			if (Evaluation.bUnderwater) { DebugColor = FLinearColor(0, 0.2, 0.7, 0.8).ToRGBE(); } //Blue color underwater, yellow out of watter
+			DrawDebugSphere(World, BonePositions[i], Bone.TestRadius, 8, DebugColor);
+		}
+	}
+}
+
+FVector UBuoyantForceComponent::GetWaterAt(const FVector& Position, bool bWithDisplacement, FWaterSurfaceInverseState& InverseState) const
+{
+	if (AccurateWaterHeight)
+	{
+		return FWaterSurfaceInverse::Solve(*WaterSurface, Position, WaterTime, WaterHeightTolerance, MaxWaterHeightIterations, InverseState);
+	}
+	return bWithDisplacement ? WaterSurface->GetWaterDisplacement(Position, WaterTime) : FVector(0, 0, WaterSurface->GetWaterHeight(Position, WaterTime));
+}
+
 FVector UBuoyantForceComponent::GetUnrealVelocityAtPoint(UPrimitiveComponent* Target, FVector Point, FName BoneName)
 {
 	if (!Target) return FVector::ZeroVector;
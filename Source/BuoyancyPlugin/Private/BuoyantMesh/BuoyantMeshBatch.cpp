@@ -0,0 +1,293 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "BuoyantMesh/BuoyantMeshBatch.h"
+#include "BuoyantMesh/BuoyantMeshComponent.h"
+#include "BuoyantMesh/BuoyantMeshTriangle.h"
+#include "BuoyantMesh/BuoyantMeshSubtriangle.h"
+#include "BuoyantMesh/BuoyantMeshVertex.h"
+#include "BuoyancySubsystem.h"
+#include "HAL/IConsoleManager.h"
+
+#if INTEL_ISPC
+#include "BuoyantMeshBatch.ispc.generated.h"
+#endif
+
+
+static TAutoConsoleVariable<int32> CVarUseISPC(
+    TEXT("buoyancy.ISPC"),
+    1,
+    TEXT("Clip the buoyant mesh triangles and evaluate their forces with the ISPC kernels, when the build has them."));
+
+static TAutoConsoleVariable<int32> CVarValidateISPC(
+    TEXT("buoyancy.ISPC.Validate"),
+    0,
+    TEXT("Also run the scalar path after the ISPC kernels and log the subtriangles where they differ."));
+
+// Relative to the magnitude of the compared values.
+static const float ValidationTolerance = 1.e-3f;
+
+static bool IsNearlyEqualForValidation(float A, float B)
+{
+	if (FMath::IsNaN(A) || FMath::IsNaN(B)) return FMath::IsNaN(A) == FMath::IsNaN(B);
+	return FMath::Abs(A - B) <= ValidationTolerance * FMath::Max3(1.f, FMath::Abs(A), FMath::Abs(B));
+}
+
+static bool IsNearlyEqualForValidation(const FVector& A, const FVector& B)
+{
+	return IsNearlyEqualForValidation(A.X, B.X) && IsNearlyEqualForValidation(A.Y, B.Y) &&
+	       IsNearlyEqualForValidation(A.Z, B.Z);
+}
+
+bool FBuoyantMeshBatch::IsUsingISPC()
+{
+#if INTEL_ISPC
+	return CVarUseISPC.GetValueOnAnyThread() != 0;
+#else
+	return false;
+#endif
+}
+
+void FBuoyantMeshBatch::Reset()
+{
+	for (auto Stream : {&AX, &AY, &AZ, &AHeight, &BX, &BY, &BZ, &BHeight, &CX, &CY, &CZ, &CHeight})
+	{
+		Stream->Reset();
+	}
+}
+
+void FBuoyantMeshBatch::AddTriangle(const FBuoyantMeshVertex& A, const FBuoyantMeshVertex& B, const FBuoyantMeshVertex& C)
+{
+	AX.Add(A.Position.X);
+	AY.Add(A.Position.Y);
+	AZ.Add(A.Position.Z);
+	AHeight.Add(A.Height);
+	BX.Add(B.Position.X);
+	BY.Add(B.Position.Y);
+	BZ.Add(B.Position.Z);
+	BHeight.Add(B.Height);
+	CX.Add(C.Position.X);
+	CY.Add(C.Position.Y);
+	CZ.Add(C.Position.Z);
+	CHeight.Add(C.Height);
+}
+
+int32 FBuoyantMeshBatch::GetTriangleCount() const
+{
+	return AX.Num();
+}
+
+TArrayView<const FVector> FBuoyantMeshBatch::GetSubtriangleCenters() const
+{
+	return SubtriangleCenters;
+}
+
+TArrayView<const float> FBuoyantMeshBatch::GetSubtriangleAreas() const
+{
+	return SubtriangleAreas;
+}
+
+FVector FBuoyantMeshBatch::GetSubtriangleNormal(int32 Slot) const
+{
+	const auto Triangle = Slot / 2;
+	return FVector{NormalX[Triangle], NormalY[Triangle], NormalZ[Triangle]};
+}
+
+TArrayView<const FVector> FBuoyantMeshBatch::GetSubtriangleForces() const
+{
+	return SubtriangleForces;
+}
+
+SIZE_T FBuoyantMeshBatch::GetAllocatedSize() const
+{
+	SIZE_T Size = 0;
+	for (auto Stream :
+	     {&AX, &AY, &AZ, &AHeight, &BX, &BY, &BZ, &BHeight, &CX, &CY, &CZ, &CHeight, &NormalX, &NormalY, &NormalZ, &SubtriangleAreas})
+	{
+		Size += Stream->GetAllocatedSize();
+	}
+	return Size + SubtriangleCenters.GetAllocatedSize() + SubtriangleForces.GetAllocatedSize();
+}
+
+int32 FBuoyantMeshBatch::Clip(const FVector& VolumeApex, float& OutVolume, FVector& OutVolumeMoment)
+{
+	const auto TriangleCount = GetTriangleCount();
+	NormalX.SetNumUninitialized(TriangleCount, false);
+	NormalY.SetNumUninitialized(TriangleCount, false);
+	NormalZ.SetNumUninitialized(TriangleCount, false);
+	SubtriangleCenters.SetNumUninitialized(TriangleCount * 2, false);
+	SubtriangleAreas.SetNumUninitialized(TriangleCount * 2, false);
+
+#if INTEL_ISPC
+	if (IsUsingISPC())
+	{
+		const auto SubtriangleCount = ClipISPC(VolumeApex, OutVolume, OutVolumeMoment);
+		if (CVarValidateISPC.GetValueOnAnyThread() == 0) return SubtriangleCount;
+
+		// The kernel leaves the centers of the unused slots unset, they are only compared where there is an area.
+		const auto Centers = SubtriangleCenters;
+		const auto Areas = SubtriangleAreas;
+		float ReferenceVolume;
+		FVector ReferenceVolumeMoment;
+		const auto ReferenceCount = ClipScalar(VolumeApex, ReferenceVolume, ReferenceVolumeMoment);
+		if (ReferenceCount != SubtriangleCount || !IsNearlyEqualForValidation(ReferenceVolume, OutVolume) ||
+		    !IsNearlyEqualForValidation(ReferenceVolumeMoment, OutVolumeMoment))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Buoyant mesh ISPC clipping: %d subtriangles, volume %f, the scalar path has %d and %f."),
+			       SubtriangleCount, OutVolume, ReferenceCount, ReferenceVolume);
+		}
+		for (int32 Slot = 0; Slot < Areas.Num(); ++Slot)
+		{
+			if (!IsNearlyEqualForValidation(Areas[Slot], SubtriangleAreas[Slot]) ||
+			    (SubtriangleAreas[Slot] != 0.f && !IsNearlyEqualForValidation(Centers[Slot], SubtriangleCenters[Slot])))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Buoyant mesh ISPC clipping: slot %d differs from the scalar path."), Slot);
+			}
+		}
+
+		// Carry on with the reference results, like the slots.
+		OutVolume = ReferenceVolume;
+		OutVolumeMoment = ReferenceVolumeMoment;
+		return ReferenceCount;
+	}
+#endif
+	return ClipScalar(VolumeApex, OutVolume, OutVolumeMoment);
+}
+
+void FBuoyantMeshBatch::EvaluateForces(TArrayView<const float> CenterHeights,
+                                       const FBuoyantMeshForceSettings& Settings,
+                                       const FBuoyantBodyState& Body)
+{
+	check(!Settings.bStaticForces || CenterHeights.Num() == SubtriangleAreas.Num());
+	SubtriangleForces.SetNumUninitialized(SubtriangleAreas.Num(), false);
+
+#if INTEL_ISPC
+	if (IsUsingISPC())
+	{
+		EvaluateForcesISPC(CenterHeights, Settings, Body);
+		if (CVarValidateISPC.GetValueOnAnyThread() == 0) return;
+
+		const auto Forces = SubtriangleForces;
+		EvaluateForcesScalar(CenterHeights, Settings, Body);
+		for (int32 Slot = 0; Slot < Forces.Num(); ++Slot)
+		{
+			if (!IsNearlyEqualForValidation(Forces[Slot], SubtriangleForces[Slot]))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Buoyant mesh ISPC forces: slot %d is %s, the scalar path has %s."), Slot,
+				       *Forces[Slot].ToString(), *SubtriangleForces[Slot].ToString());
+			}
+		}
+		return;
+	}
+#endif
+	EvaluateForcesScalar(CenterHeights, Settings, Body);
+}
+
+int32 FBuoyantMeshBatch::ClipScalar(const FVector& VolumeApex, float& OutVolume, FVector& OutVolumeMoment)
+{
+	OutVolume = 0.f;
+	OutVolumeMoment = FVector::ZeroVector;
+	int32 SubtriangleCount = 0;
+	TArray<FBuoyantMeshSubtriangle, TInlineAllocator<2>> Subtriangles;
+
+	for (int32 i = 0; i < GetTriangleCount(); ++i)
+	{
+		const FBuoyantMeshVertex A{FVector{AX[i], AY[i], AZ[i]}, AHeight[i]};
+		const FBuoyantMeshVertex B{FVector{BX[i], BY[i], BZ[i]}, BHeight[i]};
+		const FBuoyantMeshVertex C{FVector{CX[i], CY[i], CZ[i]}, CHeight[i]};
+
+		const auto Normal = FVector::CrossProduct(B.Position - A.Position, C.Position - A.Position).GetSafeNormal();
+		NormalX[i] = Normal.X;
+		NormalY[i] = Normal.Y;
+		NormalZ[i] = Normal.Z;
+
+		const auto UnderwaterCorners = FBuoyantMeshTriangle::GetUnderwaterCorners(A, B, C);
+		FBuoyantMeshTriangle::GetSubmergedPortion(A, B, C, UnderwaterCorners, /*out*/ Subtriangles);
+		SubtriangleCount += Subtriangles.Num();
+
+		for (int32 SubtriangleIndex = 0; SubtriangleIndex < 2; ++SubtriangleIndex)
+		{
+			const auto Slot = i * 2 + SubtriangleIndex;
+			if (!Subtriangles.IsValidIndex(SubtriangleIndex))
+			{
+				SubtriangleCenters[Slot] = FVector::ZeroVector;
+				SubtriangleAreas[Slot] = 0.f;
+				continue;
+			}
+
+			const auto& Subtriangle = Subtriangles[SubtriangleIndex];
+			SubtriangleCenters[Slot] = Subtriangle.GetCenter();
+			SubtriangleAreas[Slot] = Subtriangle.GetArea();
+
+			const auto TetrahedronVolume =
+			    TMathUtilities::SignedVolumeOfTetrahedron(VolumeApex, Subtriangle.A, Subtriangle.B, Subtriangle.C, Normal);
+			OutVolume += TetrahedronVolume;
+			OutVolumeMoment += TetrahedronVolume * (VolumeApex + Subtriangle.A + Subtriangle.B + Subtriangle.C) / 4.f;
+		}
+	}
+	return SubtriangleCount;
+}
+
+void FBuoyantMeshBatch::EvaluateForcesScalar(TArrayView<const float> CenterHeights,
+                                             const FBuoyantMeshForceSettings& Settings,
+                                             const FBuoyantBodyState& Body)
+{
+	for (int32 Slot = 0; Slot < SubtriangleAreas.Num(); ++Slot)
+	{
+		const auto Area = SubtriangleAreas[Slot];
+		const auto& Center = SubtriangleCenters[Slot];
+		const FVector Normal{NormalX[Slot / 2], NormalY[Slot / 2], NormalZ[Slot / 2]};
+
+		// Same as UBuoyantMeshComponent::GetSubmergedTriangleForce.
+		auto Force = FVector::ZeroVector;
+		if (!FMath::IsNearlyZero(Area))
+		{
+			if (Settings.bStaticForces)
+			{
+				const FBuoyantMeshVertex CenterVertex{Center, CenterHeights[Slot]};
+				Force += FBuoyantMeshSubtriangle::GetHydrostaticForce(
+				    Settings.WaterDensity, Settings.GravityMagnitude, CenterVertex, Normal, Area);
+			}
+
+			if (Settings.bDynamicForces)
+			{
+				Force += FBuoyantMeshSubtriangle::GetHydrodynamicForce(
+				    Settings.WaterDensity, Center, Body.GetVelocityAtPoint(Center), Normal, Area);
+			}
+		}
+		SubtriangleForces[Slot] = Force;
+	}
+}
+
+#if INTEL_ISPC
+int32 FBuoyantMeshBatch::ClipISPC(const FVector& VolumeApex, float& OutVolume, FVector& OutVolumeMoment)
+{
+	static_assert(sizeof(FVector) == sizeof(float) * 3, "The kernels read FVector arrays as packed floats.");
+
+	float VolumeAndMoment[4];
+	int32 SubtriangleCount = 0;
+	ispc::ClipTriangles(AX.GetData(), AY.GetData(), AZ.GetData(), AHeight.GetData(),
+	                    BX.GetData(), BY.GetData(), BZ.GetData(), BHeight.GetData(),
+	                    CX.GetData(), CY.GetData(), CZ.GetData(), CHeight.GetData(),
+	                    GetTriangleCount(), VolumeApex.X, VolumeApex.Y, VolumeApex.Z,
+	                    NormalX.GetData(), NormalY.GetData(), NormalZ.GetData(),
+	                    reinterpret_cast<float*>(SubtriangleCenters.GetData()), SubtriangleAreas.GetData(),
+	                    VolumeAndMoment, SubtriangleCount);
+
+	OutVolume = VolumeAndMoment[0];
+	OutVolumeMoment = FVector{VolumeAndMoment[1], VolumeAndMoment[2], VolumeAndMoment[3]};
+	return SubtriangleCount;
+}
+
+void FBuoyantMeshBatch::EvaluateForcesISPC(TArrayView<const float> CenterHeights,
+                                           const FBuoyantMeshForceSettings& Settings,
+                                           const FBuoyantBodyState& Body)
+{
+	ispc::EvaluateSubtriangleForces(reinterpret_cast<const float*>(SubtriangleCenters.GetData()),
+	                                SubtriangleAreas.GetData(), NormalX.GetData(), NormalY.GetData(), NormalZ.GetData(),
+	                                CenterHeights.GetData(), SubtriangleAreas.Num(), Settings.WaterDensity,
+	                                Settings.GravityMagnitude, Settings.bStaticForces, Settings.bDynamicForces,
+	                                &Body.CenterOfMass.X, &Body.LinearVelocity.X, &Body.AngularVelocity.X,
+	                                reinterpret_cast<float*>(SubtriangleForces.GetData()));
+}
+#endif
@@ -6,15 +6,44 @@
 #include "PhysicsEngine/BodySetup.h"
 #include "BuoyantMesh/BuoyantMeshTriangle.h"
 #include "BuoyantMesh/BuoyantMeshSubtriangle.h"
+#include "BuoyantMesh/BuoyantMeshBatch.h"
+#include "BuoyantMesh/CompactTriangleMesh.h"
 #include "BuoyantMesh/WaterHeightmapComponent.h"
+#include "BuoyantMesh/HydrostaticTable.h"
+#include "WaterSurface/WaterSurfaceProvider.h"
+#include "Engine/StaticMesh.h"
+#include "GameFramework/PlayerController.h"
 #include "Engine/World.h"
 #include "DrawDebugHelpers.h"
 #include "EngineUtils.h"
 #include "PhysXPublic.h"
+#include "BuoyancyMemory.h"
+#include "BuoyancyStats.h"
+#include "BuoyancyTrace.h"
 
 
+DECLARE_CYCLE_STAT(TEXT("Buoyant Mesh Forces"), STAT_BuoyantMeshForces, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Buoyant Mesh Dry Clusters"), STAT_BuoyantMeshDryClusters, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Buoyant Mesh Wet Clusters"), STAT_BuoyantMeshWetClusters, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Buoyant Mesh Crossing Clusters"), STAT_BuoyantMeshCrossingClusters, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Buoyant Mesh Classified Triangles"), STAT_BuoyantMeshClassifiedTriangles, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Buoyant Mesh Reclipped Triangles"), STAT_BuoyantMeshReclippedTriangles, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Buoyant Mesh Refined Triangles"), STAT_BuoyantMeshRefinedTriangles, STATGROUP_Buoyancy);
+
+// Only reached when the waves change abruptly, a vertex usually converges on its first query.
+static const int32 MaxWaterHeightIterations = 4;
+
 using FForce = UBuoyantMeshComponent::FForce;
 
+
+// Halvings of a triangle crossing the waterline, whatever WaterlineEdgeLength is. Two levels halve the edges, so the
+// pieces of a triangle more than 256 times longer than the target edge stay larger than it.
+static const int32 MaxWaterlineRefinementDepth = 16;
+
+// Added to how far the water can have moved since a vertex was sampled, for the rounding of the heights, so a vertex
+// that was almost on the waterline is always sampled again.
+static const float ReuseClassificationMargin = 0.1f;
+
 // Sets default values for this component's properties
 UBuoyantMeshComponent::UBuoyantMeshComponent()
 {
@@ -25,21 +54,84 @@ UBuoyantMeshComponent::UBuoyantMeshComponent()
 	UActorComponent::SetComponentTickEnabled(true);
 }
 
-float UBuoyantMeshComponent::GetHeightAboveWater(const FVector& Position) const
+float UBuoyantMeshComponent::GetWaterHeight(const FVector& Position) const
 {
+	if (bUseWaterPlaneThisTick) return Position.Z - WaterPlane.PlaneDot(Position) / WaterPlane.Z;
+
+	BUOYANCY_TRACE_WATER_QUERIES(1);
+
 	float WaterHeight = 0.f;
-	if (IsValid(OceanManager))
+	if (IsUsingWaterHeightmap())
 	{
-		if (bUseWaterPatch && IsValid(WaterHeightmap))
-		{
-			WaterHeight = WaterHeightmap->GetHeightAtPosition(Position);
-		}
-		else
+		WaterHeight = WaterHeightmap->GetHeightAtPosition(Position);
+	}
+	else if (WaterSurface)
+	{
+		WaterHeight = WaterSurface->GetWaterHeight(Position, WaterTime);
+	}
+	return WaterHeight;
+}
+
+float UBuoyantMeshComponent::GetHeightAboveWater(const FVector& Position) const
+{
+	return Position.Z - GetWaterHeight(Position);
+}
+
+float UBuoyantMeshComponent::GetHeightAboveWater(const FVector& Position, FWaterSurfaceInverseState& InverseState) const
+{
+	if (bUseWaterPlaneThisTick || !bAccurateWaterHeight || !WaterSurface || IsUsingWaterHeightmap())
+	{
+		return GetHeightAboveWater(Position);
+	}
+
+	BUOYANCY_TRACE_WATER_QUERIES(1);
+	const auto Water =
+	    FWaterSurfaceInverse::Solve(*WaterSurface, Position, WaterTime, WaterHeightTolerance, MaxWaterHeightIterations, InverseState);
+	return Position.Z - Water.Z;
+}
+
+void UBuoyantMeshComponent::GetHeightsAboveWater(TArrayView<const FVector> Positions, TArrayView<float> OutHeights) const
+{
+	check(Positions.Num() == OutHeights.Num());
+
+	if (bUseWaterPlaneThisTick || IsUsingWaterHeightmap() || !WaterSurface)
+	{
+		for (int32 i = 0; i < Positions.Num(); ++i)
 		{
-			WaterHeight = OceanManager->GetWaveHeight(Position, World);
+			OutHeights[i] = GetHeightAboveWater(Positions[i]);
 		}
+		return;
+	}
+
+	BUOYANCY_TRACE_WATER_QUERIES(Positions.Num());
+	WaterSurface->GetWaterHeights(Positions, WaterTime, OutHeights);
+	for (int32 i = 0; i < Positions.Num(); ++i)
+	{
+		OutHeights[i] = Positions[i].Z - OutHeights[i];
+	}
+}
+
+void UBuoyantMeshComponent::GetHeightsAboveWater(TArrayView<const FVector> Positions,
+                                                 TArrayView<FWaterSurfaceInverseState> InverseStates,
+                                                 TArrayView<float> OutHeights) const
+{
+	check(Positions.Num() == InverseStates.Num() && Positions.Num() == OutHeights.Num());
+
+	if (bUseWaterPlaneThisTick || !bAccurateWaterHeight || !WaterSurface || IsUsingWaterHeightmap())
+	{
+		GetHeightsAboveWater(Positions, OutHeights);
+		return;
+	}
+
+	BUOYANCY_TRACE_WATER_QUERIES(Positions.Num());
+	TArray<FVector> Water;
+	Water.SetNumUninitialized(Positions.Num());
+	FWaterSurfaceInverse::SolveBatch(
+	    *WaterSurface, Positions, WaterTime, WaterHeightTolerance, MaxWaterHeightIterations, InverseStates, Water);
+	for (int32 i = 0; i < Positions.Num(); ++i)
+	{
+		OutHeights[i] = Positions[i].Z - Water[i].Z;
 	}
-	return Position.Z - WaterHeight;
 }
 
 UPrimitiveComponent* UBuoyantMeshComponent::GetParentPrimitive() const
@@ -88,10 +180,11 @@ void UBuoyantMeshComponent::SetupTickOrder()
 		UpdatedComponent->PrimaryComponentTick.AddPrerequisite(this, PrimaryComponentTick);
 	}
 
-	// The water heightmap needs to tick before this component.
+	// The water heightmap needs to tick before this component, or before the subsystem that updates it.
 	if (WaterHeightmap)
 	{
 		PrimaryComponentTick.AddPrerequisite(WaterHeightmap, WaterHeightmap->PrimaryComponentTick);
+		AddBuoyancyPrerequisite(WaterHeightmap, WaterHeightmap->PrimaryComponentTick);
 	}
 }
 
@@ -108,11 +201,17 @@ void UBuoyantMeshComponent::Initialize()
 		OceanManager = FindOceanManager();
 	}
 
+	FWaterSurfaceProviders::Resolve(WaterSurfaceProvider, this, OceanManager);
+
 	WaterHeightmap = FindWaterHeightmap();
+	if (WaterHeightmap && !WaterHeightmap->WaterSurfaceProvider)
+	{
+		WaterHeightmap->WaterSurfaceProvider = WaterSurfaceProvider;
+	}
 
 	SetupTickOrder();
 
-	TriangleMeshes = TMeshUtilities::GetTriangleMeshes(this);
+	InitializeHull();
 
 	World = GetWorld();
 	GravityMagnitude = FMath::Abs(World->GetGravityZ());
@@ -120,6 +219,56 @@ void UBuoyantMeshComponent::Initialize()
 	SetMassProperties();
 }
 
+void UBuoyantMeshComponent::InitializeHull()
+{
+	TriangleMeshes.Reset();
+	CompactTriangleMeshes.Reset();
+	MeshClusters.Reset();
+	VertexWaterSamples.Reset();
+	HullLocalBounds = FBox{ForceInit};
+
+	// The hull isn't needed when the primitives replace it.
+	Primitives = bUseAnalyticPrimitives ? FBuoyantPrimitive::GetPrimitives(GetBodySetup()) : TArray<FBuoyantPrimitive>{};
+	const auto HullMeshes =
+	    Primitives.Num() == 0 ? TMeshUtilities::GetTriangleMeshes(this, HullSource) : TArray<FTriangleMesh>{};
+	for (const auto& TriangleMesh : HullMeshes)
+	{
+		TArray<FBuoyantMeshCluster> Clusters;
+		auto SortedMesh = TMeshUtilities::SortIntoClusters(TriangleMesh, TrianglesPerCluster, /*out*/ Clusters);
+		for (const auto& Cluster : Clusters)
+		{
+			HullLocalBounds += Cluster.LocalBounds;
+		}
+		MeshClusters.Add(MoveTemp(Clusters));
+
+		if (FCompactTriangleMesh::ShouldReport())
+		{
+			const auto Comparison = FCompactTriangleMesh::Compare(SortedMesh.Vertices, SortedMesh.TriangleVertexIndices);
+			UE_LOG(LogTemp,
+			       Log,
+			       TEXT("%s: hull of %d vertices and %d triangles takes %d bytes as floats and %d bytes compact, ")
+			           TEXT("with a position error of at most %f. %.1f and %.1f million corners per second."),
+			       *GetPathName(),
+			       Comparison.VertexCount,
+			       Comparison.TriangleCount,
+			       static_cast<int32>(Comparison.FloatBytes),
+			       static_cast<int32>(Comparison.CompactBytes),
+			       Comparison.MaxPositionError,
+			       Comparison.FloatCornersPerSecond / 1000000.0,
+			       Comparison.CompactCornersPerSecond / 1000000.0);
+		}
+
+		if (bUseCompactHull)
+		{
+			CompactTriangleMeshes.Emplace(SortedMesh.Vertices, SortedMesh.TriangleVertexIndices);
+		}
+		else
+		{
+			TriangleMeshes.Add(MoveTemp(SortedMesh));
+		}
+	}
+}
+
 
 void UBuoyantMeshComponent::SetMassProperties()
 {
@@ -127,7 +276,15 @@ void UBuoyantMeshComponent::SetMassProperties()
 	{
 		if (bOverrideMeshDensity)
 		{
-			const auto MeshVolume = TMathUtilities::MeshVolume(this);
+			auto MeshVolume = 0.f;
+			for (const auto& Primitive : Primitives)
+			{
+				MeshVolume += Primitive.GetTransformed(GetComponentTransform()).GetVolume();
+			}
+			if (Primitives.Num() == 0)
+			{
+				MeshVolume = TMathUtilities::MeshVolume(this, HullSource);
+			}
 			const auto ComputedMass = MeshDensity * MeshVolume;
 			UpdatedComponent->SetMassOverrideInKg(NAME_None, ComputedMass);
 		}
@@ -147,6 +304,23 @@ void UBuoyantMeshComponent::DrawDebugTriangle(
 	DrawDebugLine(World, C, A, Color, false, -1.f, 0, Thickness);
 }
 
+void UBuoyantMeshComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (RegisterWithBuoyancySubsystem(this))
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UBuoyantMeshComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterFromBuoyancySubsystem();
+
+	Super::EndPlay(EndPlayReason);
+}
+
 // Called every frame
 void UBuoyantMeshComponent::TickComponent(float DeltaTime,
                                           ELevelTick TickType,
@@ -154,6 +328,17 @@ void UBuoyantMeshComponent::TickComponent(float DeltaTime,
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
+	BUOYANCY_TRACE_SCOPE("UBuoyantMeshComponent", this);
+
+	if (GatherBuoyancy(DeltaTime))
+	{
+		EvaluateBuoyancy();
+		ApplyBuoyancy();
+	}
+}
+
+bool UBuoyantMeshComponent::GatherBuoyancy(float DeltaTime)
+{
 	if (!bHasInitialized)
 	{
 		Initialize();
@@ -165,84 +350,989 @@ void UBuoyantMeshComponent::TickComponent(float DeltaTime,
 			       Error,
 			       TEXT("BuoyantMeshComponent has no updated component set up. Use a ")
 			           TEXT("parent component with \"Simulate Physics\" turned on."));
-			return;
+			return false;
 		}
 	}
 
-	ApplyMeshForces();
+	WaterSurface = FWaterSurfaceProviders::Resolve(WaterSurfaceProvider, this, OceanManager);
+	SetGatheredState(GetComponentTransform(),
+	                 FBuoyantBodyState::FromBodyInstance(UpdatedComponent->GetBodyInstance()),
+	                 World->GetTimeSeconds(),
+	                 DeltaTime);
+	bGatheredGravityEnabled = UpdatedComponent->IsGravityEnabled();
+	bUseHydrostaticTableThisTick = Primitives.Num() == 0 && ShouldUseHydrostaticTable();
+	return true;
 }
 
+void UBuoyantMeshComponent::SetGatheredState(const FTransform& LocalToWorld,
+                                             const FBuoyantBodyState& Body,
+                                             float Time,
+                                             float DeltaTime)
+{
+	WaterTime = Time;
+	GatheredLocalToWorld = LocalToWorld;
+	GatheredBody = Body;
+	bGatheredGravityEnabled = false;
+	GatheredDeltaTime = DeltaTime;
+	bUseHydrostaticTableThisTick = false;
+	bUseWaterPlaneThisTick = false;
+	PendingForces.Reset();
+	SemiImplicitForce = FVector::ZeroVector;
+	SemiImplicitTorque = FVector::ZeroVector;
+}
 
-void UBuoyantMeshComponent::ApplyMeshForces()
+void UBuoyantMeshComponent::EvaluateBuoyancyForState(const FTransform& LocalToWorld,
+                                                     const FBuoyantBodyState& Body,
+                                                     float Time,
+                                                     float DeltaTime,
+                                                     float InGravityMagnitude,
+                                                     FVector& OutForce,
+                                                     FVector& OutTorque)
 {
-	auto debugWorld = GetWorld();
+	if (!bHasInitialized)
+	{
+		InitializeHull();
+		bHasInitialized = true;
+	}
 
-	const auto LocalToWorld = GetComponentTransform();
+	GravityMagnitude = InGravityMagnitude;
+	WaterSurface = FWaterSurfaceProviders::Resolve(WaterSurfaceProvider, this, nullptr);
+	SetGatheredState(LocalToWorld, Body, Time, DeltaTime);
+
+	EvaluateBuoyancy();
+
+	OutForce = SemiImplicitForce;
+	OutTorque = SemiImplicitTorque;
+	for (const auto& Force : PendingForces)
+	{
+		OutForce += Force.Vector;
+		OutTorque += FVector::CrossProduct(Force.Point - Body.CenterOfMass, Force.Vector);
+	}
+}
+
+void UBuoyantMeshComponent::EvaluateBuoyancy()
+{
+	Stiffness.Reset(GatheredBody);
 
-	for (const auto &TriangleMesh : TriangleMeshes)
+	if (bUseHydrostaticTableThisTick)
+	{
+		EvaluateHydrostaticTableForces();
+	}
+	else if (Primitives.Num() > 0)
+	{
+		EvaluatePrimitiveForces();
+	}
+	else
+	{
+		EvaluateMeshForces();
+	}
+
+	if (bSemiImplicitBuoyancy)
+	{
+		EvaluateSemiImplicitCorrection();
+	}
+}
+
+void UBuoyantMeshComponent::EvaluateSemiImplicitCorrection()
+{
+	auto NetForce = FVector::ZeroVector;
+	auto NetTorque = FVector::ZeroVector;
+	for (const auto& Force : PendingForces)
 	{
-		TArray<FBuoyantMeshVertex> BuoyantMeshVertices{};
-		for (const auto &Vertex : TriangleMesh.Vertices)
+		NetForce += Force.Vector;
+		NetTorque += FVector::CrossProduct(Force.Point - GatheredBody.CenterOfMass, Force.Vector);
+	}
+
+	// The pressure on the wetted surface of a closed mesh adds up to the buoyant force at the center of buoyancy,
+	// what is left is drag.
+	if (bUseDynamicForces && !bUseHydrostaticTableThisTick)
+	{
+		const auto BuoyantForce =
+		    bUseStaticForces ? FVector{0.f, 0.f, WaterDensity * GravityMagnitude * SubmergedVolume} : FVector::ZeroVector;
+		const auto BuoyantTorque = FVector::CrossProduct(CenterOfBuoyancy - GatheredBody.CenterOfMass, BuoyantForce);
+		Stiffness.AddQuadraticDrag(NetForce - BuoyantForce, NetTorque - BuoyantTorque);
+	}
+
+	if (bGatheredGravityEnabled)
+	{
+		NetForce.Z -= GatheredBody.Mass * GravityMagnitude;
+	}
+	Stiffness.GetSemiImplicitCorrection(
+	    NetForce, NetTorque, GatheredDeltaTime, /*out*/ SemiImplicitForce, /*out*/ SemiImplicitTorque);
+
+	HeaveStiffness = Stiffness.Heave;
+	RollStiffness = Stiffness.Roll;
+	PitchStiffness = Stiffness.Pitch;
+}
+
+void UBuoyantMeshComponent::ApplyBuoyancy()
+{
+	for (const auto& Force : PendingForces)
+	{
+		UpdatedComponent->AddForceAtLocation(Force.Vector, Force.Point);
+		if (bDrawForceArrows)
 		{
-			const auto WorldVertex = LocalToWorld.TransformPosition(Vertex);
-			BuoyantMeshVertices.Emplace(WorldVertex, GetHeightAboveWater(WorldVertex));
+			DrawDebugLine(World, Force.Point - (Force.Vector * ForceArrowSize * 0.0001f), Force.Point, FColor::Blue);
 		}
+	}
 
-		const auto TriangleCount = TriangleMesh.TriangleVertexIndices.Num() / 3;
-		for (int32 i = 0; i < TriangleCount; ++i)
+	if (!SemiImplicitForce.IsZero())
+	{
+		UpdatedComponent->AddForce(SemiImplicitForce);
+	}
+	if (!SemiImplicitTorque.IsZero())
+	{
+		UpdatedComponent->AddTorqueInRadians(SemiImplicitTorque);
+	}
+}
+
+bool UBuoyantMeshComponent::CanEvaluateBuoyancyInParallel() const
+{
+	// The debug drawing of the evaluation isn't thread safe. Force arrows are drawn when applying.
+	if (bDrawWaterline || bDrawVertices || bDrawTriangles || bDrawSubtriangles || bDrawClusters) return false;
+	// The water heightmap fills its caches as it is queried, and is shared by every buoyant mesh of the actor.
+	if (IsUsingWaterHeightmap()) return false;
+	return FWaterSurfaceProviders::CanQueryFromAnyThread(WaterSurface);
+}
+
+void UBuoyantMeshComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetBuoyancyAllocatedSize());
+}
+
+SIZE_T UBuoyantMeshComponent::GetBuoyancyAllocatedSize() const
+{
+	auto Size = TriangleMeshes.GetAllocatedSize() + CompactTriangleMeshes.GetAllocatedSize();
+	for (const auto& TriangleMesh : TriangleMeshes)
+	{
+		Size += TriangleMesh.Vertices.GetAllocatedSize() + TriangleMesh.TriangleVertexIndices.GetAllocatedSize();
+	}
+	for (const auto& CompactTriangleMesh : CompactTriangleMeshes)
+	{
+		Size += CompactTriangleMesh.GetAllocatedSize();
+	}
+
+	Size += GetNestedAllocatedSize(MeshClusters) + GetNestedAllocatedSize(VertexInverseStates) +
+	        GetNestedAllocatedSize(VertexWaterSamples);
+	Size += WorldVertices.GetAllocatedSize() + VertexHeightsAboveWater.GetAllocatedSize() +
+	        VertexUpdateStates.GetAllocatedSize();
+	Size += TriangleBatch.GetAllocatedSize() + SubtriangleCenterHeights.GetAllocatedSize() +
+	        BatchInverseStates.GetAllocatedSize() + RefinedVertices.GetAllocatedSize();
+	Size += PressureSlots.GetAllocatedSize() + PressureSlotCenters.GetAllocatedSize() +
+	        PressureSlotInverseStates.GetAllocatedSize();
+	Size += PendingForces.GetAllocatedSize() + Primitives.GetAllocatedSize();
+	return Size;
+}
+
+bool UBuoyantMeshComponent::ShouldUseHydrostaticTable() const
+{
+	if (!HydrostaticTable || !HydrostaticTable->IsBaked() || !bUseStaticForces || !GetStaticMesh()) return false;
+	return HydrostaticTableDistance <= 0.f || GetDistanceToNearestViewer() > HydrostaticTableDistance;
+}
+
+float UBuoyantMeshComponent::GetDistanceToNearestViewer() const
+{
+	auto NearestDistanceSquared = TNumericLimits<float>::Max();
+	for (auto Iterator = World->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const auto PlayerController = Iterator->Get();
+		if (!PlayerController) continue;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(/*out*/ ViewLocation, /*out*/ ViewRotation);
+		NearestDistanceSquared =
+		    FMath::Min(NearestDistanceSquared, FVector::DistSquared(ViewLocation, GetComponentLocation()));
+	}
+	return NearestDistanceSquared == TNumericLimits<float>::Max() ? NearestDistanceSquared
+	                                                              : FMath::Sqrt(NearestDistanceSquared);
+}
+
+void UBuoyantMeshComponent::EvaluateHydrostaticTableForces()
+{
+	const auto LocalBounds = GetStaticMesh()->GetBoundingBox();
+
+	// Sample the water under the corners of the mesh footprint and bring the samples into mesh space.
+	const FVector Corners[] = {FVector{LocalBounds.Min.X, LocalBounds.Min.Y, 0.f},
+	                           FVector{LocalBounds.Max.X, LocalBounds.Min.Y, 0.f},
+	                           FVector{LocalBounds.Max.X, LocalBounds.Max.Y, 0.f},
+	                           FVector{LocalBounds.Min.X, LocalBounds.Max.Y, 0.f}};
+	TArray<FVector> LocalWaterSamples;
+	for (const auto& Corner : Corners)
+	{
+		const auto WorldCorner = GatheredLocalToWorld.TransformPosition(Corner);
+		const FVector WaterSurfacePoint{WorldCorner.X, WorldCorner.Y, GetWaterHeight(WorldCorner)};
+		LocalWaterSamples.Add(GatheredLocalToWorld.InverseTransformPosition(WaterSurfacePoint));
+	}
+
+	FVector Plane;
+	float MaxResidual;
+	if (!TMathUtilities::FitHeightPlane(LocalWaterSamples, /*out*/ Plane, /*out*/ MaxResidual)) return;
+
+	const auto Draft = Plane.X;
+	const auto Trim = FMath::RadiansToDegrees(FMath::Atan(Plane.Y));
+	const auto Heel = FMath::RadiansToDegrees(FMath::Atan(Plane.Z));
+
+	float LocalVolume;
+	FVector LocalCenterOfBuoyancy;
+	float WaterplaneArea;
+	if (!HydrostaticTable->Lookup(
+	        Draft, Heel, Trim, /*out*/ LocalVolume, /*out*/ LocalCenterOfBuoyancy, /*out*/ WaterplaneArea))
+	{
+		return;
+	}
+
+	const auto Scale = GatheredLocalToWorld.GetScale3D();
+	SubmergedVolume = LocalVolume * FMath::Abs(Scale.X * Scale.Y * Scale.Z);
+	CenterOfBuoyancy = GatheredLocalToWorld.TransformPosition(LocalCenterOfBuoyancy);
+
+	const auto BuoyantForce = FVector{0.f, 0.f, WaterDensity * GravityMagnitude * SubmergedVolume};
+	AddMeshForce(FForce{BuoyantForce, CenterOfBuoyancy});
+
+	if (bSemiImplicitBuoyancy)
+	{
+		// The table has no second moments of the waterplane, the roll and pitch stiffness only come from the volume.
+		Stiffness.AddVerticalSpring(CenterOfBuoyancy,
+		                            WaterDensity * GravityMagnitude * WaterplaneArea * FMath::Abs(Scale.X * Scale.Y));
+		Stiffness.AddVerticalForce(CenterOfBuoyancy, BuoyantForce.Z);
+	}
+}
+
+void UBuoyantMeshComponent::EvaluatePrimitiveForces()
+{
+	SubmergedVolume = 0.f;
+	auto VolumeMoment = FVector::ZeroVector;
+
+	for (const auto& Primitive : Primitives)
+	{
+		const auto WorldPrimitive = Primitive.GetTransformed(GatheredLocalToWorld);
+		const auto Sample = WorldPrimitive.GetSubmergedHydrostatics(GetWaterPlane(WorldPrimitive.GetBounds()));
+		if (Sample.Volume <= 0.f) continue;
+
+		SubmergedVolume += Sample.Volume;
+		VolumeMoment += Sample.VolumeMoment;
+		const auto PrimitiveCenterOfBuoyancy = Sample.VolumeMoment / Sample.Volume;
+
+		if (bUseStaticForces)
 		{
-			const auto A = BuoyantMeshVertices[TriangleMesh.TriangleVertexIndices[i * 3 + 0]];
-			const auto B = BuoyantMeshVertices[TriangleMesh.TriangleVertexIndices[i * 3 + 1]];
-			const auto C = BuoyantMeshVertices[TriangleMesh.TriangleVertexIndices[i * 3 + 2]];
+			const auto BuoyantForce = FVector{0.f, 0.f, WaterDensity * GravityMagnitude * Sample.Volume};
+			AddMeshForce(FForce{BuoyantForce, PrimitiveCenterOfBuoyancy});
 
-			if (bDrawTriangles)
+			if (bSemiImplicitBuoyancy)
 			{
-				DrawDebugTriangle(debugWorld, A.Position, B.Position, C.Position, FColor::White, 4.f);
+				Stiffness.AddVerticalSpring(PrimitiveCenterOfBuoyancy,
+				                            WaterDensity * GravityMagnitude * Sample.WaterplaneArea);
+				Stiffness.AddVerticalForce(PrimitiveCenterOfBuoyancy, BuoyantForce.Z);
 			}
+		}
 
-			const auto Triangle = FBuoyantMeshTriangle::FromClockwiseVertices(A, B, C);
+		if (bUseDynamicForces)
+		{
+			const auto Velocity = GatheredBody.GetVelocityAtPoint(PrimitiveCenterOfBuoyancy);
+			const auto CrossSection = PI * FMath::Pow(3.f * Sample.Volume / (4.f * PI), 2.f / 3.f);
+			const auto Drag = -0.5f * WaterDensity * PrimitiveDragCoefficient * CrossSection * Velocity.Size() * Velocity;
+			AddMeshForce(FForce{Drag, PrimitiveCenterOfBuoyancy});
+		}
+	}
+
+	CenterOfBuoyancy = SubmergedVolume > 0.f ? VolumeMoment / SubmergedVolume : GatheredLocalToWorld.GetLocation();
+}
 
-			const auto SubTriangles = Triangle.GetSubmergedPortion(debugWorld, bDrawWaterline);
+FPlane UBuoyantMeshComponent::GetWaterPlane(const FBox& WorldBox) const
+{
+	const auto Center = WorldBox.GetCenter();
+	const FVector SamplePositions[] = {Center,
+	                                   FVector{WorldBox.Min.X, WorldBox.Min.Y, Center.Z},
+	                                   FVector{WorldBox.Max.X, WorldBox.Min.Y, Center.Z},
+	                                   FVector{WorldBox.Max.X, WorldBox.Max.Y, Center.Z},
+	                                   FVector{WorldBox.Min.X, WorldBox.Max.Y, Center.Z}};
 
-			for (const auto& SubTriangle : SubTriangles)
+	FPlane Plane;
+	float MaxResidual;
+	FitWaterPlane(MakeArrayView(SamplePositions), /*out*/ Plane, /*out*/ MaxResidual);
+	return Plane;
+}
+
+bool UBuoyantMeshComponent::FitWaterPlane(TArrayView<const FVector> SamplePositions,
+                                          FPlane& OutPlane,
+                                          float& OutMaxResidual) const
+{
+	check(SamplePositions.Num() > 0);
+
+	// Relative to the first position, so the fitted height at the origin is the water height under it.
+	const auto& Origin = SamplePositions[0];
+	TArray<FVector> WaterSamples;
+	for (const auto& Position : SamplePositions)
+	{
+		WaterSamples.Emplace(Position.X - Origin.X, Position.Y - Origin.Y, GetWaterHeight(Position));
+	}
+
+	FVector Plane;
+	if (!TMathUtilities::FitHeightPlane(WaterSamples, /*out*/ Plane, /*out*/ OutMaxResidual))
+	{
+		OutPlane = FPlane{FVector{Origin.X, Origin.Y, WaterSamples[0].Z}, FVector::UpVector};
+		return false;
+	}
+	OutPlane = FPlane{FVector{Origin.X, Origin.Y, Plane.X}, FVector{-Plane.Y, -Plane.Z, 1.f}.GetUnsafeNormal()};
+	return true;
+}
+
+void UBuoyantMeshComponent::UpdateWaterPlane()
+{
+	// Queried through the water surface, not a plane left over from the last fit.
+	bUseWaterPlaneThisTick = false;
+	if (!HullLocalBounds.IsValid) return;
+
+	// A 3x3 grid over the footprint of the hull, center first. Four samples more than the plane needs, so the residual
+	// tells the waves apart from a tilted surface. From the gathered transform rather than the component bounds, which
+	// aren't updated for a body state that wasn't gathered from the component.
+	const auto Box = HullLocalBounds.TransformBy(GatheredLocalToWorld);
+	const auto Center = Box.GetCenter();
+	TArray<FVector, TInlineAllocator<9>> SamplePositions;
+	SamplePositions.Add(Center);
+	for (int32 Y = 0; Y < 3; ++Y)
+	{
+		for (int32 X = 0; X < 3; ++X)
+		{
+			if (X == 1 && Y == 1) continue;
+			SamplePositions.Emplace(FMath::Lerp(Box.Min.X, Box.Max.X, X * 0.5f),
+			                        FMath::Lerp(Box.Min.Y, Box.Max.Y, Y * 0.5f),
+			                        Center.Z);
+		}
+	}
+
+	const auto bFitted = FitWaterPlane(SamplePositions, /*out*/ WaterPlane, /*out*/ WaterPlaneResidual);
+	if (!bFitted) return;
+
+	// Waves whose length divides the grid spacing meet every sample at the same phase, and fit a plane through all of
+	// them. The residual is checked between the samples too, at fractions of the footprint no such wavelength lines up
+	// with on both axes.
+	static const FVector2D CheckFractions[] = {FVector2D{0.309f, 0.809f}, FVector2D{0.809f, 0.309f}};
+	for (const auto& Fraction : CheckFractions)
+	{
+		const FVector Position{FMath::Lerp(Box.Min.X, Box.Max.X, Fraction.X),
+		                       FMath::Lerp(Box.Min.Y, Box.Max.Y, Fraction.Y),
+		                       Center.Z};
+		const auto PlaneHeight = Position.Z - WaterPlane.PlaneDot(Position) / WaterPlane.Z;
+		WaterPlaneResidual = FMath::Max(WaterPlaneResidual, FMath::Abs(GetWaterHeight(Position) - PlaneHeight));
+	}
+	bUseWaterPlaneThisTick = WaterPlaneResidual <= WaterPlaneTolerance;
+}
+
+void UBuoyantMeshComponent::UpdateWaterBand()
+{
+	// Water samples can't bound the crests and troughs between them, so only the provider can tell.
+	FFloatInterval WaterBounds{0.f, 0.f};
+	bHasWaterBand = !WaterSurface || WaterSurface->GetWaterHeightBounds(/*out*/ WaterBounds);
+	MinWaterHeight = WaterBounds.Min;
+	MaxWaterHeight = WaterBounds.Max;
+}
+
+bool UBuoyantMeshComponent::GetWaterHeightRange(const FBox& WorldBox, float& OutMinHeight, float& OutMaxHeight) const
+{
+	if (bUseWaterPlaneThisTick)
+	{
+		// The plane is highest and lowest at opposite corners of the footprint.
+		const FVector Low{WaterPlane.X * WaterPlane.Z >= 0.f ? WorldBox.Max.X : WorldBox.Min.X,
+		                  WaterPlane.Y * WaterPlane.Z >= 0.f ? WorldBox.Max.Y : WorldBox.Min.Y,
+		                  0.f};
+		const FVector High{WorldBox.Min.X + WorldBox.Max.X - Low.X, WorldBox.Min.Y + WorldBox.Max.Y - Low.Y, 0.f};
+		OutMinHeight = GetWaterHeight(Low);
+		OutMaxHeight = GetWaterHeight(High);
+		return true;
+	}
+	if (IsUsingWaterHeightmap())
+	{
+		FFloatInterval HeightRange;
+		const FBox2D Footprint{FVector2D{WorldBox.Min}, FVector2D{WorldBox.Max}};
+		if (!WaterHeightmap->GetHeightRange(Footprint, /*out*/ HeightRange)) return false;
+		OutMinHeight = HeightRange.Min;
+		OutMaxHeight = HeightRange.Max;
+		return true;
+	}
+	OutMinHeight = MinWaterHeight;
+	OutMaxHeight = MaxWaterHeight;
+	return bHasWaterBand;
+}
+
+bool UBuoyantMeshComponent::IsUsingWaterHeightmap() const
+{
+	return WaterSurface && bUseWaterPatch && IsValid(WaterHeightmap);
+}
+
+EBuoyantClusterState UBuoyantMeshComponent::GetClusterState(const FBuoyantMeshCluster& Cluster,
+                                                            const FTransform& LocalToWorld) const
+{
+	if (!bUseClusterCulling) return EBuoyantClusterState::Crossing;
+
+	const auto WorldBounds = Cluster.LocalBounds.TransformBy(LocalToWorld);
+	float MinHeight;
+	float MaxHeight;
+	if (!GetWaterHeightRange(WorldBounds, /*out*/ MinHeight, /*out*/ MaxHeight)) return EBuoyantClusterState::Crossing;
+
+	if (WorldBounds.Min.Z > MaxHeight) return EBuoyantClusterState::Dry;
+	if (WorldBounds.Max.Z < MinHeight) return EBuoyantClusterState::Wet;
+	return EBuoyantClusterState::Crossing;
+}
+
+void UBuoyantMeshComponent::EvaluateMeshForces()
+{
+	SCOPE_CYCLE_COUNTER(STAT_BuoyantMeshForces);
+
+	auto debugWorld = World;
+
+	// Fitted before anything queries the water, which then reads the plane if it is used.
+	bWaterPlaneFitted = false;
+	if (bFitWaterPlane)
+	{
+		UpdateWaterPlane();
+		bWaterPlaneFitted = bUseWaterPlaneThisTick;
+	}
+
+	// The submerged volume is integrated from tetrahedra with their apex on the water surface, so the waterline cap
+	// that closes the clipped hull contributes (almost) nothing and can be left out.
+	const auto ComponentLocation = GatheredLocalToWorld.GetLocation();
+	const FVector VolumeApex{ComponentLocation.X, ComponentLocation.Y, GetWaterHeight(ComponentLocation)};
+	float Volume = 0.f;
+	FVector VolumeMoment = FVector::ZeroVector;
+
+	const auto bUsePressureForces = bUseStaticForces && HydrostaticForceMode == EHydrostaticForceMode::Pressure;
+	const auto bNeedsSubtriangleForces = bUseDynamicForces || bUsePressureForces;
+
+	// With the water surface closing the hull, the waterplane is the wetted surface projected on it with the opposite
+	// sign. Each piece of it is a spring of the hydrostatic stiffness.
+	const auto bNeedsStiffness = bSemiImplicitBuoyancy && bUseStaticForces;
+	const auto WaterplaneStiffness = WaterDensity * GravityMagnitude;
+
+	// Submerged triangles are batched and clipped all at once, see FBuoyantMeshBatch. Drawing the waterline and the
+	// subtriangles needs them one at a time, so it goes through the per triangle path instead.
+	const auto bUseBatch = !bDrawWaterline && !bDrawSubtriangles;
+	// The subtriangle centers are sampled warm started from a corner of their triangle, like its vertices were.
+	const auto bNeedsCornerStates = bUsePressureForces && bAccurateWaterHeight;
+	if (bUseBatch)
+	{
+		TriangleBatch.Reset();
+		BatchInverseStates.Reset();
+	}
+
+	const auto ApplySubtriangle = [&](const FBuoyantMeshSubtriangle& SubTriangle,
+	                                  const FVector& TriangleNormal,
+	                                  const FWaterSurfaceInverseState& CornerState) {
+		BUOYANCY_TRACE_SUBTRIANGLES(1);
+
+		if (bDrawSubtriangles)
+		{
+			DrawDebugTriangle(debugWorld, SubTriangle.A, SubTriangle.B, SubTriangle.C, FColor::Yellow, 6.f);
+		}
+
+		const auto TetrahedronVolume = TMathUtilities::SignedVolumeOfTetrahedron(
+		    VolumeApex, SubTriangle.A, SubTriangle.B, SubTriangle.C, TriangleNormal);
+		Volume += TetrahedronVolume;
+		VolumeMoment += TetrahedronVolume * (VolumeApex + SubTriangle.A + SubTriangle.B + SubTriangle.C) / 4.f;
+
+		if (bNeedsStiffness)
+		{
+			Stiffness.AddVerticalSpring(SubTriangle.GetCenter(),
+			                            -WaterplaneStiffness * TriangleNormal.Z * SubTriangle.GetArea());
+		}
+
+		if (bNeedsSubtriangleForces)
+		{
+			const auto SubtriangleForce = GetSubmergedTriangleForce(SubTriangle, TriangleNormal, CornerState);
+			AddMeshForce(SubtriangleForce);
+		}
+	};
+
+	// With a water heightmap or the water plane each cluster gets its own water height range instead.
+	if (bUseClusterCulling && !bUseWaterPlaneThisTick && !IsUsingWaterHeightmap())
+	{
+		UpdateWaterBand();
+	}
+
+	// The samples only bound the heights the provider gives, not the ones of the plane, the heightmap or the inverse.
+	auto MaxWaterSlope = 0.f;
+	auto MaxWaterSpeed = 0.f;
+	const auto bReuseClassification = bReuseWaterlineClassification && WaterSurface && !bUseWaterPlaneThisTick &&
+	                                  !bAccurateWaterHeight && !IsUsingWaterHeightmap() &&
+	                                  WaterSurface->GetWaterHeightRateBounds(MaxWaterSlope, MaxWaterSpeed);
+	if (SampledWaterSurface != WaterSurface)
+	{
+		VertexWaterSamples.Reset();
+		SampledWaterSurface = WaterSurface;
+	}
+
+	DryClusterCount = 0;
+	WetClusterCount = 0;
+	CrossingClusterCount = 0;
+	int32 ClassifiedTriangleCount = 0;
+	int32 ReclippedTriangleCount = 0;
+	int32 RefinedTriangleCount = 0;
+	TArray<FBuoyantMeshSubtriangle, TInlineAllocator<2>> SubTriangles;
+
+	const auto MeshCount = MeshClusters.Num();
+	for (int32 MeshIndex = 0; MeshIndex < MeshCount; ++MeshIndex)
+	{
+		// Only one of them is set, depending on bUseCompactHull.
+		const auto TriangleMesh = TriangleMeshes.IsValidIndex(MeshIndex) ? &TriangleMeshes[MeshIndex] : nullptr;
+		const auto CompactMesh = CompactTriangleMeshes.IsValidIndex(MeshIndex) ? &CompactTriangleMeshes[MeshIndex] : nullptr;
+		BUOYANCY_TRACE_TRIANGLES(CompactMesh ? CompactMesh->GetTriangleCount()
+		                                     : TriangleMesh->TriangleVertexIndices.Num() / 3);
+
+		const auto GetVertexIndex = [&](int32 Index) {
+			return CompactMesh ? CompactMesh->GetIndex(Index) : TriangleMesh->TriangleVertexIndices[Index];
+		};
+		const auto GetLocalVertex = [&](int32 VertexIndex) {
+			return CompactMesh ? CompactMesh->GetVertex(VertexIndex) : TriangleMesh->Vertices[VertexIndex];
+		};
+		// The precomputed normal of the compact layout, or the normal of the world space corners.
+		const auto GetTriangleNormal = [&](int32 TriangleIndex, const FVector& A, const FVector& B, const FVector& C) {
+			return CompactMesh
+			           ? FCompactTriangleMesh::TransformNormal(GatheredLocalToWorld, CompactMesh->GetTriangleNormal(TriangleIndex))
+			           : FVector::CrossProduct(B - A, C - A).GetSafeNormal();
+		};
+
+		// Vertices are only transformed and sampled the first time a cluster that needs them uses them.
+		const auto VertexCount = CompactMesh ? CompactMesh->GetVertexCount() : TriangleMesh->Vertices.Num();
+		WorldVertices.SetNumUninitialized(VertexCount, false);
+		VertexHeightsAboveWater.SetNumUninitialized(VertexCount, false);
+		VertexUpdateStates.Reset();
+		VertexUpdateStates.SetNumZeroed(VertexCount, false);
+		VertexInverseStates.SetNum(MeshCount);
+		auto& InverseStates = VertexInverseStates[MeshIndex];
+		InverseStates.SetNum(VertexCount);
+		if (bReuseClassification)
+		{
+			VertexWaterSamples.SetNum(MeshCount);
+			VertexWaterSamples[MeshIndex].SetNum(VertexCount);
+		}
+
+		const auto AddBatchTriangle = [&](const FBuoyantMeshVertex& A,
+		                                  const FBuoyantMeshVertex& B,
+		                                  const FBuoyantMeshVertex& C,
+		                                  int32 CornerIndex) {
+			TriangleBatch.AddTriangle(A, B, C);
+			if (bNeedsCornerStates)
+			{
+				BatchInverseStates.Add(InverseStates[CornerIndex]);
+			}
+		};
+
+		const auto GetWorldVertex = [&](int32 VertexIndex) -> const FVector& {
+			if (VertexUpdateStates[VertexIndex] == 0)
+			{
+				WorldVertices[VertexIndex] = GatheredLocalToWorld.TransformPosition(GetLocalVertex(VertexIndex));
+				VertexUpdateStates[VertexIndex] = 1;
+			}
+			return WorldVertices[VertexIndex];
+		};
+		const auto GetBuoyantVertex = [&](int32 VertexIndex) {
+			const auto& WorldVertex = GetWorldVertex(VertexIndex);
+			if (VertexUpdateStates[VertexIndex] == 1)
 			{
-				if (bDrawSubtriangles)
+				VertexHeightsAboveWater[VertexIndex] = GetHeightAboveWater(WorldVertex, InverseStates[VertexIndex]);
+				VertexUpdateStates[VertexIndex] = 2;
+
+				if (bReuseClassification)
+				{
+					auto& Sample = VertexWaterSamples[MeshIndex][VertexIndex];
+					Sample.Position = WorldVertex;
+					Sample.Time = WaterTime;
+					Sample.HeightAboveWater = VertexHeightsAboveWater[VertexIndex];
+				}
+			}
+			return FBuoyantMeshVertex{WorldVertex, VertexHeightsAboveWater[VertexIndex]};
+		};
+		// 1 if the vertex is known to be underwater, from this tick or from its last sample if neither it nor the water
+		// can have moved enough since to cross the waterline, 0 if it is known to be above, -1 if it isn't known.
+		const auto GetKnownUnderwater = [&](int32 VertexIndex) {
+			if (VertexUpdateStates[VertexIndex] == 2) return VertexHeightsAboveWater[VertexIndex] < 0.f ? 1 : 0;
+
+			const auto& WorldVertex = GetWorldVertex(VertexIndex);
+			const auto& Sample = VertexWaterSamples[MeshIndex][VertexIndex];
+			const auto HorizontalDistance = FVector2D::Distance(FVector2D{WorldVertex}, FVector2D{Sample.Position});
+			const auto MaxChange = FMath::Abs(WorldVertex.Z - Sample.Position.Z) + MaxWaterSlope * HorizontalDistance +
+			                       MaxWaterSpeed * FMath::Abs(WaterTime - Sample.Time);
+			if (FMath::Abs(Sample.HeightAboveWater) <= MaxChange + ReuseClassificationMargin) return -1;
+			return Sample.HeightAboveWater < 0.f ? 1 : 0;
+		};
+
+		for (const auto& Cluster : MeshClusters[MeshIndex])
+		{
+			const auto ClusterState = GetClusterState(Cluster, GatheredLocalToWorld);
+
+			if (bDrawClusters)
+			{
+				const auto WorldBounds = Cluster.LocalBounds.TransformBy(GatheredLocalToWorld);
+				const auto ClusterColor = ClusterState == EBuoyantClusterState::Dry
+				                              ? FColor::White
+				                              : ClusterState == EBuoyantClusterState::Wet ? FColor::Blue : FColor::Yellow;
+				DrawDebugBox(debugWorld, WorldBounds.GetCenter(), WorldBounds.GetExtent(), ClusterColor);
+			}
+
+			if (ClusterState == EBuoyantClusterState::Dry)
+			{
+				++DryClusterCount;
+				continue;
+			}
+			else if (ClusterState == EBuoyantClusterState::Wet)
+			{
+				++WetClusterCount;
+			}
+			else
+			{
+				++CrossingClusterCount;
+			}
+
+			const auto LastTriangle = Cluster.FirstTriangle + Cluster.TriangleCount;
+			for (int32 i = Cluster.FirstTriangle; i < LastTriangle; ++i)
+			{
+				const auto IndexA = GetVertexIndex(i * 3 + 0);
+				const auto IndexB = GetVertexIndex(i * 3 + 1);
+				const auto IndexC = GetVertexIndex(i * 3 + 2);
+
+				// Whether the corners of a crossing triangle are all known to be underwater (1) or above it (0)
+				// without sampling them, with bReuseWaterlineClassification.
+				auto KnownUnderwater = -1;
+				if (ClusterState == EBuoyantClusterState::Crossing)
+				{
+					++ClassifiedTriangleCount;
+					if (bReuseClassification)
+					{
+						KnownUnderwater = GetKnownUnderwater(IndexA);
+						if (KnownUnderwater >= 0 && (GetKnownUnderwater(IndexB) != KnownUnderwater ||
+						                             GetKnownUnderwater(IndexC) != KnownUnderwater))
+						{
+							KnownUnderwater = -1;
+						}
+					}
+
+					if (KnownUnderwater == 0)
+					{
+						if (bDrawTriangles)
+						{
+							DrawDebugTriangle(debugWorld,
+							                  GetWorldVertex(IndexA),
+							                  GetWorldVertex(IndexB),
+							                  GetWorldVertex(IndexC),
+							                  FColor::White,
+							                  4.f);
+						}
+						continue;
+					}
+					else if (KnownUnderwater < 0)
+					{
+						++ReclippedTriangleCount;
+					}
+				}
+
+				if (ClusterState == EBuoyantClusterState::Wet || KnownUnderwater == 1)
+				{
+					// The whole triangle is submerged, no need to know the vertex heights.
+					const auto& A = GetWorldVertex(IndexA);
+					const auto& B = GetWorldVertex(IndexB);
+					const auto& C = GetWorldVertex(IndexC);
+
+					if (bDrawTriangles)
+					{
+						DrawDebugTriangle(debugWorld, A, B, C, FColor::White, 4.f);
+					}
+
+					if (bUseBatch)
+					{
+						AddBatchTriangle(FBuoyantMeshVertex{A, -1.f},
+						                 FBuoyantMeshVertex{B, -1.f},
+						                 FBuoyantMeshVertex{C, -1.f},
+						                 IndexA);
+						continue;
+					}
+
+					const auto TriangleNormal = GetTriangleNormal(i, A, B, C);
+					ApplySubtriangle(FBuoyantMeshSubtriangle{A, B, C}, TriangleNormal, InverseStates[IndexA]);
+				}
+				else
+				{
+					const auto A = GetBuoyantVertex(IndexA);
+					const auto B = GetBuoyantVertex(IndexB);
+					const auto C = GetBuoyantVertex(IndexC);
+
+					if (bDrawTriangles)
+					{
+						DrawDebugTriangle(debugWorld, A.Position, B.Position, C.Position, FColor::White, 4.f);
+					}
+
+					const auto Corners = FBuoyantMeshTriangle::GetUnderwaterCorners(A, B, C);
+					if (bRefineWaterline && Corners != 0 && Corners != 7)
+					{
+						RefineWaterlineTriangle(A, B, C, InverseStates[IndexA], /*out*/ RefinedVertices);
+						RefinedTriangleCount += RefinedVertices.Num() / 3;
+
+						const auto TriangleNormal = GetTriangleNormal(i, A.Position, B.Position, C.Position);
+						for (int32 Piece = 0; Piece < RefinedVertices.Num(); Piece += 3)
+						{
+							const auto& PieceA = RefinedVertices[Piece + 0];
+							const auto& PieceB = RefinedVertices[Piece + 1];
+							const auto& PieceC = RefinedVertices[Piece + 2];
+
+							if (bDrawTriangles)
+							{
+								DrawDebugTriangle(
+								    debugWorld, PieceA.Position, PieceB.Position, PieceC.Position, FColor::Cyan, 2.f);
+							}
+
+							const auto PieceCorners = FBuoyantMeshTriangle::GetUnderwaterCorners(PieceA, PieceB, PieceC);
+							if (PieceCorners == 0) continue;
+
+							if (bUseBatch)
+							{
+								AddBatchTriangle(PieceA, PieceB, PieceC, IndexA);
+								continue;
+							}
+
+							FBuoyantMeshTriangle::GetSubmergedPortion(
+							    PieceA, PieceB, PieceC, PieceCorners, /*out*/ SubTriangles, debugWorld, bDrawWaterline);
+							for (const auto& SubTriangle : SubTriangles)
+							{
+								ApplySubtriangle(SubTriangle, TriangleNormal, InverseStates[IndexA]);
+							}
+						}
+					}
+					else if (Corners == 0)
+					{
+						continue;
+					}
+					else if (bUseBatch)
+					{
+						AddBatchTriangle(A, B, C, IndexA);
+					}
+					else
+					{
+						FBuoyantMeshTriangle::GetSubmergedPortion(
+						    A, B, C, Corners, /*out*/ SubTriangles, debugWorld, bDrawWaterline);
+						const auto TriangleNormal = GetTriangleNormal(i, A.Position, B.Position, C.Position);
+						for (const auto& SubTriangle : SubTriangles)
+						{
+							ApplySubtriangle(SubTriangle, TriangleNormal, InverseStates[IndexA]);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if (bUseBatch)
+	{
+		const auto SubtriangleCount = TriangleBatch.Clip(VolumeApex, /*out*/ Volume, /*out*/ VolumeMoment);
+		BUOYANCY_TRACE_SUBTRIANGLES(SubtriangleCount);
+
+		if (bNeedsStiffness)
+		{
+			const auto Centers = TriangleBatch.GetSubtriangleCenters();
+			const auto Areas = TriangleBatch.GetSubtriangleAreas();
+			for (int32 Slot = 0; Slot < Areas.Num(); ++Slot)
+			{
+				if (Areas[Slot] == 0.f) continue;
+				Stiffness.AddVerticalSpring(
+				    Centers[Slot], -WaterplaneStiffness * TriangleBatch.GetSubtriangleNormal(Slot).Z * Areas[Slot]);
+			}
+		}
+
+		if (bNeedsSubtriangleForces && SubtriangleCount > 0)
+		{
+			const auto Centers = TriangleBatch.GetSubtriangleCenters();
+			SubtriangleCenterHeights.Reset();
+			if (bUsePressureForces)
+			{
+				// Only the slots with an area are sampled, the ISPC kernel leaves the centers of the others unset.
+				const auto Areas = TriangleBatch.GetSubtriangleAreas();
+				PressureSlots.Reset();
+				PressureSlotCenters.Reset();
+				PressureSlotInverseStates.Reset();
+				for (int32 Slot = 0; Slot < Areas.Num(); ++Slot)
+				{
+					if (Areas[Slot] == 0.f) continue;
+					PressureSlots.Add(Slot);
+					PressureSlotCenters.Add(Centers[Slot]);
+					if (bNeedsCornerStates)
+					{
+						// Both slots of a triangle start from its corner.
+						PressureSlotInverseStates.Add(BatchInverseStates[Slot / 2]);
+					}
+				}
+
+				SubtriangleCenterHeights.SetNumUninitialized(PressureSlots.Num());
+				if (bNeedsCornerStates)
+				{
+					GetHeightsAboveWater(PressureSlotCenters, PressureSlotInverseStates, SubtriangleCenterHeights);
+				}
+				else
+				{
+					GetHeightsAboveWater(PressureSlotCenters, SubtriangleCenterHeights);
+				}
+
+				// Spread the heights over their slots, from the last one so none is overwritten before it is moved.
+				SubtriangleCenterHeights.SetNumZeroed(Centers.Num());
+				for (int32 Index = PressureSlots.Num() - 1; Index >= 0; --Index)
 				{
-					DrawDebugTriangle(debugWorld, SubTriangle.A, SubTriangle.B, SubTriangle.C, FColor::Yellow, 6.f);
+					const auto Slot = PressureSlots[Index];
+					SubtriangleCenterHeights[Slot] = SubtriangleCenterHeights[Index];
+					if (Slot != Index)
+					{
+						SubtriangleCenterHeights[Index] = 0.f;
+					}
 				}
+			}
+
+			FBuoyantMeshForceSettings Settings;
+			Settings.WaterDensity = WaterDensity;
+			Settings.GravityMagnitude = GravityMagnitude;
+			Settings.bStaticForces = bUsePressureForces;
+			Settings.bDynamicForces = bUseDynamicForces;
+			TriangleBatch.EvaluateForces(SubtriangleCenterHeights, Settings, GatheredBody);
 
-				const auto SubtriangleForce = GetSubmergedTriangleForce(SubTriangle, Triangle.Normal);
-				ApplyMeshForce(SubtriangleForce);
+			// Unused slots have a zero force, which AddMeshForce skips.
+			const auto Forces = TriangleBatch.GetSubtriangleForces();
+			for (int32 Slot = 0; Slot < Forces.Num(); ++Slot)
+			{
+				AddMeshForce(FForce{Forces[Slot], Centers[Slot]});
 			}
 		}
 	}
+
+	INC_DWORD_STAT_BY(STAT_BuoyantMeshDryClusters, DryClusterCount);
+	INC_DWORD_STAT_BY(STAT_BuoyantMeshWetClusters, WetClusterCount);
+	INC_DWORD_STAT_BY(STAT_BuoyantMeshCrossingClusters, CrossingClusterCount);
+	INC_DWORD_STAT_BY(STAT_BuoyantMeshClassifiedTriangles, ClassifiedTriangleCount);
+	INC_DWORD_STAT_BY(STAT_BuoyantMeshReclippedTriangles, ReclippedTriangleCount);
+	INC_DWORD_STAT_BY(STAT_BuoyantMeshRefinedTriangles, RefinedTriangleCount);
+
+	ReclippedTriangleFraction =
+	    ClassifiedTriangleCount > 0 ? ReclippedTriangleCount / static_cast<float>(ClassifiedTriangleCount) : 0.f;
+
+	SubmergedVolume = FMath::Max(0.f, Volume);
+	CenterOfBuoyancy = FMath::IsNearlyZero(SubmergedVolume) ? ComponentLocation : VolumeMoment / Volume;
+
+	if (bUseStaticForces && HydrostaticForceMode == EHydrostaticForceMode::Volume)
+	{
+		const auto BuoyantForce = FVector{0.f, 0.f, WaterDensity * GravityMagnitude * SubmergedVolume};
+		AddMeshForce(FForce{BuoyantForce, CenterOfBuoyancy});
+	}
+
+	if (bNeedsStiffness)
+	{
+		Stiffness.AddVerticalForce(CenterOfBuoyancy, WaterDensity * GravityMagnitude * SubmergedVolume);
+	}
+}
+
+void UBuoyantMeshComponent::RefineWaterlineTriangle(const FBuoyantMeshVertex& A,
+                                                     const FBuoyantMeshVertex& B,
+                                                     const FBuoyantMeshVertex& C,
+                                                     const FWaterSurfaceInverseState& InverseState,
+                                                     TArray<FBuoyantMeshVertex>& OutVertices) const
+{
+	struct FPiece
+	{
+		FBuoyantMeshVertex A;
+		FBuoyantMeshVertex B;
+		FBuoyantMeshVertex C;
+		// Bit I of a vertex is set when it lies on edge I of the triangle being refined.
+		uint8 EdgesA;
+		uint8 EdgesB;
+		uint8 EdgesC;
+		int32 Depth;
+	};
+
+	OutVertices.Reset();
+	const auto MaxEdgeLengthSquared = FMath::Square(FMath::Max(1.f, WaterlineEdgeLength));
+
+	// Depth first, so the stack holds at most one piece per level beside the one being split.
+	TArray<FPiece, TInlineAllocator<MaxWaterlineRefinementDepth + 1>> Pieces;
+	Pieces.Add(FPiece{A, B, C, 0b101, 0b011, 0b110, 0});
+	while (Pieces.Num() > 0)
+	{
+		const auto Piece = Pieces.Pop(/*bAllowShrinking*/ false);
+		const FBuoyantMeshVertex* Vertices[] = {&Piece.A, &Piece.B, &Piece.C};
+		const uint8 VertexEdges[] = {Piece.EdgesA, Piece.EdgesB, Piece.EdgesC};
+
+		// Edge I goes from vertex I to the next one.
+		const float EdgeLengthsSquared[] = {FVector::DistSquared(Piece.A.Position, Piece.B.Position),
+		                                    FVector::DistSquared(Piece.B.Position, Piece.C.Position),
+		                                    FVector::DistSquared(Piece.C.Position, Piece.A.Position)};
+		int32 LongestEdge = 0;
+		for (int32 Edge = 1; Edge < 3; ++Edge)
+		{
+			if (EdgeLengthsSquared[Edge] > EdgeLengthsSquared[LongestEdge])
+			{
+				LongestEdge = Edge;
+			}
+		}
+
+		const auto Corners = FBuoyantMeshTriangle::GetUnderwaterCorners(Piece.A, Piece.B, Piece.C);
+		const auto bCrossesWaterline = Corners != 0 && Corners != 7;
+		if (!bCrossesWaterline || EdgeLengthsSquared[LongestEdge] <= MaxEdgeLengthSquared ||
+		    Piece.Depth >= MaxWaterlineRefinementDepth)
+		{
+			OutVertices.Add(Piece.A);
+			OutVertices.Add(Piece.B);
+			OutVertices.Add(Piece.C);
+			continue;
+		}
+
+		// Split the longest edge in its middle. Both halves keep the winding of the piece.
+		const auto StartIndex = LongestEdge;
+		const auto EndIndex = (LongestEdge + 1) % 3;
+		const auto OppositeIndex = (LongestEdge + 2) % 3;
+		const auto& Start = *Vertices[StartIndex];
+		const auto& End = *Vertices[EndIndex];
+		const auto& Opposite = *Vertices[OppositeIndex];
+		const auto MiddlePosition = (Start.Position + End.Position) * 0.5f;
+
+		// The water is only sampled inside the triangle. On its edges the height is interpolated between the corners,
+		// which is what the neighbor sharing the edge clips against when it isn't refined, or is refined differently.
+		// Otherwise the two would cut the shared edge at different points and leave a gap in the clipped hull.
+		const uint8 MiddleEdges = VertexEdges[StartIndex] & VertexEdges[EndIndex];
+		auto MiddleInverseState = InverseState;
+		const auto MiddleHeight = MiddleEdges != 0 ? (Start.Height + End.Height) * 0.5f
+		                                           : GetHeightAboveWater(MiddlePosition, MiddleInverseState);
+		const FBuoyantMeshVertex Middle{MiddlePosition, MiddleHeight};
+
+		Pieces.Add(FPiece{Start,
+		                  Middle,
+		                  Opposite,
+		                  VertexEdges[StartIndex],
+		                  MiddleEdges,
+		                  VertexEdges[OppositeIndex],
+		                  Piece.Depth + 1});
+		Pieces.Add(FPiece{
+		    Middle, End, Opposite, MiddleEdges, VertexEdges[EndIndex], VertexEdges[OppositeIndex], Piece.Depth + 1});
+	}
 }
 
-void UBuoyantMeshComponent::ApplyMeshForce(const FForce& Force)
+void UBuoyantMeshComponent::AddMeshForce(const FForce& Force)
 {
 	const auto ForceVector = bVerticalForcesOnly ? FVector{0.f, 0.f, Force.Vector.Z} : Force.Vector;
 	const auto bIsValidForce = !ForceVector.IsNearlyZero() && !ForceVector.ContainsNaN();
 	if (!bIsValidForce) return;
 
-	UpdatedComponent->AddForceAtLocation(ForceVector, Force.Point);
-	if (bDrawForceArrows)
-	{
-		DrawDebugLine(World, Force.Point - (ForceVector * ForceArrowSize * 0.0001f), Force.Point, FColor::Blue);
-	}
+	BUOYANCY_TRACE_FORCE(ForceVector);
+	PendingForces.Emplace(ForceVector, Force.Point);
 }
 
 FForce UBuoyantMeshComponent::GetSubmergedTriangleForce(const FBuoyantMeshSubtriangle& Subtriangle,
-                                                        const FVector& TriangleNormal) const
+                                                        const FVector& TriangleNormal,
+                                                        const FWaterSurfaceInverseState& CornerState) const
 {
 	const auto CenterPosition = Subtriangle.GetCenter();
-	const FBuoyantMeshVertex CenterVertex{CenterPosition, GetHeightAboveWater(CenterPosition)};
 	const auto TriangleArea = Subtriangle.GetArea();
 	if (FMath::IsNearlyZero(TriangleArea)) return FForce{FVector::ZeroVector, FVector::ZeroVector};
 
 	FVector Force = FVector::ZeroVector;
 
-	if (bUseStaticForces)
+	// In volume mode the hydrostatic force is applied once for the whole mesh.
+	if (bUseStaticForces && HydrostaticForceMode == EHydrostaticForceMode::Pressure)
 	{
+		auto CenterInverseState = CornerState;
+		const FBuoyantMeshVertex CenterVertex{CenterPosition, GetHeightAboveWater(CenterPosition, CenterInverseState)};
 		const auto StaticForce = FBuoyantMeshSubtriangle::GetHydrostaticForce(
 		    WaterDensity, GravityMagnitude, CenterVertex, TriangleNormal, TriangleArea);
 		Force += StaticForce;
@@ -250,7 +1340,7 @@ FForce UBuoyantMeshComponent::GetSubmergedTriangleForce(const FBuoyantMeshSubtri
 
 	if (bUseDynamicForces)
 	{
-		const auto CenterVelocity = UpdatedComponent->GetBodyInstance()->GetUnrealWorldVelocityAtPoint(CenterPosition);
+		const auto CenterVelocity = GatheredBody.GetVelocityAtPoint(CenterPosition);
 		const auto DynamicForce = FBuoyantMeshSubtriangle::GetHydrodynamicForce(
 		    WaterDensity, CenterPosition, CenterVelocity, TriangleNormal, TriangleArea);
 		Force += DynamicForce;
@@ -259,6 +1349,71 @@ FForce UBuoyantMeshComponent::GetSubmergedTriangleForce(const FBuoyantMeshSubtri
 	return FForce{Force, CenterPosition};
 }
 
+uint32 TMeshUtilities::SpreadBits(uint32 Value)
+{
+	// Insert two zero bits between each of the lower 10 bits.
+	Value &= 0x000003ff;
+	Value = (Value | (Value << 16)) & 0x030000ff;
+	Value = (Value | (Value << 8)) & 0x0300f00f;
+	Value = (Value | (Value << 4)) & 0x030c30c3;
+	Value = (Value | (Value << 2)) & 0x09249249;
+	return Value;
+}
+
+uint32 TMeshUtilities::GetMortonCode(const FVector& NormalizedPosition)
+{
+	const auto X = static_cast<uint32>(FMath::Clamp(NormalizedPosition.X * 1023.f, 0.f, 1023.f));
+	const auto Y = static_cast<uint32>(FMath::Clamp(NormalizedPosition.Y * 1023.f, 0.f, 1023.f));
+	const auto Z = static_cast<uint32>(FMath::Clamp(NormalizedPosition.Z * 1023.f, 0.f, 1023.f));
+	return (SpreadBits(X) << 2) | (SpreadBits(Y) << 1) | SpreadBits(Z);
+}
+
+FTriangleMesh TMeshUtilities::SortIntoClusters(const FTriangleMesh& TriangleMesh,
+                                               int32 TrianglesPerCluster,
+                                               TArray<FBuoyantMeshCluster>& OutClusters)
+{
+	const auto& Vertices = TriangleMesh.Vertices;
+	const auto& Indices = TriangleMesh.TriangleVertexIndices;
+	const auto TriangleCount = Indices.Num() / 3;
+	TrianglesPerCluster = FMath::Max(1, TrianglesPerCluster);
+
+	const FBox MeshBounds{Vertices};
+	const auto MeshSize = MeshBounds.GetSize().ComponentMax(FVector{KINDA_SMALL_NUMBER});
+
+	// Sort the triangles by the Morton code of their centroid.
+	TArray<TPair<uint32, int32>> SortKeys;
+	SortKeys.Reserve(TriangleCount);
+	for (int32 i = 0; i < TriangleCount; ++i)
+	{
+		const auto Centroid = (Vertices[Indices[i * 3 + 0]] + Vertices[Indices[i * 3 + 1]] + Vertices[Indices[i * 3 + 2]]) / 3.f;
+		SortKeys.Emplace(GetMortonCode((Centroid - MeshBounds.Min) / MeshSize), i);
+	}
+	SortKeys.Sort([](const TPair<uint32, int32>& A, const TPair<uint32, int32>& B) { return A.Key < B.Key; });
+
+	TArray<int32> SortedIndices;
+	SortedIndices.Reserve(Indices.Num());
+	OutClusters.Reset();
+	for (int32 SortedTriangle = 0; SortedTriangle < TriangleCount; ++SortedTriangle)
+	{
+		if (SortedTriangle % TrianglesPerCluster == 0)
+		{
+			OutClusters.Emplace(FBox{ForceInit}, SortedTriangle, 0);
+		}
+		auto& Cluster = OutClusters.Last();
+
+		const auto Triangle = SortKeys[SortedTriangle].Value;
+		for (int32 Corner = 0; Corner < 3; ++Corner)
+		{
+			const auto VertexIndex = Indices[Triangle * 3 + Corner];
+			SortedIndices.Add(VertexIndex);
+			Cluster.LocalBounds += Vertices[VertexIndex];
+		}
+		++Cluster.TriangleCount;
+	}
+
+	return FTriangleMesh{Vertices, SortedIndices};
+}
+
 TArray<FVector> TMeshUtilities::GetVertices(const PxTriangleMesh* TriangleMesh)
 {
 	// Get vertices
@@ -297,17 +1452,88 @@ TArray<int32> TMeshUtilities::GetTriangleVertexIndices(const PxTriangleMesh* Tri
 	return TriangleVertexIndicesUE;
 }
 
-// Reference: https://wiki.unrealengine.com/Accessing_mesh_triangles_and_vertex_positions_in_build
-TArray<FTriangleMesh> TMeshUtilities::GetTriangleMeshes(UStaticMeshComponent* StaticMeshComponent)
+TArray<FVector> TMeshUtilities::GetVertices(const PxConvexMesh* ConvexMesh, const FTransform& ElementTransform)
+{
+	const PxVec3* const VerticesPx = ConvexMesh->getVertices();
+	const PxU32 VertexCount = ConvexMesh->getNbVertices();
+
+	TArray<FVector> VerticesUE;
+	VerticesUE.Reserve(VertexCount);
+	for (PxU32 VertexIndex = 0; VertexIndex < VertexCount; ++VertexIndex)
+	{
+		VerticesUE.Add(ElementTransform.TransformPosition(P2UVector(VerticesPx[VertexIndex])));
+	}
+	return VerticesUE;
+}
+
+TArray<int32> TMeshUtilities::GetTriangleVertexIndices(const PxConvexMesh* ConvexMesh,
+                                                       const FTransform& ElementTransform)
+{
+	const PxVec3* const VerticesPx = ConvexMesh->getVertices();
+	const PxU8* const IndexBuffer = ConvexMesh->getIndexBuffer();
+
+	// A mirroring scale of the element turns the hull inside out, the winding is flipped to keep the normals outward.
+	const auto bIsMirrored = ElementTransform.GetDeterminant() < 0.f;
+
+	TArray<int32> TriangleVertexIndicesUE;
+	for (PxU32 PolygonIndex = 0; PolygonIndex < ConvexMesh->getNbPolygons(); ++PolygonIndex)
+	{
+		PxHullPolygon Polygon;
+		if (!ConvexMesh->getPolygonData(PolygonIndex, Polygon)) continue;
+
+		// The polygons are convex, so a fan from their first vertex covers them. The plane normal points out of the
+		// hull in mesh space, the fan is wound to match it whatever the winding of the polygon vertices.
+		const PxU8* const PolygonIndices = IndexBuffer + Polygon.mIndexBase;
+		const PxVec3 PlaneNormal{Polygon.mPlane[0], Polygon.mPlane[1], Polygon.mPlane[2]};
+		for (PxU16 Corner = 2; Corner < Polygon.mNbVerts; ++Corner)
+		{
+			const int32 A = PolygonIndices[0];
+			const int32 B = PolygonIndices[Corner - 1];
+			const int32 C = PolygonIndices[Corner];
+			const auto Normal = (VerticesPx[B] - VerticesPx[A]).cross(VerticesPx[C] - VerticesPx[A]);
+			const auto bIsOutward = (Normal.dot(PlaneNormal) >= 0.f) != bIsMirrored;
+
+			TriangleVertexIndicesUE.Add(A);
+			TriangleVertexIndicesUE.Add(bIsOutward ? B : C);
+			TriangleVertexIndicesUE.Add(bIsOutward ? C : B);
+		}
+	}
+	return TriangleVertexIndicesUE;
+}
+
+TArray<FTriangleMesh> TMeshUtilities::GetTriangleMeshes(UStaticMeshComponent* StaticMeshComponent,
+                                                        EBuoyantHullSource Source)
 {
 	if (!StaticMeshComponent) return {};
-	const auto BodySetup = StaticMeshComponent->GetBodySetup();
+	return GetTriangleMeshes(StaticMeshComponent->GetBodySetup(), Source);
+}
+
+// Reference: https://wiki.unrealengine.com/Accessing_mesh_triangles_and_vertex_positions_in_build
+TArray<FTriangleMesh> TMeshUtilities::GetTriangleMeshes(UBodySetup* BodySetup, EBuoyantHullSource Source)
+{
 	if (!BodySetup) return {};
 
 	TArray<FTriangleMesh> Meshes;
-	for (const auto TriangleMesh : BodySetup->TriMeshes)
+	if (Source != EBuoyantHullSource::SimpleCollision)
 	{
-		Meshes.Emplace(GetVertices(TriangleMesh), GetTriangleVertexIndices(TriangleMesh));
+		for (const auto TriangleMesh : BodySetup->TriMeshes)
+		{
+			Meshes.Emplace(GetVertices(TriangleMesh), GetTriangleVertexIndices(TriangleMesh));
+		}
+	}
+
+	// Boxes, spheres and capsules of the simple collision are not used, only the convex elements.
+	if (Source == EBuoyantHullSource::SimpleCollision || (Source == EBuoyantHullSource::Automatic && Meshes.Num() == 0))
+	{
+		for (const auto& ConvexElement : BodySetup->AggGeom.ConvexElems)
+		{
+			const auto ConvexMesh = ConvexElement.GetConvexMesh();
+			if (!ConvexMesh || ConvexMesh->getNbPolygons() == 0) continue;
+
+			const auto ElementTransform = ConvexElement.GetTransform();
+			Meshes.Emplace(GetVertices(ConvexMesh, ElementTransform),
+			               GetTriangleVertexIndices(ConvexMesh, ElementTransform));
+		}
 	}
 	return Meshes;
 }
@@ -324,14 +1550,62 @@ float TMathUtilities::SignedVolumeOfTriangle(const FVector& p1, const FVector& p
 	return (1.0f / 6.0f) * (-v321 + v231 + v312 - v132 - v213 + v123);
 }
 
+float TMathUtilities::SignedVolumeOfTetrahedron(
+    const FVector& Apex, const FVector& A, const FVector& B, const FVector& C, const FVector& OutwardNormal)
+{
+	// Subtriangles lose their winding when they are cut, so orient them with the normal of the original triangle.
+	const auto bIsWindingOutward = (FVector::CrossProduct(B - A, C - A) | OutwardNormal) >= 0.f;
+	return bIsWindingOutward ? SignedVolumeOfTriangle(A - Apex, B - Apex, C - Apex)
+	                         : SignedVolumeOfTriangle(A - Apex, C - Apex, B - Apex);
+}
+
+bool TMathUtilities::FitHeightPlane(const TArray<FVector>& Points, FVector& OutCoefficients, float& OutMaxResidual)
+{
+	if (Points.Num() < 3) return false;
+
+	// Center the points so the normal equations decouple and stay well conditioned.
+	auto Mean = FVector::ZeroVector;
+	for (const auto& Point : Points)
+	{
+		Mean += Point;
+	}
+	Mean /= Points.Num();
+
+	float Sxx = 0.f, Sxy = 0.f, Syy = 0.f, Sxz = 0.f, Syz = 0.f;
+	for (const auto& Point : Points)
+	{
+		const auto Centered = Point - Mean;
+		Sxx += Centered.X * Centered.X;
+		Sxy += Centered.X * Centered.Y;
+		Syy += Centered.Y * Centered.Y;
+		Sxz += Centered.X * Centered.Z;
+		Syz += Centered.Y * Centered.Z;
+	}
+
+	const auto Determinant = Sxx * Syy - Sxy * Sxy;
+	if (FMath::Abs(Determinant) <= SMALL_NUMBER * FMath::Max(1.f, Sxx * Syy)) return false;
+
+	const auto SlopeX = (Sxz * Syy - Syz * Sxy) / Determinant;
+	const auto SlopeY = (Syz * Sxx - Sxz * Sxy) / Determinant;
+	OutCoefficients = FVector{Mean.Z - SlopeX * Mean.X - SlopeY * Mean.Y, SlopeX, SlopeY};
+
+	OutMaxResidual = 0.f;
+	for (const auto& Point : Points)
+	{
+		const auto PlaneHeight = OutCoefficients.X + OutCoefficients.Y * Point.X + OutCoefficients.Z * Point.Y;
+		OutMaxResidual = FMath::Max(OutMaxResidual, FMath::Abs(Point.Z - PlaneHeight));
+	}
+	return true;
+}
+
 // References:
 // http://stackoverflow.com/questions/1406029/how-to-calculate-the-volume-of-a-3d-mesh-object-the-surface-of-which-is-made-up-t
 // http://research.microsoft.com/en-us/um/people/chazhang/publications/icip01_ChaZhang.pdf
 // TODO: Use local space for float precision.
-float TMathUtilities::MeshVolume(UStaticMeshComponent* StaticMeshComponent)
+float TMathUtilities::MeshVolume(UStaticMeshComponent* StaticMeshComponent, EBuoyantHullSource Source)
 {
 	float Volume = 0.f;
-	for (const auto& TriangleMesh : TMeshUtilities::GetTriangleMeshes(StaticMeshComponent))
+	for (const auto& TriangleMesh : TMeshUtilities::GetTriangleMeshes(StaticMeshComponent, Source))
 	{
 		const auto TriangleCount = TriangleMesh.TriangleVertexIndices.Num() / 3;
 		for (int32 i = 0; i < TriangleCount; ++i)
@@ -144,3 +144,71 @@ TArray<FBuoyantMeshSubtriangle> FBuoyantMeshTriangle::GetSubmergedPortion(const
 		return {};
 	}
 }
+
+uint8 FBuoyantMeshTriangle::GetUnderwaterCorners(const FBuoyantMeshVertex& A,
+                                                 const FBuoyantMeshVertex& B,
+                                                 const FBuoyantMeshVertex& C)
+{
+	return (A.IsUnderwater() ? 1 : 0) | (B.IsUnderwater() ? 2 : 0) | (C.IsUnderwater() ? 4 : 0);
+}
+
+void FBuoyantMeshTriangle::GetSubmergedPortion(const FBuoyantMeshVertex& A,
+                                               const FBuoyantMeshVertex& B,
+                                               const FBuoyantMeshVertex& C,
+                                               uint8 UnderwaterCorners,
+                                               TArray<FBuoyantMeshSubtriangle, TInlineAllocator<2>>& OutSubtriangles,
+                                               const UWorld* World,
+                                               bool bDrawWaterline)
+{
+	OutSubtriangles.Reset();
+
+	const FBuoyantMeshVertex* const Corners[] = {&A, &B, &C};
+
+	switch (UnderwaterCorners)
+	{
+		case 0:
+			// No submerged part.
+			break;
+		case 7:
+			// Return the entire triangle.
+			OutSubtriangles.Emplace(A.Position, B.Position, C.Position);
+			break;
+		case 1:
+		case 2:
+		case 4:
+		{
+			// One vertex is below water, see Figure 8 in the article in the header.
+			const auto LowIndex = UnderwaterCorners == 1 ? 0 : UnderwaterCorners == 2 ? 1 : 2;
+			const auto& Low = *Corners[LowIndex];
+			const auto& Other1 = *Corners[(LowIndex + 1) % 3];
+			const auto& Other2 = *Corners[(LowIndex + 2) % 3];
+
+			const auto Cut1 = FindCutOnEdge(Low, Other1, -Low.Height / (Other1.Height - Low.Height));
+			const auto Cut2 = FindCutOnEdge(Low, Other2, -Low.Height / (Other2.Height - Low.Height));
+			if (bDrawWaterline && IsValid(World))
+			{
+				DrawDebugLine(World, Cut1, Cut2, FColor::Blue, false, -1.f, 0, 10.f);
+			}
+			OutSubtriangles.Emplace(Cut2, Cut1, Low.Position);
+			break;
+		}
+		default:
+		{
+			// One vertex is above water, see Figure 7 in the article in the header.
+			const auto HighIndex = UnderwaterCorners == 6 ? 0 : UnderwaterCorners == 5 ? 1 : 2;
+			const auto& High = *Corners[HighIndex];
+			const auto& Under1 = *Corners[(HighIndex + 1) % 3];
+			const auto& Under2 = *Corners[(HighIndex + 2) % 3];
+
+			const auto Cut1 = FindCutOnEdge(Under1, High, -Under1.Height / (High.Height - Under1.Height));
+			const auto Cut2 = FindCutOnEdge(Under2, High, -Under2.Height / (High.Height - Under2.Height));
+			if (bDrawWaterline && IsValid(World))
+			{
+				DrawDebugLine(World, Cut1, Cut2, FColor::Blue, false, -1.f, 0, 16.f);
+			}
+			OutSubtriangles.Emplace(Under1.Position, Cut1, Under2.Position);
+			OutSubtriangles.Emplace(Cut1, Cut2, Under2.Position);
+			break;
+		}
+	}
+}
@@ -0,0 +1,561 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "BuoyantMesh/BuoyantPrimitive.h"
+#include "BuoyantMesh/BuoyantMeshComponent.h"
+#include "PhysicsEngine/BodySetup.h"
+
+
+static const double Pi = 3.14159265358979323846;
+
+// Normal components below this are taken as zero. The error it makes on the water height across the primitive is
+// this fraction of its size.
+static const double AxisEpsilon = 1.e-4;
+
+// Eight point Gauss-Legendre rule on [-1, 1].
+static const double GaussNodes[] = {-0.9602898564975363, -0.7966664774136267, -0.5255324099163290, -0.1834346424956498,
+                                    0.1834346424956498,  0.5255324099163290,  0.7966664774136267,  0.9602898564975363};
+static const double GaussWeights[] = {0.1012285362903763, 0.2223810344533745, 0.3137066458778873, 0.3626837833783620,
+                                      0.3626837833783620, 0.3137066458778873, 0.2223810344533745, 0.1012285362903763};
+
+// Submerged volume, its first moment and the waterplane area of a primitive, in its own frame. Doubles, and the C math
+// functions rather than the float FMath ones, since the closed forms subtract large terms when the water plane is
+// almost parallel to a face or to the capsule axis.
+struct FLocalHydrostatics
+{
+	double Volume = 0.0;
+	double Moment[3] = {0.0, 0.0, 0.0};
+	double WaterplaneArea = 0.0;
+
+	void Add(const FLocalHydrostatics& Other)
+	{
+		Volume += Other.Volume;
+		WaterplaneArea += Other.WaterplaneArea;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			Moment[Axis] += Other.Moment[Axis];
+		}
+	}
+};
+
+// In all the functions below, the primitive is centered on the origin and the water is where N | X <= Offset, with N
+// of unit length.
+
+static FLocalHydrostatics GetSubmergedSphere(double Radius, const double N[3], double Offset)
+{
+	FLocalHydrostatics Result;
+	const auto CapHeight = FMath::Clamp(Radius + Offset, 0.0, 2.0 * Radius);
+	if (CapHeight <= 0.0) return Result;
+
+	Result.Volume = Pi * CapHeight * CapHeight * (3.0 * Radius - CapHeight) / 3.0;
+
+	// The centroid of the cap is on the normal through the center, this far below it.
+	const auto CentroidDepth = 3.0 * FMath::Square(2.0 * Radius - CapHeight) / (4.0 * (3.0 * Radius - CapHeight));
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		Result.Moment[Axis] = -Result.Volume * CentroidDepth * N[Axis];
+	}
+
+	if (FMath::Abs(Offset) < Radius)
+	{
+		Result.WaterplaneArea = Pi * (Radius * Radius - Offset * Offset);
+	}
+	return Result;
+}
+
+static FLocalHydrostatics GetSubmergedBox(const double HalfExtent[3], const double N[3], double Offset)
+{
+	FLocalHydrostatics Result;
+
+	// Mirror the axes so the normal has no negative component, and put the origin on the lowest corner.
+	double Sign[3], Normal[3], Size[3];
+	auto CornerOffset = Offset;
+	auto Reach = 0.0;
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		Sign[Axis] = N[Axis] < 0.0 ? -1.0 : 1.0;
+		Normal[Axis] = FMath::Abs(N[Axis]);
+		Size[Axis] = 2.0 * HalfExtent[Axis];
+		CornerOffset += Normal[Axis] * HalfExtent[Axis];
+		Reach += Normal[Axis] * Size[Axis];
+	}
+	if (CornerOffset <= 0.0) return Result;
+
+	if (CornerOffset >= Reach)
+	{
+		Result.Volume = Size[0] * Size[1] * Size[2];
+		return Result;
+	}
+
+	// Axes the plane is parallel to don't change the submerged part along them, they are factored out.
+	int32 Axes[3];
+	int32 AxisCount = 0;
+	auto NormalProduct = 1.0;
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		if (Normal[Axis] > AxisEpsilon)
+		{
+			Axes[AxisCount++] = Axis;
+			NormalProduct *= Normal[Axis];
+		}
+	}
+
+	// The box is the alternating sum of the octants with their apex on its corners. Each octant clipped by the plane
+	// is a simplex, whose volume and centroid are known.
+	static const double Factorials[] = {1.0, 1.0, 2.0, 6.0};
+	double Moment[3] = {0.0, 0.0, 0.0};
+	for (int32 Corner = 0; Corner < (1 << AxisCount); ++Corner)
+	{
+		double Apex[3] = {0.0, 0.0, 0.0};
+		auto Remaining = CornerOffset;
+		auto CornerSign = 1.0;
+		for (int32 Index = 0; Index < AxisCount; ++Index)
+		{
+			if (Corner & (1 << Index))
+			{
+				const auto Axis = Axes[Index];
+				Apex[Axis] = Size[Axis];
+				Remaining -= Normal[Axis] * Size[Axis];
+				CornerSign = -CornerSign;
+			}
+		}
+		if (Remaining <= 0.0) continue;
+
+		const auto SimplexVolume =
+		    CornerSign * pow(Remaining, double(AxisCount)) / (Factorials[AxisCount] * NormalProduct);
+		Result.Volume += SimplexVolume;
+		Result.WaterplaneArea +=
+		    CornerSign * pow(Remaining, double(AxisCount - 1)) / (Factorials[AxisCount - 1] * NormalProduct);
+		for (int32 Index = 0; Index < AxisCount; ++Index)
+		{
+			const auto Axis = Axes[Index];
+			Moment[Axis] += SimplexVolume * (Apex[Axis] + Remaining / ((AxisCount + 1) * Normal[Axis]));
+		}
+	}
+	if (Result.Volume <= 0.0) return FLocalHydrostatics{};
+
+	double Centroid[3];
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		Centroid[Axis] = Size[Axis] / 2.0;
+	}
+	for (int32 Index = 0; Index < AxisCount; ++Index)
+	{
+		Centroid[Axes[Index]] = Moment[Axes[Index]] / Result.Volume;
+	}
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		if (Normal[Axis] <= AxisEpsilon)
+		{
+			Result.Volume *= Size[Axis];
+			Result.WaterplaneArea *= Size[Axis];
+		}
+	}
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		Result.Moment[Axis] = Result.Volume * Sign[Axis] * (Centroid[Axis] - HalfExtent[Axis]);
+	}
+	return Result;
+}
+
+// Area of the part of a disc of Radius at the origin where X <= Chord.
+static double GetSegmentArea(double Radius, double Chord)
+{
+	if (Chord <= -Radius) return 0.0;
+	if (Chord >= Radius) return Pi * Radius * Radius;
+	return Radius * Radius * (Pi - acos(Chord / Radius)) + Chord * sqrt(Radius * Radius - Chord * Chord);
+}
+
+// Integrals of the segment area, of the chord times the segment area, and of the first moment of the segment, from
+// -Radius to Chord.
+static double IntegrateSegmentArea(double Radius, double Chord)
+{
+	const auto R2 = Radius * Radius;
+	if (Chord <= -Radius) return 0.0;
+	if (Chord >= Radius) return Pi * R2 * Chord;
+
+	const auto Root = sqrt(R2 - Chord * Chord);
+	return R2 * (Pi * Chord - Chord * acos(Chord / Radius) + Root) - Root * Root * Root / 3.0;
+}
+
+static double IntegrateChordSegmentArea(double Radius, double Chord)
+{
+	const auto R2 = Radius * Radius;
+	const auto R4 = R2 * R2;
+	if (Chord <= -Radius) return 0.0;
+	if (Chord >= Radius) return 3.0 * Pi * R4 / 8.0 + Pi * R2 * (Chord * Chord - R2) / 2.0;
+
+	const auto C2 = Chord * Chord;
+	const auto Root = sqrt(R2 - C2);
+	return Pi * R2 * C2 / 2.0 - R2 * C2 * acos(Chord / Radius) / 2.0 + Chord * (R2 + 2.0 * C2) * Root / 8.0 -
+	       R4 * asin(Chord / Radius) / 8.0 - Pi * R4 / 16.0;
+}
+
+static double IntegrateSegmentMoment(double Radius, double Chord)
+{
+	const auto R2 = Radius * Radius;
+	const auto R4 = R2 * R2;
+	Chord = FMath::Clamp(Chord, -Radius, Radius);
+
+	const auto Root = sqrt(R2 - Chord * Chord);
+	const auto Primitive = Chord * (5.0 * R2 - 2.0 * Chord * Chord) * Root / 8.0 + 3.0 * R4 * asin(Chord / Radius) / 8.0;
+	return -2.0 / 3.0 * (Primitive + 3.0 * Pi * R4 / 16.0);
+}
+
+// Cylinder along Z, from -HalfLength to HalfLength. In each cross section the water covers a circular segment, whose
+// chord moves linearly along the axis.
+static FLocalHydrostatics GetSubmergedCylinder(double Radius, double HalfLength, const double N[3], double Offset)
+{
+	FLocalHydrostatics Result;
+	const auto CrossNormal = sqrt(N[0] * N[0] + N[1] * N[1]);
+	const auto AxialNormal = N[2];
+
+	if (CrossNormal <= AxisEpsilon)
+	{
+		// Level cross sections, the water covers a range of the axis.
+		const auto Level = Offset / AxialNormal;
+		const auto Low = AxialNormal > 0.0 ? -HalfLength : FMath::Max(-HalfLength, Level);
+		const auto High = AxialNormal > 0.0 ? FMath::Min(HalfLength, Level) : HalfLength;
+		if (High <= Low) return Result;
+
+		Result.Volume = Pi * Radius * Radius * (High - Low);
+		Result.Moment[2] = Result.Volume * (High + Low) / 2.0;
+		if (FMath::Abs(Level) < HalfLength)
+		{
+			Result.WaterplaneArea = Pi * Radius * Radius / FMath::Abs(AxialNormal);
+		}
+		return Result;
+	}
+
+	// First moment of the segments along the direction of the normal in the cross section.
+	double CrossMoment;
+	auto AxialMoment = 0.0;
+	if (FMath::Abs(AxialNormal) <= AxisEpsilon)
+	{
+		const auto Chord = Offset / CrossNormal;
+		Result.Volume = 2.0 * HalfLength * GetSegmentArea(Radius, Chord);
+		CrossMoment = 2.0 * HalfLength *
+		              (FMath::Abs(Chord) < Radius ? -2.0 / 3.0 * pow(Radius * Radius - Chord * Chord, 1.5) : 0.0);
+		if (FMath::Abs(Chord) < Radius)
+		{
+			Result.WaterplaneArea = 4.0 * HalfLength * sqrt(Radius * Radius - Chord * Chord) / CrossNormal;
+		}
+	}
+	else
+	{
+		// Distance of the chord from the axis at both ends, along the direction of the normal in the cross section.
+		const auto BottomChord = (Offset + AxialNormal * HalfLength) / CrossNormal;
+		const auto TopChord = (Offset - AxialNormal * HalfLength) / CrossNormal;
+		const auto Scale = CrossNormal / AxialNormal;
+
+		const auto AreaIntegral = IntegrateSegmentArea(Radius, BottomChord) - IntegrateSegmentArea(Radius, TopChord);
+		const auto ChordAreaIntegral =
+		    IntegrateChordSegmentArea(Radius, BottomChord) - IntegrateChordSegmentArea(Radius, TopChord);
+		Result.Volume = Scale * AreaIntegral;
+		CrossMoment = Scale * (IntegrateSegmentMoment(Radius, BottomChord) - IntegrateSegmentMoment(Radius, TopChord));
+		AxialMoment = Scale / AxialNormal * (Offset * AreaIntegral - CrossNormal * ChordAreaIntegral);
+		Result.WaterplaneArea =
+		    (GetSegmentArea(Radius, BottomChord) - GetSegmentArea(Radius, TopChord)) / AxialNormal;
+	}
+	if (Result.Volume <= 0.0) return FLocalHydrostatics{};
+
+	Result.Moment[0] = CrossMoment * N[0] / CrossNormal;
+	Result.Moment[1] = CrossMoment * N[1] / CrossNormal;
+	Result.Moment[2] = AxialMoment;
+	return Result;
+}
+
+// Half of the sphere of Radius at Center, on the side of the unit axis Outward. It is sliced parallel to the water
+// plane. Slices are whole discs or empty where the flat face doesn't cross them, the others are integrated in the
+// angle of the slice position, where they are smooth.
+static FLocalHydrostatics GetSubmergedHemisphere(double Radius,
+                                                 const double Center[3],
+                                                 const double Outward[3],
+                                                 const double N[3],
+                                                 double Offset)
+{
+	FLocalHydrostatics Result;
+	const auto CenterHeight = N[0] * Center[0] + N[1] * Center[1] + N[2] * Center[2] - Offset;
+	const auto Top = FMath::Min(Radius, -CenterHeight);
+	if (Top <= -Radius) return Result;
+
+	const auto Alignment = N[0] * Outward[0] + N[1] * Outward[1] + N[2] * Outward[2];
+	const auto Tilt = sqrt(FMath::Max(0.0, 1.0 - Alignment * Alignment));
+	// The flat face spans slices within Band of the center.
+	const auto Band = Tilt > AxisEpsilon ? Tilt * Radius : 0.0;
+	const auto R2 = Radius * Radius;
+
+	auto Volume = 0.0;
+	auto NormalMoment = 0.0;
+	auto CrossMoment = 0.0;
+
+	// Whole discs on the side the hemisphere bulges towards.
+	const auto DiscLow = Alignment > 0.0 ? Band : -Radius;
+	const auto DiscHigh = FMath::Min(Alignment > 0.0 ? Radius : -Band, Top);
+	if (DiscHigh > DiscLow)
+	{
+		const auto VolumeIntegral = [&](double S) { return Pi * (R2 * S - S * S * S / 3.0); };
+		const auto MomentIntegral = [&](double S) { return Pi * (R2 * S * S / 2.0 - S * S * S * S / 4.0); };
+		Volume += VolumeIntegral(DiscHigh) - VolumeIntegral(DiscLow);
+		NormalMoment += MomentIntegral(DiscHigh) - MomentIntegral(DiscLow);
+	}
+
+	// Within the band, the part of the slice at S beyond the face is the disc past the chord at ChordSlope * S.
+	const auto ChordSlope = Band > 0.0 ? -Alignment / Tilt : 0.0;
+	const auto GetSliceArea = [&](double S, double ChordRoot) {
+		const auto SliceRadius = sqrt(R2 - S * S);
+		return (R2 - S * S) * acos(FMath::Clamp(ChordSlope * S / SliceRadius, -1.0, 1.0)) -
+		       ChordSlope * S * ChordRoot;
+	};
+
+	const auto BandHigh = FMath::Min(Band, Top);
+	if (Band > 0.0 && BandHigh > -Band)
+	{
+		const auto LowAngle = -Pi / 2.0;
+		const auto HighAngle = asin(FMath::Clamp(BandHigh / Band, -1.0, 1.0));
+		for (int32 Node = 0; Node < ARRAY_COUNT(GaussNodes); ++Node)
+		{
+			const auto Angle = (LowAngle + HighAngle) / 2.0 + (HighAngle - LowAngle) / 2.0 * GaussNodes[Node];
+			const auto S = Band * sin(Angle);
+			const auto Weight = Band * cos(Angle) * (HighAngle - LowAngle) / 2.0 * GaussWeights[Node];
+			// Half the chord length, which vanishes at the edges of the band.
+			const auto ChordRoot = Radius * cos(Angle);
+
+			const auto SliceArea = GetSliceArea(S, ChordRoot);
+			Volume += SliceArea * Weight;
+			NormalMoment += S * SliceArea * Weight;
+			CrossMoment += 2.0 / 3.0 * ChordRoot * ChordRoot * ChordRoot * Weight;
+		}
+	}
+	if (Volume <= 0.0) return Result;
+
+	// The waterplane area is the slice at the water.
+	const auto WaterSlice = -CenterHeight;
+	if (FMath::Abs(WaterSlice) < Radius)
+	{
+		if (FMath::Abs(WaterSlice) < Band)
+		{
+			const auto ChordRoot = sqrt(FMath::Max(0.0, R2 - FMath::Square(WaterSlice / Tilt)));
+			Result.WaterplaneArea = GetSliceArea(WaterSlice, ChordRoot);
+		}
+		else if ((WaterSlice > 0.0) == (Alignment > 0.0))
+		{
+			Result.WaterplaneArea = Pi * (R2 - WaterSlice * WaterSlice);
+		}
+	}
+
+	Result.Volume = Volume;
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		// Direction of the flat face within the slices, towards the hemisphere.
+		const auto CrossDirection = Band > 0.0 ? (Outward[Axis] - Alignment * N[Axis]) / Tilt : 0.0;
+		Result.Moment[Axis] = Volume * Center[Axis] + NormalMoment * N[Axis] + CrossMoment * CrossDirection;
+	}
+	return Result;
+}
+
+static FLocalHydrostatics GetSubmergedCapsule(double Radius, double HalfLength, const double N[3], double Offset)
+{
+	auto Result = GetSubmergedCylinder(Radius, HalfLength, N, Offset);
+	for (const auto Side : {-1.0, 1.0})
+	{
+		const double Center[] = {0.0, 0.0, Side * HalfLength};
+		const double Outward[] = {0.0, 0.0, Side};
+		Result.Add(GetSubmergedHemisphere(Radius, Center, Outward, N, Offset));
+	}
+	return Result;
+}
+
+TArray<FBuoyantPrimitive> FBuoyantPrimitive::GetPrimitives(const UBodySetup* BodySetup)
+{
+	TArray<FBuoyantPrimitive> Primitives;
+	if (!BodySetup) return Primitives;
+
+	const auto& AggGeom = BodySetup->AggGeom;
+	for (const auto& SphereElement : AggGeom.SphereElems)
+	{
+		FBuoyantPrimitive Primitive;
+		Primitive.Shape = EBuoyantPrimitiveShape::Sphere;
+		Primitive.Transform = SphereElement.GetTransform();
+		Primitive.Radius = SphereElement.Radius;
+		Primitives.Add(Primitive);
+	}
+	for (const auto& BoxElement : AggGeom.BoxElems)
+	{
+		FBuoyantPrimitive Primitive;
+		Primitive.Shape = EBuoyantPrimitiveShape::Box;
+		Primitive.Transform = BoxElement.GetTransform();
+		Primitive.HalfExtent = FVector{BoxElement.X, BoxElement.Y, BoxElement.Z} / 2.f;
+		Primitives.Add(Primitive);
+	}
+	for (const auto& SphylElement : AggGeom.SphylElems)
+	{
+		FBuoyantPrimitive Primitive;
+		Primitive.Shape = EBuoyantPrimitiveShape::Capsule;
+		Primitive.Transform = SphylElement.GetTransform();
+		Primitive.Radius = SphylElement.Radius;
+		Primitive.HalfExtent = FVector{0.f, 0.f, SphylElement.Length / 2.f};
+		Primitives.Add(Primitive);
+	}
+	return Primitives;
+}
+
+FBuoyantPrimitive FBuoyantPrimitive::GetTransformed(const FTransform& LocalToWorld) const
+{
+	const auto Scale = LocalToWorld.GetScale3D().GetAbs();
+
+	auto Result = *this;
+	Result.Transform = FTransform{LocalToWorld.GetRotation() * Transform.GetRotation(),
+	                              LocalToWorld.TransformPosition(Transform.GetLocation())};
+	switch (Shape)
+	{
+		case EBuoyantPrimitiveShape::Sphere:
+			Result.Radius = Radius * Scale.GetMin();
+			break;
+		case EBuoyantPrimitiveShape::Box:
+			Result.HalfExtent = HalfExtent * Scale;
+			break;
+		case EBuoyantPrimitiveShape::Capsule:
+			Result.Radius = Radius * FMath::Max(Scale.X, Scale.Y);
+			Result.HalfExtent = HalfExtent * Scale;
+			break;
+	}
+	return Result;
+}
+
+float FBuoyantPrimitive::GetVolume() const
+{
+	const auto SphereVolume = 4.f / 3.f * PI * Radius * Radius * Radius;
+	switch (Shape)
+	{
+		case EBuoyantPrimitiveShape::Box:
+			return 8.f * HalfExtent.X * HalfExtent.Y * HalfExtent.Z;
+		case EBuoyantPrimitiveShape::Capsule:
+			return SphereVolume + PI * Radius * Radius * 2.f * HalfExtent.Z;
+		default:
+			return SphereVolume;
+	}
+}
+
+FBox FBuoyantPrimitive::GetBounds() const
+{
+	if (Shape == EBuoyantPrimitiveShape::Box)
+	{
+		FBox Bounds{ForceInit};
+		for (int32 Corner = 0; Corner < 8; ++Corner)
+		{
+			const FVector Signs{Corner & 1 ? 1.f : -1.f, Corner & 2 ? 1.f : -1.f, Corner & 4 ? 1.f : -1.f};
+			Bounds += Transform.TransformPosition(Signs * HalfExtent);
+		}
+		return Bounds;
+	}
+
+	// The sphere is a capsule with no cylinder.
+	const auto Axis = Transform.TransformVector(FVector{0.f, 0.f, HalfExtent.Z});
+	const auto Center = Transform.GetLocation();
+	return FBox{TArray<FVector>{Center - Axis, Center + Axis}}.ExpandBy(Radius);
+}
+
+FHydrostaticSample FBuoyantPrimitive::GetSubmergedHydrostatics(const FPlane& WaterPlane) const
+{
+	const auto Center = Transform.GetLocation();
+	const auto Rotation = Transform.GetRotation();
+	const auto LocalNormal = Rotation.UnrotateVector(FVector{WaterPlane.X, WaterPlane.Y, WaterPlane.Z});
+	const double N[] = {LocalNormal.X, LocalNormal.Y, LocalNormal.Z};
+	const double Offset = -WaterPlane.PlaneDot(Center);
+
+	FLocalHydrostatics Local;
+	switch (Shape)
+	{
+		case EBuoyantPrimitiveShape::Sphere:
+			Local = GetSubmergedSphere(Radius, N, Offset);
+			break;
+		case EBuoyantPrimitiveShape::Box:
+		{
+			const double LocalHalfExtent[] = {HalfExtent.X, HalfExtent.Y, HalfExtent.Z};
+			Local = GetSubmergedBox(LocalHalfExtent, N, Offset);
+			break;
+		}
+		case EBuoyantPrimitiveShape::Capsule:
+			Local = GetSubmergedCapsule(Radius, HalfExtent.Z, N, Offset);
+			break;
+	}
+
+	FHydrostaticSample Sample;
+	Sample.Volume = static_cast<float>(Local.Volume);
+	Sample.VolumeMoment = Sample.Volume * Center + Rotation.RotateVector(FVector{static_cast<float>(Local.Moment[0]),
+	                                                                             static_cast<float>(Local.Moment[1]),
+	                                                                             static_cast<float>(Local.Moment[2])});
+	Sample.WaterplaneArea = static_cast<float>(Local.WaterplaneArea);
+	return Sample;
+}
+
+FTriangleMesh FBuoyantPrimitive::Tessellate(int32 Segments) const
+{
+	TArray<FVector> Vertices;
+	TArray<int32> Indices;
+
+	if (Shape == EBuoyantPrimitiveShape::Box)
+	{
+		for (int32 Corner = 0; Corner < 8; ++Corner)
+		{
+			const FVector Signs{Corner & 1 ? 1.f : -1.f, Corner & 2 ? 1.f : -1.f, Corner & 4 ? 1.f : -1.f};
+			Vertices.Add(Transform.TransformPosition(Signs * HalfExtent));
+		}
+
+		// Corners of each face, wound like the hull triangles so the normals point out of the box.
+		static const int32 Faces[6][4] = {
+		    {0, 4, 6, 2}, {1, 3, 7, 5}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 2, 3, 1}, {4, 5, 7, 6}};
+		for (const auto& Face : Faces)
+		{
+			Indices.Append({Face[0], Face[1], Face[2], Face[0], Face[2], Face[3]});
+		}
+		return FTriangleMesh{Vertices, Indices};
+	}
+
+	// Rings of latitude from the bottom pole to the top one. The capsule has the equator twice, once at each end of
+	// the cylinder.
+	Segments = FMath::Max(4, Segments);
+	const auto Steps = FMath::Max(1, Segments / 4);
+	const auto bHasCylinder = HalfExtent.Z > 0.f;
+
+	Vertices.Add(Transform.TransformPosition(FVector{0.f, 0.f, -HalfExtent.Z - Radius}));
+	int32 RingCount = 0;
+	const auto AddRing = [&](float Latitude, float Height) {
+		for (int32 Segment = 0; Segment < Segments; ++Segment)
+		{
+			const auto Longitude = 2.f * PI * Segment / Segments;
+			const auto RingRadius = Radius * FMath::Cos(Latitude);
+			Vertices.Add(Transform.TransformPosition(FVector{RingRadius * FMath::Cos(Longitude),
+			                                                 RingRadius * FMath::Sin(Longitude),
+			                                                 Height + Radius * FMath::Sin(Latitude)}));
+		}
+		++RingCount;
+	};
+	for (int32 Step = 1; Step <= Steps; ++Step)
+	{
+		AddRing(-HALF_PI + HALF_PI * Step / Steps, -HalfExtent.Z);
+	}
+	for (int32 Step = bHasCylinder ? 0 : 1; Step < Steps; ++Step)
+	{
+		AddRing(HALF_PI * Step / Steps, HalfExtent.Z);
+	}
+	Vertices.Add(Transform.TransformPosition(FVector{0.f, 0.f, HalfExtent.Z + Radius}));
+
+	const auto GetRingVertex = [&](int32 Ring, int32 Segment) { return 1 + Ring * Segments + Segment % Segments; };
+	const auto TopPole = Vertices.Num() - 1;
+	for (int32 Segment = 0; Segment < Segments; ++Segment)
+	{
+		Indices.Append({0, GetRingVertex(0, Segment + 1), GetRingVertex(0, Segment)});
+		for (int32 Ring = 0; Ring + 1 < RingCount; ++Ring)
+		{
+			const auto A = GetRingVertex(Ring, Segment);
+			const auto B = GetRingVertex(Ring, Segment + 1);
+			const auto C = GetRingVertex(Ring + 1, Segment + 1);
+			const auto D = GetRingVertex(Ring + 1, Segment);
+			Indices.Append({A, B, C, A, C, D});
+		}
+		Indices.Append({TopPole, GetRingVertex(RingCount - 1, Segment), GetRingVertex(RingCount - 1, Segment + 1)});
+	}
+	return FTriangleMesh{Vertices, Indices};
+}
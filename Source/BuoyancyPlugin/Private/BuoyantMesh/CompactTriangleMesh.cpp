@@ -0,0 +1,192 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "BuoyantMesh/CompactTriangleMesh.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+
+
+static TAutoConsoleVariable<int32> CVarReportCompactHulls(
+    TEXT("buoyancy.CompactHull.Report"),
+    0,
+    TEXT("Log the memory and decoding speed of the compact layout of every buoyant hull when it is built, next to the float layout."),
+    ECVF_Default);
+
+static const float MaxQuantizedValue = 65535.f;
+
+// Corners transformed per layout when timing them, spread over as many passes of the index list as needed.
+static const int32 ComparedCornerCount = 1000000;
+
+static uint16 Quantize(float Value, float Origin, float Step)
+{
+	if (Step <= 0.f) return 0;
+	return static_cast<uint16>(FMath::Clamp(FMath::RoundToFloat((Value - Origin) / Step), 0.f, MaxQuantizedValue));
+}
+
+static float SignNotZero(float Value)
+{
+	return Value >= 0.f ? 1.f : -1.f;
+}
+
+FCompactTriangleMesh::FCompactTriangleMesh(const TArray<FVector>& Vertices, const TArray<int32>& TriangleVertexIndices)
+{
+	const FBox Bounds{Vertices};
+	Origin = Bounds.IsValid ? Bounds.Min : FVector::ZeroVector;
+	Step = Bounds.IsValid ? Bounds.GetSize() / MaxQuantizedValue : FVector::ZeroVector;
+
+	QuantizedPositions.Reserve(Vertices.Num() * 3);
+	for (const auto& Vertex : Vertices)
+	{
+		QuantizedPositions.Add(Quantize(Vertex.X, Origin.X, Step.X));
+		QuantizedPositions.Add(Quantize(Vertex.Y, Origin.Y, Step.Y));
+		QuantizedPositions.Add(Quantize(Vertex.Z, Origin.Z, Step.Z));
+	}
+
+	if (Vertices.Num() <= TNumericLimits<uint16>::Max() + 1)
+	{
+		Indices16.Reserve(TriangleVertexIndices.Num());
+		for (const auto Index : TriangleVertexIndices)
+		{
+			Indices16.Add(static_cast<uint16>(Index));
+		}
+	}
+	else
+	{
+		Indices32 = TriangleVertexIndices;
+	}
+
+	// From the original positions, so the normals don't pick up the quantization error.
+	const auto TriangleCount = TriangleVertexIndices.Num() / 3;
+	PackedNormals.Reserve(TriangleCount);
+	for (int32 i = 0; i < TriangleCount; ++i)
+	{
+		const auto& A = Vertices[TriangleVertexIndices[i * 3 + 0]];
+		const auto& B = Vertices[TriangleVertexIndices[i * 3 + 1]];
+		const auto& C = Vertices[TriangleVertexIndices[i * 3 + 2]];
+		PackedNormals.Add(PackNormal(FVector::CrossProduct(B - A, C - A).GetSafeNormal()));
+	}
+}
+
+FVector FCompactTriangleMesh::GetTriangleNormal(int32 TriangleIndex) const
+{
+	return UnpackNormal(PackedNormals[TriangleIndex]);
+}
+
+FVector FCompactTriangleMesh::TransformNormal(const FTransform& LocalToWorld, const FVector& LocalNormal)
+{
+	// The cross product of scaled edges is the cross product of the edges scaled by the cofactor matrix of the scale,
+	// which also flips the normal under mirroring transforms like the winding does.
+	const auto Scale = LocalToWorld.GetScale3D();
+	const FVector Cofactor{Scale.Y * Scale.Z, Scale.X * Scale.Z, Scale.X * Scale.Y};
+	return LocalToWorld.TransformVectorNoScale(LocalNormal * Cofactor).GetSafeNormal();
+}
+
+SIZE_T FCompactTriangleMesh::GetAllocatedSize() const
+{
+	return QuantizedPositions.GetAllocatedSize() + Indices16.GetAllocatedSize() + Indices32.GetAllocatedSize() +
+	       PackedNormals.GetAllocatedSize();
+}
+
+SIZE_T FCompactTriangleMesh::GetFloatLayoutSize(int32 VertexCount, int32 IndexCount)
+{
+	return VertexCount * sizeof(FVector) + IndexCount * sizeof(int32);
+}
+
+FCompactTriangleMeshComparison FCompactTriangleMesh::Compare(const TArray<FVector>& Vertices,
+                                                             const TArray<int32>& TriangleVertexIndices)
+{
+	const FCompactTriangleMesh CompactMesh{Vertices, TriangleVertexIndices};
+
+	FCompactTriangleMeshComparison Comparison;
+	Comparison.VertexCount = Vertices.Num();
+	Comparison.TriangleCount = TriangleVertexIndices.Num() / 3;
+	Comparison.FloatBytes = Vertices.GetAllocatedSize() + TriangleVertexIndices.GetAllocatedSize();
+	Comparison.CompactBytes = CompactMesh.GetAllocatedSize();
+	for (int32 i = 0; i < Vertices.Num(); ++i)
+	{
+		Comparison.MaxPositionError =
+		    FMath::Max(Comparison.MaxPositionError, FVector::Dist(Vertices[i], CompactMesh.GetVertex(i)));
+	}
+
+	const auto IndexCount = TriangleVertexIndices.Num();
+	if (IndexCount == 0) return Comparison;
+
+	const FTransform LocalToWorld{FRotator{10.f, 20.f, 30.f}, FVector{100.f, 200.f, 300.f}};
+	const auto PassCount = FMath::Max(1, ComparedCornerCount / IndexCount);
+	// Keeps the compiler from dropping the loops.
+	volatile float Sink = 0.f;
+
+	auto StartTime = FPlatformTime::Seconds();
+	auto Sum = FVector::ZeroVector;
+	for (int32 Pass = 0; Pass < PassCount; ++Pass)
+	{
+		for (int32 i = 0; i < IndexCount; ++i)
+		{
+			Sum += LocalToWorld.TransformPosition(Vertices[TriangleVertexIndices[i]]);
+		}
+	}
+	Sink = Sum.X;
+	const auto FloatSeconds = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	Sum = FVector::ZeroVector;
+	for (int32 Pass = 0; Pass < PassCount; ++Pass)
+	{
+		for (int32 i = 0; i < IndexCount; ++i)
+		{
+			Sum += LocalToWorld.TransformPosition(CompactMesh.GetVertex(CompactMesh.GetIndex(i)));
+		}
+	}
+	Sink = Sum.X;
+	const auto CompactSeconds = FPlatformTime::Seconds() - StartTime;
+
+	const auto CornerCount = static_cast<double>(PassCount) * IndexCount;
+	Comparison.FloatCornersPerSecond = FloatSeconds > 0.0 ? CornerCount / FloatSeconds : 0.0;
+	Comparison.CompactCornersPerSecond = CompactSeconds > 0.0 ? CornerCount / CompactSeconds : 0.0;
+	return Comparison;
+}
+
+bool FCompactTriangleMesh::ShouldReport()
+{
+	return CVarReportCompactHulls.GetValueOnAnyThread() != 0;
+}
+
+uint32 FCompactTriangleMesh::PackNormal(const FVector& Normal)
+{
+	// Octahedral encoding: project on the octahedron, then fold the lower half over the upper one.
+	const auto L1Norm = FMath::Abs(Normal.X) + FMath::Abs(Normal.Y) + FMath::Abs(Normal.Z);
+	if (L1Norm <= 0.f) return 0;
+
+	auto X = Normal.X / L1Norm;
+	auto Y = Normal.Y / L1Norm;
+	if (Normal.Z < 0.f)
+	{
+		const auto FoldedX = (1.f - FMath::Abs(Y)) * SignNotZero(X);
+		const auto FoldedY = (1.f - FMath::Abs(X)) * SignNotZero(Y);
+		X = FoldedX;
+		Y = FoldedY;
+	}
+
+	const auto PackedX = static_cast<uint32>(FMath::RoundToFloat((X * 0.5f + 0.5f) * MaxQuantizedValue));
+	const auto PackedY = static_cast<uint32>(FMath::RoundToFloat((Y * 0.5f + 0.5f) * MaxQuantizedValue));
+	const auto PackedNormal = (PackedX << 16) | PackedY;
+
+	// Normals close to -Z fold to a corner of the square. (-1, -1) packs to the zero reserved for degenerate
+	// triangles, the opposite corner decodes to the same normal.
+	return PackedNormal != 0 ? PackedNormal : 0xffffffff;
+}
+
+FVector FCompactTriangleMesh::UnpackNormal(uint32 PackedNormal)
+{
+	// Zero is reserved for degenerate triangles, PackNormal never returns it for a normal.
+	if (PackedNormal == 0) return FVector::ZeroVector;
+
+	const auto X = (PackedNormal >> 16) / MaxQuantizedValue * 2.f - 1.f;
+	const auto Y = (PackedNormal & 0xffff) / MaxQuantizedValue * 2.f - 1.f;
+	const auto Z = 1.f - FMath::Abs(X) - FMath::Abs(Y);
+	if (Z < 0.f)
+	{
+		return FVector{(1.f - FMath::Abs(Y)) * SignNotZero(X), (1.f - FMath::Abs(X)) * SignNotZero(Y), Z}.GetSafeNormal();
+	}
+	return FVector{X, Y, Z}.GetSafeNormal();
+}
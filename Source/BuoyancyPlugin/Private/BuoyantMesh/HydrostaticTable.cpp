@@ -0,0 +1,194 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "BuoyantMesh/HydrostaticTable.h"
+#include "BuoyantMesh/BuoyantMeshComponent.h"
+#include "BuoyantMesh/BuoyantMeshTriangle.h"
+#include "BuoyantMesh/BuoyantMeshSubtriangle.h"
+#include "Engine/StaticMesh.h"
+#include "PhysicsEngine/BodySetup.h"
+
+
+FHydrostaticSample UHydrostaticTable::SampleHull(const TArray<FTriangleMesh>& TriangleMeshes,
+                                                const FVector& PlanePoint,
+                                                const FVector& PlaneNormal)
+{
+	FHydrostaticSample Sample;
+	for (const auto& TriangleMesh : TriangleMeshes)
+	{
+		TArray<FBuoyantMeshVertex> Vertices;
+		Vertices.Reserve(TriangleMesh.Vertices.Num());
+		for (const auto& Vertex : TriangleMesh.Vertices)
+		{
+			Vertices.Emplace(Vertex, (Vertex - PlanePoint) | PlaneNormal);
+		}
+
+		const auto TriangleCount = TriangleMesh.TriangleVertexIndices.Num() / 3;
+		for (int32 i = 0; i < TriangleCount; ++i)
+		{
+			const auto Triangle =
+			    FBuoyantMeshTriangle::FromClockwiseVertices(Vertices[TriangleMesh.TriangleVertexIndices[i * 3 + 0]],
+			                                                Vertices[TriangleMesh.TriangleVertexIndices[i * 3 + 1]],
+			                                                Vertices[TriangleMesh.TriangleVertexIndices[i * 3 + 2]]);
+
+			for (const auto& Subtriangle : Triangle.GetSubmergedPortion())
+			{
+				const auto TetrahedronVolume = TMathUtilities::SignedVolumeOfTetrahedron(
+				    PlanePoint, Subtriangle.A, Subtriangle.B, Subtriangle.C, Triangle.Normal);
+				Sample.Volume += TetrahedronVolume;
+				Sample.VolumeMoment +=
+				    TetrahedronVolume * (PlanePoint + Subtriangle.A + Subtriangle.B + Subtriangle.C) / 4.f;
+
+				// The submerged surface and the waterplane together form a closed surface, so the waterplane
+				// area is the projection of the submerged surface on the plane normal.
+				Sample.WaterplaneArea -= Subtriangle.GetArea() * (Triangle.Normal | PlaneNormal);
+			}
+		}
+	}
+	return Sample;
+}
+
+void UHydrostaticTable::Bake()
+{
+	if (!SourceMesh || !SourceMesh->BodySetup)
+	{
+		UE_LOG(LogTemp, Error, TEXT("HydrostaticTable %s needs a source mesh with collision to bake."), *GetName());
+		return;
+	}
+
+	SourceMesh->BodySetup->CreatePhysicsMeshes();
+	const auto TriangleMeshes = TMeshUtilities::GetTriangleMeshes(SourceMesh->BodySetup, HullSource);
+	if (TriangleMeshes.Num() == 0)
+	{
+		UE_LOG(LogTemp,
+		       Error,
+		       TEXT("HydrostaticTable %s: %s has no collision hull to bake."),
+		       *GetName(),
+		       *SourceMesh->GetName());
+		return;
+	}
+
+	const auto MaxHeelSlope = FMath::Tan(FMath::DegreesToRadians(MaxHeel));
+	const auto MaxTrimSlope = FMath::Tan(FMath::DegreesToRadians(MaxTrim));
+
+	// Pick the draft range so the table goes from fully dry to fully submerged at every heel and trim.
+	auto MinDraft = TNumericLimits<float>::Max();
+	auto MaxDraft = TNumericLimits<float>::Lowest();
+	for (const auto& TriangleMesh : TriangleMeshes)
+	{
+		for (const auto& Vertex : TriangleMesh.Vertices)
+		{
+			const auto Slack = FMath::Abs(Vertex.X) * MaxTrimSlope + FMath::Abs(Vertex.Y) * MaxHeelSlope;
+			MinDraft = FMath::Min(MinDraft, Vertex.Z - Slack);
+			MaxDraft = FMath::Max(MaxDraft, Vertex.Z + Slack);
+		}
+	}
+
+	BakedMinDraft = MinDraft;
+	BakedMaxDraft = MaxDraft;
+	BakedMaxHeel = MaxHeel;
+	BakedMaxTrim = MaxTrim;
+	BakedDraftSteps = FMath::Max(2, DraftSteps);
+	BakedHeelSteps = FMath::Max(2, HeelSteps);
+	BakedTrimSteps = FMath::Max(2, TrimSteps);
+
+	Samples.Reset();
+	Samples.SetNum(BakedDraftSteps * BakedHeelSteps * BakedTrimSteps);
+
+	for (int32 TrimIndex = 0; TrimIndex < BakedTrimSteps; ++TrimIndex)
+	{
+		const auto Trim = FMath::Lerp(-BakedMaxTrim, BakedMaxTrim, TrimIndex / float(BakedTrimSteps - 1));
+		const auto TrimSlope = FMath::Tan(FMath::DegreesToRadians(Trim));
+
+		for (int32 HeelIndex = 0; HeelIndex < BakedHeelSteps; ++HeelIndex)
+		{
+			const auto Heel = FMath::Lerp(-BakedMaxHeel, BakedMaxHeel, HeelIndex / float(BakedHeelSteps - 1));
+			const auto HeelSlope = FMath::Tan(FMath::DegreesToRadians(Heel));
+
+			for (int32 DraftIndex = 0; DraftIndex < BakedDraftSteps; ++DraftIndex)
+			{
+				const auto Draft = FMath::Lerp(BakedMinDraft, BakedMaxDraft, DraftIndex / float(BakedDraftSteps - 1));
+				// The water plane Z = Draft + X * TrimSlope + Y * HeelSlope.
+				Samples[GetSampleIndex(DraftIndex, HeelIndex, TrimIndex)] =
+				    SampleHull(TriangleMeshes,
+				               FVector{0.f, 0.f, Draft},
+				               FVector{-TrimSlope, -HeelSlope, 1.f}.GetUnsafeNormal());
+			}
+		}
+	}
+
+	MarkPackageDirty();
+
+	UE_LOG(LogTemp,
+	       Log,
+	       TEXT("HydrostaticTable %s: baked %d samples (%d bytes) from %s."),
+	       *GetName(),
+	       Samples.Num(),
+	       static_cast<int32>(Samples.GetAllocatedSize()),
+	       *SourceMesh->GetName());
+}
+
+void UHydrostaticTable::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(Samples.GetAllocatedSize());
+}
+
+bool UHydrostaticTable::IsBaked() const
+{
+	return BakedDraftSteps >= 2 && BakedHeelSteps >= 2 && BakedTrimSteps >= 2 &&
+	       Samples.Num() == BakedDraftSteps * BakedHeelSteps * BakedTrimSteps;
+}
+
+int32 UHydrostaticTable::GetSampleIndex(int32 DraftIndex, int32 HeelIndex, int32 TrimIndex) const
+{
+	return (TrimIndex * BakedHeelSteps + HeelIndex) * BakedDraftSteps + DraftIndex;
+}
+
+float UHydrostaticTable::GetFractionalIndex(float Value, float Min, float Max, int32 StepCount)
+{
+	if (Max <= Min) return 0.f;
+	return FMath::Clamp((Value - Min) / (Max - Min), 0.f, 1.f) * (StepCount - 1);
+}
+
+bool UHydrostaticTable::Lookup(float Draft,
+                               float Heel,
+                               float Trim,
+                               float& OutVolume,
+                               FVector& OutCenterOfBuoyancy,
+                               float& OutWaterplaneArea) const
+{
+	if (!IsBaked()) return false;
+
+	const auto DraftIndex = GetFractionalIndex(Draft, BakedMinDraft, BakedMaxDraft, BakedDraftSteps);
+	const auto HeelIndex = GetFractionalIndex(Heel, -BakedMaxHeel, BakedMaxHeel, BakedHeelSteps);
+	const auto TrimIndex = GetFractionalIndex(Trim, -BakedMaxTrim, BakedMaxTrim, BakedTrimSteps);
+
+	// Lower corner of the cell containing the query, and the position inside the cell.
+	const auto Draft0 = FMath::Min(FMath::FloorToInt(DraftIndex), BakedDraftSteps - 2);
+	const auto Heel0 = FMath::Min(FMath::FloorToInt(HeelIndex), BakedHeelSteps - 2);
+	const auto Trim0 = FMath::Min(FMath::FloorToInt(TrimIndex), BakedTrimSteps - 2);
+	const auto DraftAlpha = DraftIndex - Draft0;
+	const auto HeelAlpha = HeelIndex - Heel0;
+	const auto TrimAlpha = TrimIndex - Trim0;
+
+	FHydrostaticSample Result;
+	for (int32 Corner = 0; Corner < 8; ++Corner)
+	{
+		const auto DraftOffset = Corner & 1;
+		const auto HeelOffset = (Corner >> 1) & 1;
+		const auto TrimOffset = (Corner >> 2) & 1;
+		const auto Weight = (DraftOffset ? DraftAlpha : 1.f - DraftAlpha) *
+		                    (HeelOffset ? HeelAlpha : 1.f - HeelAlpha) * (TrimOffset ? TrimAlpha : 1.f - TrimAlpha);
+
+		const auto& Sample = Samples[GetSampleIndex(Draft0 + DraftOffset, Heel0 + HeelOffset, Trim0 + TrimOffset)];
+		Result.Volume += Weight * Sample.Volume;
+		Result.VolumeMoment += Weight * Sample.VolumeMoment;
+		Result.WaterplaneArea += Weight * Sample.WaterplaneArea;
+	}
+
+	OutVolume = FMath::Max(0.f, Result.Volume);
+	OutCenterOfBuoyancy = Result.Volume > KINDA_SMALL_NUMBER ? Result.VolumeMoment / Result.Volume : FVector::ZeroVector;
+	OutWaterplaneArea = FMath::Max(0.f, Result.WaterplaneArea);
+	return true;
+}
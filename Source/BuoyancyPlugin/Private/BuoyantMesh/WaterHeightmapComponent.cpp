@@ -3,6 +3,8 @@
 
 #include "BuoyantMesh/WaterHeightmapComponent.h"
 #include "OceanPlugin/Public/OceanManager.h"
+#include "WaterSurface/WaterSurfaceProvider.h"
+#include "WaterQuery/WaterQuerySubsystem.h"
 #include "DrawDebugHelpers.h"
 #include "EngineUtils.h"
 
@@ -17,6 +19,27 @@ UWaterHeightmapComponent::UWaterHeightmapComponent()
 	UActorComponent::SetComponentTickEnabled(true);
 }
 
+void UWaterHeightmapComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	// Lets the water query components read the heights computed for the buoyant components.
+	if (const auto Subsystem = GetWorld()->GetSubsystem<UWaterQuerySubsystem>())
+	{
+		Subsystem->RegisterWaterHeightmap(this);
+	}
+}
+
+void UWaterHeightmapComponent::OnUnregister()
+{
+	if (const auto Subsystem = GetWorld()->GetSubsystem<UWaterQuerySubsystem>())
+	{
+		Subsystem->UnregisterWaterHeightmap(this);
+	}
+
+	Super::OnUnregister();
+}
+
 // Called every frame
 void UWaterHeightmapComponent::TickComponent(float DeltaTime,
                                              ELevelTick TickType,
@@ -54,6 +77,9 @@ void UWaterHeightmapComponent::UpdateGridSize()
 {
 	EnsureComponentIsInitialized();
 
+	WaterSurface = FWaterSurfaceProviders::Resolve(WaterSurfaceProvider, this, OceanManager);
+	WaterTime = GetWorld()->GetTimeSeconds();
+
 	const auto Owner = GetOwner();
 	check(Owner);
 	FVector BoxCenter;
@@ -86,6 +112,142 @@ void UWaterHeightmapComponent::ResetGridData()
 
 	UpperLeftTrianglePlanes.Empty(CellCount);
 	UpperLeftTrianglePlanes.AddDefaulted(CellCount);
+
+	HeightRangeLevels.Reset();
+}
+
+FIntVector2D UWaterHeightmapComponent::GetHeightRangeLevelSize(int32 Level) const
+{
+	const auto NodeSize = 1 << Level;
+	return FIntVector2D{(GridSizeInCells.X + NodeSize - 1) >> Level, (GridSizeInCells.Y + NodeSize - 1) >> Level};
+}
+
+void UWaterHeightmapComponent::ComputeAllVertices()
+{
+	for (int32 X = 0; X <= GridSizeInCells.X; ++X)
+	{
+		for (int32 Y = 0; Y <= GridSizeInCells.Y; ++Y)
+		{
+			GetSurfaceVertex(FIntVector2D{X, Y});
+		}
+	}
+}
+
+void UWaterHeightmapComponent::BuildHeightRangeLevels()
+{
+	ComputeAllVertices();
+
+	// The extremes of a cell are at its corners.
+	const auto GetVertexHeight = [this](int32 X, int32 Y) {
+		return VertexHeights[X * (GridSizeInCells.Y + 1) + Y].GetValue();
+	};
+	auto& Cells = HeightRangeLevels.AddDefaulted_GetRef();
+	Cells.SetNumUninitialized(GridSizeInCells.X * GridSizeInCells.Y);
+	for (int32 X = 0; X < GridSizeInCells.X; ++X)
+	{
+		for (int32 Y = 0; Y < GridSizeInCells.Y; ++Y)
+		{
+			FFloatInterval Range;
+			Range.Include(GetVertexHeight(X, Y));
+			Range.Include(GetVertexHeight(X + 1, Y));
+			Range.Include(GetVertexHeight(X, Y + 1));
+			Range.Include(GetVertexHeight(X + 1, Y + 1));
+			Cells[X * GridSizeInCells.Y + Y] = Range;
+		}
+	}
+
+	// Halve the levels until a single node covers the grid.
+	for (auto Size = GetHeightRangeLevelSize(0); Size.X > 1 || Size.Y > 1;)
+	{
+		const auto ParentSize = GetHeightRangeLevelSize(HeightRangeLevels.Num());
+		TArray<FFloatInterval> Parents;
+		Parents.SetNum(ParentSize.X * ParentSize.Y);
+		const auto& Children = HeightRangeLevels.Last();
+		for (int32 X = 0; X < Size.X; ++X)
+		{
+			for (int32 Y = 0; Y < Size.Y; ++Y)
+			{
+				const auto& Child = Children[X * Size.Y + Y];
+				auto& Parent = Parents[(X / 2) * ParentSize.Y + Y / 2];
+				Parent.Include(Child.Min);
+				Parent.Include(Child.Max);
+			}
+		}
+		HeightRangeLevels.Add(MoveTemp(Parents));
+		Size = ParentSize;
+	}
+}
+
+void UWaterHeightmapComponent::IncludeHeightRange(int32 Level,
+                                                  const FIntVector2D& Node,
+                                                  const FIntVector2D& MinCell,
+                                                  const FIntVector2D& MaxCell,
+                                                  FFloatInterval& OutRange) const
+{
+	const auto NodeMin = FIntVector2D{Node.X << Level, Node.Y << Level};
+	const auto NodeMax = FIntVector2D{((Node.X + 1) << Level) - 1, ((Node.Y + 1) << Level) - 1};
+	if (NodeMin.X > MaxCell.X || NodeMin.Y > MaxCell.Y || NodeMax.X < MinCell.X || NodeMax.Y < MinCell.Y) return;
+
+	const auto Size = GetHeightRangeLevelSize(Level);
+	const auto bIsCovered = NodeMin.X >= MinCell.X && NodeMin.Y >= MinCell.Y &&
+	                        FMath::Min(NodeMax.X, GridSizeInCells.X - 1) <= MaxCell.X &&
+	                        FMath::Min(NodeMax.Y, GridSizeInCells.Y - 1) <= MaxCell.Y;
+	if (Level == 0 || bIsCovered)
+	{
+		const auto& Range = HeightRangeLevels[Level][Node.X * Size.Y + Node.Y];
+		OutRange.Include(Range.Min);
+		OutRange.Include(Range.Max);
+		return;
+	}
+
+	// Only the nodes on the border of the region are split, so a query visits O(log + perimeter) nodes.
+	const auto ChildSize = GetHeightRangeLevelSize(Level - 1);
+	for (int32 X = Node.X * 2; X < FMath::Min(Node.X * 2 + 2, ChildSize.X); ++X)
+	{
+		for (int32 Y = Node.Y * 2; Y < FMath::Min(Node.Y * 2 + 2, ChildSize.Y); ++Y)
+		{
+			IncludeHeightRange(Level - 1, FIntVector2D{X, Y}, MinCell, MaxCell, /*out*/ OutRange);
+		}
+	}
+}
+
+bool UWaterHeightmapComponent::GetHeightRange(const FBox2D& Region, FFloatInterval& OutRange)
+{
+	EnsureUpToDateGridSize();
+
+	auto MinCell = GetCellCoordinates(FVector{Region.Min, 0.f});
+	auto MaxCell = GetCellCoordinates(FVector{Region.Max, 0.f});
+
+	FFloatInterval Range;
+
+	const auto bIsInsideGrid = IsCellInBounds(MinCell) && IsCellInBounds(MaxCell);
+	if (!bIsInsideGrid)
+	{
+		// Outside of the grid the heights come straight from the provider.
+		FFloatInterval WaterBounds{0.f, 0.f};
+		if (WaterSurface && !WaterSurface->GetWaterHeightBounds(/*out*/ WaterBounds)) return false;
+		Range.Include(WaterBounds.Min);
+		Range.Include(WaterBounds.Max);
+	}
+
+	const auto bOverlapsGrid = MaxCell.X >= 0 && MaxCell.Y >= 0 && MinCell.X < GridSizeInCells.X &&
+	                           MinCell.Y < GridSizeInCells.Y;
+	if (bOverlapsGrid)
+	{
+		MinCell = FIntVector2D{FMath::Max(MinCell.X, 0), FMath::Max(MinCell.Y, 0)};
+		MaxCell = FIntVector2D{FMath::Min(MaxCell.X, GridSizeInCells.X - 1), FMath::Min(MaxCell.Y, GridSizeInCells.Y - 1)};
+
+		if (HeightRangeLevels.Num() == 0)
+		{
+			BuildHeightRangeLevels();
+		}
+		IncludeHeightRange(HeightRangeLevels.Num() - 1, FIntVector2D{0, 0}, MinCell, MaxCell, /*out*/ Range);
+	}
+
+	Range.Min -= HeightRangeMargin;
+	Range.Max += HeightRangeMargin;
+	OutRange = Range;
+	return true;
 }
 
 void UWaterHeightmapComponent::DrawHeightmap()
@@ -117,9 +279,9 @@ void UWaterHeightmapComponent::Initialize()
 			OceanManager = Actor;
 		}
 	}
-	if (!OceanManager)
+	if (!OceanManager && !WaterSurfaceProvider)
 	{
-		UE_LOG(LogTemp, Error, TEXT("WaterPatchComponent requires an OceanManager in the level."));
+		UE_LOG(LogTemp, Error, TEXT("WaterPatchComponent requires a water surface provider or an OceanManager in the level."));
 	}
 }
 
@@ -137,7 +299,7 @@ FVector UWaterHeightmapComponent::GetSurfaceVertex(const FIntVector2D VertexCoor
 	else
 	{
 		// Point isn't in cache, compute and store it
-		const auto Height = OceanManager->GetWaveHeight(Position);
+		const auto Height = WaterSurface ? WaterSurface->GetWaterHeight(Position, WaterTime) : 0.f;
 		VertexHeights[VertexIndex] = Height;
 		return FVector{Position.X, Position.Y, Height};
 	}
@@ -164,7 +326,7 @@ int32 UWaterHeightmapComponent::GetCellIndex(const FIntVector2D CellCoordinates)
 	return CellCoordinates.X * GridSizeInCells.Y + CellCoordinates.Y;
 }
 
-FTrianglePlane UWaterHeightmapComponent::GetTrianglePlane(TArray<TOptional<FTrianglePlane>> TrianglePlanes,
+FTrianglePlane UWaterHeightmapComponent::GetTrianglePlane(TArray<TOptional<FTrianglePlane>>& TrianglePlanes,
                                                           const FIntVector2D& CellCoordinates,
                                                           const FIntVector2D& Vertex1GridCoordinates,
                                                           const FIntVector2D& Vertex2GridCoordinates,
@@ -219,7 +381,7 @@ float UWaterHeightmapComponent::GetHeightAtPosition(const FVector& Position)
 
 	if (!IsCellInBounds(CellCoordinates))
 	{
-		return IsValid(OceanManager) ?  OceanManager->GetWaveHeight(Position) : 0.f;
+		return WaterSurface ? WaterSurface->GetWaterHeight(Position, WaterTime) : 0.f;
 	}
 
 	const auto Position2D = FVector2D{Position};
@@ -245,6 +407,71 @@ float UWaterHeightmapComponent::GetHeightAtPosition(const FVector& Position)
 	}
 }
 
+void UWaterHeightmapComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetBuoyancyAllocatedSize());
+}
+
+SIZE_T UWaterHeightmapComponent::GetBuoyancyAllocatedSize() const
+{
+	auto Size = VertexHeights.GetAllocatedSize() + LowerRightTrianglePlanes.GetAllocatedSize() +
+	            UpperLeftTrianglePlanes.GetAllocatedSize() + HeightRangeLevels.GetAllocatedSize();
+	for (const auto& Level : HeightRangeLevels)
+	{
+		Size += Level.GetAllocatedSize();
+	}
+	return Size;
+}
+
+FWaterHeightmapSnapshot UWaterHeightmapComponent::GetSnapshot()
+{
+	EnsureUpToDateGridSize();
+	ComputeAllVertices();
+
+	FWaterHeightmapSnapshot Snapshot;
+	Snapshot.LowerLeftGridCorner = LowerLeftGridCorner;
+	Snapshot.CellSize = CellSize;
+	Snapshot.CellCountX = GridSizeInCells.X;
+	Snapshot.CellCountY = GridSizeInCells.Y;
+	Snapshot.VertexHeights = VertexHeights;
+	return Snapshot;
+}
+
+bool FWaterHeightmapSnapshot::GetHeightAtPosition(const FVector& Position, float& OutHeight) const
+{
+	if (CellCountX <= 0 || CellCountY <= 0) return false;
+
+	const auto Position2D = FVector2D{Position};
+	const auto GridSpacePosition = Position2D - LowerLeftGridCorner;
+	const auto CellX = FMath::FloorToInt(GridSpacePosition.X / CellSize.X);
+	const auto CellY = FMath::FloorToInt(GridSpacePosition.Y / CellSize.Y);
+	if (CellX < 0 || CellX >= CellCountX || CellY < 0 || CellY >= CellCountY) return false;
+
+	// Same triangles as GetLowerRightTrianglePlane and GetUpperLeftTrianglePlane.
+	const auto CellSpacePosition = GridSpacePosition - FVector2D(CellX, CellY) * CellSize;
+	const auto bIsLowerRight = CellSpacePosition.X > CellSpacePosition.Y;
+	const FIntPoint TriangleVertices[] = {bIsLowerRight ? FIntPoint{CellX + 1, CellY} : FIntPoint{CellX, CellY + 1},
+	                                      FIntPoint{CellX, CellY},
+	                                      FIntPoint{CellX + 1, CellY + 1}};
+
+	FVector SurfaceVertices[3];
+	for (int32 i = 0; i < 3; ++i)
+	{
+		const auto& Vertex = TriangleVertices[i];
+		const auto& HeightMaybe = VertexHeights[Vertex.X * (CellCountY + 1) + Vertex.Y];
+		if (!HeightMaybe) return false;
+
+		SurfaceVertices[i] = FVector{LowerLeftGridCorner.X + Vertex.X * CellSize.X,
+		                             LowerLeftGridCorner.Y + Vertex.Y * CellSize.Y,
+		                             HeightMaybe.GetValue()};
+	}
+
+	OutHeight = FTrianglePlane::FromTriangle(SurfaceVertices[0], SurfaceVertices[1], SurfaceVertices[2])
+	                .GetHeightAtPosition(Position2D);
+	return true;
+}
+
 float FTrianglePlane::GetHeightAtPosition(const FVector2D& Position) const
 {
 	if (e4 != 0.f)
@@ -0,0 +1,102 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "BuoyantStiffness.h"
+
+
+// Below these, drag is too small to linearize reliably and adds no damping.
+static const float MinDampedSpeed = 1.f;
+static const float MinDampedAngularSpeed = 0.01f;
+
+// Backward Euler on I dv/dt = F - K x - C v, linearized around the current state, gives the velocity change of the step
+//   (I + C dt + K dt^2) dv = (F - K v dt) dt
+// Returns the generalized force to add to F so the explicit step, I dv = F dt, takes the same velocity change.
+static float GetCorrection(float Inertia, float Stiffness, float Damping, float Velocity, float Force, float DeltaTime)
+{
+	// An unstable body would need a larger step instead, it is left to the explicit forces.
+	Stiffness = FMath::Max(0.f, Stiffness);
+	Damping = FMath::Max(0.f, Damping);
+	if (Inertia <= 0.f) return 0.f;
+
+	const auto Denominator = 1.f + (Damping * DeltaTime + Stiffness * DeltaTime * DeltaTime) / Inertia;
+	return (Force - Stiffness * Velocity * DeltaTime) / Denominator - Force;
+}
+
+void FBuoyantStiffness::Reset(const FBuoyantBodyState& InBody)
+{
+	*this = FBuoyantStiffness{};
+	Body = InBody;
+
+	const auto Forward = Body.Rotation.GetForwardVector();
+	const auto HorizontalForward = FVector{Forward.X, Forward.Y, 0.f}.GetSafeNormal();
+	if (!HorizontalForward.IsZero())
+	{
+		RollAxis = HorizontalForward;
+		PitchAxis = FVector::CrossProduct(FVector::UpVector, RollAxis);
+	}
+}
+
+void FBuoyantStiffness::AddVerticalSpring(const FVector& Position, float Stiffness)
+{
+	// Rolling by a small angle about an axis moves the point vertically by the angle times its offset across the axis.
+	const auto Offset = Position - Body.CenterOfMass;
+	Heave += Stiffness;
+	Roll += Stiffness * FMath::Square(FVector::CrossProduct(RollAxis, Offset).Z);
+	Pitch += Stiffness * FMath::Square(FVector::CrossProduct(PitchAxis, Offset).Z);
+}
+
+void FBuoyantStiffness::AddVerticalForce(const FVector& Position, float Force)
+{
+	// Rolling the point by a small angle shifts its lever arm by the angle times its height above the center of mass.
+	const auto Height = Position.Z - Body.CenterOfMass.Z;
+	Roll += Force * Height;
+	Pitch += Force * Height;
+}
+
+void FBuoyantStiffness::AddLinearDamper(const FVector& Position, const FVector& Damping)
+{
+	const auto Offset = Position - Body.CenterOfMass;
+	const auto RollLever = FVector::CrossProduct(RollAxis, Offset);
+	const auto PitchLever = FVector::CrossProduct(PitchAxis, Offset);
+	HeaveDamping += Damping.Z;
+	RollDamping += Damping | (RollLever * RollLever);
+	PitchDamping += Damping | (PitchLever * PitchLever);
+}
+
+void FBuoyantStiffness::AddQuadraticDrag(const FVector& Force, const FVector& Torque)
+{
+	// For a drag of -B |v| v, the derivative along the velocity is 2 B |v|, which is twice the drag power over the
+	// squared speed. Dividing by the whole speed keeps the estimate bounded when one component of it is small.
+	const auto SpeedSquared = Body.LinearVelocity.SizeSquared();
+	if (SpeedSquared > FMath::Square(MinDampedSpeed))
+	{
+		HeaveDamping += 2.f * FMath::Max(0.f, -(Force | Body.LinearVelocity)) / SpeedSquared;
+	}
+
+	const auto AngularSpeedSquared = Body.AngularVelocity.SizeSquared();
+	if (AngularSpeedSquared > FMath::Square(MinDampedAngularSpeed))
+	{
+		const auto AngularDamping = 2.f * FMath::Max(0.f, -(Torque | Body.AngularVelocity)) / AngularSpeedSquared;
+		RollDamping += AngularDamping;
+		PitchDamping += AngularDamping;
+	}
+}
+
+void FBuoyantStiffness::GetSemiImplicitCorrection(const FVector& NetForce,
+                                                  const FVector& NetTorque,
+                                                  float DeltaTime,
+                                                  FVector& OutForce,
+                                                  FVector& OutTorque) const
+{
+	OutForce = FVector::ZeroVector;
+	OutTorque = FVector::ZeroVector;
+	if (DeltaTime <= 0.f) return;
+
+	OutForce.Z = GetCorrection(Body.Mass, Heave, HeaveDamping, Body.LinearVelocity.Z, NetForce.Z, DeltaTime);
+
+	const auto RollCorrection = GetCorrection(Body.GetInertiaAboutAxis(RollAxis), Roll, RollDamping,
+	                                          Body.AngularVelocity | RollAxis, NetTorque | RollAxis, DeltaTime);
+	const auto PitchCorrection = GetCorrection(Body.GetInertiaAboutAxis(PitchAxis), Pitch, PitchDamping,
+	                                           Body.AngularVelocity | PitchAxis, NetTorque | PitchAxis, DeltaTime);
+	OutTorque = RollAxis * RollCorrection + PitchAxis * PitchCorrection;
+}
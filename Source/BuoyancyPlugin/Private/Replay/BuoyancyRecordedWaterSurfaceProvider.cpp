@@ -0,0 +1,43 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "Replay/BuoyancyRecordedWaterSurfaceProvider.h"
+#include "Replay/BuoyancyRecording.h"
+
+
+float UBuoyancyRecordedWaterSurfaceProvider::GetWaterHeight(const FVector& Position, float Time) const
+{
+	return Water ? Water->GetHeightAtPosition(Position) : 0.f;
+}
+
+FVector UBuoyancyRecordedWaterSurfaceProvider::GetWaterDisplacement(const FVector& Position, float Time) const
+{
+	return {0.f, 0.f, GetWaterHeight(Position, Time)};
+}
+
+FVector UBuoyancyRecordedWaterSurfaceProvider::GetWaterVelocity(const FVector& Position, float Time) const
+{
+	return FVector::ZeroVector;
+}
+
+FVector2D UBuoyancyRecordedWaterSurfaceProvider::GetWaveDirection() const
+{
+	return {1.f, 0.f};
+}
+
+bool UBuoyancyRecordedWaterSurfaceProvider::GetWaterHeightBounds(FFloatInterval& OutBounds) const
+{
+	// GetHeightAtPosition answers zero for a grid that doesn't match its resolution.
+	if (!Water || Water->Resolution < 2 || Water->Heights.Num() != Water->Resolution * Water->Resolution)
+	{
+		OutBounds = FFloatInterval{0.f, 0.f};
+		return true;
+	}
+
+	OutBounds = FFloatInterval{Water->Heights[0], Water->Heights[0]};
+	for (const auto Height : Water->Heights)
+	{
+		OutBounds.Include(Height);
+	}
+	return true;
+}
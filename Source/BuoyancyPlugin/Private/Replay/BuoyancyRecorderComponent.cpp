@@ -0,0 +1,178 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "Replay/BuoyancyRecorderComponent.h"
+#include "BuoyantMesh/BuoyantMeshComponent.h"
+#include "WaterSurface/WaterSurfaceProvider.h"
+#include "OceanPlugin/Public/OceanManager.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectIterator.h"
+
+
+UBuoyancyRecorderComponent::UBuoyancyRecorderComponent()
+{
+	// Record the state the physics simulation ended the frame with.
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+	PrimaryComponentTick.bCanEverTick = true;
+	UActorComponent::SetComponentTickEnabled(true);
+}
+
+void UBuoyancyRecorderComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (!OceanManager)
+	{
+		for (auto Actor : TActorRange<AOceanManager>(GetWorld()))
+		{
+			OceanManager = Actor;
+			break;
+		}
+	}
+
+	if (bRecordOnBeginPlay)
+	{
+		StartRecording();
+	}
+}
+
+void UBuoyancyRecorderComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopRecording();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool UBuoyancyRecorderComponent::IsRecording() const
+{
+	return Writer.IsOpen();
+}
+
+void UBuoyancyRecorderComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetBuoyancyAllocatedSize());
+}
+
+SIZE_T UBuoyancyRecorderComponent::GetBuoyancyAllocatedSize() const
+{
+	auto Size = RecordedBodies.GetAllocatedSize() + WaterSamplePositions.GetAllocatedSize() + Frame.Bodies.GetAllocatedSize();
+	for (const auto& Body : Frame.Bodies)
+	{
+		Size += Body.Water.Heights.GetAllocatedSize();
+	}
+	return Size;
+}
+
+void UBuoyancyRecorderComponent::StartRecording()
+{
+	if (IsRecording()) return;
+
+	if (!FWaterSurfaceProviders::Resolve(WaterSurfaceProvider, this, OceanManager))
+	{
+		UE_LOG(LogTemp, Error, TEXT("BuoyancyRecorderComponent requires a water surface provider or an OceanManager in the level."));
+		return;
+	}
+
+	const auto World = GetWorld();
+	FBuoyancyRecordingHeader Header;
+	Header.GravityMagnitude = FMath::Abs(World->GetGravityZ());
+	Header.WaterGridResolution = FMath::Max(2, WaterGridResolution);
+
+	RecordedBodies.Reset();
+	for (TObjectIterator<UBuoyantMeshComponent> It; It; ++It)
+	{
+		if (It->GetWorld() != World || It->IsPendingKill() || !It->GetStaticMesh()) continue;
+
+		Header.Bodies.Add(FBuoyancyRecordedBodyInfo::FromComponent(**It));
+		RecordedBodies.Add(*It);
+	}
+
+	const auto Name = FileName.IsEmpty() ? FDateTime::Now().ToString() + TEXT(".buoyrec") : FileName;
+	const auto Path = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Buoyancy"), Name);
+	if (!Writer.Open(Path, Header))
+	{
+		UE_LOG(LogTemp, Error, TEXT("BuoyancyRecorderComponent could not create %s."), *Path);
+		return;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Recording %d buoyant bodies to %s."), Header.Bodies.Num(), *Path);
+}
+
+void UBuoyancyRecorderComponent::StopRecording()
+{
+	Writer.Close();
+	RecordedBodies.Reset();
+}
+
+void UBuoyancyRecorderComponent::TickComponent(float DeltaTime,
+                                               ELevelTick TickType,
+                                               FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	WaterSurface = FWaterSurfaceProviders::Resolve(WaterSurfaceProvider, this, OceanManager);
+	if (IsRecording() && WaterSurface)
+	{
+		RecordFrame(DeltaTime);
+	}
+}
+
+void UBuoyancyRecorderComponent::RecordFrame(float DeltaTime)
+{
+	Frame.Time = GetWorld()->GetTimeSeconds();
+	Frame.DeltaTime = DeltaTime;
+	Frame.Bodies.SetNum(RecordedBodies.Num());
+
+	for (int32 i = 0; i < RecordedBodies.Num(); ++i)
+	{
+		// Destroyed bodies keep their last state so the frame layout matches the header.
+		if (const auto BuoyantMesh = RecordedBodies[i].Get())
+		{
+			RecordBody(BuoyantMesh, Frame.Bodies[i]);
+		}
+	}
+
+	Writer.WriteFrame(Frame);
+}
+
+void UBuoyancyRecorderComponent::RecordBody(const UBuoyantMeshComponent* BuoyantMesh, FBuoyancyRecordedBody& OutBody)
+{
+	OutBody.Transform = BuoyantMesh->GetComponentTransform();
+
+	const auto UpdatedComponent = BuoyantMesh->UpdatedComponent;
+	if (IsValid(UpdatedComponent) && UpdatedComponent->IsSimulatingPhysics())
+	{
+		OutBody.CenterOfMass = UpdatedComponent->GetCenterOfMass();
+		OutBody.LinearVelocity = UpdatedComponent->GetPhysicsLinearVelocity();
+		OutBody.AngularVelocity = UpdatedComponent->GetPhysicsAngularVelocityInRadians();
+	}
+	else
+	{
+		OutBody.CenterOfMass = OutBody.Transform.GetLocation();
+		OutBody.LinearVelocity = FVector::ZeroVector;
+		OutBody.AngularVelocity = FVector::ZeroVector;
+	}
+
+	auto& Water = OutBody.Water;
+	const auto Bounds = BuoyantMesh->Bounds.GetBox().ExpandBy(WaterGridMargin);
+	Water.Region = FBox2D{FVector2D{Bounds.Min}, FVector2D{Bounds.Max}};
+	Water.Resolution = FMath::Max(2, WaterGridResolution);
+	Water.Heights.SetNumUninitialized(Water.Resolution * Water.Resolution);
+
+	WaterSamplePositions.SetNumUninitialized(Water.Heights.Num());
+	for (int32 X = 0; X < Water.Resolution; ++X)
+	{
+		for (int32 Y = 0; Y < Water.Resolution; ++Y)
+		{
+			const auto Alpha = FVector2D(X, Y) / (Water.Resolution - 1);
+			const auto Position2D = Water.Region.Min + Alpha * Water.Region.GetSize();
+			WaterSamplePositions[X * Water.Resolution + Y] = FVector{Position2D.X, Position2D.Y, 0.f};
+		}
+	}
+	WaterSurface->GetWaterHeights(WaterSamplePositions, GetWorld()->GetTimeSeconds(), Water.Heights);
+}
@@ -0,0 +1,213 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "Replay/BuoyancyRecording.h"
+#include "BuoyantMesh/BuoyantMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "GameFramework/Actor.h"
+#include "HAL/FileManager.h"
+
+
+// "BUOY" in a little endian file.
+static const uint32 RecordingMagic = 0x594F5542;
+// 2: every setting of the buoyant meshes in FBuoyancyRecordedBodyInfo.
+static const int32 RecordingVersion = 2;
+
+FBuoyancyRecordedBodyInfo FBuoyancyRecordedBodyInfo::FromComponent(const UBuoyantMeshComponent& Component)
+{
+	FBuoyancyRecordedBodyInfo Info;
+	const auto Owner = Component.GetOwner();
+	Info.Name = Owner ? Owner->GetName() + TEXT(".") + Component.GetName() : Component.GetName();
+	Info.StaticMeshPath = Component.GetStaticMesh() ? Component.GetStaticMesh()->GetPathName() : FString{};
+	Info.WaterDensity = Component.WaterDensity;
+	Info.bUseStaticForces = Component.bUseStaticForces;
+	Info.bUseDynamicForces = Component.bUseDynamicForces;
+	Info.bVerticalForcesOnly = Component.bVerticalForcesOnly;
+	Info.bSemiImplicitBuoyancy = Component.bSemiImplicitBuoyancy;
+	Info.HydrostaticForceMode = static_cast<uint8>(Component.HydrostaticForceMode);
+	Info.HullSource = static_cast<uint8>(Component.HullSource);
+	Info.bUseAnalyticPrimitives = Component.bUseAnalyticPrimitives;
+	Info.PrimitiveDragCoefficient = Component.PrimitiveDragCoefficient;
+	Info.bFitWaterPlane = Component.bFitWaterPlane;
+	Info.WaterPlaneTolerance = Component.WaterPlaneTolerance;
+	Info.bRefineWaterline = Component.bRefineWaterline;
+	Info.WaterlineEdgeLength = Component.WaterlineEdgeLength;
+	Info.bUseClusterCulling = Component.bUseClusterCulling;
+	Info.TrianglesPerCluster = Component.TrianglesPerCluster;
+	Info.bReuseWaterlineClassification = Component.bReuseWaterlineClassification;
+	Info.bUseCompactHull = Component.bUseCompactHull;
+	Info.bAccurateWaterHeight = Component.bAccurateWaterHeight;
+	Info.WaterHeightTolerance = Component.WaterHeightTolerance;
+	return Info;
+}
+
+void FBuoyancyRecordedBodyInfo::ApplyTo(UBuoyantMeshComponent& Component) const
+{
+	Component.WaterDensity = WaterDensity;
+	Component.bUseStaticForces = bUseStaticForces;
+	Component.bUseDynamicForces = bUseDynamicForces;
+	Component.bVerticalForcesOnly = bVerticalForcesOnly;
+	Component.bSemiImplicitBuoyancy = bSemiImplicitBuoyancy;
+	Component.HydrostaticForceMode = static_cast<EHydrostaticForceMode>(HydrostaticForceMode);
+	Component.HullSource = static_cast<EBuoyantHullSource>(HullSource);
+	Component.bUseAnalyticPrimitives = bUseAnalyticPrimitives;
+	Component.PrimitiveDragCoefficient = PrimitiveDragCoefficient;
+	Component.bFitWaterPlane = bFitWaterPlane;
+	Component.WaterPlaneTolerance = WaterPlaneTolerance;
+	Component.bRefineWaterline = bRefineWaterline;
+	Component.WaterlineEdgeLength = WaterlineEdgeLength;
+	Component.bUseClusterCulling = bUseClusterCulling;
+	Component.TrianglesPerCluster = TrianglesPerCluster;
+	Component.bReuseWaterlineClassification = bReuseWaterlineClassification;
+	Component.bUseCompactHull = bUseCompactHull;
+	Component.bAccurateWaterHeight = bAccurateWaterHeight;
+	Component.WaterHeightTolerance = WaterHeightTolerance;
+}
+
+FArchive& operator<<(FArchive& Ar, FBuoyancyRecordedBodyInfo& Info)
+{
+	Ar << Info.Name << Info.StaticMeshPath << Info.WaterDensity << Info.bUseStaticForces << Info.bUseDynamicForces;
+	Ar << Info.bVerticalForcesOnly << Info.bSemiImplicitBuoyancy << Info.HydrostaticForceMode << Info.HullSource;
+	Ar << Info.bUseAnalyticPrimitives << Info.PrimitiveDragCoefficient;
+	Ar << Info.bFitWaterPlane << Info.WaterPlaneTolerance << Info.bRefineWaterline << Info.WaterlineEdgeLength;
+	Ar << Info.bUseClusterCulling << Info.TrianglesPerCluster << Info.bReuseWaterlineClassification;
+	return Ar << Info.bUseCompactHull << Info.bAccurateWaterHeight << Info.WaterHeightTolerance;
+}
+
+FArchive& operator<<(FArchive& Ar, FBuoyancyRecordingHeader& Header)
+{
+	return Ar << Header.GravityMagnitude << Header.WaterGridResolution << Header.Bodies;
+}
+
+FArchive& operator<<(FArchive& Ar, FBuoyancyRecordedWater& Water)
+{
+	Ar << Water.Region << Water.Resolution;
+
+	// Heights are quantized to 16 bits over their range, waves rarely span more than a few meters under a body.
+	float MinHeight = 0.f;
+	float MaxHeight = 0.f;
+	TArray<uint16> QuantizedHeights;
+	if (Ar.IsSaving() && Water.Heights.Num() > 0)
+	{
+		MinHeight = FMath::Min(Water.Heights);
+		MaxHeight = FMath::Max(Water.Heights);
+		const auto Scale = MaxHeight > MinHeight ? 65535.f / (MaxHeight - MinHeight) : 0.f;
+		QuantizedHeights.Reserve(Water.Heights.Num());
+		for (const auto Height : Water.Heights)
+		{
+			QuantizedHeights.Add(static_cast<uint16>(FMath::RoundToInt((Height - MinHeight) * Scale)));
+		}
+	}
+
+	Ar << MinHeight << MaxHeight << QuantizedHeights;
+
+	if (Ar.IsLoading())
+	{
+		const auto Step = (MaxHeight - MinHeight) / 65535.f;
+		Water.Heights.Reset(QuantizedHeights.Num());
+		for (const auto QuantizedHeight : QuantizedHeights)
+		{
+			Water.Heights.Add(MinHeight + QuantizedHeight * Step);
+		}
+	}
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FBuoyancyRecordedBody& Body)
+{
+	return Ar << Body.Transform << Body.CenterOfMass << Body.LinearVelocity << Body.AngularVelocity << Body.Water;
+}
+
+FArchive& operator<<(FArchive& Ar, FBuoyancyRecordedFrame& Frame)
+{
+	return Ar << Frame.Time << Frame.DeltaTime << Frame.Bodies;
+}
+
+float FBuoyancyRecordedWater::GetHeightAtPosition(const FVector& Position) const
+{
+	if (Resolution < 2 || Heights.Num() != Resolution * Resolution) return 0.f;
+
+	const auto Size = Region.GetSize();
+	const auto GridX = FMath::Clamp(Size.X > 0.f ? (Position.X - Region.Min.X) / Size.X : 0.f, 0.f, 1.f) * (Resolution - 1);
+	const auto GridY = FMath::Clamp(Size.Y > 0.f ? (Position.Y - Region.Min.Y) / Size.Y : 0.f, 0.f, 1.f) * (Resolution - 1);
+	const auto X0 = FMath::Min(FMath::FloorToInt(GridX), Resolution - 2);
+	const auto Y0 = FMath::Min(FMath::FloorToInt(GridY), Resolution - 2);
+	const auto AlphaX = GridX - X0;
+	const auto AlphaY = GridY - Y0;
+
+	const auto Height00 = Heights[X0 * Resolution + Y0];
+	const auto Height01 = Heights[X0 * Resolution + Y0 + 1];
+	const auto Height10 = Heights[(X0 + 1) * Resolution + Y0];
+	const auto Height11 = Heights[(X0 + 1) * Resolution + Y0 + 1];
+	return FMath::BiLerp(Height00, Height10, Height01, Height11, AlphaX, AlphaY);
+}
+
+FVector FBuoyancyRecordedBody::GetVelocityAtPoint(const FVector& Point) const
+{
+	return LinearVelocity + (AngularVelocity ^ (Point - CenterOfMass));
+}
+
+bool FBuoyancyRecordingWriter::Open(const FString& Filename, FBuoyancyRecordingHeader& Header)
+{
+	Archive.Reset(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Archive) return false;
+
+	auto Magic = RecordingMagic;
+	auto Version = RecordingVersion;
+	*Archive << Magic << Version << Header;
+	return true;
+}
+
+void FBuoyancyRecordingWriter::WriteFrame(FBuoyancyRecordedFrame& Frame)
+{
+	if (Archive)
+	{
+		*Archive << Frame;
+	}
+}
+
+void FBuoyancyRecordingWriter::Close()
+{
+	if (Archive)
+	{
+		Archive->Close();
+		Archive.Reset();
+	}
+}
+
+bool FBuoyancyRecordingWriter::IsOpen() const
+{
+	return Archive.IsValid();
+}
+
+bool FBuoyancyRecordingReader::Open(const FString& Filename)
+{
+	Archive.Reset(IFileManager::Get().CreateFileReader(*Filename));
+	if (!Archive) return false;
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	*Archive << Magic << Version;
+	if (Magic != RecordingMagic || Version != RecordingVersion)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s is not a buoyancy recording of version %d."), *Filename, RecordingVersion);
+		Archive.Reset();
+		return false;
+	}
+
+	*Archive << Header;
+	return !Archive->IsError();
+}
+
+const FBuoyancyRecordingHeader& FBuoyancyRecordingReader::GetHeader() const
+{
+	return Header;
+}
+
+bool FBuoyancyRecordingReader::ReadFrame(FBuoyancyRecordedFrame& OutFrame)
+{
+	if (!Archive || Archive->AtEnd()) return false;
+
+	*Archive << OutFrame;
+	return !Archive->IsError();
+}
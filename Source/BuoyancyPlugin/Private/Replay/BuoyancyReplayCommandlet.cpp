@@ -0,0 +1,157 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "Replay/BuoyancyReplayCommandlet.h"
+#include "Replay/BuoyancyRecording.h"
+#include "Replay/BuoyancyRecordedWaterSurfaceProvider.h"
+#include "BuoyantMesh/BuoyantMeshComponent.h"
+#include "BuoyancySubsystem.h"
+#include "Engine/StaticMesh.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Parse.h"
+#include "UObject/Package.h"
+
+
+// Buoyant mesh evaluating a recorded body, with the water of the frame being replayed.
+struct FReplayBody
+{
+	UBuoyantMeshComponent* Component = nullptr;
+	UBuoyancyRecordedWaterSurfaceProvider* Water = nullptr;
+};
+
+static FReplayBody MakeReplayBody(UStaticMesh* StaticMesh, const FBuoyancyRecordedBodyInfo& Info)
+{
+	FReplayBody Body;
+	Body.Component = NewObject<UBuoyantMeshComponent>(GetTransientPackage());
+	Body.Component->SetStaticMesh(StaticMesh);
+	Info.ApplyTo(*Body.Component);
+	Body.Water = NewObject<UBuoyancyRecordedWaterSurfaceProvider>(Body.Component);
+	Body.Component->WaterSurfaceProvider = Body.Water;
+	// Not referenced by anything else while the commandlet runs.
+	Body.Component->AddToRoot();
+	return Body;
+}
+
+UBuoyancyReplayCommandlet::UBuoyancyReplayCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UBuoyancyReplayCommandlet::Main(const FString& Params)
+{
+	FString Filename;
+	if (!FParse::Value(*Params, TEXT("File="), Filename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=BuoyancyReplay -File=<recording> [-Iterations=<count>]"));
+		return 1;
+	}
+	int32 Iterations = 1;
+	FParse::Value(*Params, TEXT("Iterations="), Iterations);
+
+	// Read the whole recording first so the file access isn't timed.
+	FBuoyancyRecordingReader Reader;
+	if (!Reader.Open(Filename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not open the buoyancy recording %s."), *Filename);
+		return 1;
+	}
+	const auto& Header = Reader.GetHeader();
+	TArray<FBuoyancyRecordedFrame> Frames;
+	FBuoyancyRecordedFrame Frame;
+	while (Reader.ReadFrame(Frame))
+	{
+		Frames.Add(Frame);
+	}
+
+	TArray<FReplayBody> ReplayBodies;
+	int32 TotalTriangleCount = 0;
+	for (const auto& Info : Header.Bodies)
+	{
+		const auto StaticMesh = LoadObject<UStaticMesh>(nullptr, *Info.StaticMeshPath);
+		if (StaticMesh && StaticMesh->BodySetup)
+		{
+			StaticMesh->BodySetup->CreatePhysicsMeshes();
+			ReplayBodies.Add(MakeReplayBody(StaticMesh, Info));
+			for (const auto& TriangleMesh : TMeshUtilities::GetTriangleMeshes(StaticMesh->BodySetup))
+			{
+				TotalTriangleCount += TriangleMesh.TriangleVertexIndices.Num() / 3;
+			}
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s: could not load %s, the body is skipped."), *Info.Name, *Info.StaticMeshPath);
+			ReplayBodies.AddDefaulted();
+		}
+	}
+
+	UE_LOG(LogTemp,
+	       Display,
+	       TEXT("Replaying %d frames of %d bodies (%d triangles) from %s."),
+	       Frames.Num(),
+	       Header.Bodies.Num(),
+	       TotalTriangleCount,
+	       *Filename);
+
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		double Checksum = 0.0;
+		auto SlowestFrameSeconds = 0.0;
+
+		const auto StartSeconds = FPlatformTime::Seconds();
+		for (const auto& ReplayedFrame : Frames)
+		{
+			const auto FrameStartSeconds = FPlatformTime::Seconds();
+			const auto BodyCount = FMath::Min(ReplayedFrame.Bodies.Num(), ReplayBodies.Num());
+			for (int32 BodyIndex = 0; BodyIndex < BodyCount; ++BodyIndex)
+			{
+				const auto& ReplayBody = ReplayBodies[BodyIndex];
+				if (!ReplayBody.Component) continue;
+
+				const auto& RecordedBody = ReplayedFrame.Bodies[BodyIndex];
+				FBuoyantBodyState BodyState;
+				BodyState.CenterOfMass = RecordedBody.CenterOfMass;
+				BodyState.LinearVelocity = RecordedBody.LinearVelocity;
+				BodyState.AngularVelocity = RecordedBody.AngularVelocity;
+				BodyState.Rotation = RecordedBody.Transform.GetRotation();
+
+				ReplayBody.Water->Water = &RecordedBody.Water;
+				FVector Force;
+				FVector Torque;
+				ReplayBody.Component->EvaluateBuoyancyForState(RecordedBody.Transform,
+				                                               BodyState,
+				                                               ReplayedFrame.Time,
+				                                               ReplayedFrame.DeltaTime,
+				                                               Header.GravityMagnitude,
+				                                               /*out*/ Force,
+				                                               /*out*/ Torque);
+				ReplayBody.Water->Water = nullptr;
+				Checksum += Force.X + Force.Y + Force.Z + Torque.Size() + ReplayBody.Component->SubmergedVolume;
+			}
+			SlowestFrameSeconds = FMath::Max(SlowestFrameSeconds, FPlatformTime::Seconds() - FrameStartSeconds);
+		}
+		const auto TotalSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+		UE_LOG(LogTemp,
+		       Display,
+		       TEXT("Iteration %d: %.3f ms total, %.4f ms per frame, %.4f ms slowest frame, checksum %.6e"),
+		       Iteration,
+		       TotalSeconds * 1000.0,
+		       Frames.Num() > 0 ? TotalSeconds * 1000.0 / Frames.Num() : 0.0,
+		       SlowestFrameSeconds * 1000.0,
+		       Checksum);
+	}
+
+	for (const auto& ReplayBody : ReplayBodies)
+	{
+		if (ReplayBody.Component)
+		{
+			ReplayBody.Component->RemoveFromRoot();
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,394 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "Stress/BuoyancyStressTestCommandlet.h"
+#include "BuoyancySubsystem.h"
+#include "WaterSurface/AnalyticWaterSurfaceProviders.h"
+#include "OceanPlugin/Public/OceanManager.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
+#include "UObject/UnrealType.h"
+
+
+// A buoyancy setup of the plugin content.
+struct FStressTestSetup
+{
+	const TCHAR* Name;
+	const TCHAR* ClassPath;
+};
+
+static const FStressTestSetup StressTestSetups[] = {
+    {TEXT("Buoy"), TEXT("/BuoyancyPlugin/BuoyantMesh/Buoy.Buoy_C")},
+    {TEXT("FishBoatForce"), TEXT("/BuoyancyPlugin/BuoyantForce/BP_FishBoat_BF.BP_FishBoat_BF_C")},
+    {TEXT("FishBoatAdvanced"), TEXT("/BuoyancyPlugin/AdvancedBuoyancy/BP_FishBoat_AB.BP_FishBoat_AB_C")},
+    {TEXT("ManOfWar"), TEXT("/BuoyancyPlugin/BuoyantForce/BP_ManOfWar_BF.BP_ManOfWar_BF_C")},
+    {TEXT("Iceberg"), TEXT("/BuoyancyPlugin/BuoyancyDestructible/IceBerg.IceBerg_C")},
+};
+
+// Instances are spaced by their bounds diagonal times this, so they don't collide when they drift.
+static const float InstanceSpacingFactor = 1.5f;
+static const float MinInstanceSpacing = 100.f;
+
+struct FStressTestSettings
+{
+	int32 WarmupFrames = 30;
+	int32 Frames = 300;
+	float DeltaTime = 1.f / 60.f;
+};
+
+// Waves of a moderate sea, in the range of the OceanManager defaults, for the thread safe water of the runs.
+struct FStressTestWave
+{
+	float Wavelength;
+	float Amplitude;
+	FVector2D Direction;
+};
+
+static const FStressTestWave StressTestWaves[] = {
+    {6000.f, 60.f, FVector2D{1.f, 0.f}},
+    {3100.f, 30.f, FVector2D{0.9f, 0.4f}},
+    {1700.f, 15.f, FVector2D{0.8f, -0.5f}},
+    {900.f, 8.f, FVector2D{0.6f, 0.8f}},
+};
+static const float StressTestWaveSteepness = 0.4f;
+
+struct FStressTestResult
+{
+	// Buoyancy components of an instance, joined with '+'.
+	FString Components;
+	int32 BodyCount = 0;
+	// Bodies the subsystem evaluated on the game thread, which the thread count doesn't change.
+	int32 GameThreadBodyCount = 0;
+	double FrameSeconds = 0.0;
+	double BuoyancySeconds = 0.0;
+	double MaxBuoyancySeconds = 0.0;
+};
+
+// Parses a comma separated list of positive integers. Returns Default if the parameter is missing or empty.
+static TArray<int32> ParseIntegerList(const FString& Params, const TCHAR* Name, const TArray<int32>& Default)
+{
+	FString Value;
+	if (!FParse::Value(*Params, Name, Value, false)) return Default;
+
+	TArray<FString> Items;
+	Value.ParseIntoArray(Items, TEXT(","));
+	TArray<int32> Integers;
+	for (const auto& Item : Items)
+	{
+		const auto Integer = FCString::Atoi(*Item);
+		if (Integer > 0) Integers.Add(Integer);
+	}
+	return Integers.Num() > 0 ? Integers : Default;
+}
+
+// Powers of two up to the number of threads that can evaluate bodies: the workers and the game thread.
+static TArray<int32> GetDefaultThreadCounts()
+{
+	const auto MaxThreadCount = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	TArray<int32> ThreadCounts;
+	for (int32 ThreadCount = 1; ThreadCount < MaxThreadCount; ThreadCount *= 2)
+	{
+		ThreadCounts.Add(ThreadCount);
+	}
+	ThreadCounts.Add(MaxThreadCount);
+	return ThreadCounts;
+}
+
+static void SetConsoleVariable(const TCHAR* Name, int32 Value)
+{
+	if (const auto Variable = IConsoleManager::Get().FindConsoleVariable(Name))
+	{
+		Variable->Set(Value, ECVF_SetByCode);
+	}
+}
+
+// A game world with physics, begun play without a game mode so it needs no game instance.
+static UWorld* CreateStressTestWorld()
+{
+	const auto World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("BuoyancyStressTest"));
+	GEngine->CreateNewWorldContext(EWorldType::Game).SetCurrentWorld(World);
+	World->bShouldSimulatePhysics = true;
+
+	World->InitializeActorsForPlay(FURL{});
+	World->GetWorldSettings()->NotifyBeginPlay();
+	return World;
+}
+
+static void DestroyStressTestWorld(UWorld* World)
+{
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
+
+static void TickStressTestWorld(UWorld* World, float DeltaTime)
+{
+	World->Tick(LEVELTICK_All, DeltaTime);
+	++GFrameCounter;
+}
+
+// Gerstner waves the bodies can query from any thread, unlike the OceanManager.
+static UObject* CreateStressTestWater(UWorld* World)
+{
+	const auto Water = NewObject<UGerstnerWaterSurfaceProvider>(World);
+	for (const auto& StressTestWave : StressTestWaves)
+	{
+		FAnalyticGerstnerWave Wave;
+		Wave.Wavelength = StressTestWave.Wavelength;
+		Wave.Amplitude = StressTestWave.Amplitude;
+		Wave.Steepness = StressTestWaveSteepness;
+		Wave.Direction = StressTestWave.Direction;
+		Water->Waves.Add(Wave);
+	}
+	return Water;
+}
+
+// Makes the buoyancy components of the actor query Water instead of the OceanManager.
+static void SetWaterSurfaceProvider(AActor* Actor, UObject* Water)
+{
+	static const FName WaterSurfaceProviderName{TEXT("WaterSurfaceProvider")};
+	for (const auto Component : Actor->GetComponents())
+	{
+		const auto Property =
+		    Component ? FindFProperty<FObjectProperty>(Component->GetClass(), WaterSurfaceProviderName) : nullptr;
+		if (Property)
+		{
+			Property->SetObjectPropertyValue_InContainer(Component, Water);
+		}
+	}
+}
+
+// Spawns the instances on a square grid at sea level, querying Water if set. Returns the buoyancy components of the
+// first one.
+static FString SpawnInstances(UWorld* World, UClass* SetupClass, int32 InstanceCount, UObject* Water)
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	const auto ColumnCount = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(InstanceCount)));
+	auto Spacing = MinInstanceSpacing;
+	TArray<FString> Components;
+	for (int32 i = 0; i < InstanceCount; ++i)
+	{
+		const FVector Location{(i % ColumnCount) * Spacing, (i / ColumnCount) * Spacing, 0.f};
+		const auto Actor = World->SpawnActor<AActor>(SetupClass, FTransform{Location}, SpawnParameters);
+		if (Actor && Water)
+		{
+			SetWaterSurfaceProvider(Actor, Water);
+		}
+		if (i > 0 || !Actor) continue;
+
+		const auto Size = Actor->GetComponentsBoundingBox(true).GetSize();
+		Spacing = FMath::Max(MinInstanceSpacing, FVector2D{Size.X, Size.Y}.Size() * InstanceSpacingFactor);
+
+		for (const auto Component : Actor->GetComponents())
+		{
+			if (Component && Component->GetClass()->GetPathName().StartsWith(TEXT("/Script/BuoyancyPlugin.")))
+			{
+				Components.AddUnique(Component->GetClass()->GetName());
+			}
+		}
+	}
+	Components.Sort();
+	return FString::Join(Components, TEXT("+"));
+}
+
+static FStressTestResult RunStressTest(UClass* SetupClass,
+                                       UClass* OceanClass,
+                                       int32 InstanceCount,
+                                       bool bOceanWater,
+                                       const FStressTestSettings& Settings)
+{
+	const auto World = CreateStressTestWorld();
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	World->SpawnActor<AActor>(OceanClass, FTransform::Identity, SpawnParameters);
+
+	FStressTestResult Result;
+	Result.Components =
+	    SpawnInstances(World, SetupClass, InstanceCount, bOceanWater ? nullptr : CreateStressTestWater(World));
+
+	// Lets the bodies settle and the caches fill before timing.
+	for (int32 Frame = 0; Frame < Settings.WarmupFrames; ++Frame)
+	{
+		TickStressTestWorld(World, Settings.DeltaTime);
+	}
+
+	const auto Subsystem = World->GetSubsystem<UBuoyancySubsystem>();
+	Result.BodyCount = Subsystem ? Subsystem->GetBodyCount() : 0;
+	for (int32 Frame = 0; Frame < Settings.Frames; ++Frame)
+	{
+		const auto StartSeconds = FPlatformTime::Seconds();
+		TickStressTestWorld(World, Settings.DeltaTime);
+		Result.FrameSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+		const auto BuoyancySeconds = Subsystem ? Subsystem->GetLastUpdateSeconds() : 0.0;
+		Result.BuoyancySeconds += BuoyancySeconds;
+		Result.MaxBuoyancySeconds = FMath::Max(Result.MaxBuoyancySeconds, BuoyancySeconds);
+	}
+	Result.GameThreadBodyCount = Subsystem ? Subsystem->GetLastGameThreadBodyCount() : 0;
+	Result.FrameSeconds /= FMath::Max(1, Settings.Frames);
+	Result.BuoyancySeconds /= FMath::Max(1, Settings.Frames);
+
+	DestroyStressTestWorld(World);
+	return Result;
+}
+
+UBuoyancyStressTestCommandlet::UBuoyancyStressTestCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UBuoyancyStressTestCommandlet::Main(const FString& Params)
+{
+	const auto InstanceCounts = ParseIntegerList(Params, TEXT("Counts="), {1, 10, 50, 100, 200});
+	const auto ThreadCounts = ParseIntegerList(Params, TEXT("Threads="), GetDefaultThreadCounts());
+
+	FStressTestSettings Settings;
+	FParse::Value(*Params, TEXT("Warmup="), Settings.WarmupFrames);
+	FParse::Value(*Params, TEXT("Frames="), Settings.Frames);
+	FParse::Value(*Params, TEXT("DeltaTime="), Settings.DeltaTime);
+	Settings.WarmupFrames = FMath::Max(0, Settings.WarmupFrames);
+	Settings.Frames = FMath::Max(1, Settings.Frames);
+
+	FString Output = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Buoyancy"), TEXT("BuoyancyStressTest.csv"));
+	FParse::Value(*Params, TEXT("Output="), Output);
+
+	FString SetupFilter;
+	TArray<FString> SetupNames;
+	if (FParse::Value(*Params, TEXT("Setups="), SetupFilter, false))
+	{
+		SetupFilter.ParseIntoArray(SetupNames, TEXT(","));
+	}
+
+	UClass* OceanClass = AOceanManager::StaticClass();
+	FString OceanClassPath;
+	if (FParse::Value(*Params, TEXT("Ocean="), OceanClassPath))
+	{
+		OceanClass = LoadClass<AOceanManager>(nullptr, *OceanClassPath);
+		if (!OceanClass)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not load the ocean class %s."), *OceanClassPath);
+			return 1;
+		}
+	}
+
+	// The OceanManager can only be queried from the game thread, so the thread counts change nothing with its water.
+	FString WaterName = TEXT("Gerstner");
+	FParse::Value(*Params, TEXT("Water="), WaterName);
+	const auto bOceanWater = WaterName == TEXT("Ocean");
+	if (!bOceanWater && WaterName != TEXT("Gerstner"))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Unknown water %s, use Gerstner or Ocean."), *WaterName);
+		return 1;
+	}
+
+	// The thread counts are applied to the subsystem evaluation.
+	SetConsoleVariable(TEXT("buoyancy.UseSubsystem"), 1);
+
+	UE_LOG(LogTemp,
+	       Display,
+	       TEXT("Buoyancy stress test: %s water, %d task graph workers, %d warmup and %d timed frames of %.4f s."),
+	       *WaterName,
+	       FTaskGraphInterface::Get().GetNumWorkerThreads(),
+	       Settings.WarmupFrames,
+	       Settings.Frames,
+	       Settings.DeltaTime);
+
+	FString Csv = TEXT("Setup,Components,Instances,Bodies,GameThreadBodies,Threads,Frames,FrameMs,BuoyancyMs,MaxBuoyancyMs,BuoyancyUsPerInstance\n");
+	int32 RunCount = 0;
+	for (const auto& Setup : StressTestSetups)
+	{
+		if (SetupNames.Num() > 0 && !SetupNames.Contains(Setup.Name)) continue;
+
+		const auto SetupClass = LoadClass<AActor>(nullptr, Setup.ClassPath);
+		if (!SetupClass)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s: could not load %s, the setup is skipped."), Setup.Name, Setup.ClassPath);
+			continue;
+		}
+
+		for (const auto InstanceCount : InstanceCounts)
+		{
+			for (const auto ThreadCount : ThreadCounts)
+			{
+				SetConsoleVariable(TEXT("buoyancy.MaxEvaluationTasks"), ThreadCount);
+				const auto Result = RunStressTest(SetupClass, OceanClass, InstanceCount, bOceanWater, Settings);
+				++RunCount;
+
+				const auto FrameMs = Result.FrameSeconds * 1000.0;
+				const auto BuoyancyMs = Result.BuoyancySeconds * 1000.0;
+				const auto MaxBuoyancyMs = Result.MaxBuoyancySeconds * 1000.0;
+				const auto BuoyancyUsPerInstance = Result.BuoyancySeconds * 1000000.0 / InstanceCount;
+				UE_LOG(LogTemp,
+				       Display,
+				       TEXT("%s x%d, %d threads: %.3f ms per frame, %.3f ms buoyancy (%.3f ms slowest), %d bodies."),
+				       Setup.Name,
+				       InstanceCount,
+				       ThreadCount,
+				       FrameMs,
+				       BuoyancyMs,
+				       MaxBuoyancyMs,
+				       Result.BodyCount);
+
+				Csv += FString::Printf(TEXT("%s,%s,%d,%d,%d,%d,%d,%.4f,%.4f,%.4f,%.3f\n"),
+				                       Setup.Name,
+				                       *Result.Components,
+				                       InstanceCount,
+				                       Result.BodyCount,
+				                       Result.GameThreadBodyCount,
+				                       ThreadCount,
+				                       Settings.Frames,
+				                       FrameMs,
+				                       BuoyancyMs,
+				                       MaxBuoyancyMs,
+				                       BuoyancyUsPerInstance);
+
+				// The other thread counts would time the same serial work.
+				if (Result.GameThreadBodyCount > 0 && Result.GameThreadBodyCount == Result.BodyCount)
+				{
+					UE_LOG(LogTemp,
+					       Warning,
+					       TEXT("%s: every body is evaluated on the game thread, the thread count sweep is skipped."),
+					       Setup.Name);
+					break;
+				}
+				if (Result.GameThreadBodyCount > 0)
+				{
+					UE_LOG(LogTemp,
+					       Warning,
+					       TEXT("%s: %d of the %d bodies are evaluated on the game thread whatever the thread count."),
+					       Setup.Name,
+					       Result.GameThreadBodyCount,
+					       Result.BodyCount);
+				}
+			}
+		}
+	}
+	SetConsoleVariable(TEXT("buoyancy.MaxEvaluationTasks"), 0);
+
+	if (RunCount == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("No setup was run."));
+		return 1;
+	}
+	if (!FFileHelper::SaveStringToFile(Csv, *Output))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not write %s."), *Output);
+		return 1;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Wrote %d runs to %s."), RunCount, *Output);
+	return 0;
+}
@@ -0,0 +1,36 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StaticMesh.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "UObject/Package.h"
+#include "BuoyantMesh/BuoyantMeshComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+
+// The engine cube, 100 uu across, with its collision cooked so its hull can be read outside of a game.
+inline UStaticMesh* LoadTestMesh()
+{
+	const auto StaticMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (StaticMesh && StaticMesh->BodySetup)
+	{
+		StaticMesh->BodySetup->CreatePhysicsMeshes();
+	}
+	return StaticMesh;
+}
+
+// A transient buoyant mesh with the default settings, floating in Water. Evaluated with EvaluateBuoyancyForState, it
+// needs neither a world nor a physics body.
+inline UBuoyantMeshComponent* MakeTestComponent(UStaticMesh* StaticMesh, UObject* Water)
+{
+	const auto Component = NewObject<UBuoyantMeshComponent>(GetTransientPackage());
+	Component->SetStaticMesh(StaticMesh);
+	Component->WaterSurfaceProvider = Water;
+	return Component;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,125 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "HAL/IConsoleManager.h"
+#include "BuoyantMesh/BuoyantMeshBatch.h"
+#include "BuoyantMesh/BuoyantMeshVertex.h"
+#include "BuoyancySubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && INTEL_ISPC
+
+
+static const EAutomationTestFlags::Type BuoyantMeshBatchTestFlags =
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter;
+
+// Relative to the magnitude of the compared values, like buoyancy.ISPC.Validate.
+static const float KernelTolerance = 1e-3f;
+
+static void TestKernelsEqual(FAutomationTestBase& Test, const TCHAR* What, float ISPC, float Scalar)
+{
+	Test.TestEqual(What, ISPC, Scalar, KernelTolerance * FMath::Max3(1.f, FMath::Abs(ISPC), FMath::Abs(Scalar)));
+}
+
+static void TestKernelsEqual(FAutomationTestBase& Test, const TCHAR* What, const FVector& ISPC, const FVector& Scalar)
+{
+	TestKernelsEqual(Test, What, ISPC.X, Scalar.X);
+	TestKernelsEqual(Test, What, ISPC.Y, Scalar.Y);
+	TestKernelsEqual(Test, What, ISPC.Z, Scalar.Z);
+}
+
+// Random triangles going through every combination of underwater corners, so each one has 0, 1, 2 or 3 of them.
+static void AddTestTriangles(FBuoyantMeshBatch& Batch)
+{
+	// Fixed seed, so a failure can be reproduced.
+	FRandomStream Random{0xBA7C4};
+	for (int32 i = 0; i < 400; ++i)
+	{
+		const auto UnderwaterCorners = i % 8;
+		const auto MakeCorner = [&](int32 Corner) {
+			const auto Position = Random.GetUnitVector() * Random.FRandRange(10.f, 500.f);
+			const auto Depth = Random.FRandRange(1.f, 200.f);
+			return FBuoyantMeshVertex{Position, (UnderwaterCorners & (1 << Corner)) != 0 ? -Depth : Depth};
+		};
+		Batch.AddTriangle(MakeCorner(0), MakeCorner(1), MakeCorner(2));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuoyantMeshBatchISPCTest, "Buoyancy.MeshBatch.ISPC", BuoyantMeshBatchTestFlags)
+
+bool FBuoyantMeshBatchISPCTest::RunTest(const FString& Parameters)
+{
+	const auto UseISPC = IConsoleManager::Get().FindConsoleVariable(TEXT("buoyancy.ISPC"));
+	const auto ValidateISPC = IConsoleManager::Get().FindConsoleVariable(TEXT("buoyancy.ISPC.Validate"));
+	if (!TestNotNull(TEXT("buoyancy.ISPC"), UseISPC) || !TestNotNull(TEXT("buoyancy.ISPC.Validate"), ValidateISPC))
+	{
+		return false;
+	}
+	const auto PreviousUseISPC = UseISPC->GetInt();
+	const auto PreviousValidateISPC = ValidateISPC->GetInt();
+	// The validation would replace the ISPC results with the scalar ones.
+	ValidateISPC->Set(0, ECVF_SetByConsole);
+
+	FBuoyantMeshBatch Batch;
+	AddTestTriangles(Batch);
+	const FVector VolumeApex{20.f, -30.f, 10.f};
+
+	UseISPC->Set(1, ECVF_SetByConsole);
+	float Volume;
+	FVector VolumeMoment;
+	const auto SubtriangleCount = Batch.Clip(VolumeApex, /*out*/ Volume, /*out*/ VolumeMoment);
+	const TArray<FVector> Centers(Batch.GetSubtriangleCenters());
+	const TArray<float> Areas(Batch.GetSubtriangleAreas());
+
+	UseISPC->Set(0, ECVF_SetByConsole);
+	float ScalarVolume;
+	FVector ScalarVolumeMoment;
+	const auto ScalarSubtriangleCount = Batch.Clip(VolumeApex, /*out*/ ScalarVolume, /*out*/ ScalarVolumeMoment);
+
+	TestEqual(TEXT("Subtriangle count"), SubtriangleCount, ScalarSubtriangleCount);
+	TestKernelsEqual(*this, TEXT("Volume"), Volume, ScalarVolume);
+	TestKernelsEqual(*this, TEXT("Volume moment"), VolumeMoment, ScalarVolumeMoment);
+	for (int32 Slot = 0; Slot < Areas.Num(); ++Slot)
+	{
+		TestKernelsEqual(*this, TEXT("Area"), Areas[Slot], Batch.GetSubtriangleAreas()[Slot]);
+		// The ISPC kernel leaves the centers of the unused slots unset.
+		if (Areas[Slot] != 0.f)
+		{
+			TestKernelsEqual(*this, TEXT("Center"), Centers[Slot], Batch.GetSubtriangleCenters()[Slot]);
+		}
+	}
+
+	// Both force kernels run on the scalar clipping results.
+	TArray<float> CenterHeights;
+	FRandomStream Random{0xF0CE};
+	for (int32 Slot = 0; Slot < Areas.Num(); ++Slot)
+	{
+		CenterHeights.Add(Random.FRandRange(-200.f, 0.f));
+	}
+	FBuoyantMeshForceSettings Settings;
+	Settings.WaterDensity = 0.001027f;
+	Settings.GravityMagnitude = 980.f;
+	Settings.bStaticForces = true;
+	Settings.bDynamicForces = true;
+	FBuoyantBodyState Body;
+	Body.CenterOfMass = FVector{5.f, 10.f, -20.f};
+	Body.LinearVelocity = FVector{300.f, -50.f, 80.f};
+	Body.AngularVelocity = FVector{0.2f, -0.4f, 0.6f};
+
+	UseISPC->Set(1, ECVF_SetByConsole);
+	Batch.EvaluateForces(CenterHeights, Settings, Body);
+	const TArray<FVector> Forces(Batch.GetSubtriangleForces());
+	UseISPC->Set(0, ECVF_SetByConsole);
+	Batch.EvaluateForces(CenterHeights, Settings, Body);
+	for (int32 Slot = 0; Slot < Forces.Num(); ++Slot)
+	{
+		TestKernelsEqual(*this, TEXT("Force"), Forces[Slot], Batch.GetSubtriangleForces()[Slot]);
+	}
+
+	UseISPC->Set(PreviousUseISPC, ECVF_SetByConsole);
+	ValidateISPC->Set(PreviousValidateISPC, ECVF_SetByConsole);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS && INTEL_ISPC
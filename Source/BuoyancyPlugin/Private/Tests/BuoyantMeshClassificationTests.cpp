@@ -0,0 +1,98 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "BuoyantMesh/BuoyantMeshComponent.h"
+#include "WaterSurface/AnalyticWaterSurfaceProviders.h"
+#include "BuoyancyTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+
+static const EAutomationTestFlags::Type BuoyantMeshClassificationTestFlags =
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter;
+
+static const int32 TickCount = 5;
+static const float TickDeltaTime = 1.f / 60.f;
+
+// A 400 uu cube crossing the waterline, sinking and rolling a little every tick.
+static FTransform GetTickTransform(int32 Tick)
+{
+	return FTransform{FRotator{0.f, 30.f, Tick * 0.5f}, FVector{0.f, 0.f, Tick * -3.f}, FVector{4.f}};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuoyantMeshClassificationReuseTest,
+                                 "Buoyancy.WaterlineClassification.Reuse",
+                                 BuoyantMeshClassificationTestFlags)
+
+bool FBuoyantMeshClassificationReuseTest::RunTest(const FString& Parameters)
+{
+	const auto StaticMesh = LoadTestMesh();
+	if (!TestNotNull(TEXT("Cube mesh"), StaticMesh)) return false;
+
+	const auto Water = NewObject<USineWaterSurfaceProvider>();
+	Water->Amplitude = 30.f;
+	Water->Wavelength = 1000.f;
+	Water->Direction = FVector2D{1.f, 0.3f};
+
+	const auto Reused = MakeTestComponent(StaticMesh, Water);
+	Reused->bReuseWaterlineClassification = true;
+	const auto Sampled = MakeTestComponent(StaticMesh, Water);
+	for (int32 Tick = 0; Tick < TickCount; ++Tick)
+	{
+		const auto Transform = GetTickTransform(Tick);
+		FBuoyantBodyState Body;
+		Body.CenterOfMass = Transform.GetLocation();
+		Body.Rotation = Transform.GetRotation();
+		Body.LinearVelocity = FVector{0.f, 0.f, -3.f / TickDeltaTime};
+
+		FVector Force, Torque, SampledForce, SampledTorque;
+		const auto Time = Tick * TickDeltaTime;
+		Reused->EvaluateBuoyancyForState(Transform, Body, Time, TickDeltaTime, 980.f, /*out*/ Force, /*out*/ Torque);
+		Sampled->EvaluateBuoyancyForState(
+		    Transform, Body, Time, TickDeltaTime, 980.f, /*out*/ SampledForce, /*out*/ SampledTorque);
+
+		// Reused or not, the triangles are clipped the same.
+		TestTrue(TEXT("Submerged hull"), Sampled->SubmergedVolume > 0.f);
+		TestEqual(TEXT("Submerged volume"),
+		          Reused->SubmergedVolume,
+		          Sampled->SubmergedVolume,
+		          1e-3f * Sampled->SubmergedVolume);
+		TestEqual(TEXT("Force"), Force, SampledForce, 1e-3f * FMath::Max(1.f, SampledForce.Size()));
+		TestEqual(TEXT("Torque"), Torque, SampledTorque, 1e-3f * FMath::Max(1.f, SampledTorque.Size()));
+
+		TestEqual(TEXT("Every triangle clipped without reuse"), Sampled->ReclippedTriangleFraction, 1.f);
+		if (Tick == 0)
+		{
+			TestEqual(TEXT("Every triangle clipped on the first tick"), Reused->ReclippedTriangleFraction, 1.f);
+		}
+		else
+		{
+			// The top and bottom faces stay far from the water, only the sides are clipped again.
+			TestTrue(TEXT("Top and bottom reused"), Reused->ReclippedTriangleFraction < 1.f);
+			TestTrue(TEXT("Sides clipped"), Reused->ReclippedTriangleFraction > 0.f);
+		}
+	}
+
+	// A body that moved further than its last samples were from the water is sampled again. Without the culling the
+	// submerged top and bottom faces go through the classification.
+	Reused->bUseClusterCulling = false;
+	Sampled->bUseClusterCulling = false;
+	const auto Transform = GetTickTransform(0) * FTransform{FVector{0.f, 0.f, -250.f}};
+	FBuoyantBodyState Body;
+	Body.CenterOfMass = Transform.GetLocation();
+	Body.Rotation = Transform.GetRotation();
+	FVector Force, Torque;
+	const auto Time = TickCount * TickDeltaTime;
+	Reused->EvaluateBuoyancyForState(Transform, Body, Time, TickDeltaTime, 980.f, /*out*/ Force, /*out*/ Torque);
+	Sampled->EvaluateBuoyancyForState(Transform, Body, Time, TickDeltaTime, 980.f, /*out*/ Force, /*out*/ Torque);
+	TestEqual(TEXT("Every triangle clipped after a jump"), Reused->ReclippedTriangleFraction, 1.f);
+	TestEqual(TEXT("Submerged volume after a jump"),
+	          Reused->SubmergedVolume,
+	          Sampled->SubmergedVolume,
+	          1e-3f * Sampled->SubmergedVolume);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,132 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "BuoyantMesh/BuoyantMeshComponent.h"
+#include "WaterSurface/AnalyticWaterSurfaceProviders.h"
+#include "BuoyancyTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+
+static const EAutomationTestFlags::Type BuoyantMeshWaterPlaneTestFlags =
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter;
+
+// Relative to the magnitude of the compared forces.
+static const float ForceTolerance = 1e-3f;
+// Relative to the magnitude of the compared forces, when the plane only approximates the water over the hull.
+static const float LongWavesForceTolerance = 1e-2f;
+
+// A 400 uu cube, half submerged in water at 0 and turned so its footprint isn't aligned with the world axes.
+static const FTransform TestTransform{FRotator{0.f, 30.f, 0.f}, FVector::ZeroVector, FVector{4.f}};
+
+// Evaluates a still body at the test transform.
+static void EvaluateTestForces(UBuoyantMeshComponent* Component, /*out*/ FVector& OutForce, /*out*/ FVector& OutTorque)
+{
+	FBuoyantBodyState Body;
+	Body.CenterOfMass = TestTransform.GetLocation();
+	Body.Rotation = TestTransform.GetRotation();
+	Component->EvaluateBuoyancyForState(
+	    TestTransform, Body, 0.f, 1.f / 60.f, 980.f, /*out*/ OutForce, /*out*/ OutTorque);
+}
+
+static void TestForcesEqual(FAutomationTestBase& Test,
+                            const TCHAR* What,
+                            const FVector& Actual,
+                            const FVector& Expected,
+                            float Tolerance)
+{
+	Test.TestEqual(What, Actual, Expected, Tolerance * FMath::Max(1.f, Expected.Size()));
+}
+
+// Compares the forces on the test cube with and without bFitWaterPlane, and returns the component fitting the plane.
+static UBuoyantMeshComponent* TestAgainstPerVertexQueries(FAutomationTestBase& Test,
+                                                          UStaticMesh* StaticMesh,
+                                                          UObject* Water,
+                                                          float Tolerance = ForceTolerance)
+{
+	const auto Fitted = MakeTestComponent(StaticMesh, Water);
+	Fitted->bFitWaterPlane = true;
+	const auto Queried = MakeTestComponent(StaticMesh, Water);
+	FVector Force, Torque, QueriedForce, QueriedTorque;
+	EvaluateTestForces(Fitted, /*out*/ Force, /*out*/ Torque);
+	EvaluateTestForces(Queried, /*out*/ QueriedForce, /*out*/ QueriedTorque);
+
+	Test.TestTrue(TEXT("Submerged hull"), Queried->SubmergedVolume > 0.f);
+	TestForcesEqual(Test, TEXT("Force"), Force, QueriedForce, Tolerance);
+	TestForcesEqual(Test, TEXT("Torque"), Torque, QueriedTorque, Tolerance);
+	return Fitted;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuoyantMeshWaterPlaneFlatTest,
+                                 "Buoyancy.WaterPlane.Flat",
+                                 BuoyantMeshWaterPlaneTestFlags)
+
+bool FBuoyantMeshWaterPlaneFlatTest::RunTest(const FString& Parameters)
+{
+	const auto StaticMesh = LoadTestMesh();
+	if (!TestNotNull(TEXT("Cube mesh"), StaticMesh)) return false;
+
+	const auto Water = NewObject<UFlatWaterSurfaceProvider>();
+	const auto Fitted = TestAgainstPerVertexQueries(*this, StaticMesh, Water);
+	TestTrue(TEXT("Plane fitted"), Fitted->bWaterPlaneFitted);
+	TestEqual(TEXT("Residual"), Fitted->WaterPlaneResidual, 0.f, 1e-3f);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuoyantMeshWaterPlaneLongWavesTest,
+                                 "Buoyancy.WaterPlane.LongWaves",
+                                 BuoyantMeshWaterPlaneTestFlags)
+
+bool FBuoyantMeshWaterPlaneLongWavesTest::RunTest(const FString& Parameters)
+{
+	const auto StaticMesh = LoadTestMesh();
+	if (!TestNotNull(TEXT("Cube mesh"), StaticMesh)) return false;
+
+	const auto Footprint = StaticMesh->GetBoundingBox().TransformBy(TestTransform);
+	const auto GridSpacing = Footprint.GetSize().X * 0.5f;
+
+	// Waves much longer than the cube, crossing the still level under its center where the surface is the steepest
+	// and the least curved. The plane is tilted and only off the waves by their small third order term.
+	const auto Water = NewObject<USineWaterSurfaceProvider>();
+	Water->Amplitude = 30.f;
+	Water->Wavelength = GridSpacing * 20.f;
+	Water->Direction = FVector2D{1.f, 0.3f};
+	const auto Fitted = TestAgainstPerVertexQueries(*this, StaticMesh, Water, LongWavesForceTolerance);
+	TestTrue(TEXT("Plane fitted to long waves"), Fitted->bWaterPlaneFitted);
+	TestTrue(TEXT("Long waves residual"), Fitted->WaterPlaneResidual <= Fitted->WaterPlaneTolerance);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuoyantMeshWaterPlaneFallbackTest,
+                                 "Buoyancy.WaterPlane.Fallback",
+                                 BuoyantMeshWaterPlaneTestFlags)
+
+bool FBuoyantMeshWaterPlaneFallbackTest::RunTest(const FString& Parameters)
+{
+	const auto StaticMesh = LoadTestMesh();
+	if (!TestNotNull(TEXT("Cube mesh"), StaticMesh)) return false;
+
+	// The sampling grid spans the footprint of the turned cube in halves.
+	const auto Footprint = StaticMesh->GetBoundingBox().TransformBy(TestTransform);
+	const auto GridSpacing = Footprint.GetSize().X * 0.5f;
+
+	const auto Water = NewObject<USineWaterSurfaceProvider>();
+	Water->Amplitude = 30.f;
+
+	// Waves shorter than the cube, which no plane fits.
+	Water->Wavelength = GridSpacing * 1.3f;
+	auto Fitted = TestAgainstPerVertexQueries(*this, StaticMesh, Water);
+	TestFalse(TEXT("Plane fitted to short waves"), Fitted->bWaterPlaneFitted);
+	TestTrue(TEXT("Short waves residual"), Fitted->WaterPlaneResidual > Fitted->WaterPlaneTolerance);
+
+	// Waves the length of the grid spacing, which are level on every sample and only seen between them.
+	Water->Wavelength = GridSpacing;
+	Fitted = TestAgainstPerVertexQueries(*this, StaticMesh, Water);
+	TestFalse(TEXT("Plane fitted to waves aliased on the grid"), Fitted->bWaterPlaneFitted);
+	TestTrue(TEXT("Aliased waves residual"), Fitted->WaterPlaneResidual > Fitted->WaterPlaneTolerance);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,254 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "BuoyantMesh/BuoyantMeshComponent.h"
+#include "WaterSurface/AnalyticWaterSurfaceProviders.h"
+#include "BuoyancyTestHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+
+static const EAutomationTestFlags::Type BuoyantMeshWaterlineTestFlags =
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter;
+
+// Cells along each axis of the box the reference submerged volume is summed over.
+static const int32 ReferenceCells = 60;
+// Largest share of the roll and pitch moment error of the unrefined hull left with the refinement.
+static const float RefinedErrorRatio = 0.75f;
+// Pressure force error, relative to the reference force.
+static const float PressureForceTolerance = 2e-2f;
+// Pressure torque error, relative to the reference force times the half size of the hull. The pressure on each
+// submerged piece is applied at its center rather than its center of pressure.
+static const float PressureTorqueTolerance = 5e-2f;
+// Difference between the pressure and volume forces of the hull in still water, relative to the volume force.
+static const float WatertightTolerance = 1e-3f;
+
+// Poses of a 400 uu cube crossing the waterline, tilted and turned so no face is aligned with the waves.
+static const FTransform TestTransforms[] = {
+    FTransform{FRotator{5.f, 0.f, 0.f}, FVector{0.f, 0.f, 0.f}, FVector{4.f}},
+    FTransform{FRotator{5.f, 0.f, 20.f}, FVector{0.f, 0.f, 0.f}, FVector{4.f}},
+    FTransform{FRotator{5.f, 60.f, 0.f}, FVector{0.f, 0.f, 80.f}, FVector{4.f}},
+    FTransform{FRotator{5.f, 60.f, 20.f}, FVector{0.f, 0.f, 80.f}, FVector{4.f}},
+    FTransform{FRotator{-5.f, 30.f, 10.f}, FVector{0.f, 0.f, 40.f}, FVector{4.f}}};
+
+// Only the buoyant force at the center of buoyancy, so the moments depend on the clipped hull alone, which is what the
+// refinement changes. The pressure forces would add the error of applying the pressure on the large submerged pieces
+// at their centers, which the refinement leaves as it is.
+static UBuoyantMeshComponent* MakeVolumeComponent(UStaticMesh* StaticMesh, UObject* Water, bool bRefineWaterline)
+{
+	const auto Component = MakeTestComponent(StaticMesh, Water);
+	Component->HydrostaticForceMode = EHydrostaticForceMode::Volume;
+	Component->bUseDynamicForces = false;
+	Component->bRefineWaterline = bRefineWaterline;
+	return Component;
+}
+
+// Only the hydrostatic pressure forces, without the drag of the dynamic forces.
+static UBuoyantMeshComponent* MakePressureComponent(UStaticMesh* StaticMesh, UObject* Water, bool bRefineWaterline)
+{
+	const auto Component = MakeTestComponent(StaticMesh, Water);
+	Component->HydrostaticForceMode = EHydrostaticForceMode::Pressure;
+	Component->bUseDynamicForces = false;
+	Component->bRefineWaterline = bRefineWaterline;
+	return Component;
+}
+
+static void EvaluateTestForces(UBuoyantMeshComponent* Component,
+                               const FTransform& Transform,
+                               /*out*/ FVector& OutForce,
+                               /*out*/ FVector& OutTorque)
+{
+	FBuoyantBodyState Body;
+	Body.CenterOfMass = Transform.GetLocation();
+	Body.Rotation = Transform.GetRotation();
+	Component->EvaluateBuoyancyForState(Transform, Body, 0.f, 1.f / 60.f, 980.f, /*out*/ OutForce, /*out*/ OutTorque);
+}
+
+static FVector EvaluateTestTorque(UBuoyantMeshComponent* Component, const FTransform& Transform)
+{
+	FVector Force, Torque;
+	EvaluateTestForces(Component, Transform, /*out*/ Force, /*out*/ Torque);
+	return Torque;
+}
+
+/*
+Force and torque about the center of the box of the water on its volume below the water, summed over small cells.
+By the divergence theorem, the pressure rho * g * (WaterHeight - Z) over the hull adds up to the pressure gradient
+over the submerged volume, rho * g * (-dWaterHeight/dX, -dWaterHeight/dY, 1) on every cell, which leans with the
+water. The buoyant force of the volume mode is its vertical part alone.
+*/
+static void GetReferenceForces(const FBox& LocalBox,
+                               const FTransform& Transform,
+                               const IWaterSurfaceProvider& Water,
+                               float WaterDensity,
+                               EHydrostaticForceMode Mode,
+                               /*out*/ FVector& OutForce,
+                               /*out*/ FVector& OutTorque)
+{
+	const auto CellSize = LocalBox.GetSize() / ReferenceCells;
+	const auto Scale = Transform.GetScale3D();
+	const auto CellVolume = FMath::Abs(CellSize.X * CellSize.Y * CellSize.Z * Scale.X * Scale.Y * Scale.Z);
+	const auto CellWeight = WaterDensity * 980.f * CellVolume;
+	// Step of the central differences of the water height.
+	const auto Step = 1.f;
+
+	OutForce = FVector::ZeroVector;
+	OutTorque = FVector::ZeroVector;
+	for (int32 X = 0; X < ReferenceCells; ++X)
+	{
+		for (int32 Y = 0; Y < ReferenceCells; ++Y)
+		{
+			for (int32 Z = 0; Z < ReferenceCells; ++Z)
+			{
+				const auto LocalCenter = LocalBox.Min + CellSize * (FVector{float(X), float(Y), float(Z)} + 0.5f);
+				const auto Center = Transform.TransformPosition(LocalCenter);
+				if (Center.Z >= Water.GetWaterHeight(Center, 0.f)) continue;
+
+				auto CellForce = FVector{0.f, 0.f, CellWeight};
+				if (Mode == EHydrostaticForceMode::Pressure)
+				{
+					const auto SlopeX = (Water.GetWaterHeight(Center + FVector{Step, 0.f, 0.f}, 0.f) -
+					                     Water.GetWaterHeight(Center - FVector{Step, 0.f, 0.f}, 0.f)) /
+					                    (2.f * Step);
+					const auto SlopeY = (Water.GetWaterHeight(Center + FVector{0.f, Step, 0.f}, 0.f) -
+					                     Water.GetWaterHeight(Center - FVector{0.f, Step, 0.f}, 0.f)) /
+					                    (2.f * Step);
+					CellForce.X = -CellWeight * SlopeX;
+					CellForce.Y = -CellWeight * SlopeY;
+				}
+				OutForce += CellForce;
+				OutTorque += FVector::CrossProduct(Center - Transform.GetLocation(), CellForce);
+			}
+		}
+	}
+}
+
+static FVector GetReferenceTorque(const FBox& LocalBox,
+                                  const FTransform& Transform,
+                                  const IWaterSurfaceProvider& Water,
+                                  float WaterDensity)
+{
+	FVector Force, Torque;
+	GetReferenceForces(
+	    LocalBox, Transform, Water, WaterDensity, EHydrostaticForceMode::Volume, /*out*/ Force, /*out*/ Torque);
+	return Torque;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuoyantMeshWaterlineMomentsTest,
+                                 "Buoyancy.WaterlineRefinement.Moments",
+                                 BuoyantMeshWaterlineTestFlags)
+
+bool FBuoyantMeshWaterlineMomentsTest::RunTest(const FString& Parameters)
+{
+	const auto StaticMesh = LoadTestMesh();
+	if (!TestNotNull(TEXT("Cube mesh"), StaticMesh)) return false;
+
+	// Waves a few times longer than the cube, which bend the waterline across its faces.
+	const auto Water = NewObject<USineWaterSurfaceProvider>();
+	Water->Amplitude = 30.f;
+	Water->Wavelength = 1000.f;
+	Water->Direction = FVector2D{1.f, 0.3f};
+
+	const auto Refined = MakeVolumeComponent(StaticMesh, Water, true);
+	const auto Unrefined = MakeVolumeComponent(StaticMesh, Water, false);
+	for (const auto& Transform : TestTransforms)
+	{
+		const auto Reference =
+		    GetReferenceTorque(StaticMesh->GetBoundingBox(), Transform, *Water, Refined->WaterDensity);
+		// Roll and pitch, the vertical moment of a vertical force is always zero.
+		const auto Error = (EvaluateTestTorque(Unrefined, Transform) - Reference).Size2D();
+		const auto RefinedError = (EvaluateTestTorque(Refined, Transform) - Reference).Size2D();
+
+		TestTrue(FString::Printf(TEXT("%s: roll and pitch moment error %f refined, %f unrefined"),
+		                         *Transform.Rotator().ToString(),
+		                         RefinedError,
+		                         Error),
+		         RefinedError < RefinedErrorRatio * Error);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuoyantMeshWaterlinePressureTest,
+                                 "Buoyancy.WaterlineRefinement.Pressure",
+                                 BuoyantMeshWaterlineTestFlags)
+
+bool FBuoyantMeshWaterlinePressureTest::RunTest(const FString& Parameters)
+{
+	const auto StaticMesh = LoadTestMesh();
+	if (!TestNotNull(TEXT("Cube mesh"), StaticMesh)) return false;
+
+	// Waves long enough for the refined waterline to follow them closely, and steep enough for the pressure to push
+	// the cube sideways noticeably.
+	const auto Water = NewObject<USineWaterSurfaceProvider>();
+	Water->Amplitude = 40.f;
+	Water->Wavelength = 4000.f;
+	Water->Direction = FVector2D{1.f, 0.3f};
+
+	const auto LocalBox = StaticMesh->GetBoundingBox();
+	const auto Pressure = MakePressureComponent(StaticMesh, Water, true);
+	for (const auto& Transform : TestTransforms)
+	{
+		FVector ReferenceForce, ReferenceTorque, Force, Torque;
+		GetReferenceForces(LocalBox,
+		                   Transform,
+		                   *Water,
+		                   Pressure->WaterDensity,
+		                   EHydrostaticForceMode::Pressure,
+		                   /*out*/ ReferenceForce,
+		                   /*out*/ ReferenceTorque);
+		EvaluateTestForces(Pressure, Transform, /*out*/ Force, /*out*/ Torque);
+
+		const auto Pose = Transform.Rotator().ToString();
+		const auto HalfSize = (LocalBox.GetExtent() * Transform.GetScale3D()).GetAbsMax();
+		TestTrue(FString::Printf(TEXT("%s: sideways reference force"), *Pose), ReferenceForce.Size2D() > 0.f);
+		TestEqual(FString::Printf(TEXT("%s: pressure force"), *Pose),
+		          Force,
+		          ReferenceForce,
+		          PressureForceTolerance * ReferenceForce.Size());
+		TestEqual(FString::Printf(TEXT("%s: pressure torque"), *Pose),
+		          Torque,
+		          ReferenceTorque,
+		          PressureTorqueTolerance * ReferenceForce.Size() * HalfSize);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuoyantMeshWaterlineWatertightTest,
+                                 "Buoyancy.WaterlineRefinement.Watertight",
+                                 BuoyantMeshWaterlineTestFlags)
+
+bool FBuoyantMeshWaterlineWatertightTest::RunTest(const FString& Parameters)
+{
+	const auto StaticMesh = LoadTestMesh();
+	if (!TestNotNull(TEXT("Cube mesh"), StaticMesh)) return false;
+
+	// In still water the pressure over a closed hull adds up to the weight of the water it displaces, straight up.
+	// A gap or an overlap left by the clipping or the refinement shows as a difference with the volume force, or as a
+	// sideways force.
+	const auto Water = NewObject<UFlatWaterSurfaceProvider>();
+	for (const auto bRefineWaterline : {false, true})
+	{
+		const auto Pressure = MakePressureComponent(StaticMesh, Water, bRefineWaterline);
+		const auto Volume = MakeVolumeComponent(StaticMesh, Water, bRefineWaterline);
+		for (const auto& Transform : TestTransforms)
+		{
+			FVector PressureForce, PressureTorque, VolumeForce, VolumeTorque;
+			EvaluateTestForces(Pressure, Transform, /*out*/ PressureForce, /*out*/ PressureTorque);
+			EvaluateTestForces(Volume, Transform, /*out*/ VolumeForce, /*out*/ VolumeTorque);
+
+			const auto What = FString::Printf(
+			    TEXT("%s%s"), *Transform.Rotator().ToString(), bRefineWaterline ? TEXT(", refined") : TEXT(""));
+			const auto Weight = Volume->WaterDensity * 980.f * Volume->SubmergedVolume;
+			TestTrue(What + TEXT(": submerged hull"), Weight > 0.f);
+			const auto Tolerance = WatertightTolerance * Weight;
+			TestEqual(What + TEXT(": volume force"), VolumeForce, FVector{0.f, 0.f, Weight}, Tolerance);
+			TestEqual(What + TEXT(": pressure force"), PressureForce, VolumeForce, Tolerance);
+			TestEqual(What + TEXT(": sideways pressure force"), PressureForce.Size2D(), 0.f, Tolerance);
+		}
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,101 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "BuoyantMesh/BuoyantPrimitive.h"
+#include "BuoyantMesh/BuoyantMeshComponent.h"
+#include "BuoyantMesh/HydrostaticTable.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+
+static const EAutomationTestFlags::Type BuoyantPrimitiveTestFlags =
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter;
+
+// Segments around the axis of the tessellation the closed forms are compared to.
+static const int32 TessellationSegments = 64;
+// Relative to the volume and the size of the primitive. Covers the volume the tessellation misses.
+static const float TessellationTolerance = 1.e-2f;
+
+// Tilts of the water plane in degrees, from level to vertical, and depths of the center of the primitive below it,
+// relative to its size, from dry to submerged.
+static const float TestTilts[] = {0.f, 0.5f, 20.f, 45.f, 80.f, 90.f};
+static const float TestDepths[] = {-0.6f, -0.3f, -0.05f, 0.f, 0.2f, 0.45f, 0.6f};
+
+// Compares the closed form to the clipped tessellation for water planes of every test tilt and depth.
+static void TestAgainstTessellation(FAutomationTestBase& Test, const FBuoyantPrimitive& Primitive)
+{
+	const auto Hull = TArray<FTriangleMesh>{Primitive.Tessellate(TessellationSegments)};
+	const auto Center = Primitive.Transform.GetLocation();
+	const auto Size = Primitive.GetBounds().GetSize().GetMax();
+	const auto VolumeTolerance = TessellationTolerance * Primitive.GetVolume();
+	const auto CenterTolerance = TessellationTolerance * Size;
+
+	for (const auto Tilt : TestTilts)
+	{
+		// Tilted about an axis that isn't one of the primitive's, so no face stays aligned with the plane.
+		const auto Normal = FRotator{Tilt, 30.f, 0.f}.RotateVector(FVector::UpVector).GetSafeNormal();
+		for (const auto Depth : TestDepths)
+		{
+			const auto PlanePoint = Center + Normal * (Depth * Size);
+			const auto Sample = Primitive.GetSubmergedHydrostatics(FPlane{PlanePoint, Normal});
+			const auto Clipped = UHydrostaticTable::SampleHull(Hull, PlanePoint, Normal);
+
+			const auto What = FString::Printf(TEXT("Tilt %.1f, depth %.2f"), Tilt, Depth);
+			Test.TestEqual(*(What + TEXT(" volume")), Sample.Volume, Clipped.Volume, VolumeTolerance);
+			// The center of buoyancy is meaningless for a sliver of volume.
+			if (FMath::Min(Sample.Volume, Clipped.Volume) > VolumeTolerance)
+			{
+				Test.TestEqual(*(What + TEXT(" center of buoyancy")),
+				               Sample.VolumeMoment / Sample.Volume,
+				               Clipped.VolumeMoment / Clipped.Volume,
+				               CenterTolerance);
+			}
+		}
+	}
+}
+
+static FTransform GetTestTransform()
+{
+	return FTransform{FRotator{10.f, 25.f, -15.f}, FVector{300.f, -200.f, 50.f}};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuoyantPrimitiveSphereTest, "Buoyancy.Primitives.Sphere", BuoyantPrimitiveTestFlags)
+
+bool FBuoyantPrimitiveSphereTest::RunTest(const FString& Parameters)
+{
+	FBuoyantPrimitive Sphere;
+	Sphere.Shape = EBuoyantPrimitiveShape::Sphere;
+	Sphere.Transform = GetTestTransform();
+	Sphere.Radius = 100.f;
+	TestAgainstTessellation(*this, Sphere);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuoyantPrimitiveBoxTest, "Buoyancy.Primitives.Box", BuoyantPrimitiveTestFlags)
+
+bool FBuoyantPrimitiveBoxTest::RunTest(const FString& Parameters)
+{
+	FBuoyantPrimitive Box;
+	Box.Shape = EBuoyantPrimitiveShape::Box;
+	Box.Transform = GetTestTransform();
+	Box.HalfExtent = FVector{150.f, 60.f, 40.f};
+	TestAgainstTessellation(*this, Box);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuoyantPrimitiveCapsuleTest, "Buoyancy.Primitives.Capsule", BuoyantPrimitiveTestFlags)
+
+bool FBuoyantPrimitiveCapsuleTest::RunTest(const FString& Parameters)
+{
+	FBuoyantPrimitive Capsule;
+	Capsule.Shape = EBuoyantPrimitiveShape::Capsule;
+	Capsule.Transform = GetTestTransform();
+	Capsule.Radius = 50.f;
+	Capsule.HalfExtent = FVector{0.f, 0.f, 100.f};
+	TestAgainstTessellation(*this, Capsule);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
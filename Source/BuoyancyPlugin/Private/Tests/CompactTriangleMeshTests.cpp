@@ -0,0 +1,57 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "BuoyantMesh/CompactTriangleMesh.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+
+static const EAutomationTestFlags::Type CompactTriangleMeshTestFlags =
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter;
+
+// A 16 bit octahedral encoding is accurate to a few 1e-5 radians.
+static const float NormalTolerance = 1e-3f;
+
+// Encodes a single triangle with the given unit normal and checks the normal it decodes to.
+static void TestTriangleNormal(FAutomationTestBase& Test, const TCHAR* What, const FVector& Normal)
+{
+	FVector TangentX, TangentY;
+	Normal.FindBestAxisVectors(TangentX, TangentY);
+	// Wound so the cross product of the edges points along the normal.
+	const auto B = TangentX * 100.f;
+	const auto C = TangentY * 100.f;
+	const auto Winding = (FVector::CrossProduct(B, C) | Normal) > 0.f;
+	const TArray<FVector> Vertices{FVector::ZeroVector, Winding ? B : C, Winding ? C : B};
+	const FCompactTriangleMesh Mesh{Vertices, TArray<int32>{0, 1, 2}};
+
+	Test.TestEqual(What, Mesh.GetTriangleNormal(0), Normal, NormalTolerance);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCompactTriangleMeshNormalsTest,
+                                 "Buoyancy.CompactHull.Normals",
+                                 CompactTriangleMeshTestFlags)
+
+bool FCompactTriangleMeshNormalsTest::RunTest(const FString& Parameters)
+{
+	TestTriangleNormal(*this, TEXT("Up"), FVector::UpVector);
+	TestTriangleNormal(*this, TEXT("Down"), -FVector::UpVector);
+	TestTriangleNormal(*this, TEXT("Forward"), FVector::ForwardVector);
+	TestTriangleNormal(*this, TEXT("Diagonal"), FVector{1.f, -2.f, -3.f}.GetSafeNormal());
+
+	// Folds to the (-1, -1) corner of the octahedral square, whose encoding is the zero of degenerate triangles.
+	const TArray<FVector> Vertices{FVector::ZeroVector, FVector{0.f, 100.f, -1e-4f}, FVector{100.f, 0.f, -1e-4f}};
+	const FCompactTriangleMesh Mesh{Vertices, TArray<int32>{0, 1, 2}};
+	const auto Normal = FVector::CrossProduct(Vertices[1], Vertices[2]).GetSafeNormal();
+	TestTrue(TEXT("Normal close to -Z, with small negative X and Y"), Normal.X < 0.f && Normal.Y < 0.f);
+	TestEqual(TEXT("Normal close to -Z"), Mesh.GetTriangleNormal(0), Normal, NormalTolerance);
+
+	// Degenerate triangles have no normal.
+	const TArray<FVector> AlignedVertices{FVector::ZeroVector, FVector{1.f, 0.f, 0.f}, FVector{2.f, 0.f, 0.f}};
+	const FCompactTriangleMesh DegenerateMesh{AlignedVertices, TArray<int32>{0, 1, 2}};
+	TestEqual(TEXT("Degenerate triangle"), DegenerateMesh.GetTriangleNormal(0), FVector::ZeroVector);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
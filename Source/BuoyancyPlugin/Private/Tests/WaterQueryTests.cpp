@@ -0,0 +1,100 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "WaterQuery/WaterQueryContext.h"
+#include "WaterSurface/AnalyticWaterSurfaceProviders.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+
+static const EAutomationTestFlags::Type WaterQueryTestFlags =
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter;
+
+static UGerstnerWaterSurfaceProvider* MakeTestWaterSurface()
+{
+	const auto Provider = NewObject<UGerstnerWaterSurfaceProvider>();
+	FAnalyticGerstnerWave Wave;
+	Wave.Wavelength = 1500.f;
+	Wave.Amplitude = 80.f;
+	Wave.Direction = FVector2D{1.f, 0.4f};
+	Provider->Waves.Add(Wave);
+	Wave.Wavelength = 600.f;
+	Wave.Amplitude = 20.f;
+	Wave.Direction = FVector2D{-0.2f, 1.f};
+	Provider->Waves.Add(Wave);
+	return Provider;
+}
+
+static FWaterQueryBatchRef MakeTestBatch()
+{
+	const auto Batch = MakeShared<FWaterQueryBatch, ESPMode::ThreadSafe>();
+	for (int32 i = 0; i < 1000; ++i)
+	{
+		Batch->Points.Emplace(i * 37.f - 15000.f, (i % 97) * 53.f, 0.f);
+	}
+	for (int32 i = 0; i < 200; ++i)
+	{
+		const FVector Start{i * 71.f, i * -29.f, 300.f - i};
+		Batch->SegmentStarts.Add(Start);
+		Batch->SegmentEnds.Add(Start + FVector{150.f, 40.f, -500.f});
+	}
+	return Batch;
+}
+
+// Runs the tasks of a batch and waits for them.
+static void RunBatch(const FWaterQueryContextRef& Context, const FWaterQueryBatchRef& Batch, int32 QueriesPerTask)
+{
+	FGraphEventArray Tasks;
+	FWaterQueryContext::DispatchTasks(Context, Batch, QueriesPerTask, /*out*/ Tasks);
+	FTaskGraphInterface::Get().WaitUntilTasksComplete(Tasks, ENamedThreads::GameThread);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWaterQueryResultOrderTest, "Buoyancy.WaterQuery.ResultOrder", WaterQueryTestFlags)
+
+bool FWaterQueryResultOrderTest::RunTest(const FString& Parameters)
+{
+	const auto Provider = MakeTestWaterSurface();
+	const auto Context = MakeShared<FWaterQueryContext, ESPMode::ThreadSafe>();
+	Context->WaterSurfaceSnapshot = Provider->MakeSnapshot();
+	Context->WaterTime = 2.f;
+	Context->SegmentSteps = 8;
+	Context->SegmentRefinementSteps = 4;
+	if (!TestTrue(TEXT("Gerstner snapshot"), Context->WaterSurfaceSnapshot.IsValid())) return false;
+
+	// Changing the provider after the dispatch must not change the results.
+	const auto Batch = MakeTestBatch();
+	FGraphEventArray Tasks;
+	FWaterQueryContext::DispatchTasks(Context, Batch, 7, /*out*/ Tasks);
+	Provider->Waves.Reset();
+	Provider->BaseHeight = 1000.f;
+	FTaskGraphInterface::Get().WaitUntilTasksComplete(Tasks, ENamedThreads::GameThread);
+
+	// Many small tasks, a few large ones and a single one all give the results in query order.
+	const auto ManyTasksBatch = MakeTestBatch();
+	RunBatch(Context, ManyTasksBatch, 3);
+	const auto SingleTaskBatch = MakeTestBatch();
+	RunBatch(Context, SingleTaskBatch, 100000);
+
+	const auto Original = MakeTestWaterSurface();
+	for (int32 i = 0; i < Batch->Points.Num(); ++i)
+	{
+		const auto Expected = Original->GetWaterHeight(Batch->Points[i], Context->WaterTime);
+		TestEqual(TEXT("Point height"), Batch->PointHeights[i], Expected, 1e-3f);
+		TestTrue(TEXT("Same point height for any task size"),
+		         Batch->PointHeights[i] == ManyTasksBatch->PointHeights[i] &&
+		             Batch->PointHeights[i] == SingleTaskBatch->PointHeights[i]);
+	}
+	for (int32 i = 0; i < Batch->SegmentStarts.Num(); ++i)
+	{
+		const auto Expected = Context->TraceSegment(Batch->SegmentStarts[i], Batch->SegmentEnds[i]);
+		const auto& Hit = Batch->SegmentHits[i];
+		TestTrue(TEXT("Segment hit"), Hit.bHit == Expected.bHit && Hit.Time == Expected.Time);
+		TestTrue(TEXT("Same segment hit for any task size"),
+		         Hit.Time == ManyTasksBatch->SegmentHits[i].Time && Hit.Time == SingleTaskBatch->SegmentHits[i].Time);
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
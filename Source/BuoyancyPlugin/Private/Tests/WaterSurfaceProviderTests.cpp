@@ -0,0 +1,243 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "WaterSurface/AnalyticWaterSurfaceProviders.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+
+static const EAutomationTestFlags::Type WaterSurfaceTestFlags =
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter;
+
+// A few positions spread over more than a wavelength, with various heights the queries must ignore.
+static TArray<FVector> GetTestPositions()
+{
+	TArray<FVector> Positions;
+	for (int32 i = 0; i < 16; ++i)
+	{
+		Positions.Emplace(i * 337.f - 2500.f, i * i * 41.f - 900.f, i * 25.f - 200.f);
+	}
+	return Positions;
+}
+
+// Checks that the batched queries give the same results as the single ones.
+static void TestBatchedQueries(FAutomationTestBase& Test, const IWaterSurfaceProvider& Provider, float Time)
+{
+	const auto Positions = GetTestPositions();
+	TArray<float> Heights;
+	TArray<FVector> Displacements;
+	TArray<FVector> Velocities;
+	Heights.SetNumZeroed(Positions.Num());
+	Displacements.SetNumZeroed(Positions.Num());
+	Velocities.SetNumZeroed(Positions.Num());
+	Provider.GetWaterHeights(Positions, Time, Heights);
+	Provider.GetWaterDisplacements(Positions, Time, Displacements);
+	Provider.GetWaterVelocities(Positions, Time, Velocities);
+
+	for (int32 i = 0; i < Positions.Num(); ++i)
+	{
+		Test.TestEqual(TEXT("Batched height"), Heights[i], Provider.GetWaterHeight(Positions[i], Time), 1e-3f);
+		Test.TestEqual(
+		    TEXT("Batched displacement"), Displacements[i], Provider.GetWaterDisplacement(Positions[i], Time), 1e-3f);
+		Test.TestEqual(TEXT("Batched velocity"), Velocities[i], Provider.GetWaterVelocity(Positions[i], Time), 1e-3f);
+	}
+}
+
+// Checks the velocity against the change of the displacement over a short time.
+static void TestVelocity(FAutomationTestBase& Test, const IWaterSurfaceProvider& Provider, float Time, float Tolerance)
+{
+	const auto TimeStep = 1e-3f;
+	for (const auto& Position : GetTestPositions())
+	{
+		const auto Before = Provider.GetWaterDisplacement(Position, Time - TimeStep);
+		const auto After = Provider.GetWaterDisplacement(Position, Time + TimeStep);
+		Test.TestEqual(
+		    TEXT("Velocity"), Provider.GetWaterVelocity(Position, Time), (After - Before) / (2.f * TimeStep), Tolerance);
+	}
+}
+
+// Checks that the heights stay within the bounds of the provider over a few times.
+static void TestHeightBounds(FAutomationTestBase& Test, const IWaterSurfaceProvider& Provider)
+{
+	FFloatInterval Bounds;
+	if (!Test.TestTrue(TEXT("Height bounds"), Provider.GetWaterHeightBounds(Bounds))) return;
+
+	for (int32 Step = 0; Step < 8; ++Step)
+	{
+		const auto Time = Step * 0.7f;
+		for (const auto& Position : GetTestPositions())
+		{
+			const auto Height = Provider.GetWaterHeight(Position, Time);
+			Test.TestTrue(TEXT("Height within the bounds"), Height >= Bounds.Min - 1e-3f && Height <= Bounds.Max + 1e-3f);
+		}
+	}
+}
+
+// Checks that the heights change no faster than the rate bounds of the provider, between nearby queries.
+static void TestHeightRateBounds(FAutomationTestBase& Test, const IWaterSurfaceProvider& Provider, float Time)
+{
+	float MaxSlope, MaxSpeed;
+	if (!Test.TestTrue(TEXT("Height rate bounds"), Provider.GetWaterHeightRateBounds(MaxSlope, MaxSpeed))) return;
+
+	const FVector Offsets[] = {FVector{35.f, 0.f, 0.f}, FVector{-12.f, 27.f, 0.f}, FVector{0.f, 0.f, 0.f}};
+	const float TimeSteps[] = {0.f, 1.f / 60.f, 0.25f};
+	for (const auto& Position : GetTestPositions())
+	{
+		const auto Height = Provider.GetWaterHeight(Position, Time);
+		for (const auto& Offset : Offsets)
+		{
+			for (const auto TimeStep : TimeSteps)
+			{
+				const auto Change = FMath::Abs(Provider.GetWaterHeight(Position + Offset, Time + TimeStep) - Height);
+				const auto Bound = MaxSlope * Offset.Size2D() + MaxSpeed * TimeStep;
+				Test.TestTrue(TEXT("Height change within the rate bounds"), Change <= Bound + 1e-3f);
+			}
+		}
+	}
+}
+
+// Checks the number of waves the provider reports and, for a single wave, that the surface repeats over its
+// wavelength and its period.
+static void TestWaves(FAutomationTestBase& Test, const IWaterSurfaceProvider& Provider, int32 WaveCount, float Time)
+{
+	TArray<FWaterSurfaceWave> Waves;
+	if (!Test.TestTrue(TEXT("Waves"), Provider.GetWaves(Waves))) return;
+	if (!Test.TestEqual(TEXT("Wave count"), Waves.Num(), WaveCount) || WaveCount != 1) return;
+
+	const auto& Wave = Waves[0];
+	const auto WaveNumber = Wave.WaveVector.Size();
+	const auto WavelengthStep = FVector{Wave.WaveVector / WaveNumber * 2.f * PI / WaveNumber, 0.f};
+	const auto PeriodStep = 2.f * PI / Wave.AngularFrequency;
+	for (const auto& Position : GetTestPositions())
+	{
+		const auto Height = Provider.GetWaterHeight(Position, Time);
+		Test.TestEqual(
+		    TEXT("Height a wavelength away"), Provider.GetWaterHeight(Position + WavelengthStep, Time), Height, 1e-1f);
+		Test.TestEqual(
+		    TEXT("Height a period later"), Provider.GetWaterHeight(Position, Time + PeriodStep), Height, 1e-1f);
+	}
+}
+
+// Checks that the snapshot of the provider gives its heights.
+static void TestSnapshot(FAutomationTestBase& Test, const IWaterSurfaceProvider& Provider, float Time)
+{
+	const auto Snapshot = Provider.MakeSnapshot();
+	if (!Test.TestTrue(TEXT("Snapshot"), Snapshot.IsValid())) return;
+
+	const auto Positions = GetTestPositions();
+	TArray<float> Heights;
+	Heights.SetNumZeroed(Positions.Num());
+	Snapshot->GetWaterHeights(Positions, Time, Heights);
+	for (int32 i = 0; i < Positions.Num(); ++i)
+	{
+		const auto Height = Provider.GetWaterHeight(Positions[i], Time);
+		Test.TestEqual(TEXT("Snapshot height"), Snapshot->GetWaterHeight(Positions[i], Time), Height, 1e-3f);
+		Test.TestEqual(TEXT("Batched snapshot height"), Heights[i], Height, 1e-3f);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFlatWaterSurfaceProviderTest, "Buoyancy.WaterSurface.Flat", WaterSurfaceTestFlags)
+
+bool FFlatWaterSurfaceProviderTest::RunTest(const FString& Parameters)
+{
+	const auto Provider = NewObject<UFlatWaterSurfaceProvider>();
+	Provider->Height = 125.f;
+
+	for (const auto& Position : GetTestPositions())
+	{
+		TestEqual(TEXT("Height"), Provider->GetWaterHeight(Position, 3.f), 125.f);
+		TestEqual(TEXT("Displacement"), Provider->GetWaterDisplacement(Position, 3.f), FVector{0.f, 0.f, 125.f});
+		TestEqual(TEXT("Velocity"), Provider->GetWaterVelocity(Position, 3.f), FVector::ZeroVector);
+	}
+	TestBatchedQueries(*this, *Provider, 3.f);
+	TestHeightBounds(*this, *Provider);
+	TestHeightRateBounds(*this, *Provider, 3.f);
+	TestSnapshot(*this, *Provider, 3.f);
+	TestWaves(*this, *Provider, 0, 3.f);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSineWaterSurfaceProviderTest, "Buoyancy.WaterSurface.Sine", WaterSurfaceTestFlags)
+
+bool FSineWaterSurfaceProviderTest::RunTest(const FString& Parameters)
+{
+	const auto Provider = NewObject<USineWaterSurfaceProvider>();
+	Provider->BaseHeight = 10.f;
+	Provider->Amplitude = 40.f;
+	Provider->Wavelength = 1000.f;
+	Provider->Direction = FVector2D{0.f, 3.f};
+
+	// At rest, crests are a quarter wavelength from the origin along the direction and the surface is constant
+	// across it.
+	TestEqual(TEXT("Crest"), Provider->GetWaterHeight(FVector{0.f, 250.f, 0.f}, 0.f), 50.f, 1e-2f);
+	TestEqual(TEXT("Trough"), Provider->GetWaterHeight(FVector{0.f, 750.f, 0.f}, 0.f), -30.f, 1e-2f);
+	TestEqual(TEXT("Across the direction"), Provider->GetWaterHeight(FVector{800.f, 250.f, 0.f}, 0.f), 50.f, 1e-2f);
+
+	const auto Direction = Provider->GetWaveDirection();
+	TestTrue(TEXT("Normalized direction"), Direction.Equals(FVector2D{0.f, 1.f}, 1e-4f));
+
+	TestBatchedQueries(*this, *Provider, 2.5f);
+	TestVelocity(*this, *Provider, 2.5f, 0.5f);
+	TestHeightBounds(*this, *Provider);
+	TestHeightRateBounds(*this, *Provider, 2.5f);
+	TestSnapshot(*this, *Provider, 2.5f);
+	TestWaves(*this, *Provider, 1, 2.5f);
+
+	Provider->Direction = FVector2D::ZeroVector;
+	TestTrue(TEXT("Direction fallback"), Provider->GetWaveDirection().Equals(FVector2D{1.f, 0.f}));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGerstnerWaterSurfaceProviderTest, "Buoyancy.WaterSurface.Gerstner", WaterSurfaceTestFlags)
+
+bool FGerstnerWaterSurfaceProviderTest::RunTest(const FString& Parameters)
+{
+	const auto Provider = NewObject<UGerstnerWaterSurfaceProvider>();
+	Provider->BaseHeight = -20.f;
+	FAnalyticGerstnerWave Wave;
+	Wave.Wavelength = 3000.f;
+	Wave.Amplitude = 60.f;
+	Wave.Steepness = 0.3f;
+	Wave.Direction = FVector2D{1.f, 1.f};
+	Provider->Waves.Add(Wave);
+	Wave.Wavelength = 1100.f;
+	Wave.Amplitude = 15.f;
+	Wave.Direction = FVector2D{-0.3f, 1.f};
+	Provider->Waves.Add(Wave);
+
+	TestBatchedQueries(*this, *Provider, 4.f);
+	TestVelocity(*this, *Provider, 4.f, 0.5f);
+	TestHeightBounds(*this, *Provider);
+	TestHeightRateBounds(*this, *Provider, 4.f);
+	TestSnapshot(*this, *Provider, 4.f);
+	TestWaves(*this, *Provider, 2, 4.f);
+
+	// The height under the displaced position of a rest point is the height of that point.
+	for (const auto& RestPosition : GetTestPositions())
+	{
+		const auto Displacement = Provider->GetWaterDisplacement(RestPosition, 4.f);
+		const FVector DisplacedPosition{RestPosition.X + Displacement.X, RestPosition.Y + Displacement.Y, 0.f};
+		TestEqual(TEXT("Height of the displaced point"),
+		          Provider->GetWaterHeight(DisplacedPosition, 4.f),
+		          Displacement.Z,
+		          1.f);
+	}
+
+	// A wave without a direction travels along X, in the queries and in the wave direction.
+	Provider->Waves.SetNum(1);
+	Provider->Waves[0].Direction = FVector2D::ZeroVector;
+	const auto Direction = Provider->GetWaveDirection();
+	TestFalse(TEXT("Direction is a number"), Direction.ContainsNaN());
+	TestTrue(TEXT("Direction fallback"), Direction.Equals(FVector2D{1.f, 0.f}));
+
+	const auto ZeroDirectionHeight = Provider->GetWaterHeight(FVector{700.f, 300.f, 0.f}, 1.f);
+	Provider->Waves[0].Direction = FVector2D{1.f, 0.f};
+	TestEqual(TEXT("Zero direction queries"),
+	          ZeroDirectionHeight,
+	          Provider->GetWaterHeight(FVector{700.f, 300.f, 0.f}, 1.f));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
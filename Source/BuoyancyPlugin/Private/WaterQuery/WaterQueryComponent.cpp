@@ -0,0 +1,236 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "WaterQuery/WaterQueryComponent.h"
+#include "WaterQuery/WaterQueryContext.h"
+#include "WaterQuery/WaterQuerySubsystem.h"
+#include "BuoyantMesh/WaterHeightmapComponent.h"
+#include "WaterSurface/WaterSurfaceProvider.h"
+#include "OceanPlugin/Public/OceanManager.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "BuoyancyStats.h"
+
+
+DECLARE_CYCLE_STAT(TEXT("Water Query Dispatch"), STAT_WaterQueryDispatch, STATGROUP_Buoyancy);
+DECLARE_CYCLE_STAT(TEXT("Water Query Wait"), STAT_WaterQueryWait, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Water Query Points"), STAT_WaterQueryPoints, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Water Query Segments"), STAT_WaterQuerySegments, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Water Query Game Thread Batches"), STAT_WaterQueryGameThreadBatches, STATGROUP_Buoyancy);
+
+void FWaterQueryCompletionTickFunction::ExecuteTick(float DeltaTime,
+                                                    ELevelTick TickType,
+                                                    ENamedThreads::Type CurrentThread,
+                                                    const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && !Target->IsPendingKill())
+	{
+		Target->CompleteInFlightBatches();
+	}
+}
+
+FString FWaterQueryCompletionTickFunction::DiagnosticMessage()
+{
+	return (Target ? Target->GetFullName() : TEXT("<NULL>")) + TEXT("[CompleteWaterQueries]");
+}
+
+UWaterQueryComponent::UWaterQueryComponent()
+{
+	// Dispatch after the buoyant components have filled the water heightmaps.
+	PrimaryComponentTick.TickGroup = TG_DuringPhysics;
+	PrimaryComponentTick.bCanEverTick = true;
+	UActorComponent::SetComponentTickEnabled(true);
+
+	CompletionTickFunction.TickGroup = TG_LastDemotable;
+	CompletionTickFunction.bCanEverTick = true;
+	CompletionTickFunction.bStartWithTickEnabled = true;
+}
+
+UWaterQueryComponent* UWaterQueryComponent::FindWaterQueryComponent(const UWorld* World)
+{
+	const auto Subsystem = World ? World->GetSubsystem<UWaterQuerySubsystem>() : nullptr;
+	return Subsystem ? Subsystem->GetWaterQueryComponent() : nullptr;
+}
+
+void UWaterQueryComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetBuoyancyAllocatedSize());
+}
+
+SIZE_T UWaterQueryComponent::GetBuoyancyAllocatedSize() const
+{
+	auto Size = QueuedBatches.GetAllocatedSize() + InFlightBatches.GetAllocatedSize() + InFlightTasks.GetAllocatedSize();
+	for (const auto* PendingBatches : {&QueuedBatches, &InFlightBatches})
+	{
+		for (const auto& PendingBatch : *PendingBatches)
+		{
+			Size += sizeof(FWaterQueryBatch) + PendingBatch.Batch->GetAllocatedSize();
+		}
+	}
+	return Size;
+}
+
+AOceanManager* UWaterQueryComponent::FindOceanManager() const
+{
+	for (auto Actor : TActorRange<AOceanManager>(GetWorld()))
+	{
+		return Actor;
+	}
+	return nullptr;
+}
+
+void UWaterQueryComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	if (const auto Subsystem = GetWorld()->GetSubsystem<UWaterQuerySubsystem>())
+	{
+		Subsystem->RegisterWaterQueryComponent(this);
+	}
+}
+
+void UWaterQueryComponent::OnUnregister()
+{
+	if (const auto Subsystem = GetWorld()->GetSubsystem<UWaterQuerySubsystem>())
+	{
+		Subsystem->UnregisterWaterQueryComponent(this);
+	}
+
+	Super::OnUnregister();
+}
+
+void UWaterQueryComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (!OceanManager)
+	{
+		OceanManager = FindOceanManager();
+	}
+}
+
+void UWaterQueryComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// The tasks reference the world, they can't outlive it.
+	CompleteInFlightBatches();
+	QueuedBatches.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UWaterQueryComponent::RegisterComponentTickFunctions(bool bRegister)
+{
+	Super::RegisterComponentTickFunctions(bRegister);
+
+	if (bRegister)
+	{
+		if (SetupActorComponentTickFunction(&CompletionTickFunction))
+		{
+			CompletionTickFunction.Target = this;
+			CompletionTickFunction.AddPrerequisite(this, PrimaryComponentTick);
+		}
+	}
+	else if (CompletionTickFunction.IsTickFunctionRegistered())
+	{
+		CompletionTickFunction.UnRegisterTickFunction();
+	}
+}
+
+void UWaterQueryComponent::TickComponent(float DeltaTime,
+                                         ELevelTick TickType,
+                                         FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	DispatchQueuedBatches();
+}
+
+void UWaterQueryComponent::Submit(const FWaterQueryBatchRef& Batch, FOnWaterQueryBatchReady OnReady)
+{
+	check(IsInGameThread());
+
+	if (Batch->SegmentStarts.Num() != Batch->SegmentEnds.Num())
+	{
+		UE_LOG(LogTemp,
+		       Error,
+		       TEXT("WaterQueryComponent: a batch has %d segment starts but %d segment ends, the extra ones are ignored."),
+		       Batch->SegmentStarts.Num(),
+		       Batch->SegmentEnds.Num());
+	}
+
+	Batch->bIsReady = false;
+	QueuedBatches.Emplace(Batch, OnReady);
+}
+
+void UWaterQueryComponent::DispatchQueuedBatches()
+{
+	SCOPE_CYCLE_COUNTER(STAT_WaterQueryDispatch);
+
+	if (QueuedBatches.Num() == 0) return;
+
+	const auto Context = MakeShared<FWaterQueryContext, ESPMode::ThreadSafe>();
+	const auto WaterSurface = FWaterSurfaceProviders::Resolve(WaterSurfaceProvider, this, OceanManager);
+	Context->WaterSurfaceSnapshot = WaterSurface ? WaterSurface->MakeSnapshot() : nullptr;
+	Context->GameThreadWaterSurface = Context->WaterSurfaceSnapshot ? nullptr : WaterSurface;
+	if (Context->GameThreadWaterSurface)
+	{
+		INC_DWORD_STAT_BY(STAT_WaterQueryGameThreadBatches, QueuedBatches.Num());
+		if (!bHasWarnedGameThreadQueries)
+		{
+			bHasWarnedGameThreadQueries = true;
+			UE_LOG(LogTemp,
+			       Warning,
+			       TEXT("%s: the water surface provider can't be copied for the worker threads, so the water queries ")
+			           TEXT("run on the game thread. Use a provider that can, like a Gerstner water surface."),
+			       *GetPathName());
+		}
+	}
+	Context->WaterTime = GetWorld()->GetTimeSeconds();
+	Context->SegmentSteps = FMath::Max(1, SegmentSteps);
+	Context->SegmentRefinementSteps = FMath::Max(0, SegmentRefinementSteps);
+	if (const auto Subsystem = GetWorld()->GetSubsystem<UWaterQuerySubsystem>())
+	{
+		for (const auto& Heightmap : Subsystem->GetWaterHeightmaps())
+		{
+			if (!Heightmap.IsValid()) continue;
+
+			auto Snapshot = Heightmap->GetSnapshot();
+			if (Snapshot.CellCountX > 0)
+			{
+				Context->Heightmaps.Add(MoveTemp(Snapshot));
+			}
+		}
+	}
+
+	for (const auto& Pending : QueuedBatches)
+	{
+		const auto& Batch = Pending.Batch;
+		INC_DWORD_STAT_BY(STAT_WaterQueryPoints, Batch->Points.Num());
+		INC_DWORD_STAT_BY(STAT_WaterQuerySegments, FMath::Min(Batch->SegmentStarts.Num(), Batch->SegmentEnds.Num()));
+
+		FWaterQueryContext::DispatchTasks(Context, Batch, QueriesPerTask, /*out*/ InFlightTasks);
+		InFlightBatches.Add(Pending);
+	}
+	QueuedBatches.Reset();
+}
+
+void UWaterQueryComponent::CompleteInFlightBatches()
+{
+	SCOPE_CYCLE_COUNTER(STAT_WaterQueryWait);
+
+	if (InFlightTasks.Num() > 0)
+	{
+		FTaskGraphInterface::Get().WaitUntilTasksComplete(InFlightTasks, ENamedThreads::GameThread);
+		InFlightTasks.Reset();
+	}
+
+	// The callbacks can submit new batches, they go to QueuedBatches.
+	auto CompletedBatches = MoveTemp(InFlightBatches);
+	InFlightBatches.Reset();
+	for (const auto& Completed : CompletedBatches)
+	{
+		Completed.Batch->bIsReady = true;
+		Completed.OnReady.ExecuteIfBound(*Completed.Batch);
+	}
+}
@@ -0,0 +1,148 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "WaterQuery/WaterQueryContext.h"
+
+
+float FWaterQueryContext::GetWaterHeight(const FVector& Position) const
+{
+	float Height;
+	if (GetHeightmapHeight(Position, /*out*/ Height)) return Height;
+	if (WaterSurfaceSnapshot) return WaterSurfaceSnapshot->GetWaterHeight(Position, WaterTime);
+	return GameThreadWaterSurface ? GameThreadWaterSurface->GetWaterHeight(Position, WaterTime) : 0.f;
+}
+
+void FWaterQueryContext::GetWaterHeights(TArrayView<const FVector> Positions, TArrayView<float> OutHeights) const
+{
+	TArray<int32, TInlineAllocator<64>> MissedIndices;
+	TArray<FVector, TInlineAllocator<64>> MissedPositions;
+	for (int32 i = 0; i < Positions.Num(); ++i)
+	{
+		if (!GetHeightmapHeight(Positions[i], /*out*/ OutHeights[i]))
+		{
+			MissedIndices.Add(i);
+			MissedPositions.Add(Positions[i]);
+		}
+	}
+
+	if (MissedIndices.Num() == 0) return;
+
+	TArray<float, TInlineAllocator<64>> MissedHeights;
+	MissedHeights.SetNumZeroed(MissedIndices.Num());
+	if (WaterSurfaceSnapshot)
+	{
+		WaterSurfaceSnapshot->GetWaterHeights(MissedPositions, WaterTime, MissedHeights);
+	}
+	else if (GameThreadWaterSurface)
+	{
+		GameThreadWaterSurface->GetWaterHeights(MissedPositions, WaterTime, MissedHeights);
+	}
+	for (int32 i = 0; i < MissedIndices.Num(); ++i)
+	{
+		OutHeights[MissedIndices[i]] = MissedHeights[i];
+	}
+}
+
+bool FWaterQueryContext::GetHeightmapHeight(const FVector& Position, float& OutHeight) const
+{
+	for (const auto& Heightmap : Heightmaps)
+	{
+		if (Heightmap.GetHeightAtPosition(Position, /*out*/ OutHeight)) return true;
+	}
+	return false;
+}
+
+float FWaterQueryContext::GetHeightAboveWater(const FVector& Position) const
+{
+	return Position.Z - GetWaterHeight(Position);
+}
+
+FWaterSegmentHit FWaterQueryContext::TraceSegment(const FVector& Start, const FVector& End) const
+{
+	FWaterSegmentHit Hit;
+	if (GetHeightAboveWater(Start) <= 0.f)
+	{
+		Hit.bHit = true;
+		Hit.Time = 0.f;
+		Hit.Location = Start;
+		return Hit;
+	}
+
+	auto AboveWaterTime = 0.f;
+	for (int32 Step = 1; Step <= SegmentSteps; ++Step)
+	{
+		auto UnderwaterTime = Step / static_cast<float>(SegmentSteps);
+		if (GetHeightAboveWater(FMath::Lerp(Start, End, UnderwaterTime)) > 0.f)
+		{
+			AboveWaterTime = UnderwaterTime;
+			continue;
+		}
+
+		// The surface is between the last two samples, bisect it.
+		for (int32 Iteration = 0; Iteration < SegmentRefinementSteps; ++Iteration)
+		{
+			const auto MiddleTime = (AboveWaterTime + UnderwaterTime) / 2.f;
+			if (GetHeightAboveWater(FMath::Lerp(Start, End, MiddleTime)) > 0.f)
+			{
+				AboveWaterTime = MiddleTime;
+			}
+			else
+			{
+				UnderwaterTime = MiddleTime;
+			}
+		}
+
+		Hit.bHit = true;
+		Hit.Time = UnderwaterTime;
+		Hit.Location = FMath::Lerp(Start, End, UnderwaterTime);
+		return Hit;
+	}
+
+	Hit.Location = End;
+	return Hit;
+}
+
+
+void FWaterQueryContext::DispatchTasks(const FWaterQueryContextRef& Context,
+                                       const FWaterQueryBatchRef& Batch,
+                                       int32 QueriesPerTask,
+                                       FGraphEventArray& OutTasks)
+{
+	const auto PointsPerTask = FMath::Max(1, QueriesPerTask);
+	const auto SegmentsPerTask = FMath::Max(1, PointsPerTask / (Context->SegmentSteps + Context->SegmentRefinementSteps + 1));
+	const auto TaskThread = Context->GameThreadWaterSurface ? ENamedThreads::GameThread : ENamedThreads::AnyThread;
+
+	const auto PointCount = Batch->Points.Num();
+	const auto SegmentCount = FMath::Min(Batch->SegmentStarts.Num(), Batch->SegmentEnds.Num());
+	Batch->PointHeights.SetNumUninitialized(PointCount);
+	Batch->SegmentHits.Reset();
+	Batch->SegmentHits.SetNum(SegmentCount);
+
+	for (int32 First = 0; First < PointCount; First += PointsPerTask)
+	{
+		const auto Last = FMath::Min(First + PointsPerTask, PointCount);
+		OutTasks.Add(FFunctionGraphTask::CreateAndDispatchWhenReady(
+		    [Context, Batch, First, Last]() {
+			    Context->GetWaterHeights(MakeArrayView(Batch->Points).Slice(First, Last - First),
+			                             MakeArrayView(Batch->PointHeights).Slice(First, Last - First));
+		    },
+		    TStatId(),
+		    nullptr,
+		    TaskThread));
+	}
+
+	for (int32 First = 0; First < SegmentCount; First += SegmentsPerTask)
+	{
+		const auto Last = FMath::Min(First + SegmentsPerTask, SegmentCount);
+		OutTasks.Add(FFunctionGraphTask::CreateAndDispatchWhenReady(
+		    [Context, Batch, First, Last]() {
+			    for (int32 i = First; i < Last; ++i)
+			    {
+				    Batch->SegmentHits[i] = Context->TraceSegment(Batch->SegmentStarts[i], Batch->SegmentEnds[i]);
+			    }
+		    },
+		    TStatId(),
+		    nullptr,
+		    TaskThread));
+	}
+}
@@ -0,0 +1,43 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "BuoyantMesh/WaterHeightmapComponent.h"
+#include "WaterQuery/WaterQueryComponent.h"
+#include "WaterSurface/WaterSurfaceProvider.h"
+
+
+struct FWaterQueryContext;
+
+using FWaterQueryContextRef = TSharedRef<const FWaterQueryContext, ESPMode::ThreadSafe>;
+
+// Everything the tasks of one dispatch of UWaterQueryComponent read. Shared by the tasks and never modified after the
+// dispatch, so the tasks don't touch anything the game thread changes.
+struct FWaterQueryContext
+{
+	// Copy of the water surface provider made at the dispatch.
+	FWaterSurfaceSnapshotPtr WaterSurfaceSnapshot;
+	// The provider itself when it can't be copied. The tasks then run on the game thread.
+	const IWaterSurfaceProvider* GameThreadWaterSurface = nullptr;
+	float WaterTime = 0.f;
+	TArray<FWaterHeightmapSnapshot> Heightmaps;
+	int32 SegmentSteps = 1;
+	int32 SegmentRefinementSteps = 0;
+
+	float GetWaterHeight(const FVector& Position) const;
+	// Answers from the heightmaps where possible and sends the remaining positions to the water surface in one batch.
+	void GetWaterHeights(TArrayView<const FVector> Positions, TArrayView<float> OutHeights) const;
+	bool GetHeightmapHeight(const FVector& Position, float& OutHeight) const;
+	float GetHeightAboveWater(const FVector& Position) const;
+	FWaterSegmentHit TraceSegment(const FVector& Start, const FVector& End) const;
+
+	// Splits the queries of a batch into tasks, adds them to OutTasks and fills the results of the batch as they run.
+	// Each task writes its own range of results, so the results don't depend on the scheduling.
+	static void DispatchTasks(const FWaterQueryContextRef& Context,
+	                          const FWaterQueryBatchRef& Batch,
+	                          int32 QueriesPerTask,
+	                          FGraphEventArray& OutTasks);
+};
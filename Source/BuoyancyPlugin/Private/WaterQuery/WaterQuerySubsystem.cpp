@@ -0,0 +1,53 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "WaterQuery/WaterQuerySubsystem.h"
+#include "WaterQuery/WaterQueryComponent.h"
+#include "BuoyantMesh/WaterHeightmapComponent.h"
+
+
+void UWaterQuerySubsystem::Deinitialize()
+{
+	WaterQueryComponents.Reset();
+	WaterHeightmaps.Reset();
+
+	Super::Deinitialize();
+}
+
+void UWaterQuerySubsystem::RegisterWaterQueryComponent(UWaterQueryComponent* Component)
+{
+	check(IsInGameThread());
+	WaterQueryComponents.AddUnique(Component);
+}
+
+void UWaterQuerySubsystem::UnregisterWaterQueryComponent(UWaterQueryComponent* Component)
+{
+	check(IsInGameThread());
+	WaterQueryComponents.Remove(Component);
+}
+
+void UWaterQuerySubsystem::RegisterWaterHeightmap(UWaterHeightmapComponent* Heightmap)
+{
+	check(IsInGameThread());
+	WaterHeightmaps.AddUnique(Heightmap);
+}
+
+void UWaterQuerySubsystem::UnregisterWaterHeightmap(UWaterHeightmapComponent* Heightmap)
+{
+	check(IsInGameThread());
+	WaterHeightmaps.Remove(Heightmap);
+}
+
+UWaterQueryComponent* UWaterQuerySubsystem::GetWaterQueryComponent() const
+{
+	for (const auto& Component : WaterQueryComponents)
+	{
+		if (Component.IsValid()) return Component.Get();
+	}
+	return nullptr;
+}
+
+const TArray<TWeakObjectPtr<UWaterHeightmapComponent>>& UWaterQuerySubsystem::GetWaterHeightmaps() const
+{
+	return WaterHeightmaps;
+}
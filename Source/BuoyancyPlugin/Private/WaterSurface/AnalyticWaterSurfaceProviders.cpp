@@ -0,0 +1,418 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "WaterSurface/AnalyticWaterSurfaceProviders.h"
+
+
+// Used by the dispersion relation, in cm/s^2.
+static const float Gravity = 980.f;
+
+// Deep water dispersion relation.
+static float GetDeepWaterAngularFrequency(float Wavelength)
+{
+	const auto WaveNumber = 2.f * PI / FMath::Max(Wavelength, 1.f);
+	return FMath::Sqrt(Gravity * WaveNumber);
+}
+
+// Normalized direction of a wave, along X if it has none.
+static FVector2D GetSafeWaveDirection(const FVector2D& Direction)
+{
+	return Direction.IsNearlyZero() ? FVector2D{1.f, 0.f} : Direction.GetSafeNormal();
+}
+
+float UFlatWaterSurfaceProvider::GetWaterHeight(const FVector& Position, float Time) const
+{
+	return Height;
+}
+
+FVector UFlatWaterSurfaceProvider::GetWaterDisplacement(const FVector& Position, float Time) const
+{
+	return FVector{0.f, 0.f, Height};
+}
+
+FVector UFlatWaterSurfaceProvider::GetWaterVelocity(const FVector& Position, float Time) const
+{
+	return FVector::ZeroVector;
+}
+
+FVector2D UFlatWaterSurfaceProvider::GetWaveDirection() const
+{
+	return FVector2D{1.f, 0.f};
+}
+
+bool UFlatWaterSurfaceProvider::GetWaterHeightBounds(FFloatInterval& OutBounds) const
+{
+	OutBounds = FFloatInterval{Height, Height};
+	return true;
+}
+
+bool UFlatWaterSurfaceProvider::GetWaterHeightRateBounds(float& OutMaxSlope, float& OutMaxSpeed) const
+{
+	OutMaxSlope = 0.f;
+	OutMaxSpeed = 0.f;
+	return true;
+}
+
+bool UFlatWaterSurfaceProvider::GetWaves(TArray<FWaterSurfaceWave>& OutWaves) const
+{
+	OutWaves.Reset();
+	return true;
+}
+
+class FFlatWaterSurfaceSnapshot : public FWaterSurfaceSnapshot
+{
+   public:
+	explicit FFlatWaterSurfaceSnapshot(float Height) : Height{Height}
+	{
+	}
+
+	virtual float GetWaterHeight(const FVector& Position, float Time) const override
+	{
+		return Height;
+	}
+
+   private:
+	const float Height;
+};
+
+FWaterSurfaceSnapshotPtr UFlatWaterSurfaceProvider::MakeSnapshot() const
+{
+	return MakeShared<FFlatWaterSurfaceSnapshot, ESPMode::ThreadSafe>(Height);
+}
+
+// Phase of a sine wave, shared by the provider and its snapshots.
+static float GetSinePhase(float Wavelength, const FVector2D& Direction, const FVector& Position, float Time)
+{
+	const auto WaveNumber = 2.f * PI / FMath::Max(Wavelength, 1.f);
+	return WaveNumber * (GetSafeWaveDirection(Direction) | FVector2D{Position}) -
+	       GetDeepWaterAngularFrequency(Wavelength) * Time;
+}
+
+float USineWaterSurfaceProvider::GetAngularFrequency() const
+{
+	return GetDeepWaterAngularFrequency(Wavelength);
+}
+
+float USineWaterSurfaceProvider::GetPhase(const FVector& Position, float Time) const
+{
+	return GetSinePhase(Wavelength, Direction, Position, Time);
+}
+
+float USineWaterSurfaceProvider::GetWaterHeight(const FVector& Position, float Time) const
+{
+	return BaseHeight + Amplitude * FMath::Sin(GetPhase(Position, Time));
+}
+
+FVector USineWaterSurfaceProvider::GetWaterDisplacement(const FVector& Position, float Time) const
+{
+	return FVector{0.f, 0.f, GetWaterHeight(Position, Time)};
+}
+
+FVector USineWaterSurfaceProvider::GetWaterVelocity(const FVector& Position, float Time) const
+{
+	return FVector{0.f, 0.f, -Amplitude * GetAngularFrequency() * FMath::Cos(GetPhase(Position, Time))};
+}
+
+FVector2D USineWaterSurfaceProvider::GetWaveDirection() const
+{
+	return GetSafeWaveDirection(Direction);
+}
+
+bool USineWaterSurfaceProvider::GetWaterHeightBounds(FFloatInterval& OutBounds) const
+{
+	OutBounds = FFloatInterval{BaseHeight - FMath::Abs(Amplitude), BaseHeight + FMath::Abs(Amplitude)};
+	return true;
+}
+
+bool USineWaterSurfaceProvider::GetWaterHeightRateBounds(float& OutMaxSlope, float& OutMaxSpeed) const
+{
+	OutMaxSlope = FMath::Abs(Amplitude) * 2.f * PI / FMath::Max(Wavelength, 1.f);
+	OutMaxSpeed = FMath::Abs(Amplitude) * GetAngularFrequency();
+	return true;
+}
+
+bool USineWaterSurfaceProvider::GetWaves(TArray<FWaterSurfaceWave>& OutWaves) const
+{
+	FWaterSurfaceWave Wave;
+	Wave.WaveVector = GetSafeWaveDirection(Direction) * 2.f * PI / FMath::Max(Wavelength, 1.f);
+	Wave.AngularFrequency = GetAngularFrequency();
+	Wave.Amplitude = FMath::Abs(Amplitude);
+	OutWaves.Reset(1);
+	OutWaves.Add(Wave);
+	return true;
+}
+
+class FSineWaterSurfaceSnapshot : public FWaterSurfaceSnapshot
+{
+   public:
+	explicit FSineWaterSurfaceSnapshot(const USineWaterSurfaceProvider& Provider)
+	    : BaseHeight{Provider.BaseHeight}
+	    , Amplitude{Provider.Amplitude}
+	    , Wavelength{Provider.Wavelength}
+	    , Direction{Provider.Direction}
+	{
+	}
+
+	virtual float GetWaterHeight(const FVector& Position, float Time) const override
+	{
+		return BaseHeight + Amplitude * FMath::Sin(GetSinePhase(Wavelength, Direction, Position, Time));
+	}
+
+   private:
+	const float BaseHeight;
+	const float Amplitude;
+	const float Wavelength;
+	const FVector2D Direction;
+};
+
+FWaterSurfaceSnapshotPtr USineWaterSurfaceProvider::MakeSnapshot() const
+{
+	return MakeShared<FSineWaterSurfaceSnapshot, ESPMode::ThreadSafe>(*this);
+}
+
+// What a wave contributes at a given time, so a batch doesn't recompute it for every position.
+struct FGerstnerWaveConstants
+{
+	// Direction * wave number.
+	FVector2D WaveVector;
+	// -AngularFrequency * Time.
+	float PhaseOffset;
+	float AngularFrequency;
+	float Amplitude;
+	// Direction * amplitude of the horizontal motion.
+	FVector2D HorizontalAmplitude;
+};
+
+typedef TArray<FGerstnerWaveConstants, TInlineAllocator<8>> FGerstnerWaveSet;
+
+static void MakeWaveSet(const TArray<FAnalyticGerstnerWave>& Waves, float Time, FGerstnerWaveSet& OutWaveSet)
+{
+	OutWaveSet.Reset(Waves.Num());
+	for (const auto& Wave : Waves)
+	{
+		const auto Direction = GetSafeWaveDirection(Wave.Direction);
+		const auto WaveNumber = 2.f * PI / FMath::Max(Wave.Wavelength, 1.f);
+
+		FGerstnerWaveConstants Constants;
+		Constants.WaveVector = Direction * WaveNumber;
+		Constants.AngularFrequency = GetDeepWaterAngularFrequency(Wave.Wavelength);
+		Constants.PhaseOffset = -Constants.AngularFrequency * Time;
+		Constants.Amplitude = Wave.Amplitude;
+		// Spread the steepness over the waves so their sum never loops over itself.
+		Constants.HorizontalAmplitude =
+		    Direction * (FMath::Clamp(Wave.Steepness, 0.f, 1.f) / (WaveNumber * Waves.Num()));
+		OutWaveSet.Add(Constants);
+	}
+}
+
+// Horizontal displacement in X and Y, height above the base height in Z, of the point at rest at RestPosition.
+static FVector GetDisplacement(const FGerstnerWaveSet& WaveSet, const FVector2D& RestPosition)
+{
+	auto Displacement = FVector::ZeroVector;
+	for (const auto& Wave : WaveSet)
+	{
+		float Sin, Cos;
+		FMath::SinCos(&Sin, &Cos, (Wave.WaveVector | RestPosition) + Wave.PhaseOffset);
+		Displacement.X += Wave.HorizontalAmplitude.X * Cos;
+		Displacement.Y += Wave.HorizontalAmplitude.Y * Cos;
+		Displacement.Z += Wave.Amplitude * Sin;
+	}
+	return Displacement;
+}
+
+static FVector GetVelocity(const FGerstnerWaveSet& WaveSet, const FVector2D& RestPosition)
+{
+	auto Velocity = FVector::ZeroVector;
+	for (const auto& Wave : WaveSet)
+	{
+		float Sin, Cos;
+		FMath::SinCos(&Sin, &Cos, (Wave.WaveVector | RestPosition) + Wave.PhaseOffset);
+		Velocity.X += Wave.HorizontalAmplitude.X * Wave.AngularFrequency * Sin;
+		Velocity.Y += Wave.HorizontalAmplitude.Y * Wave.AngularFrequency * Sin;
+		Velocity.Z -= Wave.Amplitude * Wave.AngularFrequency * Cos;
+	}
+	return Velocity;
+}
+
+// Finds the point at rest that is displaced above Position, then returns its height above the base height.
+static float GetHeight(const FGerstnerWaveSet& WaveSet, const FVector2D& Position)
+{
+	auto RestPosition = Position;
+	for (int32 Iteration = 0; Iteration < 2; ++Iteration)
+	{
+		const auto Displacement = GetDisplacement(WaveSet, RestPosition);
+		RestPosition = Position - FVector2D{Displacement.X, Displacement.Y};
+	}
+	return GetDisplacement(WaveSet, RestPosition).Z;
+}
+
+// Batched heights of a set of waves, shared by the provider and its snapshots.
+static void GetGerstnerHeights(const TArray<FAnalyticGerstnerWave>& Waves,
+                               float BaseHeight,
+                               TArrayView<const FVector> Positions,
+                               float Time,
+                               TArrayView<float> OutHeights)
+{
+	check(OutHeights.Num() == Positions.Num());
+
+	FGerstnerWaveSet WaveSet;
+	MakeWaveSet(Waves, Time, WaveSet);
+	for (int32 i = 0; i < Positions.Num(); ++i)
+	{
+		OutHeights[i] = BaseHeight + GetHeight(WaveSet, FVector2D{Positions[i]});
+	}
+}
+
+float UGerstnerWaterSurfaceProvider::GetWaterHeight(const FVector& Position, float Time) const
+{
+	FGerstnerWaveSet WaveSet;
+	MakeWaveSet(Waves, Time, WaveSet);
+	return BaseHeight + GetHeight(WaveSet, FVector2D{Position});
+}
+
+FVector UGerstnerWaterSurfaceProvider::GetWaterDisplacement(const FVector& Position, float Time) const
+{
+	FGerstnerWaveSet WaveSet;
+	MakeWaveSet(Waves, Time, WaveSet);
+	return GetDisplacement(WaveSet, FVector2D{Position}) + FVector{0.f, 0.f, BaseHeight};
+}
+
+FVector UGerstnerWaterSurfaceProvider::GetWaterVelocity(const FVector& Position, float Time) const
+{
+	FGerstnerWaveSet WaveSet;
+	MakeWaveSet(Waves, Time, WaveSet);
+	return GetVelocity(WaveSet, FVector2D{Position});
+}
+
+FVector2D UGerstnerWaterSurfaceProvider::GetWaveDirection() const
+{
+	// Average of the directions the waves travel in, weighted by the amplitudes. A wave without a direction travels
+	// along X, like in the queries.
+	auto Direction = FVector2D::ZeroVector;
+	for (const auto& Wave : Waves)
+	{
+		Direction += GetSafeWaveDirection(Wave.Direction) * Wave.Amplitude;
+	}
+	return GetSafeWaveDirection(Direction);
+}
+
+bool UGerstnerWaterSurfaceProvider::GetWaterHeightBounds(FFloatInterval& OutBounds) const
+{
+	// Every height is the sum of the waves' sines at some point at rest, whatever the inversion converged to.
+	auto AmplitudeSum = 0.f;
+	for (const auto& Wave : Waves)
+	{
+		AmplitudeSum += FMath::Abs(Wave.Amplitude);
+	}
+	OutBounds = FFloatInterval{BaseHeight - AmplitudeSum, BaseHeight + AmplitudeSum};
+	return true;
+}
+
+bool UGerstnerWaterSurfaceProvider::GetWaterHeightRateBounds(float& OutMaxSlope, float& OutMaxSpeed) const
+{
+	// Bounds of the gradients of the sines and of the horizontal displacement, over the rest positions.
+	auto HeightSlope = 0.f;
+	auto HeightSpeed = 0.f;
+	auto DisplacementSlope = 0.f;
+	auto DisplacementSpeed = 0.f;
+	FGerstnerWaveSet WaveSet;
+	MakeWaveSet(Waves, 0.f, WaveSet);
+	for (const auto& Wave : WaveSet)
+	{
+		const auto WaveNumber = Wave.WaveVector.Size();
+		const auto HorizontalAmplitude = Wave.HorizontalAmplitude.Size();
+		HeightSlope += FMath::Abs(Wave.Amplitude) * WaveNumber;
+		HeightSpeed += FMath::Abs(Wave.Amplitude) * Wave.AngularFrequency;
+		DisplacementSlope += HorizontalAmplitude * WaveNumber;
+		DisplacementSpeed += HorizontalAmplitude * Wave.AngularFrequency;
+	}
+
+	// GetHeight reads the sines at a rest position found with two fixed point iterations, whose derivatives are
+	// bounded through the chain rule, so the bounds hold for the heights it computes and not only the exact surface.
+	OutMaxSlope = HeightSlope * (1.f + DisplacementSlope + DisplacementSlope * DisplacementSlope);
+	OutMaxSpeed = HeightSpeed + HeightSlope * DisplacementSpeed * (1.f + DisplacementSlope);
+	return true;
+}
+
+bool UGerstnerWaterSurfaceProvider::GetWaves(TArray<FWaterSurfaceWave>& OutWaves) const
+{
+	FGerstnerWaveSet WaveSet;
+	MakeWaveSet(Waves, 0.f, WaveSet);
+	OutWaves.Reset(WaveSet.Num());
+	for (const auto& Constants : WaveSet)
+	{
+		FWaterSurfaceWave Wave;
+		Wave.WaveVector = Constants.WaveVector;
+		Wave.AngularFrequency = Constants.AngularFrequency;
+		Wave.Amplitude = FMath::Max(FMath::Abs(Constants.Amplitude), Constants.HorizontalAmplitude.Size());
+		OutWaves.Add(Wave);
+	}
+	return true;
+}
+
+class FGerstnerWaterSurfaceSnapshot : public FWaterSurfaceSnapshot
+{
+   public:
+	explicit FGerstnerWaterSurfaceSnapshot(const UGerstnerWaterSurfaceProvider& Provider)
+	    : BaseHeight{Provider.BaseHeight}, Waves{Provider.Waves}
+	{
+	}
+
+	virtual float GetWaterHeight(const FVector& Position, float Time) const override
+	{
+		float Height;
+		GetGerstnerHeights(Waves, BaseHeight, MakeArrayView(&Position, 1), Time, MakeArrayView(&Height, 1));
+		return Height;
+	}
+
+	virtual void GetWaterHeights(TArrayView<const FVector> Positions,
+	                             float Time,
+	                             TArrayView<float> OutHeights) const override
+	{
+		GetGerstnerHeights(Waves, BaseHeight, Positions, Time, OutHeights);
+	}
+
+   private:
+	const float BaseHeight;
+	const TArray<FAnalyticGerstnerWave> Waves;
+};
+
+FWaterSurfaceSnapshotPtr UGerstnerWaterSurfaceProvider::MakeSnapshot() const
+{
+	return MakeShared<FGerstnerWaterSurfaceSnapshot, ESPMode::ThreadSafe>(*this);
+}
+
+void UGerstnerWaterSurfaceProvider::GetWaterHeights(TArrayView<const FVector> Positions,
+                                                    float Time,
+                                                    TArrayView<float> OutHeights) const
+{
+	GetGerstnerHeights(Waves, BaseHeight, Positions, Time, OutHeights);
+}
+
+void UGerstnerWaterSurfaceProvider::GetWaterDisplacements(TArrayView<const FVector> Positions,
+                                                          float Time,
+                                                          TArrayView<FVector> OutDisplacements) const
+{
+	check(OutDisplacements.Num() == Positions.Num());
+
+	FGerstnerWaveSet WaveSet;
+	MakeWaveSet(Waves, Time, WaveSet);
+	for (int32 i = 0; i < Positions.Num(); ++i)
+	{
+		OutDisplacements[i] = GetDisplacement(WaveSet, FVector2D{Positions[i]}) + FVector{0.f, 0.f, BaseHeight};
+	}
+}
+
+void UGerstnerWaterSurfaceProvider::GetWaterVelocities(TArrayView<const FVector> Positions,
+                                                       float Time,
+                                                       TArrayView<FVector> OutVelocities) const
+{
+	check(OutVelocities.Num() == Positions.Num());
+
+	FGerstnerWaveSet WaveSet;
+	MakeWaveSet(Waves, Time, WaveSet);
+	for (int32 i = 0; i < Positions.Num(); ++i)
+	{
+		OutVelocities[i] = GetVelocity(WaveSet, FVector2D{Positions[i]});
+	}
+}
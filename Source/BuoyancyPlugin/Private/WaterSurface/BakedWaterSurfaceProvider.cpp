@@ -0,0 +1,114 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "WaterSurface/BakedWaterSurfaceProvider.h"
+#include "Misc/Paths.h"
+
+
+FString UBakedWaterSurfaceProvider::GetAtlasPath(const FString& FileName)
+{
+	if (!FPaths::IsRelative(FileName)) return FileName;
+	return FPaths::Combine(FPaths::ProjectContentDir(), TEXT("Buoyancy"), FileName);
+}
+
+bool UBakedWaterSurfaceProvider::LoadAtlas()
+{
+	// The previous atlas is closed once the snapshots still reading it are released.
+	Atlas = MakeShared<FWaterSurfaceAtlas, ESPMode::ThreadSafe>();
+	if (FileName.IsEmpty()) return false;
+
+	const auto Path = GetAtlasPath(FileName);
+	if (!Atlas->Open(Path))
+	{
+		UE_LOG(LogTemp, Error, TEXT("BakedWaterSurfaceProvider could not open %s."), *Path);
+		return false;
+	}
+	return true;
+}
+
+const FWaterSurfaceAtlas& UBakedWaterSurfaceProvider::GetAtlas() const
+{
+	return *Atlas;
+}
+
+void UBakedWaterSurfaceProvider::PostLoad()
+{
+	Super::PostLoad();
+
+	if (!HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+	{
+		LoadAtlas();
+	}
+}
+
+void UBakedWaterSurfaceProvider::BeginDestroy()
+{
+	Atlas = MakeShared<FWaterSurfaceAtlas, ESPMode::ThreadSafe>();
+
+	Super::BeginDestroy();
+}
+
+void UBakedWaterSurfaceProvider::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(Atlas->GetAllocatedSize());
+}
+
+#if WITH_EDITOR
+void UBakedWaterSurfaceProvider::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED(UBakedWaterSurfaceProvider, FileName))
+	{
+		LoadAtlas();
+	}
+}
+#endif
+
+float UBakedWaterSurfaceProvider::GetWaterHeight(const FVector& Position, float Time) const
+{
+	return Atlas->GetHeight(Position, Time);
+}
+
+FVector UBakedWaterSurfaceProvider::GetWaterDisplacement(const FVector& Position, float Time) const
+{
+	return Atlas->GetDisplacement(Position, Time);
+}
+
+FVector UBakedWaterSurfaceProvider::GetWaterVelocity(const FVector& Position, float Time) const
+{
+	return Atlas->GetVelocity(Position, Time);
+}
+
+FVector2D UBakedWaterSurfaceProvider::GetWaveDirection() const
+{
+	return Atlas->IsOpen() ? Atlas->GetHeader().WaveDirection : FVector2D{1.f, 0.f};
+}
+
+bool UBakedWaterSurfaceProvider::GetWaterHeightBounds(FFloatInterval& OutBounds) const
+{
+	OutBounds = Atlas->GetHeightRange();
+	return true;
+}
+
+class FBakedWaterSurfaceSnapshot : public FWaterSurfaceSnapshot
+{
+   public:
+	explicit FBakedWaterSurfaceSnapshot(const TSharedRef<FWaterSurfaceAtlas, ESPMode::ThreadSafe>& Atlas) : Atlas{Atlas}
+	{
+	}
+
+	virtual float GetWaterHeight(const FVector& Position, float Time) const override
+	{
+		return Atlas->GetHeight(Position, Time);
+	}
+
+   private:
+	const TSharedRef<const FWaterSurfaceAtlas, ESPMode::ThreadSafe> Atlas;
+};
+
+FWaterSurfaceSnapshotPtr UBakedWaterSurfaceProvider::MakeSnapshot() const
+{
+	return MakeShared<FBakedWaterSurfaceSnapshot, ESPMode::ThreadSafe>(Atlas);
+}
@@ -0,0 +1,68 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "WaterSurface/OceanManagerWaterSurfaceProvider.h"
+#include "OceanPlugin/Public/OceanManager.h"
+#include "Engine/World.h"
+
+
+AOceanManager* UOceanManagerWaterSurfaceProvider::GetOceanManager() const
+{
+	return IsValid(OceanManager) ? OceanManager : nullptr;
+}
+
+float UOceanManagerWaterSurfaceProvider::GetWaterHeight(const FVector& Position, float Time) const
+{
+	const auto Ocean = GetOceanManager();
+	if (!Ocean) return 0.f;
+
+	return bTwoGerstnerIterations ? Ocean->GetWaveHeightValue(Position, Ocean->GetWorld(), true, true).Z
+	                              : Ocean->GetWaveHeight(Position, Ocean->GetWorld());
+}
+
+FVector UOceanManagerWaterSurfaceProvider::GetWaterDisplacement(const FVector& Position, float Time) const
+{
+	const auto Ocean = GetOceanManager();
+	return Ocean ? Ocean->GetWaveHeightValue(Position, Ocean->GetWorld(), false, false) : FVector::ZeroVector;
+}
+
+FVector UOceanManagerWaterSurfaceProvider::GetWaterVelocity(const FVector& Position, float Time) const
+{
+	return FVector::ZeroVector;
+}
+
+FVector2D UOceanManagerWaterSurfaceProvider::GetWaveDirection() const
+{
+	const auto Ocean = GetOceanManager();
+	return Ocean ? Ocean->GlobalWaveDirection : FVector2D{1.f, 0.f};
+}
+
+bool UOceanManagerWaterSurfaceProvider::GetWaterHeightBounds(FFloatInterval& OutBounds) const
+{
+	const auto Ocean = GetOceanManager();
+	if (!Ocean) return false;
+
+	// Every cluster adds its eight waves, each with its amplitude scaled by the matching set offset. The sum is the
+	// highest the crests can add up to, whether or not the OceanManager averages it over the waves.
+	const FWaveParameter* const SetOffsets[] = {&Ocean->WaveSetOffsetsOverride.Wave01,
+	                                            &Ocean->WaveSetOffsetsOverride.Wave02,
+	                                            &Ocean->WaveSetOffsetsOverride.Wave03,
+	                                            &Ocean->WaveSetOffsetsOverride.Wave04,
+	                                            &Ocean->WaveSetOffsetsOverride.Wave05,
+	                                            &Ocean->WaveSetOffsetsOverride.Wave06,
+	                                            &Ocean->WaveSetOffsetsOverride.Wave07,
+	                                            &Ocean->WaveSetOffsetsOverride.Wave08};
+	float AmplitudeSum = 0.f;
+	for (const auto& Cluster : Ocean->WaveClusters)
+	{
+		for (const auto Offset : SetOffsets)
+		{
+			AmplitudeSum += FMath::Abs(Cluster.Amplitude * Offset->Amplitude);
+		}
+	}
+	AmplitudeSum *= FMath::Abs(Ocean->GlobalWaveAmplitude);
+
+	const auto BaseHeight = Ocean->GetActorLocation().Z;
+	OutBounds = FFloatInterval{BaseHeight - AmplitudeSum, BaseHeight + AmplitudeSum};
+	return true;
+}
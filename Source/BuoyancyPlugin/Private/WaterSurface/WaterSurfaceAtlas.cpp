@@ -0,0 +1,263 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "WaterSurface/WaterSurfaceAtlas.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/BufferReader.h"
+
+
+// "WSAT" in a little endian file.
+static const uint32 AtlasMagic = 0x54415357;
+static const int32 AtlasVersion = 1;
+// The texels start at a multiple of this, so they can be read in place from the mapped file.
+static const int64 TexelAlignment = 16;
+static const float QuantizedRange = 32767.f;
+
+FArchive& operator<<(FArchive& Ar, FWaterSurfaceAtlasHeader& Header)
+{
+	return Ar << Header.Resolution << Header.FrameCount << Header.Origin << Header.TileSize << Header.TimeOrigin
+	          << Header.Period << Header.WaveDirection << Header.Offset << Header.Scale;
+}
+
+FWaterSurfaceAtlas::~FWaterSurfaceAtlas()
+{
+	Close();
+}
+
+bool FWaterSurfaceAtlas::Write(const FString& Filename, FWaterSurfaceAtlasHeader& Header, const TArray<FVector4>& Samples)
+{
+	check(Samples.Num() == Header.Resolution * Header.Resolution * Header.FrameCount);
+
+	auto MinValue = FVector4{BIG_NUMBER, BIG_NUMBER, BIG_NUMBER, BIG_NUMBER};
+	auto MaxValue = FVector4{-BIG_NUMBER, -BIG_NUMBER, -BIG_NUMBER, -BIG_NUMBER};
+	for (const auto& Sample : Samples)
+	{
+		for (int32 Channel = 0; Channel < 4; ++Channel)
+		{
+			MinValue[Channel] = FMath::Min(MinValue[Channel], Sample[Channel]);
+			MaxValue[Channel] = FMath::Max(MaxValue[Channel], Sample[Channel]);
+		}
+	}
+	for (int32 Channel = 0; Channel < 4; ++Channel)
+	{
+		Header.Offset[Channel] = (MinValue[Channel] + MaxValue[Channel]) / 2.f;
+		Header.Scale[Channel] = FMath::Max((MaxValue[Channel] - MinValue[Channel]) / 2.f / QuantizedRange, KINDA_SMALL_NUMBER);
+	}
+
+	const TUniquePtr<FArchive> Archive{IFileManager::Get().CreateFileWriter(*Filename)};
+	if (!Archive) return false;
+
+	auto Magic = AtlasMagic;
+	auto Version = AtlasVersion;
+	*Archive << Magic << Version << Header;
+
+	uint8 Padding[TexelAlignment] = {};
+	Archive->Serialize(Padding, Align(Archive->Tell(), TexelAlignment) - Archive->Tell());
+
+	TArray<FTexel> Texels;
+	Texels.SetNumUninitialized(Samples.Num());
+	for (int32 i = 0; i < Samples.Num(); ++i)
+	{
+		int16 Quantized[4];
+		for (int32 Channel = 0; Channel < 4; ++Channel)
+		{
+			const auto Value = (Samples[i][Channel] - Header.Offset[Channel]) / Header.Scale[Channel];
+			Quantized[Channel] = static_cast<int16>(FMath::Clamp(FMath::RoundToInt(Value), -32767, 32767));
+		}
+		Texels[i] = FTexel{Quantized[0], Quantized[1], Quantized[2], Quantized[3]};
+	}
+	Archive->Serialize(Texels.GetData(), Texels.Num() * sizeof(FTexel));
+
+	return Archive->Close();
+}
+
+bool FWaterSurfaceAtlas::Open(const FString& Filename)
+{
+	Close();
+
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (MappedFile)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	}
+	if (MappedRegion)
+	{
+		Data = MappedRegion->GetMappedPtr();
+		Size = MappedRegion->GetMappedSize();
+	}
+	else
+	{
+		MappedFile.Reset();
+		if (!FFileHelper::LoadFileToArray(LoadedFile, *Filename, FILEREAD_Silent)) return false;
+		Data = LoadedFile.GetData();
+		Size = LoadedFile.Num();
+	}
+
+	FBufferReader Reader{const_cast<uint8*>(Data), Size, /*bInFreeOnClose*/ false};
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Reader << Magic << Version;
+	if (Magic != AtlasMagic || Version != AtlasVersion)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s is not a water surface atlas of version %d."), *Filename, AtlasVersion);
+		Close();
+		return false;
+	}
+
+	Reader << Header;
+	const auto TexelOffset = Align(Reader.Tell(), TexelAlignment);
+	const auto TexelCount = static_cast<int64>(Header.Resolution) * Header.Resolution * Header.FrameCount;
+	if (Reader.IsError() || Header.Resolution < 1 || Header.FrameCount < 1 || Header.Period <= 0.f ||
+	    Header.TileSize.X <= 0.f || Header.TileSize.Y <= 0.f || TexelOffset + TexelCount * sizeof(FTexel) > Size)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Water surface atlas %s is truncated or corrupted."), *Filename);
+		Close();
+		return false;
+	}
+
+	Texels = reinterpret_cast<const FTexel*>(Data + TexelOffset);
+	return true;
+}
+
+void FWaterSurfaceAtlas::Close()
+{
+	Texels = nullptr;
+	// The region has to go before the file it maps.
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	LoadedFile.Empty();
+}
+
+bool FWaterSurfaceAtlas::IsOpen() const
+{
+	return Texels != nullptr;
+}
+
+const FWaterSurfaceAtlasHeader& FWaterSurfaceAtlas::GetHeader() const
+{
+	return Header;
+}
+
+int64 FWaterSurfaceAtlas::GetSizeInBytes() const
+{
+	return GetFrameSizeInBytes() * Header.FrameCount;
+}
+
+int64 FWaterSurfaceAtlas::GetFrameSizeInBytes() const
+{
+	return static_cast<int64>(Header.Resolution) * Header.Resolution * sizeof(FTexel);
+}
+
+bool FWaterSurfaceAtlas::IsMapped() const
+{
+	return IsOpen() && MappedRegion.IsValid();
+}
+
+SIZE_T FWaterSurfaceAtlas::GetAllocatedSize() const
+{
+	return LoadedFile.GetAllocatedSize();
+}
+
+FFloatInterval FWaterSurfaceAtlas::GetHeightRange() const
+{
+	if (!IsOpen()) return FFloatInterval{0.f, 0.f};
+
+	// The interpolated heights stay between the extreme texel values.
+	const auto Low = Header.Offset.X + Header.Scale.X * TNumericLimits<int16>::Min();
+	const auto High = Header.Offset.X + Header.Scale.X * TNumericLimits<int16>::Max();
+	return FFloatInterval{FMath::Min(Low, High), FMath::Max(Low, High)};
+}
+
+FWaterSurfaceAtlas::FSampleCoordinates FWaterSurfaceAtlas::GetSampleCoordinates(const FVector& Position,
+                                                                                float Time) const
+{
+	const auto Resolution = Header.Resolution;
+	const auto GridX = (Position.X - Header.Origin.X) / Header.TileSize.X * Resolution;
+	const auto GridY = (Position.Y - Header.Origin.Y) / Header.TileSize.Y * Resolution;
+	const auto FrameTime = (Time - Header.TimeOrigin) / Header.Period * Header.FrameCount;
+
+	const auto FloorX = FMath::FloorToFloat(GridX);
+	const auto FloorY = FMath::FloorToFloat(GridY);
+	const auto FloorFrame = FMath::FloorToFloat(FrameTime);
+	const auto AlphaX = GridX - FloorX;
+	const auto AlphaY = GridY - FloorY;
+
+	// The atlas tiles, so the coordinates wrap around.
+	const auto X0 = ((static_cast<int32>(FloorX) % Resolution) + Resolution) % Resolution;
+	const auto Y0 = ((static_cast<int32>(FloorY) % Resolution) + Resolution) % Resolution;
+	const auto X1 = (X0 + 1) % Resolution;
+	const auto Y1 = (Y0 + 1) % Resolution;
+	const auto Frame0 = ((static_cast<int32>(FloorFrame) % Header.FrameCount) + Header.FrameCount) % Header.FrameCount;
+	const auto Frame1 = (Frame0 + 1) % Header.FrameCount;
+
+	FSampleCoordinates Coordinates;
+	Coordinates.FrameOffsets[0] = Frame0 * Resolution * Resolution;
+	Coordinates.FrameOffsets[1] = Frame1 * Resolution * Resolution;
+	Coordinates.TexelOffsets[0] = Y0 * Resolution + X0;
+	Coordinates.TexelOffsets[1] = Y0 * Resolution + X1;
+	Coordinates.TexelOffsets[2] = Y1 * Resolution + X0;
+	Coordinates.TexelOffsets[3] = Y1 * Resolution + X1;
+	Coordinates.TexelWeights[0] = (1.f - AlphaX) * (1.f - AlphaY);
+	Coordinates.TexelWeights[1] = AlphaX * (1.f - AlphaY);
+	Coordinates.TexelWeights[2] = (1.f - AlphaX) * AlphaY;
+	Coordinates.TexelWeights[3] = AlphaX * AlphaY;
+	Coordinates.FrameAlpha = FrameTime - FloorFrame;
+	return Coordinates;
+}
+
+float FWaterSurfaceAtlas::GetHeight(const FVector& Position, float Time) const
+{
+	if (!IsOpen()) return 0.f;
+
+	const auto Coordinates = GetSampleCoordinates(Position, Time);
+	float FrameHeights[2];
+	for (int32 Frame = 0; Frame < 2; ++Frame)
+	{
+		const auto FrameTexels = Texels + Coordinates.FrameOffsets[Frame];
+		auto Quantized = 0.f;
+		for (int32 i = 0; i < 4; ++i)
+		{
+			Quantized += Coordinates.TexelWeights[i] * FrameTexels[Coordinates.TexelOffsets[i]].Height;
+		}
+		FrameHeights[Frame] = Quantized;
+	}
+	return Header.Offset.X + Header.Scale.X * FMath::Lerp(FrameHeights[0], FrameHeights[1], Coordinates.FrameAlpha);
+}
+
+FVector FWaterSurfaceAtlas::GetFrameDisplacement(const FSampleCoordinates& Coordinates, int32 Frame) const
+{
+	const auto FrameTexels = Texels + Coordinates.FrameOffsets[Frame];
+	auto Quantized = FVector::ZeroVector;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		const auto& Texel = FrameTexels[Coordinates.TexelOffsets[i]];
+		Quantized += Coordinates.TexelWeights[i] * FVector(Texel.DisplacementX, Texel.DisplacementY, Texel.DisplacementZ);
+	}
+	return Quantized;
+}
+
+FVector FWaterSurfaceAtlas::GetDisplacement(const FVector& Position, float Time) const
+{
+	if (!IsOpen()) return FVector::ZeroVector;
+
+	const auto Coordinates = GetSampleCoordinates(Position, Time);
+	const auto Quantized = FMath::Lerp(
+	    GetFrameDisplacement(Coordinates, 0), GetFrameDisplacement(Coordinates, 1), Coordinates.FrameAlpha);
+	return FVector{Header.Offset.Y, Header.Offset.Z, Header.Offset.W} +
+	       FVector{Header.Scale.Y, Header.Scale.Z, Header.Scale.W} * Quantized;
+}
+
+FVector FWaterSurfaceAtlas::GetVelocity(const FVector& Position, float Time) const
+{
+	if (!IsOpen()) return FVector::ZeroVector;
+
+	const auto Coordinates = GetSampleCoordinates(Position, Time);
+	const auto FrameDuration = Header.Period / Header.FrameCount;
+	const auto QuantizedChange = GetFrameDisplacement(Coordinates, 1) - GetFrameDisplacement(Coordinates, 0);
+	return FVector{Header.Scale.Y, Header.Scale.Z, Header.Scale.W} * QuantizedChange / FrameDuration;
+}
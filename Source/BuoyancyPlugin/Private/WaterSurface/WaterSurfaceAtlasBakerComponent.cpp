@@ -0,0 +1,301 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "WaterSurface/WaterSurfaceAtlasBakerComponent.h"
+#include "WaterSurface/BakedWaterSurfaceProvider.h"
+#include "WaterSurface/WaterSurfaceProvider.h"
+#include "OceanPlugin/Public/OceanManager.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "EngineUtils.h"
+#include "Misc/App.h"
+
+
+// Jump of a wave of unit amplitude whose phase changes by Phase over a tile or a period: zero for whole turns.
+static float GetSeamHeight(float Phase)
+{
+	return 2.f * FMath::Abs(FMath::Sin(Phase / 2.f));
+}
+
+UWaterSurfaceAtlasBakerComponent::UWaterSurfaceAtlasBakerComponent()
+{
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+	PrimaryComponentTick.bCanEverTick = true;
+	UActorComponent::SetComponentTickEnabled(true);
+}
+
+void UWaterSurfaceAtlasBakerComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (!OceanManager)
+	{
+		for (auto Actor : TActorRange<AOceanManager>(GetWorld()))
+		{
+			OceanManager = Actor;
+			break;
+		}
+	}
+
+	if (bBakeOnBeginPlay)
+	{
+		StartBake();
+	}
+}
+
+void UWaterSurfaceAtlasBakerComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (IsBaking())
+	{
+		NextFrame = INDEX_NONE;
+		EndFixedTimeStep();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool UWaterSurfaceAtlasBakerComponent::IsBaking() const
+{
+	return NextFrame != INDEX_NONE;
+}
+
+void UWaterSurfaceAtlasBakerComponent::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(GetBuoyancyAllocatedSize());
+}
+
+SIZE_T UWaterSurfaceAtlasBakerComponent::GetBuoyancyAllocatedSize() const
+{
+	return Samples.GetAllocatedSize() + TexelPositions.GetAllocatedSize();
+}
+
+void UWaterSurfaceAtlasBakerComponent::StartBake()
+{
+	if (IsBaking()) return;
+
+	Source = FWaterSurfaceProviders::Resolve(WaterSurfaceProvider, this, OceanManager);
+	if (!Source)
+	{
+		UE_LOG(LogTemp, Error, TEXT("WaterSurfaceAtlasBakerComponent requires a water surface provider or an OceanManager in the level."));
+		return;
+	}
+
+	if (!CheckSeams()) return;
+
+	const auto Owner = GetOwner();
+	check(Owner);
+
+	Header = FWaterSurfaceAtlasHeader{};
+	Header.Resolution = FMath::Max(2, Resolution);
+	Header.FrameCount = FMath::Max(1, FrameCount);
+	Header.TileSize = FVector2D{FMath::Max(TileSize.X, 1.f), FMath::Max(TileSize.Y, 1.f)};
+	Header.Origin = FVector2D{Owner->GetActorLocation()} - Header.TileSize / 2.f;
+	Header.Period = FMath::Max(Period, 0.01f);
+	Header.TimeOrigin = GetWorld()->GetTimeSeconds();
+	Header.WaveDirection = Source->GetWaveDirection();
+
+	TexelPositions.SetNumUninitialized(Header.Resolution * Header.Resolution);
+	for (int32 Y = 0; Y < Header.Resolution; ++Y)
+	{
+		for (int32 X = 0; X < Header.Resolution; ++X)
+		{
+			const auto Alpha = FVector2D(X, Y) / Header.Resolution;
+			const auto Position2D = Header.Origin + Alpha * Header.TileSize;
+			TexelPositions[Y * Header.Resolution + X] = FVector{Position2D.X, Position2D.Y, 0.f};
+		}
+	}
+	Samples.SetNumUninitialized(TexelPositions.Num() * Header.FrameCount);
+
+	if (Source->CanQueryAnyTime())
+	{
+		for (int32 Frame = 0; Frame < Header.FrameCount; ++Frame)
+		{
+			BakeFrame(Frame, Header.TimeOrigin + Frame * Header.Period / Header.FrameCount);
+		}
+		FinishBake();
+	}
+	else
+	{
+		UE_LOG(LogTemp, Log, TEXT("Baking the water surface atlas over the next %d frames."), Header.FrameCount);
+		BeginFixedTimeStep();
+		NextFrame = 0;
+	}
+}
+
+bool UWaterSurfaceAtlasBakerComponent::CheckSeams() const
+{
+	TArray<FWaterSurfaceWave> Waves;
+	if (!Source->GetWaves(Waves))
+	{
+		UE_LOG(LogTemp,
+		       Warning,
+		       TEXT("WaterSurfaceAtlasBakerComponent can't check that the tile size and the period fit the waves, ")
+		           TEXT("the measured error shows the seams."));
+		return true;
+	}
+
+	// The atlas wraps around along X, along Y and in time, each wave jumps by the phase it is off a whole turn there.
+	auto SeamHeight = FVector::ZeroVector;
+	for (const auto& Wave : Waves)
+	{
+		SeamHeight.X += Wave.Amplitude * GetSeamHeight(Wave.WaveVector.X * TileSize.X);
+		SeamHeight.Y += Wave.Amplitude * GetSeamHeight(Wave.WaveVector.Y * TileSize.Y);
+		SeamHeight.Z += Wave.Amplitude * GetSeamHeight(Wave.AngularFrequency * Period);
+	}
+	if (SeamHeight.GetMax() <= SeamTolerance) return true;
+
+	UE_LOG(LogTemp,
+	       Error,
+	       TEXT("WaterSurfaceAtlasBakerComponent refused to bake: the waves would leave seams of %.2f along X, %.2f ")
+	           TEXT("along Y and %.2f in time, above the tolerance of %.2f. The tile size has to be a multiple of the ")
+	           TEXT("wavelengths along X and Y, and the period of the wave periods."),
+	       SeamHeight.X,
+	       SeamHeight.Y,
+	       SeamHeight.Z,
+	       SeamTolerance);
+	return false;
+}
+
+void UWaterSurfaceAtlasBakerComponent::BeginFixedTimeStep()
+{
+	bPreviousUseFixedTimeStep = FApp::UseFixedTimeStep();
+	PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+
+	// The world time advances by the engine time step times the time dilation.
+	const auto TimeDilation = GetWorld()->GetWorldSettings()->GetEffectiveTimeDilation();
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(Header.Period / Header.FrameCount / FMath::Max(TimeDilation, KINDA_SMALL_NUMBER));
+}
+
+void UWaterSurfaceAtlasBakerComponent::EndFixedTimeStep()
+{
+	FApp::SetUseFixedTimeStep(bPreviousUseFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+}
+
+void UWaterSurfaceAtlasBakerComponent::TickComponent(float DeltaTime,
+                                                     ELevelTick TickType,
+                                                     FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (!IsBaking()) return;
+
+	Source = FWaterSurfaceProviders::Resolve(WaterSurfaceProvider, this, OceanManager);
+	if (!Source)
+	{
+		NextFrame = INDEX_NONE;
+		EndFixedTimeStep();
+		return;
+	}
+
+	// The tick the bake starts on may not be a fixed step yet, so the frames are timed from the first sample.
+	const auto Time = GetWorld()->GetTimeSeconds();
+	if (NextFrame == 0)
+	{
+		Header.TimeOrigin = Time;
+	}
+	const auto FrameStep = Header.Period / Header.FrameCount;
+	const auto FrameTime = Header.TimeOrigin + NextFrame * FrameStep;
+	if (!FMath::IsNearlyEqual(Time, FrameTime, FrameStep * 0.01f))
+	{
+		UE_LOG(LogTemp,
+		       Warning,
+		       TEXT("WaterSurfaceAtlasBakerComponent sampled frame %d at %.3f s instead of %.3f s, ")
+		           TEXT("something else changed the time step or the time dilation."),
+		       NextFrame,
+		       Time - Header.TimeOrigin,
+		       FrameTime - Header.TimeOrigin);
+	}
+	BakeFrame(NextFrame, FrameTime);
+	++NextFrame;
+
+	if (NextFrame == Header.FrameCount)
+	{
+		EndFixedTimeStep();
+		FinishBake();
+	}
+}
+
+void UWaterSurfaceAtlasBakerComponent::BakeFrame(int32 Frame, float Time)
+{
+	TArray<float> Heights;
+	TArray<FVector> Displacements;
+	Heights.SetNumUninitialized(TexelPositions.Num());
+	Displacements.SetNumUninitialized(TexelPositions.Num());
+	Source->GetWaterHeights(TexelPositions, Time, Heights);
+	Source->GetWaterDisplacements(TexelPositions, Time, Displacements);
+
+	const auto FrameOffset = Frame * TexelPositions.Num();
+	for (int32 i = 0; i < TexelPositions.Num(); ++i)
+	{
+		Samples[FrameOffset + i] = FVector4{Heights[i], Displacements[i].X, Displacements[i].Y, Displacements[i].Z};
+	}
+}
+
+void UWaterSurfaceAtlasBakerComponent::FinishBake()
+{
+	NextFrame = INDEX_NONE;
+
+	const auto Path = UBakedWaterSurfaceProvider::GetAtlasPath(FileName);
+	const auto bWritten = FWaterSurfaceAtlas::Write(Path, Header, Samples);
+	Samples.Empty();
+	TexelPositions.Empty();
+
+	FWaterSurfaceAtlas Atlas;
+	if (!bWritten || !Atlas.Open(Path))
+	{
+		UE_LOG(LogTemp, Error, TEXT("WaterSurfaceAtlasBakerComponent could not write %s."), *Path);
+		return;
+	}
+
+	AtlasSizeInMegabytes = Atlas.GetSizeInBytes() / (1024.f * 1024.f);
+	FrameSizeInMegabytes = Atlas.GetFrameSizeInBytes() / (1024.f * 1024.f);
+	MeasureError(Atlas);
+
+	UE_LOG(LogTemp,
+	       Log,
+	       TEXT("Baked %s: %dx%d texels, %d frames, %.2f MB (%.3f MB per frame). Height error max %.2f, mean %.2f. ")
+	           TEXT("Displacement error max %.2f."),
+	       *Path,
+	       Header.Resolution,
+	       Header.Resolution,
+	       Header.FrameCount,
+	       AtlasSizeInMegabytes,
+	       FrameSizeInMegabytes,
+	       MaxHeightError,
+	       MeanHeightError,
+	       MaxDisplacementError);
+}
+
+void UWaterSurfaceAtlasBakerComponent::MeasureError(const FWaterSurfaceAtlas& Atlas)
+{
+	const auto& AtlasHeader = Atlas.GetHeader();
+	const auto bCanQueryAnyTime = Source->CanQueryAnyTime();
+	const auto CurrentTime = GetWorld()->GetTimeSeconds();
+
+	// Fixed seed, so bakes with different settings are compared on the same points.
+	FRandomStream Random{0x5EED};
+	MaxHeightError = 0.f;
+	MaxDisplacementError = 0.f;
+	auto TotalHeightError = 0.f;
+	const auto SampleCount = FMath::Max(1, ErrorSampleCount);
+	for (int32 i = 0; i < SampleCount; ++i)
+	{
+		// The tile and its neighbours, and the period and the ones around it, so the samples cross the seams.
+		const auto Alpha = FVector2D{Random.FRandRange(-1.f, 2.f), Random.FRandRange(-1.f, 2.f)};
+		const auto Position2D = AtlasHeader.Origin + Alpha * AtlasHeader.TileSize;
+		const auto Position = FVector{Position2D.X, Position2D.Y, 0.f};
+		const auto Time =
+		    bCanQueryAnyTime ? AtlasHeader.TimeOrigin + Random.FRandRange(-1.f, 2.f) * AtlasHeader.Period : CurrentTime;
+
+		const auto HeightError = FMath::Abs(Atlas.GetHeight(Position, Time) - Source->GetWaterHeight(Position, Time));
+		const auto DisplacementError =
+		    (Atlas.GetDisplacement(Position, Time) - Source->GetWaterDisplacement(Position, Time)).Size();
+		MaxHeightError = FMath::Max(MaxHeightError, HeightError);
+		MaxDisplacementError = FMath::Max(MaxDisplacementError, DisplacementError);
+		TotalHeightError += HeightError;
+	}
+	MeanHeightError = TotalHeightError / SampleCount;
+}
@@ -0,0 +1,133 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "WaterSurface/WaterSurfaceInverse.h"
+#include "WaterSurface/WaterSurfaceProvider.h"
+#include "BuoyancyStats.h"
+
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Water Inverse Points"), STAT_WaterInversePoints, STATGROUP_Buoyancy);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Water Inverse Evaluations"), STAT_WaterInverseEvaluations, STATGROUP_Buoyancy);
+
+static FVector2D Multiply(const FVector4& Matrix, const FVector2D& Vector)
+{
+	return FVector2D{Matrix.X * Vector.X + Matrix.Y * Vector.Y, Matrix.Z * Vector.X + Matrix.W * Vector.Y};
+}
+
+// Broyden's update of the inverse Jacobian after the rest point moved by RestStep and the residual by ResidualStep.
+static void UpdateInverseJacobian(FVector4& InverseJacobian, const FVector2D& RestStep, const FVector2D& ResidualStep)
+{
+	const auto PredictedStep = Multiply(InverseJacobian, ResidualStep);
+	const auto Denominator = RestStep | PredictedStep;
+	if (FMath::Abs(Denominator) < KINDA_SMALL_NUMBER) return;
+
+	// RestStep^T * InverseJacobian
+	const FVector2D Row{RestStep.X * InverseJacobian.X + RestStep.Y * InverseJacobian.Z,
+	                    RestStep.X * InverseJacobian.Y + RestStep.Y * InverseJacobian.W};
+	const auto Correction = (RestStep - PredictedStep) / Denominator;
+	InverseJacobian.X += Correction.X * Row.X;
+	InverseJacobian.Y += Correction.X * Row.Y;
+	InverseJacobian.Z += Correction.Y * Row.X;
+	InverseJacobian.W += Correction.Y * Row.Y;
+}
+
+// Iteration state of one point.
+struct FInversePoint
+{
+	FVector2D Target;
+	FVector2D Rest;
+	FVector2D PreviousRest;
+	FVector2D PreviousResidual;
+	bool bHasPrevious = false;
+
+	FInversePoint(const FVector& Position, const FWaterSurfaceInverseState& State)
+	    : Target{Position}, Rest{FVector2D{Position} - State.Displacement}
+	{
+	}
+
+	// Takes the displacement of the current rest point and returns true once it's close enough.
+	bool Step(const FVector& Displacement, float ToleranceSquared, FWaterSurfaceInverseState& State)
+	{
+		const auto Residual = Rest + FVector2D{Displacement} - Target;
+		if (bHasPrevious)
+		{
+			UpdateInverseJacobian(State.InverseJacobian, Rest - PreviousRest, Residual - PreviousResidual);
+		}
+		State.Displacement = FVector2D{Displacement};
+		if (Residual.SizeSquared() <= ToleranceSquared) return true;
+
+		PreviousRest = Rest;
+		PreviousResidual = Residual;
+		bHasPrevious = true;
+		Rest -= Multiply(State.InverseJacobian, Residual);
+		return false;
+	}
+};
+
+FVector FWaterSurfaceInverse::Solve(const IWaterSurfaceProvider& Surface,
+                                    const FVector& Position,
+                                    float Time,
+                                    float Tolerance,
+                                    int32 MaxIterations,
+                                    FWaterSurfaceInverseState& InOutState)
+{
+	INC_DWORD_STAT(STAT_WaterInversePoints);
+
+	FInversePoint Point{Position, InOutState};
+	FVector Displacement;
+	const auto IterationCount = FMath::Max(1, MaxIterations);
+	for (int32 Iteration = 0; Iteration < IterationCount; ++Iteration)
+	{
+		INC_DWORD_STAT(STAT_WaterInverseEvaluations);
+		Displacement = Surface.GetWaterDisplacement(FVector{Point.Rest.X, Point.Rest.Y, Position.Z}, Time);
+		if (Point.Step(Displacement, FMath::Square(Tolerance), InOutState)) break;
+	}
+	return Displacement;
+}
+
+void FWaterSurfaceInverse::SolveBatch(const IWaterSurfaceProvider& Surface,
+                                      TArrayView<const FVector> Positions,
+                                      float Time,
+                                      float Tolerance,
+                                      int32 MaxIterations,
+                                      TArrayView<FWaterSurfaceInverseState> InOutStates,
+                                      TArrayView<FVector> OutDisplacements)
+{
+	check(InOutStates.Num() == Positions.Num() && OutDisplacements.Num() == Positions.Num());
+	INC_DWORD_STAT_BY(STAT_WaterInversePoints, Positions.Num());
+
+	TArray<FInversePoint, TInlineAllocator<32>> Points;
+	TArray<int32, TInlineAllocator<32>> ActiveIndices;
+	for (int32 i = 0; i < Positions.Num(); ++i)
+	{
+		Points.Emplace(Positions[i], InOutStates[i]);
+		ActiveIndices.Add(i);
+	}
+
+	TArray<FVector, TInlineAllocator<32>> RestPositions;
+	TArray<FVector, TInlineAllocator<32>> Displacements;
+	const auto IterationCount = FMath::Max(1, MaxIterations);
+	for (int32 Iteration = 0; Iteration < IterationCount && ActiveIndices.Num() > 0; ++Iteration)
+	{
+		INC_DWORD_STAT_BY(STAT_WaterInverseEvaluations, ActiveIndices.Num());
+
+		RestPositions.Reset();
+		for (const auto Index : ActiveIndices)
+		{
+			RestPositions.Add(FVector{Points[Index].Rest.X, Points[Index].Rest.Y, Positions[Index].Z});
+		}
+		Displacements.SetNumUninitialized(ActiveIndices.Num());
+		Surface.GetWaterDisplacements(RestPositions, Time, Displacements);
+
+		// Walk backwards so converged points can be swapped out.
+		for (int32 i = ActiveIndices.Num() - 1; i >= 0; --i)
+		{
+			const auto Index = ActiveIndices[i];
+			OutDisplacements[Index] = Displacements[i];
+			if (Points[Index].Step(Displacements[i], FMath::Square(Tolerance), InOutStates[Index]))
+			{
+				ActiveIndices.RemoveAtSwap(i, 1, false);
+			}
+		}
+	}
+}
@@ -0,0 +1,77 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#include "WaterSurface/WaterSurfaceProvider.h"
+#include "WaterSurface/OceanManagerWaterSurfaceProvider.h"
+#include "OceanPlugin/Public/OceanManager.h"
+
+
+void FWaterSurfaceSnapshot::GetWaterHeights(TArrayView<const FVector> Positions,
+                                            float Time,
+                                            TArrayView<float> OutHeights) const
+{
+	check(OutHeights.Num() == Positions.Num());
+	for (int32 i = 0; i < Positions.Num(); ++i)
+	{
+		OutHeights[i] = GetWaterHeight(Positions[i], Time);
+	}
+}
+
+void IWaterSurfaceProvider::GetWaterHeights(TArrayView<const FVector> Positions,
+                                            float Time,
+                                            TArrayView<float> OutHeights) const
+{
+	check(OutHeights.Num() == Positions.Num());
+	for (int32 i = 0; i < Positions.Num(); ++i)
+	{
+		OutHeights[i] = GetWaterHeight(Positions[i], Time);
+	}
+}
+
+void IWaterSurfaceProvider::GetWaterDisplacements(TArrayView<const FVector> Positions,
+                                                  float Time,
+                                                  TArrayView<FVector> OutDisplacements) const
+{
+	check(OutDisplacements.Num() == Positions.Num());
+	for (int32 i = 0; i < Positions.Num(); ++i)
+	{
+		OutDisplacements[i] = GetWaterDisplacement(Positions[i], Time);
+	}
+}
+
+void IWaterSurfaceProvider::GetWaterVelocities(TArrayView<const FVector> Positions,
+                                               float Time,
+                                               TArrayView<FVector> OutVelocities) const
+{
+	check(OutVelocities.Num() == Positions.Num());
+	for (int32 i = 0; i < Positions.Num(); ++i)
+	{
+		OutVelocities[i] = GetWaterVelocity(Positions[i], Time);
+	}
+}
+
+IWaterSurfaceProvider* FWaterSurfaceProviders::Resolve(UObject*& InOutProviderObject,
+                                                       UObject* Outer,
+                                                       AOceanManager* OceanManager)
+{
+	if (const auto Adapter = Cast<UOceanManagerWaterSurfaceProvider>(InOutProviderObject))
+	{
+		if (!Adapter->OceanManager)
+		{
+			Adapter->OceanManager = OceanManager;
+		}
+		return Adapter;
+	}
+
+	if (const auto Provider = Cast<IWaterSurfaceProvider>(InOutProviderObject))
+	{
+		return Provider;
+	}
+
+	if (!IsValid(OceanManager)) return nullptr;
+
+	const auto Adapter = NewObject<UOceanManagerWaterSurfaceProvider>(Outer);
+	Adapter->OceanManager = OceanManager;
+	InOutProviderObject = Adapter;
+	return Adapter;
+}
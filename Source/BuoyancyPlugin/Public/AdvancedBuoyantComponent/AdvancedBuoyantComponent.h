@@ -5,6 +5,10 @@
 
 #include "CoreMinimal.h"
 #include "OceanPlugin/Public/OceanManager.h"
+#include "WaterSurface/WaterSurfaceProvider.h"
+#include "WaterSurface/WaterSurfaceInverse.h"
+#include "BuoyancySubsystem.h"
+#include "BuoyantMesh/CompactTriangleMesh.h"
 #include "AdvancedBuoyantComponent.generated.h"
 
 USTRUCT(BlueprintType)
@@ -80,7 +84,7 @@ struct FForceTriangle
 };
 
 UCLASS( ClassGroup=(Physics), meta=(BlueprintSpawnableComponent) )
-class BUOYANCYPLUGIN_API UAdvancedBuoyantComponent : public USceneComponent
+class BUOYANCYPLUGIN_API UAdvancedBuoyantComponent : public USceneComponent, public FBuoyantBody
 {
 	GENERATED_BODY()
 
@@ -89,8 +93,20 @@ public:
 	UAdvancedBuoyantComponent();
 
 	virtual void InitializeComponent() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void TickComponent( float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction ) override;
 
+	virtual bool GatherBuoyancy(float DeltaTime) override;
+	virtual void EvaluateBuoyancy() override;
+	virtual void ApplyBuoyancy() override;
+	// Adds its forces while evaluating them
+	virtual bool CanEvaluateBuoyancyInParallel() const override { return false; }
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+	// Memory of the hull, the water grid and the triangle buffers of this component, which GetResourceSizeEx reports.
+	SIZE_T GetBuoyancyAllocatedSize() const;
+
 	
 	// use drag when using advanced Buoyant (most likely will always be yes)
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Options")
@@ -102,6 +118,15 @@ public:
 	// World information
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "World Data")
 		AOceanManager* TheOcean = nullptr;
+	// Water surface the mesh floats on. If unassigned, TheOcean is used.
+	UPROPERTY(EditAnywhere, Instanced, BlueprintReadWrite, Category = "World Data", meta = (MustImplement = "WaterSurfaceProvider"))
+		UObject* WaterSurfaceProvider = nullptr;
+	// Account for the horizontal displacement of the waves when sampling the height grid, warm started from the last frame.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "World Data")
+		bool bAccurateWaterHeight = true;
+	// Horizontal error under which the accurate water height stops iterating.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "World Data", meta = (ClampMin = "0.01", EditCondition = "bAccurateWaterHeight"))
+		float WaterHeightTolerance = 1.f;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "World Data")
 		float WaterDensity = 1025.f;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "World Data")
@@ -119,6 +144,10 @@ public:
 private:
 
 	UWorld* World;
+	IWaterSurfaceProvider* WaterSurface = nullptr;
+	float WaterTime = 0.f;
+	// Warm starts of the accurate water height, one per grid point.
+	TArray<FWaterSurfaceInverseState> GridInverseStates;
 	float CorrectedMeshDensity;
 	float CorrectedWaterDensity;
 
@@ -134,6 +163,9 @@ public:
 		FTransform MeshTransform;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Advanced Buoyant|Mesh Data")
 		float FalseVolume = 0.f;
+	// Store the welded hull with 16 bit quantized positions and indices and packed normals, see FCompactTriangleMesh. Applied on initialization.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Advanced Buoyant|Mesh Data")
+		bool bUseCompactHull = false;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Advanced Buoyant|Coefficients")
 		float BuoyantReductionCoefficient = 0.f;
@@ -184,7 +216,23 @@ private:
 	float ForceC;      // result of multiplication used elsewhere that will not change
 	FVector MinBound;  // mesh bounds
 	FVector MaxBound;  // mesh bounds
-	TArray< TArray<FVector> > Triangles;  // an array of the triangles
+	TArray<FVector> HullVertices;  // welded local space vertices, shared between triangles
+	TArray<int32> HullIndices;  // three indices into HullVertices per triangle
+	FCompactTriangleMesh CompactHull;  // replaces HullVertices and HullIndices when bUseCompactHull is set
+	TArray<FBuoyantVertex> HullWorldVertices;  // world position and depth of each hull vertex, refreshed once per tick
 	void PopulateTrianglesFromStaticMesh();
+	void UpdateHullWorldVertices();
+
+	// Read the hull from whichever layout it is stored in
+	int32 GetHullTriangleCount() const;
+	int32 GetHullIndex(int32 Index) const;
+	FVector GetHullOutwardNormal(int32 TriIndex, const FVector& v0, const FVector& v1, const FVector& v2) const;
+
+	// Same as SplitTriangle without returning a copy of the two triangles, which are the last two of SubmergedTris
+	void AddSplitTriangles(const FBuoyantVertex& H, const FBuoyantVertex& M, const FBuoyantVertex& L, const FVector& OutArrow);
+	void DrawLastSplitTriangles(FColor DebugColor);
+
+	// Depth of a world position whose local space position is already known, avoids the inverse transform.
+	float GetOceanDepthFromLocalPosition(const FVector& LocalPosition, float WorldZ) const;
 	
 };
@@ -0,0 +1,172 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+#include "BuoyancySubsystem.generated.h"
+
+
+class UActorComponent;
+class UBuoyancySubsystem;
+struct FBodyInstance;
+
+// Rigid body state read on the game thread, so velocities can be evaluated from any thread.
+struct BUOYANCYPLUGIN_API FBuoyantBodyState
+{
+	FVector CenterOfMass = FVector::ZeroVector;
+	FVector LinearVelocity = FVector::ZeroVector;
+	// In radians per second.
+	FVector AngularVelocity = FVector::ZeroVector;
+	float Mass = 0.f;
+	FQuat Rotation = FQuat::Identity;
+	// Principal moments of inertia along the body axes, in kg uu^2.
+	FVector Inertia = FVector::ZeroVector;
+
+	// Zero if the body instance isn't valid.
+	static FBuoyantBodyState FromBodyInstance(const FBodyInstance* BodyInstance);
+
+	// Same as FBodyInstance::GetUnrealWorldVelocityAtPoint at the time of the read.
+	FVector GetVelocityAtPoint(const FVector& Point) const
+	{
+		return LinearVelocity + FVector::CrossProduct(AngularVelocity, Point - CenterOfMass);
+	}
+
+	// Moment of inertia about a world space axis through the center of mass. Assumes the principal axes of the
+	// body are its own axes.
+	float GetInertiaAboutAxis(const FVector& Axis) const
+	{
+		const auto LocalAxis = Rotation.UnrotateVector(Axis);
+		return Inertia | (LocalAxis * LocalAxis);
+	}
+};
+
+/*
+
+A buoyant component whose update is split in three phases, so UBuoyancySubsystem can update many of them at once.
+
+Gather reads everything the update needs from physics, the world and other components on the game thread. Evaluate
+computes the forces from that alone and may run on any thread, concurrently with the evaluation of other bodies. Apply
+writes the forces back on the game thread. A component not registered with the subsystem runs the three phases in a row
+from its own tick.
+
+*/
+
+class BUOYANCYPLUGIN_API FBuoyantBody
+{
+   public:
+	virtual ~FBuoyantBody() = default;
+
+	// Returns false to skip Evaluate and Apply this frame.
+	virtual bool GatherBuoyancy(float DeltaTime) = 0;
+	virtual void EvaluateBuoyancy() = 0;
+	virtual void ApplyBuoyancy() = 0;
+
+	// False if Evaluate has to run on the game thread, e.g. while debug drawing, or when it queries objects that other
+	// bodies may be querying too and that aren't thread safe, like a water heightmap.
+	virtual bool CanEvaluateBuoyancyInParallel() const
+	{
+		return true;
+	}
+
+	// Whether Evaluate may spread its own work over more threads, with a ParallelFor over its points. False while
+	// buoyancy.MaxEvaluationTasks caps the threads evaluating the bodies.
+	static bool CanEvaluateBuoyancyWithNestedTasks();
+
+	// Registers the component with the subsystem of its world if buoyancy.UseSubsystem is set.
+	// Returns true if it was, the component should then stop ticking on its own.
+	bool RegisterWithBuoyancySubsystem(UActorComponent* Component);
+	void UnregisterFromBuoyancySubsystem();
+
+	bool IsRegisteredWithBuoyancySubsystem() const
+	{
+		return Subsystem != nullptr;
+	}
+
+	// Makes the subsystem update wait for a tick function, when registered. Used for the water heightmaps.
+	void AddBuoyancyPrerequisite(UObject* TargetObject, FTickFunction& TargetTickFunction);
+
+   private:
+	UBuoyancySubsystem* Subsystem = nullptr;
+};
+
+// Updates the bodies of a UBuoyancySubsystem.
+USTRUCT()
+struct FBuoyancySubsystemTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UBuoyancySubsystem* Target = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime,
+	                         ELevelTick TickType,
+	                         ENamedThreads::Type CurrentThread,
+	                         const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template <>
+struct TStructOpsTypeTraits<FBuoyancySubsystemTickFunction>
+    : public TStructOpsTypeTraitsBase2<FBuoyancySubsystemTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/*
+
+Updates every registered buoyant body of the world from a single tick function in TG_PrePhysics, instead of one tick per
+component.
+
+All bodies are gathered on the game thread, evaluated in parallel on the task graph workers, then applied in
+registration order. Bodies that can't be evaluated in parallel are evaluated on the game thread while the workers
+evaluate the others. buoyancy.MaxEvaluationTasks caps the number of threads evaluating at once.
+
+Enabled with buoyancy.UseSubsystem, which is read when the components begin play. It is off by default: the forces of
+the registered components are applied together before physics instead of from their own ticks, which changes the order
+they are applied in relative to other ticking code.
+
+*/
+
+UCLASS()
+class BUOYANCYPLUGIN_API UBuoyancySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+   public:
+	virtual void Deinitialize() override;
+
+	void Register(FBuoyantBody* Body, UActorComponent* Component);
+	void Unregister(FBuoyantBody* Body);
+	void AddPrerequisite(UObject* TargetObject, FTickFunction& TargetTickFunction);
+
+	void Update(float DeltaTime);
+
+	int32 GetBodyCount() const;
+	// Bodies that were evaluated on the game thread in the last update, see FBuoyantBody::CanEvaluateBuoyancyInParallel.
+	int32 GetLastGameThreadBodyCount() const;
+	// Wall time of the last update, gather to apply.
+	double GetLastUpdateSeconds() const;
+
+   private:
+	struct FRegisteredBody
+	{
+		FBuoyantBody* Body;
+		TWeakObjectPtr<UActorComponent> Component;
+		// Unreal Insights event named after the component, registered on its first traced update.
+		uint32 TraceEventType = 0;
+	};
+
+	TArray<FRegisteredBody> Bodies;
+	FBuoyancySubsystemTickFunction TickFunction;
+	double LastUpdateSeconds = 0.0;
+
+	// Scratch lists of the bodies gathered this frame, kept to avoid reallocating every tick.
+	TArray<int32> GatheredBodies;
+	TArray<int32> ParallelBodies;
+	TArray<int32> GameThreadBodies;
+};
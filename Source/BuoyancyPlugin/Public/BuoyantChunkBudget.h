@@ -0,0 +1,36 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+class UWorld;
+
+/*
+
+Global budget of fully evaluated buoyant destructible chunks, set per world with buoyancy.MaxActiveChunks.
+
+Components ask for the chunks they would like to evaluate every frame. The budget is shared in proportion to what every
+component of the world asked for on the previous frame, so the components don't depend on their tick order. A fracture
+can go over the budget for the frame it happens on.
+
+*/
+
+class BUOYANCYPLUGIN_API FBuoyantChunkBudget
+{
+   public:
+	// Returns how many of the Demand chunks the caller may evaluate in full this frame.
+	static int32 Request(const UWorld* World, int32 Demand);
+
+   private:
+	struct FWorldBudget
+	{
+		uint64 Frame = 0;
+		int32 Demand = 0;
+		int32 PreviousDemand = 0;
+	};
+
+	static TMap<TWeakObjectPtr<const UWorld>, FWorldBudget> WorldBudgets;
+};
@@ -7,15 +7,17 @@
 #include "GameFramework/MovementComponent.h"
 #include "PhysicsEngine/PhysicsConstraintComponent.h"
 #include "OceanPlugin/Public/OceanManager.h"
+#include "WaterSurface/WaterSurfaceProvider.h"
+#include "BuoyancySubsystem.h"
 #include "BuoyantComponent.generated.h"
 
 
 /**
  *	Buoyant component
- *	OceanManager is required in the level for this to work.
+ *	Needs a water surface provider, or an OceanManager in the level.
  */
 UCLASS(ClassGroup = Movement, meta = (BlueprintSpawnableComponent), HideCategories = (PlanarMovement, "Components|Movement|Planar", Velocity))
-class BUOYANCYPLUGIN_API UBuoyantComponent : public UMovementComponent
+class BUOYANCYPLUGIN_API UBuoyantComponent : public UMovementComponent, public FBuoyantBody
 {
 	GENERATED_BODY()
 
@@ -23,12 +25,26 @@ public:
 	UBuoyantComponent(const class FObjectInitializer& ObjectInitializer);
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 	virtual void InitializeComponent() override;
 
+	virtual bool GatherBuoyancy(float DeltaTime) override;
+	virtual void EvaluateBuoyancy() override;
+	virtual void ApplyBuoyancy() override;
+	virtual bool CanEvaluateBuoyancyInParallel() const override;
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+	// Memory of the test points and their buffers, which GetResourceSizeEx reports.
+	SIZE_T GetBuoyancyAllocatedSize() const;
+
 	/* OceanManager used by the component, if unassigned component will auto-detect */
 	UPROPERTY(EditAnywhere, AdvancedDisplay, BlueprintReadWrite, Category = "Buoyant Settings")
 	AOceanManager* OceanManager;
+
+	/* Water surface the component floats on. If unassigned, the OceanManager is used. */
+	UPROPERTY(EditAnywhere, Instanced, BlueprintReadWrite, Category = "Buoyant Settings", meta = (MustImplement = "WaterSurfaceProvider"))
+	UObject* WaterSurfaceProvider = nullptr;
 	
 	/* Density of mesh. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings")
@@ -103,4 +119,18 @@ protected:
 	static FVector GetVelocityAtPoint(UPrimitiveComponent* Target, FVector Point, FName BoneName = NAME_None);
 
 	void ApplyUprightConstraint();
+
+private:
+	/* Gathered for the evaluation */
+	FTransform GatheredTransform;
+	FBuoyantBodyState GatheredBody;
+	float GatheredGravityZ;
+	const IWaterSurfaceProvider* GatheredWaterSurface = nullptr;
+	float GatheredWaterTime;
+
+	/* Evaluated forces, one per test point */
+	TArray<FVector> PointPositions;
+	TArray<FVector> PointForces;
+	TArray<bool> PointUnderwaterFlags;
+	int32 PointsUnderWaterCount;
 };
@@ -5,12 +5,21 @@
 
 #include "CoreMinimal.h"
 #include "OceanPlugin/Public/OceanManager.h"
+#include "WaterSurface/WaterSurfaceProvider.h"
 #include "DestructibleComponent.h"
+#include "BuoyancySubsystem.h"
 #include "BuoyantDestructibleComponent.generated.h"
 
+#if WITH_PHYSX
+namespace physx
+{
+	class PxRigidDynamic;
+	class PxScene;
+}
+#endif // WITH_PHYSX
 
 UCLASS(ClassGroup = Physics, hidecategories = (Object, Mesh, "Components|SkinnedMesh", Mirroring, Activation, "Components|Activation"), config = Engine, editinlinenew, meta = (BlueprintSpawnableComponent))
-class BUOYANCYPLUGIN_API UBuoyantDestructibleComponent : public UDestructibleComponent
+class BUOYANCYPLUGIN_API UBuoyantDestructibleComponent : public UDestructibleComponent, public FBuoyantBody
 {
 	GENERATED_BODY()
 
@@ -18,18 +27,120 @@ public:
 	UBuoyantDestructibleComponent(const class FObjectInitializer& ObjectInitializer);
  
 protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
 	virtual void InitializeComponent() override;
 
+public:
+	virtual bool GatherBuoyancy(float DeltaTime) override;
+	virtual void EvaluateBuoyancy() override;
+	virtual void ApplyBuoyancy() override;
+	virtual bool CanEvaluateBuoyancyInParallel() const override;
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+	//Memory of the chunk states and their buffers, which GetResourceSizeEx reports.
+	SIZE_T GetBuoyancyAllocatedSize() const;
+
+	/* Makes the frozen chunks dynamic again. Called on every fracture of the component. */
+	UFUNCTION(BlueprintCallable, Category = "Chunk Budget")
+	void WakeChunks();
+
 private:
+	UFUNCTION()
+	void HandleFracture(const FVector& HitPoint, const FVector& HitDirection);
+
 	float _SignedRadius;
 	float _baseAngularDamping;
 	float _baseLinearDamping;
+
+	//Gathered for the evaluation.
+	IWaterSurfaceProvider* WaterSurface;
+	float WaterTime;
+	float GatheredGravity;
+	float GatheredDeltaTime;
+
+#if WITH_PHYSX
+	//How much of the buoyancy a chunk gets.
+	enum class EChunkTier : uint8
+	{
+		//Full buoyancy.
+		Active,
+		//Below SmallChunkSize, samples the water every SmallChunkUpdateInterval ticks and has no wave push.
+		Simplified,
+		//Settled, kinematic and following the water surface.
+		Frozen,
+		//Beyond the budget or CullDistance, not evaluated at all. Stays dynamic, and sleeps once at rest.
+		Culled,
+	};
+
+	//What was last written to the actor of a chunk, indexed by chunk index.
+	struct FChunkState
+	{
+		physx::PxRigidDynamic* Actor = nullptr;
+		//Thresholds written with the current settings.
+		bool bPropertiesWritten = false;
+		bool bUnderwater = false;
+		bool bKinematic = false;
+		EChunkTier Tier = EChunkTier::Active;
+		//Time spent floating below the settle speeds.
+		float SettledTime = 0.f;
+		//Height of the center of mass above the water when frozen.
+		float FrozenHeightAboveWater = 0.f;
+		float LastWaterHeight = 0.f;
+		int32 TicksSinceWaterSample = 0;
+	};
+
+	//What a visible chunk reads from physics this tick, and what it has to write back.
+	struct FChunkEvaluation
+	{
+		physx::PxRigidDynamic* Actor;
+		int32 ChunkIndex;
+		EChunkTier Tier;
+		FVector Location;
+		FVector Velocity;
+		float AngularSpeed;
+		float Mass;
+		bool bSmall;
+		float DistanceSquared;
+		bool bSampleWater;
+		float WaterHeight;
+		bool bUnderwater;
+		FVector Force;
+		bool bClampVelocity;
+		FVector ClampedVelocity;
+	};
+
+	TArray<FChunkState> ChunkStates;
+
+	//Scene of the chunks gathered this tick.
+	physx::PxScene* PScene;
+
+	//Settings the chunk actors were last written with, changing one rewrites all of them.
+	float AppliedSleepThreshold;
+	float AppliedStabilizationThreshold;
+	float AppliedLinearDamping;
+	float AppliedAngularDamping;
+
+	//Scratch buffers of the visible chunks, kept to avoid reallocating every tick.
+	TArray<FChunkEvaluation> ChunkEvaluations;
+	TArray<int32> BudgetedChunks;
+	TArray<int32> SampledChunks;
+	TArray<FVector> ChunkLocations;
+	TArray<float> ChunkWaterHeights;
+
+	//Picks the tier of every visible chunk from its state, its size, the viewers and the budget.
+	void UpdateChunkTiers(bool bHasViewers);
+#endif // WITH_PHYSX
  
 public:
 	UPROPERTY(EditAnywhere, AdvancedDisplay, BlueprintReadWrite, Category = "Buoyant Settings")
 	AOceanManager* OceanManager;
 
+	/* Water surface the chunks float on. If unassigned, the OceanManager is used. */
+	UPROPERTY(EditAnywhere, Instanced, BlueprintReadWrite, Category = "Buoyant Settings", meta = (MustImplement = "WaterSurfaceProvider"))
+	UObject* WaterSurfaceProvider;
+
 	/* Density of each chunk */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings")
 	float ChunkDensity;
@@ -81,5 +192,53 @@ public:
 	*/
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Advanced")
 	float ChunkStabilizationThreshold;
+
+	/* Most chunks of this component that get full or simplified buoyancy, the nearest to the viewers first. 0 for no limit. The global budget is set with buoyancy.MaxActiveChunks. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk Budget", meta = (ClampMin = "0"))
+	int32 MaxActiveChunks;
+
+	/* Chunks farther than this from every viewer are culled. 0 to never cull by distance. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk Budget", meta = (ClampMin = "0"))
+	float CullDistance;
+
+	/* Chunks whose largest bounds extent is below this get simplified buoyancy. 0 to disable. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk Budget", meta = (ClampMin = "0"))
+	float SmallChunkSize;
+
+	/* Ticks between two water samples of a chunk with simplified buoyancy. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk Budget", meta = (ClampMin = "1"))
+	int32 SmallChunkUpdateInterval;
+
+	/* Freeze the chunks that have settled on the water, they become kinematic and follow the water surface. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk Budget")
+	bool FreezeSettledChunks;
+
+	/* A floating chunk slower than this has settled. A culled chunk slower than this is put to sleep. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk Budget")
+	float SettleLinearSpeed;
+
+	/* A floating chunk turning slower than this (radians per second) has settled. A culled chunk turning slower than this is put to sleep. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk Budget")
+	float SettleAngularSpeed;
+
+	/* Time a chunk has to stay settled before it's frozen. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Chunk Budget", meta = (EditCondition = "FreezeSettledChunks"))
+	float SettleTime;
+
+	/* Chunks with full buoyancy last tick. */
+	UPROPERTY(BlueprintReadOnly, Category = "Chunk Budget")
+	int32 ActiveChunkCount;
+
+	/* Chunks with simplified buoyancy last tick. */
+	UPROPERTY(BlueprintReadOnly, Category = "Chunk Budget")
+	int32 SimplifiedChunkCount;
+
+	/* Chunks frozen on the water surface last tick. */
+	UPROPERTY(BlueprintReadOnly, Category = "Chunk Budget")
+	int32 FrozenChunkCount;
+
+	/* Chunks culled last tick. */
+	UPROPERTY(BlueprintReadOnly, Category = "Chunk Budget")
+	int32 CulledChunkCount;
  
 };
@@ -5,10 +5,17 @@
 
 #include "CoreMinimal.h"
 #include "OceanPlugin/Public/OceanManager.h"
+#include "WaterSurface/WaterSurfaceProvider.h"
+#include "WaterSurface/WaterSurfaceInverse.h"
+#include "BuoyancySubsystem.h"
+#include "BuoyantStiffness.h"
 #include <Components/SceneComponent.h>
 #include "BuoyantForceComponent.generated.h"
 
 
+class USkeletalMeshComponent;
+struct FBodyInstance;
+
 //Custom bone density/radius override struct.
 USTRUCT(BlueprintType)
 struct BUOYANCYPLUGIN_API FStructBoneOverride
@@ -34,23 +41,46 @@ struct BUOYANCYPLUGIN_API FStructBoneOverride
 
 /** 
  *	Applies Buoyant forces to physics objects.
- *	OceanManager is required in the level for this to work.
+ *	Needs a water surface provider, or an OceanManager in the level.
  */
 UCLASS(hidecategories=(Object, Mobility, LOD), ClassGroup=Physics, showcategories=Trigger, MinimalAPI, meta=(BlueprintSpawnableComponent))
-class UBuoyantForceComponent : public USceneComponent
+class UBuoyantForceComponent : public USceneComponent, public FBuoyantBody
 {
 	GENERATED_BODY()
 
 public:
 	UBuoyantForceComponent(const class FObjectInitializer& ObjectInitializer);
 
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 	virtual void InitializeComponent() override;
 
+	virtual bool GatherBuoyancy(float DeltaTime) override;
+	virtual void EvaluateBuoyancy() override;
+	virtual void ApplyBuoyancy() override;
+	virtual bool CanEvaluateBuoyancyInParallel() const override;
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+	//Memory of the test points, the bone table and their buffers, which GetResourceSizeEx reports.
+	SIZE_T GetBuoyancyAllocatedSize() const;
+
+	/**
+	* Rebuilds the table of buoyant bones on the next tick.
+	* The table follows the skeletal mesh, its bodies, MeshDensity, TestPointRadius and the size of BoneOverride on its own,
+	* call this after editing an existing BoneOverride entry at runtime.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Buoyant Settings")
+	void RebuildBoneTable();
+
 
 	/* OceanManager used by the component, if unassigned component will auto-detect */
 	UPROPERTY(EditAnywhere, AdvancedDisplay, BlueprintReadWrite, Category = "Buoyant Settings")
 	AOceanManager* OceanManager;
+
+	/* Water surface the component floats on. If unassigned, the OceanManager is used. */
+	UPROPERTY(EditAnywhere, Instanced, BlueprintReadWrite, Category = "Buoyant Settings", meta = (MustImplement = "WaterSurfaceProvider"))
+	UObject* WaterSurfaceProvider;
 	
 	/* Density of mesh. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings")
@@ -77,6 +107,13 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings")
 	float MaxUnderwaterVelocity;
 
+	/**
+	* Integrate heave, roll and pitch semi-implicitly from the stiffness and damping of the buoyancy points, see FBuoyantStiffness.
+	* Keeps light bodies stable at low frame rates and with long physics steps. Bones only get the heave correction.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings")
+	bool SemiImplicitBuoyancy;
+
 	/* Radius of the points. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings", meta = (DisplayName = "Buoyancy Point Radius"))
 	float TestPointRadius;
@@ -98,12 +135,20 @@ public:
 	bool SnapToSurfaceIfNoPhysics;
 
 	/**
-	* More accurate gerstner wave height calculations by accounting for the x/y displacement.
-	* Keep in mind that this effectively doubles the gerstner calculations per test point.
-	* Use only if accurate height readback is needed.
+	* More accurate wave height by accounting for the x/y displacement of the waves.
+	* Solves for the surface point that ends up above each point, starting from last frame's solution,
+	* so it usually costs a single displacement query per point.
 	*/
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings")
-	bool TwoGerstnerIterations;
+	bool AccurateWaterHeight;
+
+	/* Horizontal error under which the accurate wave height stops iterating. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Buoyant Settings", meta = (ClampMin = "0.01", EditCondition = "AccurateWaterHeight"))
+	float WaterHeightTolerance;
+
+	/* Most displacement queries per point for the accurate wave height, reached only when the waves change abruptly. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Buoyant Settings", meta = (ClampMin = "1", EditCondition = "AccurateWaterHeight"))
+	int32 MaxWaterHeightIterations;
 
 	/* Per-point mesh density override, can be used for half-sinking objects etc. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Buoyant Settings")
@@ -142,17 +187,93 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Buoyant Settings")
 	float WaveForceMultiplier;
 
+	/* Ignored while the component is updated by the buoyancy subsystem, which ticks in TG_PrePhysics. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Buoyant Settings")
 	TEnumAsByte<enum ETickingGroup> TickGroup;
 
 private:
 
+	// A physics body of the skeletal mesh, with its overrides resolved.
+	struct FBuoyantBone
+	{
+		FBodyInstance* BodyInstance;
+		int32 BodyIndex;
+		float Density;
+		float TestRadius;
+		float Mass;
+	};
+
+	// What a bone reads from physics this tick, and what it has to apply back.
+	struct FBoneEvaluation
+	{
+		int32 BoneIndex;
+		FVector Velocity;
+		FVector AngularVelocity;
+		bool bUnderwater;
+		FVector Force;
+		FVector LinearVelocityChange;
+		FVector AngularVelocityChange;
+		bool bClampVelocity;
+		FVector ClampedVelocity;
+	};
+
+	TArray<FBuoyantBone> BoneTable;
+	TWeakObjectPtr<USkeletalMeshComponent> BoneTableMesh;
+	int32 BoneTableBodyCount;
+	int32 BoneTableOverrideCount;
+	float BoneTableMeshDensity;
+	float BoneTableTestPointRadius;
+	bool bBoneTableDirty;
+
+	// Scratch buffers of the active bones, kept to avoid reallocating every tick.
+	TArray<FBoneEvaluation> BoneEvaluations;
+	TArray<FVector> BonePositions;
+	TArray<FVector> BoneWaterDisplacements;
+	TArray<float> BoneWaterHeights;
+	TArray<FWaterSurfaceInverseState> ActiveBoneInverseStates;
+
+	bool IsBoneTableValid(USkeletalMeshComponent* SkeletalComp) const;
+	void BuildBoneTable(USkeletalMeshComponent* SkeletalComp);
+	//Read on the game thread, evaluated on any thread, applied on the game thread. See FBuoyantBody.
+	bool GatherBoneStates(USkeletalMeshComponent* SkeletalComp);
+	void EvaluateBoneForces(const FVector2D& WaveDirection);
+	void ApplyBoneForces();
+
 	static FVector GetUnrealVelocityAtPoint(UPrimitiveComponent* Target, FVector Point, FName BoneName = NAME_None);
 	void ApplyUprightConstraint(UPrimitiveComponent* BasePrimComp);
+	// Water height in Z, and the horizontal displacement in X/Y if bWithDisplacement.
+	FVector GetWaterAt(const FVector& Position, bool bWithDisplacement, FWaterSurfaceInverseState& InverseState) const;
 
 	float _baseAngularDamping;
 	float _baseLinearDamping;
 
 	UWorld* World;
+
+	IWaterSurfaceProvider* WaterSurface;
+	float WaterTime;
+
+	//Gathered for the evaluation.
+	TWeakObjectPtr<UPrimitiveComponent> GatheredPrimComp;
+	FTransform GatheredTransform;
+	FBuoyantBodyState GatheredBody;
+	float GatheredGravity;
+	float GatheredDeltaTime;
+	bool bGatheredGravityEnabled;
+	bool bGatheredBones;
+
+	//Linearized with the point forces, and applied at the center of mass on top of them.
+	FBuoyantStiffness Stiffness;
+	FVector SemiImplicitForce;
+	FVector SemiImplicitTorque;
+
+	//Evaluated forces, one per test point.
+	TArray<FVector> PointPositions;
+	TArray<FVector> PointForces;
+	TArray<bool> PointUnderwaterFlags;
+
+	// Warm starts of the accurate wave height. Same layout as TestPoints and BoneTable.
+	TArray<FWaterSurfaceInverseState> TestPointInverseStates;
+	TArray<FWaterSurfaceInverseState> BoneInverseStates;
+	FWaterSurfaceInverseState SnapInverseState;
 	
 };
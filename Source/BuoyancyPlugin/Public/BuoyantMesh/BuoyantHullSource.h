@@ -0,0 +1,21 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BuoyantHullSource.generated.h"
+
+
+// Which collision of the body setup the buoyancy hull is built from.
+UENUM(BlueprintType)
+enum class EBuoyantHullSource : uint8
+{
+	// The complex collision mesh, or the simple collision convex elements when there is none.
+	Automatic,
+	// The complex collision mesh only.
+	ComplexCollision,
+	// The cooked hulls of the simple collision convex elements only. Each element is a closed hull of its own, so
+	// overlapping elements count the shared volume twice.
+	SimpleCollision
+};
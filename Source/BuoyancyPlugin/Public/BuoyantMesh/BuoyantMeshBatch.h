@@ -0,0 +1,89 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+struct FBuoyantMeshVertex;
+struct FBuoyantBodyState;
+
+// What the subtriangle forces of a FBuoyantMeshBatch depend on besides the triangles.
+struct FBuoyantMeshForceSettings
+{
+	float WaterDensity = 0.f;
+	float GravityMagnitude = 0.f;
+	bool bStaticForces = false;
+	bool bDynamicForces = false;
+};
+
+/*
+
+Triangles of a buoyant mesh stored as a structure of arrays, so they can be clipped against the water and have their
+forces evaluated in one call instead of one triangle at a time.
+
+Each triangle gets two subtriangle slots, 2 * I and 2 * I + 1, matching the up to two subtriangles
+FBuoyantMeshTriangle::GetSubmergedPortion cuts it into. Unused slots have a zero area and a zero force.
+
+The kernels are written in ISPC and selected at runtime with buoyancy.ISPC when the build supports it. The scalar path
+is built on FBuoyantMeshTriangle and FBuoyantMeshSubtriangle, and is the reference for the ISPC one:
+buoyancy.ISPC.Validate runs both and logs the slots that differ.
+
+*/
+
+class BUOYANCYPLUGIN_API FBuoyantMeshBatch
+{
+   public:
+	static bool IsUsingISPC();
+
+	void Reset();
+	void AddTriangle(const FBuoyantMeshVertex& A, const FBuoyantMeshVertex& B, const FBuoyantMeshVertex& C);
+	int32 GetTriangleCount() const;
+
+	// Cuts the submerged part of every triangle into subtriangles and integrates the submerged volume with tetrahedra
+	// from VolumeApex, see UBuoyantMeshComponent. Returns the number of subtriangles.
+	int32 Clip(const FVector& VolumeApex, float& OutVolume, FVector& OutVolumeMoment);
+
+	// Two slots per triangle, valid after Clip.
+	TArrayView<const FVector> GetSubtriangleCenters() const;
+	TArrayView<const float> GetSubtriangleAreas() const;
+	// Normal of the triangle the slot was cut from, valid after Clip.
+	FVector GetSubtriangleNormal(int32 Slot) const;
+
+	// Hydrostatic and hydrodynamic forces on the subtriangles, applied at their centers. CenterHeights are the heights
+	// above water of the centers and are only read for the static forces.
+	void EvaluateForces(TArrayView<const float> CenterHeights,
+	                    const FBuoyantMeshForceSettings& Settings,
+	                    const FBuoyantBodyState& Body);
+
+	// Two slots per triangle, valid after EvaluateForces.
+	TArrayView<const FVector> GetSubtriangleForces() const;
+
+	SIZE_T GetAllocatedSize() const;
+
+   private:
+	// Corners, in the order they were added.
+	TArray<float> AX, AY, AZ, AHeight;
+	TArray<float> BX, BY, BZ, BHeight;
+	TArray<float> CX, CY, CZ, CHeight;
+
+	// One normal per triangle.
+	TArray<float> NormalX, NormalY, NormalZ;
+	// One entry per slot.
+	TArray<FVector> SubtriangleCenters;
+	TArray<float> SubtriangleAreas;
+	TArray<FVector> SubtriangleForces;
+
+	int32 ClipScalar(const FVector& VolumeApex, float& OutVolume, FVector& OutVolumeMoment);
+	void EvaluateForcesScalar(TArrayView<const float> CenterHeights,
+	                          const FBuoyantMeshForceSettings& Settings,
+	                          const FBuoyantBodyState& Body);
+
+#if INTEL_ISPC
+	int32 ClipISPC(const FVector& VolumeApex, float& OutVolume, FVector& OutVolumeMoment);
+	void EvaluateForcesISPC(TArrayView<const float> CenterHeights,
+	                        const FBuoyantMeshForceSettings& Settings,
+	                        const FBuoyantBodyState& Body);
+#endif
+};
@@ -6,6 +6,14 @@
 #include "CoreMinimal.h"
 #include "Components/StaticMeshComponent.h"
 #include "PhysXIncludes.h"
+#include "WaterSurface/WaterSurfaceInverse.h"
+#include "BuoyancySubsystem.h"
+#include "BuoyantStiffness.h"
+#include "BuoyantMesh/BuoyantMeshBatch.h"
+#include "BuoyantMesh/BuoyantMeshVertex.h"
+#include "BuoyantMesh/CompactTriangleMesh.h"
+#include "BuoyantMesh/BuoyantHullSource.h"
+#include "BuoyantMesh/BuoyantPrimitive.h"
 #include "BuoyantMeshComponent.generated.h"
 
 
@@ -13,7 +21,10 @@ struct BuoyantMeshVertex;
 struct FBuoyantMeshTriangle;
 struct FBuoyantMeshSubtriangle;
 class AOceanManager;
+class IWaterSurfaceProvider;
 class UWaterHeightmapComponent;
+class UHydrostaticTable;
+class UBodySetup;
 
 struct FTriangleMesh
 {
@@ -26,6 +37,43 @@ struct FTriangleMesh
 	}
 };
 
+// A group of consecutive, spatially close triangles of a FTriangleMesh.
+// Whole clusters are skipped or take a fast path when they are entirely above or below the water.
+struct FBuoyantMeshCluster
+{
+	// Bounds of the cluster vertices in mesh space.
+	FBox LocalBounds;
+	int32 FirstTriangle;
+	int32 TriangleCount;
+
+	FBuoyantMeshCluster(const FBox& LocalBounds, int32 FirstTriangle, int32 TriangleCount)
+	    : LocalBounds{LocalBounds}, FirstTriangle{FirstTriangle}, TriangleCount{TriangleCount}
+	{
+	}
+};
+
+// Position of a cluster relative to the water surface.
+enum class EBuoyantClusterState : uint8
+{
+	// Entirely above the highest possible water, no forces.
+	Dry,
+	// Entirely below the lowest possible water, the triangles don't need clipping.
+	Wet,
+	// Possibly crossing the waterline, the triangles are clipped.
+	Crossing
+};
+
+// How the hydrostatic (buoyant) forces are evaluated.
+UENUM(BlueprintType)
+enum class EHydrostaticForceMode : uint8
+{
+	// Sample the water pressure at the center of every submerged subtriangle.
+	Pressure,
+	// Integrate the submerged volume of the clipped hull and apply a single buoyant force at its centroid.
+	// Exact for closed meshes and needs no water query per subtriangle.
+	Volume
+};
+
 /*
 
 This component applies to the root component Buoyant forces modeled from a static mesh.
@@ -38,7 +86,7 @@ In addition, support for dynamic (drag) forces is included.
 */
 
 UCLASS(ClassGroup = Physics, config = Engine, editinlinenew, meta = (BlueprintSpawnableComponent))
-class BUOYANCYPLUGIN_API UBuoyantMeshComponent : public UStaticMeshComponent
+class BUOYANCYPLUGIN_API UBuoyantMeshComponent : public UStaticMeshComponent, public FBuoyantBody
 {
 	GENERATED_BODY()
 
@@ -67,10 +115,108 @@ class BUOYANCYPLUGIN_API UBuoyantMeshComponent : public UStaticMeshComponent
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings")
 	bool bUseDynamicForces = true;
 
+	// How the hydrostatic forces are computed. Volume mode requires a closed mesh.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings")
+	EHydrostaticForceMode HydrostaticForceMode = EHydrostaticForceMode::Pressure;
+
+	// Integrate heave, roll and pitch semi-implicitly from the linearized hydrostatic stiffness and drag damping of
+	// the mesh, see FBuoyantStiffness. Keeps light bodies stable at low frame rates and with long physics steps.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings")
+	bool bSemiImplicitBuoyancy = false;
+
+	// Baked hydrostatics of this mesh, used instead of the triangles when the mesh is far from every viewer.
+	// Only hydrostatic forces are applied while the table is in use.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings|Hydrostatic Table")
+	UHydrostaticTable* HydrostaticTable = nullptr;
+
+	// Distance to the nearest viewer above which the hydrostatic table is used. Zero always uses it.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings|Hydrostatic Table", meta = (ClampMin = "0"))
+	float HydrostaticTableDistance = 20000.f;
+
+	// Collision the hull is built from. Simple collision convex elements are usually much lighter than the complex
+	// collision mesh. Changes are applied on initialization.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings")
+	EBuoyantHullSource HullSource = EBuoyantHullSource::Automatic;
+
+	// Float on the sphere, box and capsule elements of the simple collision, integrated in closed form against a water
+	// plane fitted under each of them, instead of the hull triangles. Only used when the body has such elements, and
+	// then the convex elements and the complex collision are ignored. Changes are applied on initialization.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings|Primitives")
+	bool bUseAnalyticPrimitives = false;
+
+	// Quadratic drag coefficient of the primitives, applied to the cross section of a sphere of their submerged volume.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings|Primitives", meta = (ClampMin = "0", EditCondition = "bUseAnalyticPrimitives"))
+	float PrimitiveDragCoefficient = 0.5f;
+
+	// Sample the water on a small grid under the mesh and clip the hull against the least squares plane through the
+	// samples, instead of querying the water at every vertex. Meant for meshes much smaller than the waves. Ticks where
+	// the samples, or two checks between them, are further than WaterPlaneTolerance from the plane fall back to the per
+	// vertex queries.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings|Water Plane")
+	bool bFitWaterPlane = false;
+
+	// Largest vertical distance in uu between the water samples and the fitted plane for the plane to be used.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings|Water Plane", meta = (ClampMin = "0", EditCondition = "bFitWaterPlane"))
+	float WaterPlaneTolerance = 5.f;
+
+	// Split the triangles crossing the waterline in halves across their longest edge, sampling the water at the new
+	// vertices, until the pieces still crossing it have no edge longer than WaterlineEdgeLength. The clipped hull then
+	// follows the waves between the hull vertices, which gives better roll and pitch moments on coarse meshes without
+	// paying for a denser hull everywhere. The water is only sampled inside the triangles: on the hull edges the height
+	// is interpolated between the vertices, so neighboring triangles still clip their shared edges at the same points.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings|Waterline Refinement")
+	bool bRefineWaterline = false;
+
+	// Longest edge in uu of the refined triangles crossing the waterline.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings|Waterline Refinement", meta = (ClampMin = "1", EditCondition = "bRefineWaterline"))
+	float WaterlineEdgeLength = 50.f;
+
+	// Group the triangles in clusters and skip the clusters that are entirely above the water.
+	// Clusters entirely below the water are not clipped.
+	// Without a water heightmap, this needs a water surface provider that can bound its heights, see
+	// IWaterSurfaceProvider::GetWaterHeightBounds. With an OceanManager the band is its base height plus and
+	// minus the sum of its wave amplitudes.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings|Culling")
+	bool bUseClusterCulling = true;
+
+	// Maximum number of triangles in a cluster. Changes are applied on initialization.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings|Culling", meta = (ClampMin = "1"))
+	int32 TrianglesPerCluster = 32;
+
+	// Keep the height above water of each vertex from the tick it was last sampled, and skip the water queries of the
+	// triangles whose corners were all further from the water than the vertices and the waves can have moved since,
+	// see IWaterSurfaceProvider::GetWaterHeightRateBounds. Those triangles are used whole or skipped as before, only
+	// the ones near the waterline are sampled and clipped again, so the forces are the same with fewer water queries.
+	// Needs a provider that bounds its rates, and isn't used with a water heightmap, the water plane or the accurate
+	// water height. Assumes the provider's waves don't change while the mesh floats on them.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings|Culling")
+	bool bReuseWaterlineClassification = false;
+
+	// Store the hull with 16 bit positions quantized to the mesh bounds, 16 bit indices when possible and packed
+	// triangle normals, see FCompactTriangleMesh. Saves memory for actors instantiated in large numbers, at the cost
+	// of moving the vertices by up to 1/131070 of the bounds size. Changes are applied on initialization.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings|Memory")
+	bool bUseCompactHull = false;
+
 	// OceanManager used by the component, if unassigned component will auto-detect.
 	UPROPERTY(EditAnywhere, AdvancedDisplay, BlueprintReadWrite, Category = "Buoyant Settings")
 	AOceanManager* OceanManager = nullptr;
 
+	// Water surface the mesh floats on. If unassigned, the OceanManager is used.
+	// Also used by the water heightmap of the actor when it has no provider of its own.
+	UPROPERTY(EditAnywhere, Instanced, BlueprintReadWrite, Category = "Buoyant Settings", meta = (MustImplement = "WaterSurfaceProvider"))
+	UObject* WaterSurfaceProvider = nullptr;
+
+	// Account for the horizontal displacement of the waves when sampling the water height at the vertices, by
+	// solving for the surface point above each of them. Warm started from the last tick, so it usually costs one
+	// displacement query per vertex. Not used with a water heightmap.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Buoyant Settings")
+	bool bAccurateWaterHeight = false;
+
+	// Horizontal error under which the accurate water height stops iterating.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Buoyant Settings", meta = (ClampMin = "0.01", EditCondition = "bAccurateWaterHeight"))
+	float WaterHeightTolerance = 1.f;
+
 	// Draw arrows representing the buoyant forces pushing on the mesh?
 	// The length is proportional to the force magnitude.
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug")
@@ -92,6 +238,10 @@ class BUOYANCYPLUGIN_API UBuoyantMeshComponent : public UStaticMeshComponent
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug")
 	bool bDrawSubtriangles = false;
 
+	// Draw the cluster bounds? Dry clusters are white, wet clusters blue and crossing clusters yellow.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug")
+	bool bDrawClusters = false;
+
 	// Force arrow size multiplier.
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug")
 	float ForceArrowSize = 1.f;
@@ -116,6 +266,52 @@ class BUOYANCYPLUGIN_API UBuoyantMeshComponent : public UStaticMeshComponent
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mass Settings")
 	float WaterDensity = 0.001027f;
 
+	// Submerged volume of the mesh in uu^3, updated every tick.
+	UPROPERTY(BlueprintReadOnly, Category = "Buoyant Output")
+	float SubmergedVolume = 0.f;
+
+	// World space centroid of the submerged volume, updated every tick.
+	UPROPERTY(BlueprintReadOnly, Category = "Buoyant Output")
+	FVector CenterOfBuoyancy = FVector::ZeroVector;
+
+	// Growth of the buoyant force with depth, in force per uu, updated every tick with bSemiImplicitBuoyancy.
+	UPROPERTY(BlueprintReadOnly, Category = "Buoyant Output")
+	float HeaveStiffness = 0.f;
+
+	// Growth of the restoring torques with the roll and pitch angles, in torque per radian, updated every tick with
+	// bSemiImplicitBuoyancy.
+	UPROPERTY(BlueprintReadOnly, Category = "Buoyant Output")
+	float RollStiffness = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Buoyant Output")
+	float PitchStiffness = 0.f;
+
+	// Number of clusters entirely above the water last tick.
+	UPROPERTY(BlueprintReadOnly, Category = "Buoyant Output")
+	int32 DryClusterCount = 0;
+
+	// Number of clusters entirely below the water last tick.
+	UPROPERTY(BlueprintReadOnly, Category = "Buoyant Output")
+	int32 WetClusterCount = 0;
+
+	// Number of clusters crossing the waterline last tick.
+	UPROPERTY(BlueprintReadOnly, Category = "Buoyant Output")
+	int32 CrossingClusterCount = 0;
+
+	// Fraction of the triangles in crossing clusters that were sampled and clipped last tick. The others kept the
+	// classification of their corners from an earlier tick, with bReuseWaterlineClassification.
+	UPROPERTY(BlueprintReadOnly, Category = "Buoyant Output")
+	float ReclippedTriangleFraction = 0.f;
+
+	// Whether the hull was clipped against the fitted water plane last tick, with bFitWaterPlane.
+	UPROPERTY(BlueprintReadOnly, Category = "Buoyant Output")
+	bool bWaterPlaneFitted = false;
+
+	// Largest vertical distance in uu between the water samples or checks and the fitted plane last tick, with
+	// bFitWaterPlane.
+	UPROPERTY(BlueprintReadOnly, Category = "Buoyant Output")
+	float WaterPlaneResidual = 0.f;
+
 	struct FForce
 	{
 		FVector Vector;
@@ -126,7 +322,32 @@ class BUOYANCYPLUGIN_API UBuoyantMeshComponent : public UStaticMeshComponent
 		}
 	};
 
+	virtual bool GatherBuoyancy(float DeltaTime) override;
+	virtual void EvaluateBuoyancy() override;
+	virtual void ApplyBuoyancy() override;
+	virtual bool CanEvaluateBuoyancyInParallel() const override;
+
+	// Evaluates the buoyancy of a body state that wasn't gathered from this component, e.g. a recorded one, through the
+	// same path as a tick, but returns the net force and torque about the center of mass instead of applying them.
+	// Needs no world or physics body: the hull is built from the static mesh on the first call, and the water is
+	// WaterSurfaceProvider, which must be set.
+	void EvaluateBuoyancyForState(const FTransform& LocalToWorld,
+	                              const FBuoyantBodyState& Body,
+	                              float Time,
+	                              float DeltaTime,
+	                              float InGravityMagnitude,
+	                              FVector& OutForce,
+	                              FVector& OutTorque);
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
+	// Memory of the hull and the buoyancy buffers of this component, which GetResourceSizeEx adds to the mesh memory.
+	// The hydrostatic table and the water surface provider are shared objects and aren't included.
+	SIZE_T GetBuoyancyAllocatedSize() const;
+
    protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void TickComponent(float DeltaTime,
 	                           enum ELevelTick TickType,
 	                           FActorComponentTickFunction* ThisTickFunction) override;
@@ -134,27 +355,155 @@ class BUOYANCYPLUGIN_API UBuoyantMeshComponent : public UStaticMeshComponent
    private:
 	bool bHasInitialized = false;
 	void Initialize();
+	// Builds the hull, or the primitives replacing it, from the static mesh.
+	void InitializeHull();
 
 	void SetMassProperties();
 
 	UWorld* World = nullptr;
 	float GravityMagnitude = 0.f;
 
+	// Resolved from WaterSurfaceProvider every tick.
+	IWaterSurfaceProvider* WaterSurface = nullptr;
+	float WaterTime = 0.f;
+
+	// Gathered on the game thread for the evaluation.
+	FTransform GatheredLocalToWorld;
+	FBuoyantBodyState GatheredBody;
+	bool bGatheredGravityEnabled = false;
+	float GatheredDeltaTime = 0.f;
+	bool bUseHydrostaticTableThisTick = false;
+	// Sets the gathered state and clears the results of the previous evaluation. Gravity and the hydrostatic table
+	// are left off.
+	void SetGatheredState(const FTransform& LocalToWorld, const FBuoyantBodyState& Body, float Time, float DeltaTime);
+
+	// Forces evaluated this tick, added to the updated component when applying.
+	TArray<FForce> PendingForces;
+
+	// Linearized while evaluating the forces, with bSemiImplicitBuoyancy.
+	FBuoyantStiffness Stiffness;
+	// Added at the center of mass when applying, on top of PendingForces.
+	FVector SemiImplicitForce = FVector::ZeroVector;
+	FVector SemiImplicitTorque = FVector::ZeroVector;
+	void EvaluateSemiImplicitCorrection();
+
 	AOceanManager* FindOceanManager() const;
 	UWaterHeightmapComponent* FindWaterHeightmap() const;
 
-	FForce GetSubmergedTriangleForce(const FBuoyantMeshSubtriangle& Subtriangle, const FVector& TriangleNormal) const;
-
-	void ApplyMeshForces();
-
-	void ApplyMeshForce(const FForce& Force);
+	// The water at the center is sampled warm started from CornerState, the inverse state of a corner of the triangle
+	// the subtriangle was cut from, so it is found the same way as at the vertices.
+	FForce GetSubmergedTriangleForce(const FBuoyantMeshSubtriangle& Subtriangle,
+	                                 const FVector& TriangleNormal,
+	                                 const FWaterSurfaceInverseState& CornerState) const;
+
+	// Pieces of a triangle crossing the waterline refined with bRefineWaterline, three vertices each in the winding of
+	// the triangle. The water at the new vertices inside the triangle is sampled warm started from InverseState, the
+	// new vertices on its edges are interpolated.
+	void RefineWaterlineTriangle(const FBuoyantMeshVertex& A,
+	                             const FBuoyantMeshVertex& B,
+	                             const FBuoyantMeshVertex& C,
+	                             const FWaterSurfaceInverseState& InverseState,
+	                             TArray<FBuoyantMeshVertex>& OutVertices) const;
+	// Scratch buffer of RefineWaterlineTriangle.
+	TArray<FBuoyantMeshVertex> RefinedVertices;
+
+	void EvaluateMeshForces();
+
+	bool ShouldUseHydrostaticTable() const;
+	// Fits a water plane under the mesh and adds the buoyant force found in the hydrostatic table.
+	void EvaluateHydrostaticTableForces();
+	// Distance from the component to the nearest player viewpoint, or the largest float if there is none.
+	float GetDistanceToNearestViewer() const;
+
+	// Primitives of the simple collision in mesh space, used instead of the hull with bUseAnalyticPrimitives.
+	TArray<FBuoyantPrimitive> Primitives;
+	// Adds the buoyant force and drag of each primitive.
+	void EvaluatePrimitiveForces();
+	// Least squares plane through the water under the center and the corners of the footprint of the box.
+	FPlane GetWaterPlane(const FBox& WorldBox) const;
+	// Least squares plane through the water under the positions, relative to the first one. Returns false and a level
+	// plane through the water under the first position if the positions are all on a line.
+	bool FitWaterPlane(TArrayView<const FVector> SamplePositions, FPlane& OutPlane, float& OutMaxResidual) const;
+
+	// With bFitWaterPlane, the water surface this tick when it is close enough to the samples. Every water height
+	// query of the mesh path reads this plane instead while bUseWaterPlaneThisTick is set.
+	bool bUseWaterPlaneThisTick = false;
+	FPlane WaterPlane;
+	void UpdateWaterPlane();
+	// Mesh space bounds of the hull, whose footprint the water plane is fitted over.
+	FBox HullLocalBounds{ForceInit};
+
+	// Queues the force for ApplyBuoyancy.
+	void AddMeshForce(const FForce& Force);
 
 	void SetupTickOrder();
 
+	// The hull is kept in one of these layouts, depending on bUseCompactHull.
 	TArray<FTriangleMesh> TriangleMeshes;
+	TArray<FCompactTriangleMesh> CompactTriangleMeshes;
+	// Clusters of each triangle mesh, in the same order as TriangleMeshes.
+	TArray<TArray<FBuoyantMeshCluster>> MeshClusters;
+
+	// Scratch buffers for the vertices of the triangle mesh being processed, kept to avoid reallocating every tick.
+	TArray<FVector> WorldVertices;
+	TArray<float> VertexHeightsAboveWater;
+	// 0 if the vertex hasn't been used yet, 1 if its world position is known, 2 if its height is known too.
+	TArray<uint8> VertexUpdateStates;
+
+	// Submerged triangles of all the triangle meshes, clipped and evaluated together when nothing is being drawn.
+	FBuoyantMeshBatch TriangleBatch;
+	TArray<float> SubtriangleCenterHeights;
+	// With the accurate water height, the inverse state of a corner of each triangle of the batch.
+	TArray<FWaterSurfaceInverseState> BatchInverseStates;
+	// The slots of the batch with an area, whose centers are sampled for the pressure forces, with their centers and
+	// the inverse states they start from.
+	TArray<int32> PressureSlots;
+	TArray<FVector> PressureSlotCenters;
+	TArray<FWaterSurfaceInverseState> PressureSlotInverseStates;
+	// Warm starts of the accurate water height at the vertices. Same layout as TriangleMeshes.
+	TArray<TArray<FWaterSurfaceInverseState>> VertexInverseStates;
+
+	// Last sampled height above water of a vertex, with bReuseWaterlineClassification.
+	struct FVertexWaterSample
+	{
+		FVector Position = FVector::ZeroVector;
+		float Time = 0.f;
+		// Zero until the vertex is sampled, which is never far enough from the water to be reused.
+		float HeightAboveWater = 0.f;
+	};
+	// Same layout as TriangleMeshes. Reset when the hull or the water surface changes.
+	TArray<TArray<FVertexWaterSample>> VertexWaterSamples;
+	// Water surface the samples were taken on.
+	const IWaterSurfaceProvider* SampledWaterSurface = nullptr;
+
+	// Bounds of the water surface this tick, given by the provider. Unknown if it can't bound its heights.
+	bool bHasWaterBand = false;
+	float MinWaterHeight = 0.f;
+	float MaxWaterHeight = 0.f;
+	void UpdateWaterBand();
+
+	// Gets the lowest and highest water height that can be found under the world space box.
+	// Uses the water plane or the water heightmap if they are used, the provider bounds otherwise.
+	// Returns false if the water could be at any height.
+	bool GetWaterHeightRange(const FBox& WorldBox, float& OutMinHeight, float& OutMaxHeight) const;
+
+	bool IsUsingWaterHeightmap() const;
+
+	EBuoyantClusterState GetClusterState(const FBuoyantMeshCluster& Cluster, const FTransform& LocalToWorld) const;
+
+	// Attempts to get the height of the water surface under a point.
+	float GetWaterHeight(const FVector& Position) const;
 
 	// Attempts to get the height above the water of a point.
 	float GetHeightAboveWater(const FVector& Position) const;
+	// Same, with the accurate water height if enabled.
+	float GetHeightAboveWater(const FVector& Position, FWaterSurfaceInverseState& InverseState) const;
+	// Same for many points, with a single query to the water surface when there is no water heightmap.
+	void GetHeightsAboveWater(TArrayView<const FVector> Positions, TArrayView<float> OutHeights) const;
+	// Same, with the accurate water height if enabled, solved for all the points at once.
+	void GetHeightsAboveWater(TArrayView<const FVector> Positions,
+	                          TArrayView<FWaterSurfaceInverseState> InverseStates,
+	                          TArrayView<float> OutHeights) const;
 
 	static void DrawDebugTriangle(UWorld* const World,
 	                              const FVector& A,
@@ -173,18 +522,50 @@ class BUOYANCYPLUGIN_API UBuoyantMeshComponent : public UStaticMeshComponent
 class TMeshUtilities
 {
    public:
-	static TArray<FTriangleMesh> GetTriangleMeshes(UStaticMeshComponent* StaticMeshComponent);
+	static TArray<FTriangleMesh> GetTriangleMeshes(UStaticMeshComponent* StaticMeshComponent,
+	                                               EBuoyantHullSource Source = EBuoyantHullSource::Automatic);
+	static TArray<FTriangleMesh> GetTriangleMeshes(UBodySetup* BodySetup,
+	                                               EBuoyantHullSource Source = EBuoyantHullSource::Automatic);
+
+	// Reorders the triangles along a space filling curve so consecutive triangles are close to each other, then
+	// groups them in clusters of at most TrianglesPerCluster triangles.
+	static FTriangleMesh SortIntoClusters(const FTriangleMesh& TriangleMesh,
+	                                      int32 TrianglesPerCluster,
+	                                      TArray<FBuoyantMeshCluster>& OutClusters);
 
    private:
+	// Morton code of a position normalized to [0, 1] on each axis, with 10 bits per axis.
+	static uint32 GetMortonCode(const FVector& NormalizedPosition);
+	static uint32 SpreadBits(uint32 Value);
+
 	static TArray<FVector> GetVertices(const PxTriangleMesh* TriangleMesh);
 	static TArray<int32> GetTriangleVertexIndices(const PxTriangleMesh* TriangleMesh);
+
+	// Vertices of a cooked convex hull in body space, and its polygons fan-triangulated with outward normals once the
+	// vertices went through ElementTransform.
+	static TArray<FVector> GetVertices(const PxConvexMesh* ConvexMesh, const FTransform& ElementTransform);
+	static TArray<int32> GetTriangleVertexIndices(const PxConvexMesh* ConvexMesh, const FTransform& ElementTransform);
 };
 
 class TMathUtilities
 {
    public:
 	// Calculates the volume of a triangle mesh.
-	static float MeshVolume(UStaticMeshComponent* StaticMeshComponent);
+	static float MeshVolume(UStaticMeshComponent* StaticMeshComponent,
+	                        EBuoyantHullSource Source = EBuoyantHullSource::Automatic);
+
+	// Signed volume of the tetrahedron formed by a triangle and an apex point. The sign is positive when the apex
+	// is behind the triangle with respect to its outward normal, so summing over a closed mesh gives its volume
+	// for any apex.
+	static float SignedVolumeOfTetrahedron(const FVector& Apex,
+	                                       const FVector& A,
+	                                       const FVector& B,
+	                                       const FVector& C,
+	                                       const FVector& OutwardNormal);
+
+	// Least squares fit of the plane Z = C.X + C.Y * X + C.Z * Y through the points.
+	// Returns false if the points do not span a plane in XY.
+	static bool FitHeightPlane(const TArray<FVector>& Points, FVector& OutCoefficients, float& OutMaxResidual);
 
    private:
 	/*
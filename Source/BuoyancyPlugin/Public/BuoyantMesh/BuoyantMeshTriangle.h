@@ -40,6 +40,21 @@ struct FBuoyantMeshTriangle
 	TArray<FBuoyantMeshSubtriangle> GetSubmergedPortion(const UWorld* World = nullptr,
 	                                                    bool bDrawWaterline = false) const;
 
+	// Bit I is set if the I-th vertex (A, B then C) is underwater.
+	static uint8 GetUnderwaterCorners(const FBuoyantMeshVertex& A,
+	                                  const FBuoyantMeshVertex& B,
+	                                  const FBuoyantMeshVertex& C);
+
+	// Calculates the submerged part of a triangle from its underwater corners, without sorting the vertices or
+	// allocating. The subtriangles are the same as the ones from GetSubmergedPortion, up to their vertex order.
+	static void GetSubmergedPortion(const FBuoyantMeshVertex& A,
+	                                const FBuoyantMeshVertex& B,
+	                                const FBuoyantMeshVertex& C,
+	                                uint8 UnderwaterCorners,
+	                                TArray<FBuoyantMeshSubtriangle, TInlineAllocator<2>>& OutSubtriangles,
+	                                const UWorld* World = nullptr,
+	                                bool bDrawWaterline = false);
+
    private:
 	// Find the cutting point on a triangle edge, at the determined distance from the start vertex.
 	static FVector FindCutOnEdge(const FBuoyantMeshVertex& Start,
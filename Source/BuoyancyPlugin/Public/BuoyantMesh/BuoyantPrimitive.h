@@ -0,0 +1,65 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BuoyantMesh/HydrostaticTable.h"
+
+
+class UBodySetup;
+struct FTriangleMesh;
+
+enum class EBuoyantPrimitiveShape : uint8
+{
+	Sphere,
+	Box,
+	Capsule
+};
+
+/*
+
+A sphere, box or capsule element of the simple collision, whose part below a water plane is integrated in closed form
+instead of clipping triangles.
+
+The box is the alternating sum of the octants at its corners, each of which the plane clips to a simplex. The capsule
+cylinder integrates circular segments along its axis. The end hemispheres are sliced parallel to the water plane: the
+slices their flat face doesn't cross are whole discs or empty, the others are integrated with a fixed Gauss rule that
+is accurate to float precision.
+
+The Buoyancy.Primitives automation tests check the closed forms against a clipped tessellation of the primitive, the
+way the mesh path would integrate it.
+
+*/
+
+struct BUOYANCYPLUGIN_API FBuoyantPrimitive
+{
+	EBuoyantPrimitiveShape Shape = EBuoyantPrimitiveShape::Sphere;
+
+	// From the primitive to its space, without scale. The capsule axis is the Z axis of the primitive.
+	FTransform Transform;
+
+	// Sphere and capsule radius.
+	float Radius = 0.f;
+
+	// Half size of the box. The capsule cylinder goes from -HalfExtent.Z to HalfExtent.Z.
+	FVector HalfExtent = FVector::ZeroVector;
+
+	// The sphere, box and capsule elements of the simple collision, in mesh space.
+	static TArray<FBuoyantPrimitive> GetPrimitives(const UBodySetup* BodySetup);
+
+	// The primitive moved by LocalToWorld, scaled like the physics scales the simple collision: the sphere by the
+	// smallest axis of the scale, the capsule radius by the largest of X and Y.
+	FBuoyantPrimitive GetTransformed(const FTransform& LocalToWorld) const;
+
+	float GetVolume() const;
+
+	FBox GetBounds() const;
+
+	// Hydrostatics of the part below the water plane, in the space Transform maps to. The plane normal points out of
+	// the water and has a unit length.
+	FHydrostaticSample GetSubmergedHydrostatics(const FPlane& WaterPlane) const;
+
+	// Triangles of the surface with outward normals, with Segments around the axis.
+	FTriangleMesh Tessellate(int32 Segments) const;
+};
@@ -0,0 +1,89 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+// Memory and decoding speed of a hull in the compact layout, next to the same hull as float vertices and int32 indices.
+struct FCompactTriangleMeshComparison
+{
+	int32 VertexCount = 0;
+	int32 TriangleCount = 0;
+	SIZE_T FloatBytes = 0;
+	SIZE_T CompactBytes = 0;
+	// Largest distance between a vertex and its quantized position, in mesh space.
+	float MaxPositionError = 0.f;
+	// Triangle corners read and transformed to world space per second, as the buoyancy loops do.
+	double FloatCornersPerSecond = 0.0;
+	double CompactCornersPerSecond = 0.0;
+};
+
+/*
+
+A triangle mesh stored for hulls that are instantiated in large numbers.
+
+Positions are quantized to 16 bits per axis over the bounds of the mesh, so a vertex takes 6 bytes instead of 12 and
+moves by at most half a quantization step on each axis. Indices take 16 bits when the mesh has at most 65536 vertices.
+The normal of every triangle, the normalized cross product of (B - A) and (C - A), is precomputed and packed in 32 bits
+with an octahedral encoding.
+
+Decoding a position is a multiply-add per axis, so the buoyancy loops read the compact layout directly.
+
+*/
+
+class BUOYANCYPLUGIN_API FCompactTriangleMesh
+{
+   public:
+	FCompactTriangleMesh() = default;
+	FCompactTriangleMesh(const TArray<FVector>& Vertices, const TArray<int32>& TriangleVertexIndices);
+
+	int32 GetVertexCount() const { return QuantizedPositions.Num() / 3; }
+	int32 GetIndexCount() const { return Indices16.Num() + Indices32.Num(); }
+	int32 GetTriangleCount() const { return GetIndexCount() / 3; }
+
+	FORCEINLINE FVector GetVertex(int32 VertexIndex) const
+	{
+		const auto Quantized = &QuantizedPositions[VertexIndex * 3];
+		return FVector{Origin.X + Quantized[0] * Step.X, Origin.Y + Quantized[1] * Step.Y, Origin.Z + Quantized[2] * Step.Z};
+	}
+
+	FORCEINLINE int32 GetIndex(int32 Index) const
+	{
+		return Indices32.Num() > 0 ? Indices32[Index] : static_cast<int32>(Indices16[Index]);
+	}
+
+	// Unit normal of the triangle in mesh space.
+	FVector GetTriangleNormal(int32 TriangleIndex) const;
+
+	// Transforms a mesh space triangle normal with the transform the vertices go through, keeping it perpendicular to
+	// the triangle under non-uniform and negative scales.
+	static FVector TransformNormal(const FTransform& LocalToWorld, const FVector& LocalNormal);
+
+	SIZE_T GetAllocatedSize() const;
+	// Size of the same mesh as float vertices and int32 indices.
+	static SIZE_T GetFloatLayoutSize(int32 VertexCount, int32 IndexCount);
+
+	// Encodes the mesh and times both layouts. Meant for logging, it takes a few milliseconds on large hulls.
+	static FCompactTriangleMeshComparison Compare(const TArray<FVector>& Vertices, const TArray<int32>& TriangleVertexIndices);
+
+	// Whether the components should log FCompactTriangleMesh::Compare when they build their hulls, see
+	// buoyancy.CompactHull.Report.
+	static bool ShouldReport();
+
+   private:
+	FVector Origin = FVector::ZeroVector;
+	FVector Step = FVector::ZeroVector;
+
+	// Three values per vertex.
+	TArray<uint16> QuantizedPositions;
+	// Only one of them is used, depending on the vertex count.
+	TArray<uint16> Indices16;
+	TArray<int32> Indices32;
+	// One per triangle.
+	TArray<uint32> PackedNormals;
+
+	static uint32 PackNormal(const FVector& Normal);
+	static FVector UnpackNormal(uint32 PackedNormal);
+};
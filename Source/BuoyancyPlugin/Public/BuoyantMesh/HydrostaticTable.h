@@ -0,0 +1,135 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "BuoyantMesh/BuoyantHullSource.h"
+#include "HydrostaticTable.generated.h"
+
+
+class UStaticMesh;
+struct FTriangleMesh;
+
+// Hydrostatics of the hull for one water plane.
+USTRUCT()
+struct FHydrostaticSample
+{
+	GENERATED_BODY()
+
+	// Submerged volume in uu^3.
+	UPROPERTY()
+	float Volume = 0.f;
+
+	// Submerged volume times its centroid, in mesh space.
+	// Stored instead of the centroid so it can be interpolated linearly.
+	UPROPERTY()
+	FVector VolumeMoment = FVector::ZeroVector;
+
+	// Area of the hull cross section at the waterline in uu^2.
+	UPROPERTY()
+	float WaterplaneArea = 0.f;
+};
+
+/*
+
+Reduced-order hydrostatic model of a hull, in the spirit of the hydrostatic tables used by naval architects.
+
+The collision mesh of SourceMesh is swept over draft, heel and trim, and the submerged volume, centre of buoyancy and
+waterplane area are stored for each combination. At runtime a hull far from the camera only needs to fit a water plane
+under itself and look up the result, at a cost that does not depend on its triangle count.
+
+The water plane is expressed in mesh space as Z = Draft + X * tan(Trim) + Y * tan(Heel).
+
+*/
+
+UCLASS(BlueprintType)
+class BUOYANCYPLUGIN_API UHydrostaticTable : public UDataAsset
+{
+	GENERATED_BODY()
+
+   public:
+	// Mesh whose collision is used to bake the table. It needs a complex collision mesh or convex elements.
+	UPROPERTY(EditAnywhere, Category = "Bake")
+	UStaticMesh* SourceMesh = nullptr;
+
+	// Collision of SourceMesh the table is baked from. It should match the HullSource of the buoyant meshes using it.
+	UPROPERTY(EditAnywhere, Category = "Bake")
+	EBuoyantHullSource HullSource = EBuoyantHullSource::Automatic;
+
+	// Number of samples between the fully dry and the fully submerged draft.
+	UPROPERTY(EditAnywhere, Category = "Bake", meta = (ClampMin = "2"))
+	int32 DraftSteps = 32;
+
+	// Number of samples between -MaxHeel and MaxHeel.
+	UPROPERTY(EditAnywhere, Category = "Bake", meta = (ClampMin = "2"))
+	int32 HeelSteps = 19;
+
+	// Number of samples between -MaxTrim and MaxTrim.
+	UPROPERTY(EditAnywhere, Category = "Bake", meta = (ClampMin = "2"))
+	int32 TrimSteps = 9;
+
+	// Largest heel angle in degrees. Larger angles are clamped at lookup.
+	UPROPERTY(EditAnywhere, Category = "Bake", meta = (ClampMin = "0", ClampMax = "80"))
+	float MaxHeel = 45.f;
+
+	// Largest trim angle in degrees. Larger angles are clamped at lookup.
+	UPROPERTY(EditAnywhere, Category = "Bake", meta = (ClampMin = "0", ClampMax = "80"))
+	float MaxTrim = 20.f;
+
+	// Sweeps SourceMesh and stores the results in this asset.
+	UFUNCTION(CallInEditor, Category = "Bake")
+	void Bake();
+
+	bool IsBaked() const;
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
+	// Trilinear lookup of the hydrostatics for the water plane Z = Draft + X * tan(Trim) + Y * tan(Heel), with the
+	// angles in degrees. All results are in mesh space. Returns false if the table has not been baked.
+	bool Lookup(float Draft,
+	            float Heel,
+	            float Trim,
+	            float& OutVolume,
+	            FVector& OutCenterOfBuoyancy,
+	            float& OutWaterplaneArea) const;
+
+	// Clips the hull against the water plane through PlanePoint and integrates the submerged part. The plane normal
+	// points out of the water. Results are in the space of the hull.
+	static FHydrostaticSample SampleHull(const TArray<FTriangleMesh>& TriangleMeshes,
+	                                     const FVector& PlanePoint,
+	                                     const FVector& PlaneNormal);
+
+   private:
+	// Draft range covered by the table, from fully dry to fully submerged at any heel and trim.
+	UPROPERTY(VisibleAnywhere, Category = "Baked Data")
+	float BakedMinDraft = 0.f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Baked Data")
+	float BakedMaxDraft = 0.f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Baked Data")
+	float BakedMaxHeel = 0.f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Baked Data")
+	float BakedMaxTrim = 0.f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Baked Data")
+	int32 BakedDraftSteps = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Baked Data")
+	int32 BakedHeelSteps = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Baked Data")
+	int32 BakedTrimSteps = 0;
+
+	// Samples stored with draft varying fastest, then heel, then trim.
+	UPROPERTY()
+	TArray<FHydrostaticSample> Samples;
+
+	int32 GetSampleIndex(int32 DraftIndex, int32 HeelIndex, int32 TrimIndex) const;
+
+	// Converts a value to a fractional index in a table axis of StepCount samples spanning [Min, Max].
+	static float GetFractionalIndex(float Value, float Min, float Max, int32 StepCount);
+};
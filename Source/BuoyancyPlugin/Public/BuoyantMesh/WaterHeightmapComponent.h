@@ -5,13 +5,31 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Math/Interval.h"
 #include "WaterHeightmapComponent.generated.h"
 
 
 class AOceanManager;
+class IWaterSurfaceProvider;
+
+// Copy of the water heights of a UWaterHeightmapComponent for the current tick.
+// It doesn't compute missing heights, so unlike the component it can be read from any thread.
+struct FWaterHeightmapSnapshot
+{
+	FVector2D LowerLeftGridCorner = FVector2D::ZeroVector;
+	FVector2D CellSize = FVector2D::ZeroVector;
+	int32 CellCountX = 0;
+	int32 CellCountY = 0;
+	TArray<TOptional<float>> VertexHeights;
+
+	// Interpolates the water height like UWaterHeightmapComponent::GetHeightAtPosition.
+	// Returns false outside the grid or if a vertex of the containing triangle hasn't been computed.
+	bool GetHeightAtPosition(const FVector& Position, float& OutHeight) const;
+};
+
 // Water heightmap centered on the owning actor.
-// Only the heightmap vertices that are actually used trigger an ocean height calculation. Queries between vertices are
-// interpolated. Vertex heights are cached within a tick.
+// Only the heightmap vertices that are actually used trigger an ocean height calculation, unless a height range is
+// queried, which computes them all. Queries between vertices are interpolated. Vertex heights are cached within a tick.
 UCLASS(editinlinenew, meta = (BlueprintSpawnableComponent))
 class BUOYANCYPLUGIN_API UWaterHeightmapComponent : public UActorComponent
 {
@@ -20,6 +38,21 @@ class BUOYANCYPLUGIN_API UWaterHeightmapComponent : public UActorComponent
 public:
 	float GetHeightAtPosition(const FVector& Position);
 
+	// Gets the lowest and highest water height over an XY region, conservatively, widened by HeightRangeMargin.
+	// Inside the grid the heightmap is planar in each triangle, so the range is the one of the vertices of the cells
+	// the region covers. The first query of a tick computes every vertex and builds a min/max pyramid over the cells,
+	// which answers the later queries in logarithmic time. Outside the grid it needs the height bounds of the water
+	// surface provider. Returns false if the water under the region could be at any height.
+	bool GetHeightRange(const FBox2D& Region, FFloatInterval& OutRange);
+
+	// Computes the heights of the vertices that aren't computed yet this tick and copies the whole grid, so what the
+	// snapshot answers doesn't depend on which vertices the buoyant components happened to use.
+	FWaterHeightmapSnapshot GetSnapshot();
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+	// Memory of the grid heights, triangle planes and height range pyramid, which GetResourceSizeEx reports.
+	SIZE_T GetBuoyancyAllocatedSize() const;
+
 	// Represents the plane defined by the three points in a triangle.
 	// Reference: Step 2 in http://codespear.github.io/graphics/2013/09/21/terrain-surface/
 	struct FTrianglePlane
@@ -56,6 +89,14 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water Patch")
 		float GridSizeMultiplier = 1.f;
 
+	// Water surface sampled at the heightmap vertices. If unassigned, the OceanManager of the level is used.
+	UPROPERTY(EditAnywhere, Instanced, BlueprintReadWrite, Category = "Water Patch", meta = (MustImplement = "WaterSurfaceProvider"))
+		UObject* WaterSurfaceProvider = nullptr;
+
+	// Added below and above the height ranges to account for wave crests and troughs between the heightmap vertices.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water Patch", meta = (ClampMin = "0"))
+		float HeightRangeMargin = 50.f;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug")
 		bool bDrawUsedTriangles = false;
 
@@ -65,6 +106,8 @@ public:
 	UWaterHeightmapComponent();
 
 protected:
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
 	virtual void TickComponent(float DeltaTime,
 		ELevelTick TickType,
 		FActorComponentTickFunction* ThisTickFunction) override;
@@ -91,6 +134,19 @@ private:
 	TArray<TOptional<FTrianglePlane>> LowerRightTrianglePlanes;
 	// Array containing the plane of the upper left triangle in each cell.
 	TArray<TOptional<FTrianglePlane>> UpperLeftTrianglePlanes;
+	// Min/max pyramid of the cell heights, built by the first height range query of a tick.
+	// Level 0 has the range of each cell, and each cell of a level has the range of 2x2 cells of the level below.
+	TArray<TArray<FFloatInterval>> HeightRangeLevels;
+
+	void ComputeAllVertices();
+	void BuildHeightRangeLevels();
+	FIntVector2D GetHeightRangeLevelSize(int32 Level) const;
+	// Includes in OutRange the range of the cells between MinCell and MaxCell that are under a node of a level.
+	void IncludeHeightRange(int32 Level,
+		const FIntVector2D& Node,
+		const FIntVector2D& MinCell,
+		const FIntVector2D& MaxCell,
+		FFloatInterval& OutRange) const;
 
 	void ResetGridData();
 
@@ -104,7 +160,7 @@ private:
 	bool bGridSizeNeedsUpdate = true;
 
 	FVector GetSurfaceVertex(const FIntVector2D VertexCoordinates);
-	FTrianglePlane GetTrianglePlane(TArray<TOptional<FTrianglePlane>> TrianglePlanes,
+	FTrianglePlane GetTrianglePlane(TArray<TOptional<FTrianglePlane>>& TrianglePlanes,
 		const FIntVector2D& CellCoordinates,
 		const FIntVector2D& Vertex1GridCoordinates,
 		const FIntVector2D& Vertex2GridCoordinates,
@@ -116,4 +172,8 @@ private:
 
 	UPROPERTY()
 		AOceanManager* OceanManager = nullptr;
+
+	// Resolved from WaterSurfaceProvider when the grid is updated, once per tick.
+	IWaterSurfaceProvider* WaterSurface = nullptr;
+	float WaterTime = 0.f;
 };
@@ -0,0 +1,68 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BuoyancySubsystem.h"
+
+
+/*
+
+Linearized hydrostatics of a floating body about its center of mass: how fast the restoring force grows with heave and
+the restoring torques with roll and pitch, and how strongly the water damps these motions.
+
+Buoyancy forces are evaluated once per frame and applied for the whole physics step. When the step is long compared to
+the period of the heave or roll oscillation of a light body, the explicit forces overshoot and the body jitters or
+explodes. GetSemiImplicitCorrection uses the linearized model to integrate the three motions with a backward Euler
+step instead, which is stable for any step, and matches the explicit forces as the step gets shorter.
+
+Only the diagonal terms are kept. Roll and pitch are measured about the horizontal forward and right axes of the body.
+
+*/
+
+struct BUOYANCYPLUGIN_API FBuoyantStiffness
+{
+	// Horizontal axes the roll and pitch are measured about, in world space.
+	FVector RollAxis = FVector::ForwardVector;
+	FVector PitchAxis = FVector::RightVector;
+
+	// Growth of the upward force with depth, in force per uu.
+	float Heave = 0.f;
+	// Growth of the restoring torque with the roll and pitch angles, in torque per radian. Negative when unstable.
+	float Roll = 0.f;
+	float Pitch = 0.f;
+
+	// Opposing force per uu/s of vertical velocity, and opposing torque per rad/s of roll and pitch rate.
+	float HeaveDamping = 0.f;
+	float RollDamping = 0.f;
+	float PitchDamping = 0.f;
+
+	// Clears the coefficients and measures the axes on the body.
+	void Reset(const FBuoyantBodyState& InBody);
+
+	// Adds an upward force that grows by Stiffness per uu of depth at a point, e.g. a piece of the waterplane.
+	void AddVerticalSpring(const FVector& Position, float Stiffness);
+
+	// Adds a constant upward force at a point fixed in the body, e.g. the buoyancy of the submerged volume at its
+	// centroid. It restores roll and pitch when above the center of mass, and overturns the body otherwise.
+	void AddVerticalForce(const FVector& Position, float Force);
+
+	// Adds a linear damper at a point, opposing the point velocity by Damping on each world axis.
+	void AddLinearDamper(const FVector& Position, const FVector& Damping);
+
+	// Adds the damping of drag forces, from their total force and torque about the center of mass. Drag that grows
+	// with the square of the speed is linearized around the current velocity.
+	void AddQuadraticDrag(const FVector& Force, const FVector& Torque);
+
+	// Force and torque to add to the explicit forces of this step so heave, roll and pitch are integrated
+	// semi-implicitly. NetForce includes gravity, NetTorque is about the center of mass.
+	void GetSemiImplicitCorrection(const FVector& NetForce,
+	                               const FVector& NetTorque,
+	                               float DeltaTime,
+	                               FVector& OutForce,
+	                               FVector& OutTorque) const;
+
+   private:
+	FBuoyantBodyState Body;
+};
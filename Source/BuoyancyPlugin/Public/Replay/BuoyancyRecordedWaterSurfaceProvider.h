@@ -0,0 +1,40 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "WaterSurface/WaterSurfaceProvider.h"
+#include "BuoyancyRecordedWaterSurfaceProvider.generated.h"
+
+
+struct FBuoyancyRecordedWater;
+
+/*
+
+Water surface provider answering from the water recorded around one body for one frame, so UBuoyancyReplayCommandlet
+can evaluate the recording through UBuoyantMeshComponent. The commandlet points it at the frame being replayed.
+
+The recording only has heights, so the surface has no horizontal displacement and no velocity, and the Time of the
+queries is ignored.
+
+*/
+
+UCLASS(Transient)
+class BUOYANCYPLUGIN_API UBuoyancyRecordedWaterSurfaceProvider : public UObject, public IWaterSurfaceProvider
+{
+	GENERATED_BODY()
+
+   public:
+	// Must outlive the queries. Without it the water is at height zero.
+	const FBuoyancyRecordedWater* Water = nullptr;
+
+	virtual float GetWaterHeight(const FVector& Position, float Time) const override;
+	virtual FVector GetWaterDisplacement(const FVector& Position, float Time) const override;
+	virtual FVector GetWaterVelocity(const FVector& Position, float Time) const override;
+	virtual FVector2D GetWaveDirection() const override;
+	virtual bool CanQueryAnyTime() const override { return false; }
+	// The bounds of the recorded grid, which the interpolated heights never leave.
+	virtual bool GetWaterHeightBounds(FFloatInterval& OutBounds) const override;
+};
@@ -0,0 +1,92 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Replay/BuoyancyRecording.h"
+#include "BuoyancyRecorderComponent.generated.h"
+
+
+class AOceanManager;
+class IWaterSurfaceProvider;
+class UBuoyantMeshComponent;
+
+/*
+
+Records the water and the state of every UBuoyantMeshComponent of the level to a file, once per frame after physics.
+The recording can be replayed with the BuoyancyReplay commandlet to benchmark the buoyancy code on exactly the same
+workload, without the OceanManager, physics or rendering.
+
+Only UBuoyantMeshComponents are recorded, with their settings: the other buoyant components can't be evaluated outside
+of their world. Bodies are collected when the recording starts. The water is sampled from the water surface provider on a grid around
+each body, in one batch per body, which adds WaterGridResolution^2 water queries per body and frame while recording.
+
+*/
+
+UCLASS(ClassGroup = Physics, meta = (BlueprintSpawnableComponent))
+class BUOYANCYPLUGIN_API UBuoyancyRecorderComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+   public:
+	UBuoyancyRecorderComponent();
+
+	// File name of the recording, relative to Saved/Buoyancy. Leave empty to name it after the current time.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Recording")
+	FString FileName;
+
+	// Start recording on begin play.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Recording")
+	bool bRecordOnBeginPlay = false;
+
+	// Number of water samples along each side of the grid recorded around a body.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Recording", meta = (ClampMin = "2"))
+	int32 WaterGridResolution = 16;
+
+	// Added around the body bounds when sampling the water.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Recording", meta = (ClampMin = "0"))
+	float WaterGridMargin = 100.f;
+
+	// OceanManager used by the component, if unassigned component will auto-detect.
+	UPROPERTY(EditAnywhere, AdvancedDisplay, BlueprintReadWrite, Category = "Recording")
+	AOceanManager* OceanManager = nullptr;
+
+	// Water surface that is recorded. If unassigned, the OceanManager is used.
+	UPROPERTY(EditAnywhere, Instanced, BlueprintReadWrite, Category = "Recording", meta = (MustImplement = "WaterSurfaceProvider"))
+	UObject* WaterSurfaceProvider = nullptr;
+
+	UFUNCTION(BlueprintCallable, Category = "Recording")
+	void StartRecording();
+
+	UFUNCTION(BlueprintCallable, Category = "Recording")
+	void StopRecording();
+
+	UFUNCTION(BlueprintCallable, Category = "Recording")
+	bool IsRecording() const;
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+	// Memory of the recorded bodies and the frame buffer, which GetResourceSizeEx reports.
+	SIZE_T GetBuoyancyAllocatedSize() const;
+
+   protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime,
+	                           ELevelTick TickType,
+	                           FActorComponentTickFunction* ThisTickFunction) override;
+
+   private:
+	FBuoyancyRecordingWriter Writer;
+	TArray<TWeakObjectPtr<UBuoyantMeshComponent>> RecordedBodies;
+	// Reused for every frame to avoid reallocating.
+	FBuoyancyRecordedFrame Frame;
+	TArray<FVector> WaterSamplePositions;
+
+	// Resolved from WaterSurfaceProvider for each recorded frame.
+	IWaterSurfaceProvider* WaterSurface = nullptr;
+
+	void RecordFrame(float DeltaTime);
+	void RecordBody(const UBuoyantMeshComponent* BuoyantMesh, FBuoyancyRecordedBody& OutBody);
+};
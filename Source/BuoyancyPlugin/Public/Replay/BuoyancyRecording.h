@@ -0,0 +1,130 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/*
+
+Binary recording of the water and of the buoyant bodies, frame by frame, so a session can be replayed offline without
+the OceanManager, physics or rendering. See UBuoyancyRecorderComponent and UBuoyancyReplayCommandlet.
+
+The file starts with a FBuoyancyRecordingHeader followed by FBuoyancyRecordedFrames until the end of the file.
+The water is stored as heights sampled on a grid around each body, quantized to 16 bits over the range of the grid.
+
+*/
+
+class UBuoyantMeshComponent;
+
+// Static description of a recorded body: its mesh and the UBuoyantMeshComponent settings that change the evaluation.
+// The hydrostatic table, the water patch and the debug settings aren't recorded.
+struct BUOYANCYPLUGIN_API FBuoyancyRecordedBodyInfo
+{
+	FString Name;
+	// Path of the static mesh whose collision is used for buoyancy.
+	FString StaticMeshPath;
+	float WaterDensity = 0.f;
+	bool bUseStaticForces = true;
+	bool bUseDynamicForces = true;
+	bool bVerticalForcesOnly = false;
+	bool bSemiImplicitBuoyancy = false;
+	// EHydrostaticForceMode and EBuoyantHullSource.
+	uint8 HydrostaticForceMode = 0;
+	uint8 HullSource = 0;
+	bool bUseAnalyticPrimitives = false;
+	float PrimitiveDragCoefficient = 0.f;
+	bool bFitWaterPlane = false;
+	float WaterPlaneTolerance = 0.f;
+	bool bRefineWaterline = false;
+	float WaterlineEdgeLength = 0.f;
+	bool bUseClusterCulling = true;
+	int32 TrianglesPerCluster = 0;
+	bool bReuseWaterlineClassification = false;
+	bool bUseCompactHull = false;
+	bool bAccurateWaterHeight = false;
+	float WaterHeightTolerance = 0.f;
+
+	// Copies the settings of a component, or back to one.
+	static FBuoyancyRecordedBodyInfo FromComponent(const UBuoyantMeshComponent& Component);
+	void ApplyTo(UBuoyantMeshComponent& Component) const;
+
+	friend FArchive& operator<<(FArchive& Ar, FBuoyancyRecordedBodyInfo& Info);
+};
+
+struct FBuoyancyRecordingHeader
+{
+	float GravityMagnitude = 0.f;
+	// Resolution of the water grid recorded around each body.
+	int32 WaterGridResolution = 0;
+	TArray<FBuoyancyRecordedBodyInfo> Bodies;
+
+	friend FArchive& operator<<(FArchive& Ar, FBuoyancyRecordingHeader& Header);
+};
+
+// Water heights sampled on a square grid over an XY region.
+struct FBuoyancyRecordedWater
+{
+	FBox2D Region{ForceInit};
+	int32 Resolution = 0;
+	// Resolution * Resolution heights, X major.
+	TArray<float> Heights;
+
+	// Bilinear interpolation of the grid, clamped at the region borders.
+	float GetHeightAtPosition(const FVector& Position) const;
+
+	friend FArchive& operator<<(FArchive& Ar, FBuoyancyRecordedWater& Water);
+};
+
+// State of a body at the end of a frame.
+struct FBuoyancyRecordedBody
+{
+	FTransform Transform;
+	FVector CenterOfMass = FVector::ZeroVector;
+	FVector LinearVelocity = FVector::ZeroVector;
+	// In radians per second.
+	FVector AngularVelocity = FVector::ZeroVector;
+	FBuoyancyRecordedWater Water;
+
+	FVector GetVelocityAtPoint(const FVector& Point) const;
+
+	friend FArchive& operator<<(FArchive& Ar, FBuoyancyRecordedBody& Body);
+};
+
+// One frame, with a body for each FBuoyancyRecordingHeader::Bodies entry, in the same order.
+struct FBuoyancyRecordedFrame
+{
+	float Time = 0.f;
+	float DeltaTime = 0.f;
+	TArray<FBuoyancyRecordedBody> Bodies;
+
+	friend FArchive& operator<<(FArchive& Ar, FBuoyancyRecordedFrame& Frame);
+};
+
+class BUOYANCYPLUGIN_API FBuoyancyRecordingWriter
+{
+   public:
+	// Creates the file and writes the header. Returns false if the file can't be created.
+	bool Open(const FString& Filename, FBuoyancyRecordingHeader& Header);
+	void WriteFrame(FBuoyancyRecordedFrame& Frame);
+	void Close();
+	bool IsOpen() const;
+
+   private:
+	TUniquePtr<FArchive> Archive;
+};
+
+class BUOYANCYPLUGIN_API FBuoyancyRecordingReader
+{
+   public:
+	// Opens the file and reads the header. Returns false if it isn't a recording of a supported version.
+	bool Open(const FString& Filename);
+	const FBuoyancyRecordingHeader& GetHeader() const;
+	// Reads the next frame. Returns false at the end of the file.
+	bool ReadFrame(FBuoyancyRecordedFrame& OutFrame);
+
+   private:
+	TUniquePtr<FArchive> Archive;
+	FBuoyancyRecordingHeader Header;
+};
@@ -0,0 +1,33 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "BuoyancyReplayCommandlet.generated.h"
+
+
+/*
+
+Replays a recording made by UBuoyancyRecorderComponent through the buoyant mesh code: every body gets a transient
+UBuoyantMeshComponent with its recorded settings, which evaluates each frame with
+UBuoyantMeshComponent::EvaluateBuoyancyForState against the recorded water, with no OceanManager, physics or rendering. The bodies follow their recorded trajectories, so every run does exactly the same work.
+
+Usage: UE4Editor-Cmd <Project> -run=BuoyancyReplay -File=<recording> [-Iterations=<count>] -nullrhi
+
+Each iteration logs its duration and a checksum of the results, which should be identical between two builds that
+only differ by optimizations.
+
+*/
+
+UCLASS()
+class UBuoyancyReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+   public:
+	UBuoyancyReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,45 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "BuoyancyStressTestCommandlet.generated.h"
+
+
+/*
+
+Measures how the cost of the buoyancy setups of the plugin content scales with the number of floating bodies.
+
+For every setup, instance count and thread count, a game world is created with an OceanManager, the instances are
+spawned on a grid at sea level and the world is ticked for a fixed number of frames, physics included. The setups are
+the buoy (UBuoyantMeshComponent), the fishing boat with UBuoyantForceComponent and with UAdvancedBuoyantComponent,
+the man-of-war (UBuoyantForceComponent) and the iceberg (UBuoyantDestructibleComponent).
+
+The task graph worker count is fixed at startup, so the thread count caps the threads evaluating the bodies with
+buoyancy.MaxEvaluationTasks. Bodies are updated by UBuoyancySubsystem, buoyancy.UseSubsystem is forced on.
+
+The OceanManager can only be queried from the game thread, so by default the bodies query a fixed set of Gerstner
+waves instead, which they can evaluate in parallel. -Water=Ocean keeps the OceanManager. Bodies evaluated on the game
+thread whatever the thread count, like UAdvancedBuoyantComponent, are reported, and the thread count sweep of a setup
+stops after its first run when all of its bodies are.
+
+Usage: UE4Editor-Cmd <Project> -run=BuoyancyStressTest -nullrhi [-Setups=Buoy,ManOfWar] [-Counts=1,10,100]
+       [-Threads=1,2,4] [-Water=Gerstner|Ocean] [-Frames=300] [-Warmup=30] [-DeltaTime=0.016667] [-Output=<csv>]
+
+The CSV, Saved/Buoyancy/BuoyancyStressTest.csv by default, has one row per run with the number of bodies evaluated on
+the game thread, the mean frame time, the mean and largest buoyancy update time, and the buoyancy time per instance.
+
+*/
+
+UCLASS()
+class UBuoyancyStressTestCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+   public:
+	UBuoyancyStressTestCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,191 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "WaterQueryComponent.generated.h"
+
+
+class AOceanManager;
+class UWaterQueryComponent;
+
+// First crossing of a segment with the water surface.
+struct FWaterSegmentHit
+{
+	// True if the segment starts underwater or goes through the water surface.
+	bool bHit = false;
+	// Position of the hit along the segment, from 0 at the start to 1 at the end.
+	float Time = 1.f;
+	// Hit position, the segment start if it starts underwater, the segment end if there is no hit.
+	FVector Location = FVector::ZeroVector;
+};
+
+// A batch of water queries. Fill in the queries, submit the batch to a UWaterQueryComponent and read the results once
+// IsReady() returns true. The queries must not be changed while the batch is in flight.
+// Results are in the same order as the queries.
+struct FWaterQueryBatch
+{
+	// Positions whose water height is wanted. Only X and Y are used.
+	TArray<FVector> Points;
+
+	// Segments tested against the water surface, as start and end positions.
+	TArray<FVector> SegmentStarts;
+	TArray<FVector> SegmentEnds;
+
+	// Water height under each of Points.
+	TArray<float> PointHeights;
+
+	// First water surface hit of each segment.
+	TArray<FWaterSegmentHit> SegmentHits;
+
+	bool IsReady() const
+	{
+		return bIsReady;
+	}
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return Points.GetAllocatedSize() + SegmentStarts.GetAllocatedSize() + SegmentEnds.GetAllocatedSize() +
+		       PointHeights.GetAllocatedSize() + SegmentHits.GetAllocatedSize();
+	}
+
+   private:
+	friend class UWaterQueryComponent;
+	bool bIsReady = false;
+};
+
+using FWaterQueryBatchRef = TSharedRef<FWaterQueryBatch, ESPMode::ThreadSafe>;
+
+DECLARE_DELEGATE_OneParam(FOnWaterQueryBatchReady, const FWaterQueryBatch&);
+
+// Waits for the queries of a UWaterQueryComponent at the end of the frame.
+USTRUCT()
+struct FWaterQueryCompletionTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UWaterQueryComponent* Target = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime,
+	                         ELevelTick TickType,
+	                         ENamedThreads::Type CurrentThread,
+	                         const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template <>
+struct TStructOpsTypeTraits<FWaterQueryCompletionTickFunction>
+    : public TStructOpsTypeTraitsBase2<FWaterQueryCompletionTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/*
+
+Answers batched water height and segment queries on worker threads, for gameplay code that needs many water queries
+per frame.
+
+Batches submitted before this component ticks (TG_DuringPhysics) are dispatched to the task graph right away and run
+alongside the physics simulation. They are completed at the end of the same frame, in TG_LastDemotable, so every query
+sees the water at the same time. Batches submitted later are dispatched on the next frame. Either way the results are in
+the batch at the latest one frame after submission, and the callbacks are called on the game thread in submission order.
+
+Heights come from the water heightmaps of the world inside their grids, and from the water surface provider outside,
+batched per task. The heightmaps are completed and copied at dispatch, so which of their vertices the buoyant components
+used doesn't change the results. The provider is copied too, see IWaterSurfaceProvider::MakeSnapshot, so the workers
+never touch a live object. A provider that can't be copied, like the OceanManager, is queried by tasks on the game
+thread instead, which run while the completion waits for them: the queries are then serial, and a warning says so. Use
+a provider that can be copied, like a Gerstner water surface matching the ocean, to answer them on worker threads.
+
+The components and the heightmaps are found through the UWaterQuerySubsystem of the world.
+
+*/
+
+UCLASS(ClassGroup = Physics, meta = (BlueprintSpawnableComponent))
+class BUOYANCYPLUGIN_API UWaterQueryComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+   public:
+	UWaterQueryComponent();
+
+	// Queues a batch of queries. OnReady is called on the game thread once the results are in the batch.
+	void Submit(const FWaterQueryBatchRef& Batch, FOnWaterQueryBatchReady OnReady = FOnWaterQueryBatchReady());
+
+	// Returns the first registered water query component of the world, if any.
+	static UWaterQueryComponent* FindWaterQueryComponent(const UWorld* World);
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+	// Memory of the pending batches, which GetResourceSizeEx reports. The batches are owned by their submitters but
+	// counted here while they wait for their results.
+	SIZE_T GetBuoyancyAllocatedSize() const;
+
+	// Number of point queries in a worker task. Segment tasks are made smaller by the number of samples per segment.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water Query", meta = (ClampMin = "1"))
+	int32 QueriesPerTask = 1024;
+
+	// Number of evenly spaced samples along a segment when looking for the water surface.
+	// Waves narrower than the segment length divided by this can be missed.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water Query", meta = (ClampMin = "1"))
+	int32 SegmentSteps = 16;
+
+	// Bisection iterations refining the position of a segment hit.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water Query", meta = (ClampMin = "0"))
+	int32 SegmentRefinementSteps = 6;
+
+	// OceanManager used by the component, if unassigned component will auto-detect.
+	UPROPERTY(EditAnywhere, AdvancedDisplay, BlueprintReadWrite, Category = "Water Query")
+	AOceanManager* OceanManager = nullptr;
+
+	// Water surface answering the queries the heightmaps can't. If unassigned, the OceanManager is used.
+	UPROPERTY(EditAnywhere, Instanced, BlueprintReadWrite, Category = "Water Query", meta = (MustImplement = "WaterSurfaceProvider"))
+	UObject* WaterSurfaceProvider = nullptr;
+
+   protected:
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime,
+	                           ELevelTick TickType,
+	                           FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void RegisterComponentTickFunctions(bool bRegister) override;
+
+   private:
+	friend struct FWaterQueryCompletionTickFunction;
+
+	struct FPendingBatch
+	{
+		FWaterQueryBatchRef Batch;
+		FOnWaterQueryBatchReady OnReady;
+
+		FPendingBatch(const FWaterQueryBatchRef& Batch, const FOnWaterQueryBatchReady& OnReady)
+		    : Batch{Batch}, OnReady{OnReady}
+		{
+		}
+	};
+
+	// Submitted batches waiting for the next dispatch.
+	TArray<FPendingBatch> QueuedBatches;
+	// Dispatched batches, in submission order, and the tasks working on them.
+	TArray<FPendingBatch> InFlightBatches;
+	FGraphEventArray InFlightTasks;
+
+	FWaterQueryCompletionTickFunction CompletionTickFunction;
+
+	// Whether the queries running on the game thread were reported.
+	bool bHasWarnedGameThreadQueries = false;
+
+	void DispatchQueuedBatches();
+	// Waits for the in flight tasks and calls the callbacks of their batches.
+	void CompleteInFlightBatches();
+
+	AOceanManager* FindOceanManager() const;
+};
@@ -0,0 +1,42 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WaterQuerySubsystem.generated.h"
+
+
+class UWaterHeightmapComponent;
+class UWaterQueryComponent;
+
+/*
+
+Keeps track of the water query components and water heightmaps of a world, so the water query components find them
+without iterating over every object. Both register themselves when they are registered with the world.
+
+*/
+
+UCLASS()
+class BUOYANCYPLUGIN_API UWaterQuerySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+   public:
+	virtual void Deinitialize() override;
+
+	void RegisterWaterQueryComponent(UWaterQueryComponent* Component);
+	void UnregisterWaterQueryComponent(UWaterQueryComponent* Component);
+	void RegisterWaterHeightmap(UWaterHeightmapComponent* Heightmap);
+	void UnregisterWaterHeightmap(UWaterHeightmapComponent* Heightmap);
+
+	// First registered water query component, if any.
+	UWaterQueryComponent* GetWaterQueryComponent() const;
+	// Registered water heightmaps, in registration order.
+	const TArray<TWeakObjectPtr<UWaterHeightmapComponent>>& GetWaterHeightmaps() const;
+
+   private:
+	TArray<TWeakObjectPtr<UWaterQueryComponent>> WaterQueryComponents;
+	TArray<TWeakObjectPtr<UWaterHeightmapComponent>> WaterHeightmaps;
+};
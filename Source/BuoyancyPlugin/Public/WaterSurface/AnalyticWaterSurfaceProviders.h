@@ -0,0 +1,132 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "WaterSurface/WaterSurfaceProvider.h"
+#include "AnalyticWaterSurfaceProviders.generated.h"
+
+
+/*
+
+Cheap water surfaces defined by a few parameters, to run the buoyancy components without an OceanManager, in tests and
+benchmarks or in levels that don't need the full ocean. Waves follow the deep water dispersion relation.
+
+*/
+
+// Still water at a constant height.
+UCLASS(EditInlineNew, DefaultToInstanced, meta = (DisplayName = "Flat Water Surface"))
+class BUOYANCYPLUGIN_API UFlatWaterSurfaceProvider : public UObject, public IWaterSurfaceProvider
+{
+	GENERATED_BODY()
+
+   public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water Surface")
+	float Height = 0.f;
+
+	virtual float GetWaterHeight(const FVector& Position, float Time) const override;
+	virtual FVector GetWaterDisplacement(const FVector& Position, float Time) const override;
+	virtual FVector GetWaterVelocity(const FVector& Position, float Time) const override;
+	virtual FVector2D GetWaveDirection() const override;
+	virtual bool GetWaterHeightBounds(FFloatInterval& OutBounds) const override;
+	virtual bool GetWaterHeightRateBounds(float& OutMaxSlope, float& OutMaxSpeed) const override;
+	virtual bool GetWaves(TArray<FWaterSurfaceWave>& OutWaves) const override;
+	virtual FWaterSurfaceSnapshotPtr MakeSnapshot() const override;
+};
+
+// A single sine wave, the water only moves vertically.
+UCLASS(EditInlineNew, DefaultToInstanced, meta = (DisplayName = "Sine Water Surface"))
+class BUOYANCYPLUGIN_API USineWaterSurfaceProvider : public UObject, public IWaterSurfaceProvider
+{
+	GENERATED_BODY()
+
+   public:
+	// Height of the water at rest.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water Surface")
+	float BaseHeight = 0.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water Surface", meta = (ClampMin = "0"))
+	float Amplitude = 50.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water Surface", meta = (ClampMin = "1"))
+	float Wavelength = 2000.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water Surface")
+	FVector2D Direction = FVector2D{1.f, 0.f};
+
+	virtual float GetWaterHeight(const FVector& Position, float Time) const override;
+	virtual FVector GetWaterDisplacement(const FVector& Position, float Time) const override;
+	virtual FVector GetWaterVelocity(const FVector& Position, float Time) const override;
+	virtual FVector2D GetWaveDirection() const override;
+	virtual bool GetWaterHeightBounds(FFloatInterval& OutBounds) const override;
+	virtual bool GetWaterHeightRateBounds(float& OutMaxSlope, float& OutMaxSpeed) const override;
+	virtual bool GetWaves(TArray<FWaterSurfaceWave>& OutWaves) const override;
+	virtual FWaterSurfaceSnapshotPtr MakeSnapshot() const override;
+
+   private:
+	float GetPhase(const FVector& Position, float Time) const;
+	float GetAngularFrequency() const;
+};
+
+USTRUCT(BlueprintType)
+struct BUOYANCYPLUGIN_API FAnalyticGerstnerWave
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wave", meta = (ClampMin = "1"))
+	float Wavelength = 2000.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wave", meta = (ClampMin = "0"))
+	float Amplitude = 50.f;
+
+	// 0 is a sine wave, 1 gives sharp crests when the wave is alone.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wave", meta = (ClampMin = "0", ClampMax = "1"))
+	float Steepness = 0.5f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Wave")
+	FVector2D Direction = FVector2D{1.f, 0.f};
+};
+
+/*
+
+A fixed set of Gerstner waves, the same model as the OceanManager without its runtime settings.
+
+The height under a point is found by inverting the horizontal displacement with two fixed point iterations.
+The batched queries compute the constants of the waves once for the whole batch.
+
+*/
+
+UCLASS(EditInlineNew, DefaultToInstanced, meta = (DisplayName = "Gerstner Water Surface"))
+class BUOYANCYPLUGIN_API UGerstnerWaterSurfaceProvider : public UObject, public IWaterSurfaceProvider
+{
+	GENERATED_BODY()
+
+   public:
+	// Height of the water at rest.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water Surface")
+	float BaseHeight = 0.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water Surface")
+	TArray<FAnalyticGerstnerWave> Waves;
+
+	virtual float GetWaterHeight(const FVector& Position, float Time) const override;
+	virtual FVector GetWaterDisplacement(const FVector& Position, float Time) const override;
+	virtual FVector GetWaterVelocity(const FVector& Position, float Time) const override;
+	virtual FVector2D GetWaveDirection() const override;
+	virtual bool GetWaterHeightBounds(FFloatInterval& OutBounds) const override;
+	virtual bool GetWaterHeightRateBounds(float& OutMaxSlope, float& OutMaxSpeed) const override;
+	virtual bool GetWaves(TArray<FWaterSurfaceWave>& OutWaves) const override;
+	virtual FWaterSurfaceSnapshotPtr MakeSnapshot() const override;
+
+	virtual void GetWaterHeights(TArrayView<const FVector> Positions,
+	                             float Time,
+	                             TArrayView<float> OutHeights) const override;
+	virtual void GetWaterDisplacements(TArrayView<const FVector> Positions,
+	                                   float Time,
+	                                   TArrayView<FVector> OutDisplacements) const override;
+	virtual void GetWaterVelocities(TArrayView<const FVector> Positions,
+	                                float Time,
+	                                TArrayView<FVector> OutVelocities) const override;
+};
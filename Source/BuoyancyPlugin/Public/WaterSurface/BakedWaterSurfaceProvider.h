@@ -0,0 +1,65 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "WaterSurface/WaterSurfaceProvider.h"
+#include "WaterSurface/WaterSurfaceAtlas.h"
+#include "BakedWaterSurfaceProvider.generated.h"
+
+
+/*
+
+Water surface answering from an atlas baked by UWaterSurfaceAtlasBakerComponent, in constant time per query whatever the
+number of waves. Queries between texels and frames are interpolated, see FWaterSurfaceAtlas.
+
+The atlas is opened when the provider is loaded or edited. Call LoadAtlas after changing FileName at runtime.
+
+Atlases are stored in Content/Buoyancy, but they aren't assets and aren't cooked: packaged builds only have them when
+that directory is staged as loose files, so they can be memory mapped. Add it to the project's Config/DefaultGame.ini:
+
+	[/Script/UnrealEd.ProjectPackagingSettings]
+	+DirectoriesToAlwaysStageAsNonUFS=(Path="Buoyancy")
+
+*/
+
+UCLASS(EditInlineNew, DefaultToInstanced, meta = (DisplayName = "Baked Water Surface"))
+class BUOYANCYPLUGIN_API UBakedWaterSurfaceProvider : public UObject, public IWaterSurfaceProvider
+{
+	GENERATED_BODY()
+
+   public:
+	// Atlas file, relative to Content/Buoyancy, or an absolute path.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water Surface")
+	FString FileName = TEXT("WaterSurface.wsatlas");
+
+	// Opens the atlas. Returns false if it can't be read, queries then answer flat water at height 0.
+	UFUNCTION(BlueprintCallable, Category = "Water Surface")
+	bool LoadAtlas();
+
+	const FWaterSurfaceAtlas& GetAtlas() const;
+
+	virtual float GetWaterHeight(const FVector& Position, float Time) const override;
+	virtual FVector GetWaterDisplacement(const FVector& Position, float Time) const override;
+	virtual FVector GetWaterVelocity(const FVector& Position, float Time) const override;
+	virtual FVector2D GetWaveDirection() const override;
+	virtual bool GetWaterHeightBounds(FFloatInterval& OutBounds) const override;
+	// The snapshots share the atlas, which LoadAtlas replaces instead of closing it under them.
+	virtual FWaterSurfaceSnapshotPtr MakeSnapshot() const override;
+
+	virtual void PostLoad() override;
+	virtual void BeginDestroy() override;
+	// Only a loaded copy of the atlas is reported, a mapped atlas is shared with the other providers mapping the file.
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	// Path of an atlas file named as in FileName.
+	static FString GetAtlasPath(const FString& FileName);
+
+   private:
+	TSharedRef<FWaterSurfaceAtlas, ESPMode::ThreadSafe> Atlas = MakeShared<FWaterSurfaceAtlas, ESPMode::ThreadSafe>();
+};
@@ -0,0 +1,49 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "WaterSurface/WaterSurfaceProvider.h"
+#include "OceanManagerWaterSurfaceProvider.generated.h"
+
+
+/*
+
+Water surface provider answering from the Gerstner waves of an AOceanManager.
+
+The OceanManager keeps its own clock, so the Time of the queries is ignored. It has no velocity query, so the water
+velocity is zero. Nothing makes its wave queries safe to call from several threads, so the components using this
+provider evaluate their buoyancy on the game thread. Its waves can be changed at runtime, so its height bounds, the
+base height of the OceanManager plus and minus the sum of its wave amplitudes, only hold for the current waves and are
+queried again every tick.
+
+*/
+
+UCLASS(EditInlineNew, DefaultToInstanced, meta = (DisplayName = "OceanManager Water Surface"))
+class BUOYANCYPLUGIN_API UOceanManagerWaterSurfaceProvider : public UObject, public IWaterSurfaceProvider
+{
+	GENERATED_BODY()
+
+   public:
+	// OceanManager answering the queries, if unassigned the one of the component using the provider.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water Surface")
+	class AOceanManager* OceanManager = nullptr;
+
+	// Account for the horizontal displacement of the waves in GetWaterHeight with a second Gerstner iteration.
+	// More accurate heights, but twice as expensive. FWaterSurfaceInverse is usually both cheaper and more accurate.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Water Surface")
+	bool bTwoGerstnerIterations = false;
+
+	virtual float GetWaterHeight(const FVector& Position, float Time) const override;
+	virtual FVector GetWaterDisplacement(const FVector& Position, float Time) const override;
+	virtual FVector GetWaterVelocity(const FVector& Position, float Time) const override;
+	virtual FVector2D GetWaveDirection() const override;
+	virtual bool GetWaterHeightBounds(FFloatInterval& OutBounds) const override;
+	virtual bool CanQueryAnyTime() const override { return false; }
+	virtual bool CanQueryFromAnyThread() const override { return false; }
+
+   private:
+	AOceanManager* GetOceanManager() const;
+};
@@ -0,0 +1,102 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Interval.h"
+
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/*
+
+Water surface baked into a tileable space x time atlas, see UWaterSurfaceAtlasBakerComponent.
+
+The atlas covers one TileSize square starting at Origin and one Period starting at TimeOrigin, and repeats outside of
+them. Each texel has the water height at its position and the displacement of the surface point at rest there, in the
+same convention as IWaterSurfaceProvider. The channels are quantized to 16 bits over their range.
+
+The file is memory mapped when the platform supports it, so only the pages of the frames that are actually sampled
+become resident. Texels are stored frame by frame, then row by row.
+
+*/
+
+struct BUOYANCYPLUGIN_API FWaterSurfaceAtlasHeader
+{
+	int32 Resolution = 0;
+	int32 FrameCount = 0;
+	FVector2D Origin = FVector2D::ZeroVector;
+	FVector2D TileSize = FVector2D::ZeroVector;
+	float TimeOrigin = 0.f;
+	float Period = 0.f;
+	FVector2D WaveDirection = FVector2D{1.f, 0.f};
+	// A channel value is Offset + Scale * quantized value. X is the height, Y Z W the displacement.
+	FVector4 Offset{0.f, 0.f, 0.f, 0.f};
+	FVector4 Scale{0.f, 0.f, 0.f, 0.f};
+
+	friend FArchive& operator<<(FArchive& Ar, FWaterSurfaceAtlasHeader& Header);
+};
+
+class BUOYANCYPLUGIN_API FWaterSurfaceAtlas
+{
+   public:
+	~FWaterSurfaceAtlas();
+
+	// Quantizes the samples and writes the atlas. Samples are height, displacement X, Y, Z, in the texel order of the
+	// file. The quantization of the header is filled in. Returns false if the file can't be written.
+	static bool Write(const FString& Filename, FWaterSurfaceAtlasHeader& Header, const TArray<FVector4>& Samples);
+
+	// Maps the file, or loads it if the platform can't map files. Returns false if it isn't a valid atlas.
+	bool Open(const FString& Filename);
+	void Close();
+	bool IsOpen() const;
+
+	const FWaterSurfaceAtlasHeader& GetHeader() const;
+	// Size of the texels of the whole atlas, and of one frame, which is about what a time has resident.
+	int64 GetSizeInBytes() const;
+	int64 GetFrameSizeInBytes() const;
+	// Whether the texels are read from a mapped file, whose pages are shared by every atlas mapping it.
+	bool IsMapped() const;
+	// Memory allocated for a loaded copy of the file, zero when it is mapped.
+	SIZE_T GetAllocatedSize() const;
+	// Range of heights the quantization can represent, which contains every height the atlas answers.
+	FFloatInterval GetHeightRange() const;
+
+	// Bilinear in space, linear in time.
+	float GetHeight(const FVector& Position, float Time) const;
+	FVector GetDisplacement(const FVector& Position, float Time) const;
+	// Time derivative of the displacement between the two frames around Time.
+	FVector GetVelocity(const FVector& Position, float Time) const;
+
+   private:
+	// One quantized texel, see FWaterSurfaceAtlasHeader::Offset.
+	struct FTexel
+	{
+		int16 Height;
+		int16 DisplacementX;
+		int16 DisplacementY;
+		int16 DisplacementZ;
+	};
+
+	// The four texels around a position in the two frames around a time.
+	struct FSampleCoordinates
+	{
+		int32 FrameOffsets[2];
+		int32 TexelOffsets[4];
+		float TexelWeights[4];
+		float FrameAlpha;
+	};
+
+	FWaterSurfaceAtlasHeader Header;
+	const FTexel* Texels = nullptr;
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	// Used when the file can't be mapped.
+	TArray<uint8> LoadedFile;
+
+	FSampleCoordinates GetSampleCoordinates(const FVector& Position, float Time) const;
+	FVector GetFrameDisplacement(const FSampleCoordinates& Coordinates, int32 Frame) const;
+};
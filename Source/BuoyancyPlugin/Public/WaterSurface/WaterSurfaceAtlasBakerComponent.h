@@ -0,0 +1,136 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "WaterSurface/WaterSurfaceAtlas.h"
+#include "WaterSurfaceAtlasBakerComponent.generated.h"
+
+
+class AOceanManager;
+class IWaterSurfaceProvider;
+
+/*
+
+Bakes a water surface into an atlas file for UBakedWaterSurfaceProvider.
+
+The atlas covers a TileSize square centered on the owning actor, over one Period, and repeats in space and time. That
+is exact when the wavelengths along X and Y divide the tile size and the wave periods divide Period, otherwise there are
+seams where it repeats. Providers that report their waves are checked before baking, and the bake is refused when the
+seams would be higher than SeamTolerance. The error reported after the bake is measured over the tile and its
+neighbours, across the period boundaries, so it shows the seams as well as the resolution loss, along with the size of
+the atlas, so the resolution can be picked.
+
+Providers that can be queried at any time are baked right away. The others, like the OceanManager, are baked over one
+Period of play, one frame per tick: the engine is switched to a fixed time step of one frame of the atlas while baking,
+so every tick samples the water exactly one frame later, whatever the frame rate. Their error can only be measured at
+the current time.
+
+*/
+
+UCLASS(ClassGroup = Physics, meta = (BlueprintSpawnableComponent))
+class BUOYANCYPLUGIN_API UWaterSurfaceAtlasBakerComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+   public:
+	UWaterSurfaceAtlasBakerComponent();
+
+	// Atlas file, relative to Content/Buoyancy, or an absolute path. See UBakedWaterSurfaceProvider for staging it.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake")
+	FString FileName = TEXT("WaterSurface.wsatlas");
+
+	// Size of the tile, should be a multiple of the wavelengths along X and Y.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake")
+	FVector2D TileSize = FVector2D{20480.f, 20480.f};
+
+	// Duration of the baked loop in seconds, should be a multiple of the wave periods.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake", meta = (ClampMin = "0.01"))
+	float Period = 16.f;
+
+	// Highest seam the waves may leave where the tile or the period repeats, in uu. Bakes of waves that don't fit the
+	// tile size and the period closer than that are refused.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake", meta = (ClampMin = "0"))
+	float SeamTolerance = 1.f;
+
+	// Number of texels along each side of the tile.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake", meta = (ClampMin = "2"))
+	int32 Resolution = 256;
+
+	// Number of frames over the period.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake", meta = (ClampMin = "1"))
+	int32 FrameCount = 64;
+
+	// Number of random points the baked atlas is compared to the water surface at, over the tile and the eight around
+	// it, and over the baked period and the ones before and after it.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake", meta = (ClampMin = "1"))
+	int32 ErrorSampleCount = 4096;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bake")
+	bool bBakeOnBeginPlay = false;
+
+	// OceanManager used by the component, if unassigned component will auto-detect.
+	UPROPERTY(EditAnywhere, AdvancedDisplay, BlueprintReadWrite, Category = "Bake")
+	AOceanManager* OceanManager = nullptr;
+
+	// Water surface to bake. If unassigned, the OceanManager is used.
+	UPROPERTY(EditAnywhere, Instanced, BlueprintReadWrite, Category = "Bake", meta = (MustImplement = "WaterSurfaceProvider"))
+	UObject* WaterSurfaceProvider = nullptr;
+
+	// Size of the baked atlas file.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Bake Results")
+	float AtlasSizeInMegabytes = 0.f;
+
+	// Size of one frame, about what is resident when sampling a single time.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Bake Results")
+	float FrameSizeInMegabytes = 0.f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Bake Results")
+	float MaxHeightError = 0.f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Bake Results")
+	float MeanHeightError = 0.f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Bake Results")
+	float MaxDisplacementError = 0.f;
+
+	UFUNCTION(BlueprintCallable, Category = "Bake")
+	void StartBake();
+
+	UFUNCTION(BlueprintCallable, Category = "Bake")
+	bool IsBaking() const;
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+	// Memory of the samples of the bake in progress, which GetResourceSizeEx reports.
+	SIZE_T GetBuoyancyAllocatedSize() const;
+
+   protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime,
+	                           ELevelTick TickType,
+	                           FActorComponentTickFunction* ThisTickFunction) override;
+
+   private:
+	IWaterSurfaceProvider* Source = nullptr;
+	FWaterSurfaceAtlasHeader Header;
+	// Height and displacement of every texel, in the order of the atlas file.
+	TArray<FVector4> Samples;
+	// Positions of the texels of a frame.
+	TArray<FVector> TexelPositions;
+	int32 NextFrame = INDEX_NONE;
+
+	// Engine time step settings replaced while baking over time.
+	bool bPreviousUseFixedTimeStep = false;
+	double PreviousFixedDeltaTime = 0.0;
+	void BeginFixedTimeStep();
+	void EndFixedTimeStep();
+
+	// False if the waves of the source leave seams higher than SeamTolerance.
+	bool CheckSeams() const;
+	void BakeFrame(int32 Frame, float Time);
+	void FinishBake();
+	void MeasureError(const FWaterSurfaceAtlas& Atlas);
+};
@@ -0,0 +1,50 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+class IWaterSurfaceProvider;
+
+// What the inverse found at a point on the previous frame, to start the next solve from.
+struct BUOYANCYPLUGIN_API FWaterSurfaceInverseState
+{
+	// Horizontal displacement of the rest point that ended up above the point.
+	FVector2D Displacement = FVector2D::ZeroVector;
+	// Approximate inverse of the Jacobian of the displaced position by the rest position, rows (X, Y) and (Z, W).
+	FVector4 InverseJacobian{1.f, 0.f, 0.f, 1.f};
+};
+
+/*
+
+Finds the water height above or below a point accounting for the horizontal displacement of the waves, by looking for
+the rest point whose displaced position is the point.
+
+It is a quasi-Newton (Broyden) iteration on the horizontal displacement, warm started from the displacement and
+Jacobian found on the previous frame, so a point moving with the water usually converges on the first evaluation. It
+stops once the displaced rest point is within Tolerance of the point, or after MaxIterations evaluations.
+
+*/
+
+class BUOYANCYPLUGIN_API FWaterSurfaceInverse
+{
+   public:
+	// Returns the horizontal displacement of the found rest point in X and Y, and the water height in Z.
+	static FVector Solve(const IWaterSurfaceProvider& Surface,
+	                     const FVector& Position,
+	                     float Time,
+	                     float Tolerance,
+	                     int32 MaxIterations,
+	                     FWaterSurfaceInverseState& InOutState);
+
+	// Same as Solve for every position, with one batched displacement query per iteration.
+	static void SolveBatch(const IWaterSurfaceProvider& Surface,
+	                       TArrayView<const FVector> Positions,
+	                       float Time,
+	                       float Tolerance,
+	                       int32 MaxIterations,
+	                       TArrayView<FWaterSurfaceInverseState> InOutStates,
+	                       TArrayView<FVector> OutDisplacements);
+};
@@ -0,0 +1,129 @@
+// For copyright see LICENSE in EnvironmentProject root dir, or:
+//https://github.com/UE4-OceanProject/OceanProject/blob/Master-Environment-Project/LICENSE
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Interval.h"
+#include "UObject/Interface.h"
+#include "WaterSurfaceProvider.generated.h"
+
+
+class AOceanManager;
+
+/*
+
+Copy of what the height queries of a water surface provider depend on, made on the game thread by
+IWaterSurfaceProvider::MakeSnapshot. The copy is never changed, so worker threads can query it while the provider keeps
+being edited or ticked on the game thread. It gives the same heights as the provider at the time of the copy.
+
+*/
+
+class BUOYANCYPLUGIN_API FWaterSurfaceSnapshot
+{
+   public:
+	virtual ~FWaterSurfaceSnapshot() = default;
+
+	virtual float GetWaterHeight(const FVector& Position, float Time) const = 0;
+	virtual void GetWaterHeights(TArrayView<const FVector> Positions, float Time, TArrayView<float> OutHeights) const;
+};
+
+using FWaterSurfaceSnapshotPtr = TSharedPtr<const FWaterSurfaceSnapshot, ESPMode::ThreadSafe>;
+
+// One of the plane waves a water surface is the sum of.
+struct FWaterSurfaceWave
+{
+	// Direction the wave travels in times its wave number, in radians per uu.
+	FVector2D WaveVector = FVector2D::ZeroVector;
+	// In radians per second.
+	float AngularFrequency = 0.f;
+	// Largest displacement of the surface by the wave, vertical or horizontal.
+	float Amplitude = 0.f;
+};
+
+UINTERFACE(meta = (CannotImplementInterfaceInBlueprint))
+class BUOYANCYPLUGIN_API UWaterSurfaceProvider : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/*
+
+Source of water surface data for the buoyancy components, so they don't depend on a specific water implementation.
+
+Positions are in world space and Time is the world time in seconds. Queries are only made from worker threads when
+CanQueryFromAnyThread() returns true, and the implementations that do must then be safe to call from several threads at
+once, as long as their settings aren't being changed. Callers evaluating in parallel check it once per update, see
+FWaterSurfaceProviders::CanQueryFromAnyThread.
+
+The batched queries fill the output views, which must be as long as Positions. Their default implementations loop over
+the single queries; providers that can share work between positions should override them.
+
+*/
+
+class BUOYANCYPLUGIN_API IWaterSurfaceProvider
+{
+	GENERATED_BODY()
+
+   public:
+	// Height of the water surface right above or below Position.
+	virtual float GetWaterHeight(const FVector& Position, float Time) const = 0;
+
+	// Displacement of the surface point whose undisturbed position is Position, in X and Y.
+	// Z is the height of the displaced point.
+	virtual FVector GetWaterDisplacement(const FVector& Position, float Time) const = 0;
+
+	// Velocity of the water at the surface point whose undisturbed position is Position.
+	virtual FVector GetWaterVelocity(const FVector& Position, float Time) const = 0;
+
+	// Main direction the waves travel in.
+	virtual FVector2D GetWaveDirection() const = 0;
+
+	// False if the provider ignores the Time of the queries and always answers for the current time.
+	virtual bool CanQueryAnyTime() const { return true; }
+
+	// False if the queries have to be made from the game thread.
+	virtual bool CanQueryFromAnyThread() const { return true; }
+
+	// Copies the provider for height queries from worker threads, see FWaterSurfaceSnapshot. Called on the game thread.
+	// Returns nullptr if the provider can't be copied, its queries must then be made on the game thread.
+	virtual FWaterSurfaceSnapshotPtr MakeSnapshot() const { return nullptr; }
+
+	// Lowest and highest water height the surface can reach, anywhere and at any time. Providers whose waves can be
+	// changed at runtime bound their current waves, so callers query the bounds again every tick.
+	// Returns false if the provider can't bound its surface, callers must then assume the water can be at any height.
+	virtual bool GetWaterHeightBounds(FFloatInterval& OutBounds) const { return false; }
+
+	// How fast GetWaterHeight can change: between two queries, the heights differ by at most OutMaxSlope times the
+	// horizontal distance between the positions plus OutMaxSpeed times the time between them. Providers whose waves
+	// can be changed at runtime bound their current waves. Returns false if the provider can't bound its changes.
+	virtual bool GetWaterHeightRateBounds(float& OutMaxSlope, float& OutMaxSpeed) const { return false; }
+
+	// Plane waves the surface is the sum of, e.g. to check that a baked tile repeats them. Providers whose waves can be
+	// changed at runtime return their current waves. Returns false if the surface isn't a known sum of plane waves.
+	virtual bool GetWaves(TArray<FWaterSurfaceWave>& OutWaves) const { return false; }
+
+	virtual void GetWaterHeights(TArrayView<const FVector> Positions, float Time, TArrayView<float> OutHeights) const;
+	virtual void GetWaterDisplacements(TArrayView<const FVector> Positions,
+	                                   float Time,
+	                                   TArrayView<FVector> OutDisplacements) const;
+	virtual void GetWaterVelocities(TArrayView<const FVector> Positions,
+	                                float Time,
+	                                TArrayView<FVector> OutVelocities) const;
+};
+
+class BUOYANCYPLUGIN_API FWaterSurfaceProviders
+{
+   public:
+	// Returns the provider object as a water surface provider. If it isn't one, and the OceanManager is valid, an
+	// OceanManager adapter owned by Outer is created, stored in InOutProviderObject and returned. An adapter without
+	// an OceanManager is given this one.
+	// Returns nullptr if there is no water at all.
+	static IWaterSurfaceProvider* Resolve(UObject*& InOutProviderObject, UObject* Outer, AOceanManager* OceanManager);
+
+	// Whether the resolved provider, if any, can be queried from worker threads.
+	static bool CanQueryFromAnyThread(const IWaterSurfaceProvider* Provider)
+	{
+		return !Provider || Provider->CanQueryFromAnyThread();
+	}
+};